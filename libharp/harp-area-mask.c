@@ -30,6 +30,7 @@
  */
 
 #include "harp-area-mask.h"
+#include "harp-csv.h"
 
 #include <ctype.h>
 #include <stdlib.h>
@@ -37,7 +38,6 @@
 #include <string.h>
 
 #define AREA_MASK_BLOCK_SIZE 1024
-#define AREA_MASK_MAX_LINE_SIZE 1024
 
 int harp_area_mask_new(harp_area_mask **new_area_mask)
 {
@@ -341,10 +341,9 @@ static int parse_polygon(const char *str, harp_spherical_polygon **polygon)
     return 0;
 }
 
-static int read_area_mask(FILE *stream, harp_area_mask **new_area_mask)
+static int read_area_mask(harp_csv_file *csv_file, harp_area_mask **new_area_mask)
 {
     harp_area_mask *area_mask;
-    char line[AREA_MASK_MAX_LINE_SIZE];
     int read_header;
     long i;
 
@@ -353,16 +352,14 @@ static int read_area_mask(FILE *stream, harp_area_mask **new_area_mask)
         return -1;
     }
 
-    i = 1;
     read_header = 0;
-    while (fgets(line, AREA_MASK_MAX_LINE_SIZE, stream) != NULL)
+    for (i = 0; i < csv_file->num_lines; i++)
     {
         harp_spherical_polygon *polygon;
 
         /* Skip blank lines. */
-        if (is_blank_line(line))
+        if (is_blank_line(csv_file->line[i]))
         {
-            i++;
             continue;
         }
 
@@ -370,13 +367,12 @@ static int read_area_mask(FILE *stream, harp_area_mask **new_area_mask)
         if (!read_header)
         {
             read_header = 1;
-            i++;
             continue;
         }
 
-        if (parse_polygon(line, &polygon) != 0)
+        if (parse_polygon(csv_file->line[i], &polygon) != 0)
         {
-            harp_add_error_message(" (line %lu)", i);
+            harp_add_error_message(" (line %lu)", i + 1);
             harp_area_mask_delete(area_mask);
             return -1;
         }
@@ -387,15 +383,6 @@ static int read_area_mask(FILE *stream, harp_area_mask **new_area_mask)
             harp_area_mask_delete(area_mask);
             return -1;
         }
-
-        i++;
-    }
-
-    if (ferror(stream) || !feof(stream))
-    {
-        harp_set_error(HARP_ERROR_FILE_READ, "read error");
-        harp_area_mask_delete(area_mask);
-        return -1;
     }
 
     *new_area_mask = area_mask;
@@ -404,7 +391,7 @@ static int read_area_mask(FILE *stream, harp_area_mask **new_area_mask)
 
 int harp_area_mask_read(const char *filename, harp_area_mask **new_area_mask)
 {
-    FILE *stream;
+    harp_csv_file *csv_file;
     harp_area_mask *area_mask;
 
     if (filename == NULL)
@@ -413,26 +400,20 @@ int harp_area_mask_read(const char *filename, harp_area_mask **new_area_mask)
         return -1;
     }
 
-    stream = fopen(filename, "r");
-    if (stream == NULL)
+    if (harp_csv_file_read(filename, &csv_file) != 0)
     {
-        harp_set_error(HARP_ERROR_FILE_OPEN, "cannot open area mask file '%s'", filename);
+        harp_add_error_message(" (while reading area mask file)");
         return -1;
     }
 
-    if (read_area_mask(stream, &area_mask) != 0)
+    if (read_area_mask(csv_file, &area_mask) != 0)
     {
         harp_add_error_message(" (while reading area mask file '%s')", filename);
-        fclose(stream);
+        harp_csv_file_delete(csv_file);
         return -1;
     }
 
-    if (fclose(stream) != 0)
-    {
-        harp_set_error(HARP_ERROR_FILE_CLOSE, "cannot close area mask file '%s'", filename);
-        harp_area_mask_delete(area_mask);
-        return -1;
-    }
+    harp_csv_file_delete(csv_file);
 
     *new_area_mask = area_mask;
     return 0;
@@ -1207,38 +1207,15 @@ static int find_matching_cells_for_points(harp_variable *latitude, harp_variable
  * @{
  */
 
-/** Bin the product's variables.
- * This will bin all variables in the time dimension. Each time sample will be put in the bin defined by bin_index.
- * All variables with a time dimension will then be resampled using these bins.
- * The resulting value for each variable will be the average of all values for the bin (using existing count variables
- * as weighting factors where available).
- * Variables with multiple dimensions will have all elements in the sub dimensions averaged on an element by element
- * basis.
- *
- * Variables that have a time dimension but no unit (or using a string data type) will be removed.
- *
- * All variables that are binned (except existing 'count' variables) are converted to a double data type.
- * Bins that have no samples will end up with a NaN value.
- *
- * If the product did not already have a 'count' variable then a 'count' variable will be added to the product that
- * will contain the number of samples per bin.
- *
- * Only non-NaN values will contribute to a bin. If there are NaN values then a separate variable-specific count
- * variable will be created that will contain the number of non-NaN values that contributed to each bin. This
- * count variable will have the same dimensions as the variable it provides the count for.
- *
- * \param product Product to regrid.
- * \param num_bins Number of target bins.
- * \param num_elements Length of bin_index array (should equal the length of the time dimension)
- * \param bin_index Array of target bin index numbers (0 .. num_bins-1) for each sample in the time dimension.
- *
- * \return
- *   \arg \c 0, Success.
- *   \arg \c -1, Error occurred (check #harp_errno).
+/* Bin the product's variables (see harp_product_bin()).
+ * If bin_variable is not NULL then this variable (which should not be part of the product and should only depend on
+ * the time dimension) is resampled to the bins using the same rearrangement as the binned product variables.
  */
-LIBHARP_API int harp_product_bin(harp_product *product, long num_bins, long num_elements, long *bin_index)
+static int bin_product(harp_product *product, long num_bins, long num_elements, long *bin_index,
+                       harp_variable *bin_variable)
 {
     harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
+    harp_gather_plan *plan = NULL;
     binning_type *bintype = NULL;
     long filtered_count_size = 0;
     int32_t *filtered_count = NULL;
@@ -1568,7 +1545,7 @@ LIBHARP_API int harp_product_bin(harp_product *product, long num_bins, long num_
         }
     }
 
-    /* resample variables */
+    /* resample variables (the resampling is the same for all variables, so derive it only once) */
     for (k = 0; k < product->num_variables; k++)
     {
         if (bintype[k] == binning_skip || bintype[k] == binning_remove)
@@ -1576,12 +1553,39 @@ LIBHARP_API int harp_product_bin(harp_product *product, long num_bins, long num_
             continue;
         }
 
+        if (plan == NULL)
+        {
+            if (harp_gather_plan_new(num_elements, num_bins, index, &plan) != 0)
+            {
+                goto error;
+            }
+        }
+
         /* resample the time dimension to the target bins */
-        if (harp_variable_rearrange_dimension(product->variable[k], 0, num_bins, index) != 0)
+        if (harp_variable_rearrange_dimension_with_plan(product->variable[k], 0, plan) != 0)
+        {
+            goto error;
+        }
+    }
+    if (bin_variable != NULL)
+    {
+        if (plan == NULL)
+        {
+            if (harp_gather_plan_new(num_elements, num_bins, index, &plan) != 0)
+            {
+                goto error;
+            }
+        }
+        if (harp_variable_rearrange_dimension_with_plan(bin_variable, 0, plan) != 0)
         {
             goto error;
         }
     }
+    if (plan != NULL)
+    {
+        harp_gather_plan_delete(plan);
+        plan = NULL;
+    }
 
     /* update product dimensions */
     product->dimension[harp_dimension_time] = num_bins;
@@ -1749,9 +1753,47 @@ LIBHARP_API int harp_product_bin(harp_product *product, long num_bins, long num_
     {
         free(index);
     }
+    if (plan != NULL)
+    {
+        harp_gather_plan_delete(plan);
+    }
     return -1;
 }
 
+/** Bin the product's variables.
+ * This will bin all variables in the time dimension. Each time sample will be put in the bin defined by bin_index.
+ * All variables with a time dimension will then be resampled using these bins.
+ * The resulting value for each variable will be the average of all values for the bin (using existing count variables
+ * as weighting factors where available).
+ * Variables with multiple dimensions will have all elements in the sub dimensions averaged on an element by element
+ * basis.
+ *
+ * Variables that have a time dimension but no unit (or using a string data type) will be removed.
+ *
+ * All variables that are binned (except existing 'count' variables) are converted to a double data type.
+ * Bins that have no samples will end up with a NaN value.
+ *
+ * If the product did not already have a 'count' variable then a 'count' variable will be added to the product that
+ * will contain the number of samples per bin.
+ *
+ * Only non-NaN values will contribute to a bin. If there are NaN values then a separate variable-specific count
+ * variable will be created that will contain the number of non-NaN values that contributed to each bin. This
+ * count variable will have the same dimensions as the variable it provides the count for.
+ *
+ * \param product Product to regrid.
+ * \param num_bins Number of target bins.
+ * \param num_elements Length of bin_index array (should equal the length of the time dimension)
+ * \param bin_index Array of target bin index numbers (0 .. num_bins-1) for each sample in the time dimension.
+ *
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_product_bin(harp_product *product, long num_bins, long num_elements, long *bin_index)
+{
+    return bin_product(product, num_bins, num_elements, bin_index, NULL);
+}
+
 /** Bin the product's variables into a spatial grid.
  * This will bin all variables with a time dimension into a three dimensional time x latitude x longitude grid.
  * Each time sample will first be allocated to a time bin defined by time_bin_index (similar to \a harp_product_bin).
@@ -1819,6 +1861,7 @@ LIBHARP_API int harp_product_bin_spatial(harp_product *product, long num_time_bi
     long *latlon_cell_index = NULL;     /* flat latlon cell index for each matching cell for each sample [sum(num_latlon_index)] */
     double *latlon_weight = NULL;       /* weight for each matching cell for each sample [sum(num_latlon_index)] */
     long *time_index = NULL;    /* index of first contributing sample for each bin */
+    harp_gather_plan *time_plan = NULL; /* rearrangement of the time dimension using time_index */
     int32_t *time_count = NULL; /* number of samples per time bin */
     long filtered_count_size = 0;
     int32_t *filtered_count = NULL;
@@ -2224,7 +2267,14 @@ LIBHARP_API int harp_product_bin_spatial(harp_product *product, long num_time_bi
                     }
                 }
             }
-            if (harp_variable_rearrange_dimension(variable, 0, num_time_bins, time_index) != 0)
+            if (time_plan == NULL)
+            {
+                if (harp_gather_plan_new(num_time_elements, num_time_bins, time_index, &time_plan) != 0)
+                {
+                    goto error;
+                }
+            }
+            if (harp_variable_rearrange_dimension_with_plan(variable, 0, time_plan) != 0)
             {
                 goto error;
             }
@@ -2712,6 +2762,10 @@ LIBHARP_API int harp_product_bin_spatial(harp_product *product, long num_time_bi
         free(filtered_weight);
     }
     free(time_index);
+    if (time_plan != NULL)
+    {
+        harp_gather_plan_delete(time_plan);
+    }
     free(time_count);
     free(count);
     free(num_latlon_index);
@@ -2780,6 +2834,10 @@ LIBHARP_API int harp_product_bin_spatial(harp_product *product, long num_time_bi
     {
         free(time_index);
     }
+    if (time_plan != NULL)
+    {
+        harp_gather_plan_delete(time_plan);
+    }
     if (time_count != NULL)
     {
         free(time_count);
@@ -3120,13 +3178,6 @@ int harp_product_bin_with_variable(harp_product *product, const char *variable_n
             free(index);
             return -1;
         }
-        if (harp_variable_rearrange_dimension(variable, 0, num_bins, index) != 0)
-        {
-            harp_variable_delete(variable);
-            free(bin_index);
-            free(index);
-            return -1;
-        }
     }
     else
     {
@@ -3135,7 +3186,8 @@ int harp_product_bin_with_variable(harp_product *product, const char *variable_n
 
     free(index);
 
-    if (harp_product_bin(product, num_bins, num_elements, bin_index) != 0)
+    /* the copy of the variable that we bin on is resampled together with the product variables */
+    if (bin_product(product, num_bins, num_elements, bin_index, variable) != 0)
     {
         if (variable != NULL)
         {
@@ -190,6 +190,7 @@ LIBHARP_API int harp_collocation_result_new(harp_collocation_result **new_colloc
         {
             collocation_result->difference_unit[i] = NULL;
         }
+        collocation_result->num_differences = num_differences;
         if (difference_variable_name != NULL)
         {
             for (i = 0; i < num_differences; i++)
@@ -769,28 +770,10 @@ LIBHARP_API int harp_collocation_result_remove_pair_at_index(harp_collocation_re
  * @}
  */
 
-static int read_header(FILE *file, harp_collocation_result *collocation_result)
+static int read_header(char *line, harp_collocation_result *collocation_result)
 {
-    char line[HARP_CSV_LINE_LENGTH];
     char *cursor = line;
     char *string = NULL;
-    size_t length;
-
-    rewind(file);
-
-    if (fgets(line, HARP_CSV_LINE_LENGTH, file) == NULL)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "error reading header");
-        return -1;
-    }
-
-    /* trim end-of-line */
-    length = strlen(line);
-    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n'))
-    {
-        length--;
-    }
-    line[length] = '\0';
 
     harp_csv_parse_string(&cursor, &string);
     if (strcmp(string, "collocation_index") != 0)
@@ -840,69 +823,156 @@ static int read_header(FILE *file, harp_collocation_result *collocation_result)
     return 0;
 }
 
-static int read_pair(FILE *file, harp_collocation_result *collocation_result)
+/* Determine the index of a source product in a dataset (adding the product if needed).
+ * Pairs are generally grouped by source product, so the product of the previous pair is checked first.
+ */
+static int get_product_index(harp_dataset *dataset, const char *source_product, const char **last_source_product,
+                             long *last_product_index, long *product_index)
 {
-    char line[HARP_CSV_LINE_LENGTH];
-    char *cursor = line;
-    long collocation_index;
-    char *source_product_a;
-    char *source_product_b;
-    long index_a;
-    long index_b;
-    double *difference = NULL;
-    int i;
-
-    if (fgets(line, HARP_CSV_LINE_LENGTH, file) == NULL)
+    if (*last_source_product != NULL && strcmp(*last_source_product, source_product) == 0)
+    {
+        *product_index = *last_product_index;
+        return 0;
+    }
+    if (harp_dataset_add_product(dataset, source_product, NULL) != 0)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "error reading line");
         return -1;
     }
+    if (harp_dataset_get_index_from_source_product(dataset, source_product, product_index) != 0)
+    {
+        return -1;
+    }
+    *last_source_product = source_product;
+    *last_product_index = *product_index;
 
-    harp_csv_rtrim(line);
+    return 0;
+}
 
-    /* Parse line */
-    harp_csv_parse_long(&cursor, &collocation_index);
-    harp_csv_parse_string(&cursor, &source_product_a);
-    harp_csv_parse_long(&cursor, &index_a);
-    harp_csv_parse_string(&cursor, &source_product_b);
-    harp_csv_parse_long(&cursor, &index_b);
+/* Read all pairs (i.e. all lines after the header) of a collocation result file.
+ * The lines are first parsed into columnar arrays, after which the pairs are created in one go.
+ */
+static int read_pairs(harp_csv_file *csv_file, harp_collocation_result *collocation_result)
+{
+    harp_csv_column_type *column_type = NULL;
+    void **column_data = NULL;
+    const char *last_source_product_a = NULL;
+    const char *last_source_product_b = NULL;
+    long last_product_index_a = -1;
+    long last_product_index_b = -1;
+    double *difference = NULL;
+    long num_pairs = csv_file->num_lines - 1;
+    long num_allocated;
+    int num_columns = 5 + collocation_result->num_differences;
+    int result = -1;
+    long i;
+    int j;
 
+    column_type = malloc(num_columns * sizeof(harp_csv_column_type));
+    column_data = malloc(num_columns * sizeof(void *));
     if (collocation_result->num_differences > 0)
     {
         difference = malloc(collocation_result->num_differences * sizeof(double));
-        if (difference == NULL)
+    }
+    if (column_type == NULL || column_data == NULL || (collocation_result->num_differences > 0 && difference == NULL))
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_columns * (sizeof(harp_csv_column_type) + sizeof(void *)), __FILE__, __LINE__);
+        goto error;
+    }
+    for (j = 0; j < num_columns; j++)
+    {
+        column_data[j] = NULL;
+    }
+    column_type[0] = harp_csv_column_long;
+    column_type[1] = harp_csv_column_string;
+    column_type[2] = harp_csv_column_long;
+    column_type[3] = harp_csv_column_string;
+    column_type[4] = harp_csv_column_long;
+    for (j = 5; j < num_columns; j++)
+    {
+        column_type[j] = harp_csv_column_double;
+    }
+    for (j = 0; j < num_columns; j++)
+    {
+        size_t element_size = column_type[j] == harp_csv_column_long ? sizeof(long) :
+            column_type[j] == harp_csv_column_double ? sizeof(double) : sizeof(char *);
+
+        column_data[j] = malloc(num_pairs * element_size);
+        if (column_data[j] == NULL)
         {
             harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                           collocation_result->num_differences * sizeof(double), __FILE__, __LINE__);
-            return -1;
+                           num_pairs * element_size, __FILE__, __LINE__);
+            goto error;
         }
-        for (i = 0; i < collocation_result->num_differences; i++)
+    }
+
+    if (harp_csv_file_parse_columns(csv_file, 1, num_columns, column_type, column_data) != 0)
+    {
+        goto error;
+    }
+
+    /* allocate the pair array in one go (as a multiple of the block size that harp_collocation_result_add_pair uses) */
+    num_allocated = ((num_pairs - 1) / COLLOCATION_RESULT_BLOCK_SIZE + 1) * COLLOCATION_RESULT_BLOCK_SIZE;
+    collocation_result->pair = malloc(num_allocated * sizeof(harp_collocation_pair *));
+    if (collocation_result->pair == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_allocated * sizeof(harp_collocation_pair *), __FILE__, __LINE__);
+        goto error;
+    }
+
+    for (i = 0; i < num_pairs; i++)
+    {
+        long product_index_a;
+        long product_index_b;
+
+        if (get_product_index(collocation_result->dataset_a, ((char **)column_data[1])[i], &last_source_product_a,
+                              &last_product_index_a, &product_index_a) != 0)
         {
-            if (harp_csv_parse_double(&cursor, &difference[i]) != 0)
-            {
-                free(difference);
-                return -1;
-            }
+            goto error;
+        }
+        if (get_product_index(collocation_result->dataset_b, ((char **)column_data[3])[i], &last_source_product_b,
+                              &last_product_index_b, &product_index_b) != 0)
+        {
+            goto error;
         }
+        for (j = 0; j < collocation_result->num_differences; j++)
+        {
+            difference[j] = ((double *)column_data[5 + j])[i];
+        }
+        if (collocation_pair_new(((long *)column_data[0])[i], product_index_a, ((long *)column_data[2])[i],
+                                 product_index_b, ((long *)column_data[4])[i], collocation_result->num_differences,
+                                 difference, &collocation_result->pair[i]) != 0)
+        {
+            goto error;
+        }
+        collocation_result->num_pairs++;
     }
 
-    if (harp_collocation_result_add_pair(collocation_result, collocation_index, source_product_a, index_a,
-                                         source_product_b, index_b, collocation_result->num_differences, difference)
-        != 0)
+    result = 0;
+
+  error:
+    if (column_data != NULL)
     {
-        if (difference != NULL)
+        for (j = 0; j < num_columns; j++)
         {
-            free(difference);
+            if (column_data[j] != NULL)
+            {
+                free(column_data[j]);
+            }
         }
-        return -1;
+        free(column_data);
+    }
+    if (column_type != NULL)
+    {
+        free(column_type);
     }
-
     if (difference != NULL)
     {
         free(difference);
     }
 
-    return 0;
+    return result;
 }
 
 /** \addtogroup harp_collocation
@@ -921,9 +991,7 @@ LIBHARP_API int harp_collocation_result_read(const char *collocation_result_file
                                              harp_collocation_result **new_collocation_result)
 {
     harp_collocation_result *collocation_result = NULL;
-    FILE *file;
-    long i;
-    long num_lines;
+    harp_csv_file *csv_file;
 
     if (collocation_result_filename == NULL)
     {
@@ -931,34 +999,25 @@ LIBHARP_API int harp_collocation_result_read(const char *collocation_result_file
         return -1;
     }
 
-    /* Open the collocation result file */
-    file = fopen(collocation_result_filename, "r");
-    if (file == NULL)
-    {
-        harp_set_error(HARP_ERROR_FILE_OPEN, "error opening collocation result file '%s'", collocation_result_filename);
-        return -1;
-    }
-
-    /* Get number of lines */
-    if (harp_csv_get_num_lines(file, collocation_result_filename, &num_lines) != 0)
+    /* Read the full collocation result file */
+    if (harp_csv_file_read(collocation_result_filename, &csv_file) != 0)
     {
-        fclose(file);
+        harp_add_error_message(" (while reading collocation result file)");
         return -1;
     }
 
     /* Start new collocation result */
     if (harp_collocation_result_new(&collocation_result, 0, NULL, NULL) != 0)
     {
-        fclose(file);
+        harp_csv_file_delete(csv_file);
         return -1;
     }
 
     /* Exclude the header line */
-    num_lines--;
-    if (num_lines < 1)
+    if (csv_file->num_lines < 2)
     {
         /* No lines to read */
-        fclose(file);
+        harp_csv_file_delete(csv_file);
 
         /* Return an empty collocation result */
         *new_collocation_result = collocation_result;
@@ -966,32 +1025,23 @@ LIBHARP_API int harp_collocation_result_read(const char *collocation_result_file
     }
 
     /* Initialize the collocation result and update the collocation differences with the information in the header */
-    if (read_header(file, collocation_result) != 0)
+    if (read_header(csv_file->line[0], collocation_result) != 0)
     {
         harp_collocation_result_delete(collocation_result);
-        fclose(file);
+        harp_csv_file_delete(csv_file);
         return -1;
     }
 
     /* Read the matching pairs */
-    for (i = 0; i < num_lines; i++)
+    if (read_pairs(csv_file, collocation_result) != 0)
     {
-        if (read_pair(file, collocation_result) != 0)
-        {
-            harp_collocation_result_delete(collocation_result);
-            fclose(file);
-            return -1;
-        }
-    }
-
-    /* Close the collocation result file */
-    if (fclose(file) != 0)
-    {
-        harp_set_error(HARP_ERROR_FILE_CLOSE, "error closing collocation result file");
         harp_collocation_result_delete(collocation_result);
+        harp_csv_file_delete(csv_file);
         return -1;
     }
 
+    harp_csv_file_delete(csv_file);
+
     *new_collocation_result = collocation_result;
     return 0;
 }
@@ -33,6 +33,10 @@
 #include "harp-csv.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
@@ -225,56 +229,338 @@ int harp_csv_parse_variable_name_and_unit(char **str, char **variable_name, char
     return 0;
 }
 
-int harp_csv_get_num_lines(FILE *file, const char *filename, long *new_num_lines)
+/* Modifies the string end */
+void harp_csv_rtrim(char *str)
 {
+    size_t length = strlen(str);
+
+    while (length > 0 && (str[length - 1] == '\r' || str[length - 1] == '\n' || str[length - 1] == '\t' ||
+                          str[length - 1] == ' '))
+    {
+        length--;
+    }
+    str[length] = '\0';
+}
+
+/* Returns a pointer to a substring */
+char *harp_csv_ltrim(char *str)
+{
+    while (isspace(str[0]))
+    {
+        str++;
+    }
+
+    return str;
+}
+
+void harp_csv_file_delete(harp_csv_file *csv_file)
+{
+    if (csv_file != NULL)
+    {
+        if (csv_file->filename != NULL)
+        {
+            free(csv_file->filename);
+        }
+        if (csv_file->buffer != NULL)
+        {
+            free(csv_file->buffer);
+        }
+        if (csv_file->line != NULL)
+        {
+            free(csv_file->line);
+        }
+        free(csv_file);
+    }
+}
+
+static int read_file_content(harp_csv_file *csv_file)
+{
+    FILE *file;
     long length;
-    char LINE[HARP_CSV_LINE_LENGTH];
-    long num_lines = 0;
 
-    while (fgets(LINE, HARP_CSV_LINE_LENGTH, file) != NULL)
+    file = fopen(csv_file->filename, "rb");
+    if (file == NULL)
+    {
+        harp_set_error(HARP_ERROR_FILE_OPEN, "could not open '%s' (%s)", csv_file->filename, strerror(errno));
+        return -1;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        harp_set_error(HARP_ERROR_FILE_READ, "could not determine size of '%s' (%s)", csv_file->filename,
+                       strerror(errno));
+        fclose(file);
+        return -1;
+    }
+
+    csv_file->buffer = malloc(length + 1);
+    if (csv_file->buffer == NULL)
     {
-        /* Trim the line */
-        length = (long)strlen(LINE);
-        while (length > 0 && (LINE[length - 1] == '\r' || LINE[length - 1] == '\n'))
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (unsigned long)length + 1, __FILE__, __LINE__);
+        fclose(file);
+        return -1;
+    }
+    if (length > 0 && fread(csv_file->buffer, 1, length, file) != (size_t)length)
+    {
+        harp_set_error(HARP_ERROR_FILE_READ, "could not read '%s' (%s)", csv_file->filename, strerror(errno));
+        fclose(file);
+        return -1;
+    }
+    csv_file->buffer[length] = '\0';
+
+    if (fclose(file) != 0)
+    {
+        harp_set_error(HARP_ERROR_FILE_CLOSE, "could not close '%s' (%s)", csv_file->filename, strerror(errno));
+        return -1;
+    }
+
+    /* split the buffer into lines in place */
+    if (length > 0)
+    {
+        char *end = &csv_file->buffer[length];
+        char *cursor;
+        long num_lines = 0;
+
+        cursor = csv_file->buffer;
+        while ((cursor = memchr(cursor, '\n', end - cursor)) != NULL)
         {
-            length--;
+            num_lines++;
+            cursor++;
+        }
+        if (end[-1] != '\n')
+        {
+            /* last line without end-of-line */
+            num_lines++;
         }
-        LINE[length] = '\0';
 
-        /* Do not allow empty lines */
-        if (length == 0)
+        csv_file->line = malloc(num_lines * sizeof(char *));
+        if (csv_file->line == NULL)
         {
-            harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "empty line in file '%s'", filename);
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           num_lines * sizeof(char *), __FILE__, __LINE__);
             return -1;
         }
 
-        num_lines++;
+        cursor = csv_file->buffer;
+        while (csv_file->num_lines < num_lines)
+        {
+            char *line_end;
+
+            line_end = memchr(cursor, '\n', end - cursor);
+            if (line_end == NULL)
+            {
+                line_end = end;
+            }
+            csv_file->line[csv_file->num_lines] = cursor;
+            csv_file->num_lines++;
+            cursor = line_end + 1;
+            if (line_end > csv_file->buffer && line_end[-1] == '\r')
+            {
+                line_end--;
+            }
+            *line_end = '\0';
+        }
     }
 
-    *new_num_lines = num_lines;
     return 0;
 }
 
-/* Modifies the string end */
-void harp_csv_rtrim(char *str)
+/* Read a csv file into memory.
+ * The file is read with a single read operation and split into lines without any further copying of data.
+ * Line i of csv_file->line is line i + 1 of the file.
+ */
+int harp_csv_file_read(const char *filename, harp_csv_file **new_csv_file)
 {
-    size_t length = strlen(str);
+    harp_csv_file *csv_file;
 
-    while (length > 0 && (str[length - 1] == '\r' || str[length - 1] == '\n' || str[length - 1] == '\t' ||
-                          str[length - 1] == ' '))
+    csv_file = (harp_csv_file *)malloc(sizeof(harp_csv_file));
+    if (csv_file == NULL)
     {
-        length--;
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_csv_file), __FILE__, __LINE__);
+        return -1;
     }
-    str[length] = '\0';
+    csv_file->filename = NULL;
+    csv_file->buffer = NULL;
+    csv_file->num_lines = 0;
+    csv_file->line = NULL;
+
+    csv_file->filename = strdup(filename);
+    if (csv_file->filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                       __LINE__);
+        harp_csv_file_delete(csv_file);
+        return -1;
+    }
+
+    if (read_file_content(csv_file) != 0)
+    {
+        harp_csv_file_delete(csv_file);
+        return -1;
+    }
+
+    *new_csv_file = csv_file;
+    return 0;
 }
 
-/* Returns a pointer to a substring */
-char *harp_csv_ltrim(char *str)
+/* Locale independent integer parsing; returns the number of parsed bytes or -1 if the element is not an integer or if
+ * the value does not fit in a long.
+ */
+static long parse_long(const char *buffer, long buffer_length, long *dst)
 {
-    while (isspace(str[0]))
+    const char *cursor = buffer;
+    const char *end = &buffer[buffer_length];
+    unsigned long value = 0;
+    unsigned long max_value;
+    int negative = 0;
+
+    if (cursor < end && (*cursor == '+' || *cursor == '-'))
     {
-        str++;
+        negative = (*cursor == '-');
+        cursor++;
+    }
+    if (cursor == end)
+    {
+        return -1;
     }
+    max_value = negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9')
+    {
+        unsigned long digit = (unsigned long)(*cursor - '0');
 
-    return str;
+        if (value > (max_value - digit) / 10)
+        {
+            /* value does not fit in a long */
+            return -1;
+        }
+        value = 10 * value + digit;
+        cursor++;
+    }
+    if (cursor != end)
+    {
+        return -1;
+    }
+
+    if (negative && value > 0)
+    {
+        /* value - 1 always fits in a long (also for LONG_MIN) */
+        *dst = -(long)(value - 1) - 1;
+    }
+    else
+    {
+        *dst = (long)value;
+    }
+    return buffer_length;
+}
+
+/* Parse num_columns comma separated elements from each line, starting at first_line, into columnar arrays.
+ * column_data[i] should point to an array of at least (csv_file->num_lines - first_line) elements of the type that is
+ * given by column_type[i]. Leading and trailing white space of elements is ignored. Numeric values are parsed using
+ * locale independent parsers, and string elements are nul-terminated in place (in the buffer of csv_file).
+ * Errors mention the file name and line number of the element that could not be parsed.
+ */
+int harp_csv_file_parse_columns(harp_csv_file *csv_file, long first_line, int num_columns,
+                                const harp_csv_column_type *column_type, void **column_data)
+{
+    long i;
+    int j;
+
+    for (i = first_line; i < csv_file->num_lines; i++)
+    {
+        char *cursor = csv_file->line[i];
+        long index = i - first_line;
+
+        if (*cursor == '\0')
+        {
+            harp_set_error(HARP_ERROR_INVALID_FORMAT, "empty line in file '%s' (line %ld)", csv_file->filename, i + 1);
+            return -1;
+        }
+
+        for (j = 0; j < num_columns; j++)
+        {
+            char *element;
+            long length;
+
+            if (j > 0)
+            {
+                if (*cursor != ',')
+                {
+                    harp_set_error(HARP_ERROR_INVALID_FORMAT, "expected %d elements in file '%s' (line %ld)",
+                                   num_columns, csv_file->filename, i + 1);
+                    return -1;
+                }
+                cursor++;
+            }
+
+            while (*cursor == ' ' || *cursor == '\t')
+            {
+                cursor++;
+            }
+            element = cursor;
+            while (*cursor != ',' && *cursor != '\0')
+            {
+                cursor++;
+            }
+            length = (long)(cursor - element);
+            while (length > 0 && (element[length - 1] == ' ' || element[length - 1] == '\t'))
+            {
+                length--;
+            }
+
+            switch (column_type[j])
+            {
+                case harp_csv_column_long:
+                    if (parse_long(element, length, &((long *)column_data[j])[index]) != length)
+                    {
+                        harp_set_error(HARP_ERROR_INVALID_FORMAT, "could not parse integer value from csv element "
+                                       "'%.*s' in file '%s' (line %ld)", (int)length, element, csv_file->filename,
+                                       i + 1);
+                        return -1;
+                    }
+                    break;
+                case harp_csv_column_double:
+                    if (length == 0 || harp_parse_double(element, length, &((double *)column_data[j])[index], 0) !=
+                        length)
+                    {
+                        harp_set_error(HARP_ERROR_INVALID_FORMAT, "could not parse floating point value from csv "
+                                       "element '%.*s' in file '%s' (line %ld)", (int)length, element,
+                                       csv_file->filename, i + 1);
+                        return -1;
+                    }
+                    break;
+                case harp_csv_column_string:
+                    ((char **)column_data[j])[index] = element;
+                    break;
+            }
+        }
+        if (*cursor != '\0')
+        {
+            harp_set_error(HARP_ERROR_INVALID_FORMAT, "expected %d elements in file '%s' (line %ld)", num_columns,
+                           csv_file->filename, i + 1);
+            return -1;
+        }
+
+        /* terminate string elements only after the full line is parsed (terminating earlier would hide the ',') */
+        for (j = 0; j < num_columns; j++)
+        {
+            if (column_type[j] == harp_csv_column_string)
+            {
+                char *element = ((char **)column_data[j])[index];
+                char *end = element;
+
+                while (*end != ',' && *end != '\0')
+                {
+                    end++;
+                }
+                while (end > element && (end[-1] == ' ' || end[-1] == '\t'))
+                {
+                    end--;
+                }
+                *end = '\0';
+            }
+        }
+    }
+
+    return 0;
 }
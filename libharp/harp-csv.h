@@ -36,11 +36,34 @@
 
 #define HARP_CSV_LINE_LENGTH 4096
 
+typedef enum harp_csv_column_type_enum
+{
+    harp_csv_column_long,       /* column data is a long array */
+    harp_csv_column_double,     /* column data is a double array */
+    harp_csv_column_string      /* column data is a char* array (pointing into the buffer of the csv file) */
+} harp_csv_column_type;
+
+/* In-memory csv file.
+ * The full file content is read in one go and split in place into nul-terminated lines (without end-of-line
+ * characters).
+ */
+typedef struct harp_csv_file_struct
+{
+    char *filename;
+    char *buffer;       /* file content */
+    long num_lines;
+    char **line;        /* pointers to the start of each line in buffer */
+} harp_csv_file;
+
+int harp_csv_file_read(const char *filename, harp_csv_file **new_csv_file);
+void harp_csv_file_delete(harp_csv_file *csv_file);
+int harp_csv_file_parse_columns(harp_csv_file *csv_file, long first_line, int num_columns,
+                                const harp_csv_column_type *column_type, void **column_data);
+
 int harp_csv_parse_double(char **str, double *value);
 int harp_csv_parse_long(char **str, long *value);
 void harp_csv_parse_string(char **str, char **value);
 int harp_csv_parse_variable_name_and_unit(char **str, char **variable_name, char **unit);
-int harp_csv_get_num_lines(FILE *file, const char *filename, long *new_num_lines);
 void harp_csv_rtrim(char *str);
 char *harp_csv_ltrim(char *str);
 
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2015-2018 S[&]T, The Netherlands.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "harp-internal.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The decode kernels below are written such that the loop bodies have no data dependent branches: instead of skipping
+ * invalid values, NaN is selected for them (using a select instead of adding NaN or 0 keeps the sign of a -0.0 result).
+ * This allows compilers to vectorize the loops.
+ * When the target elements are larger than the source elements (integer widening), the array is decoded in place by
+ * processing it from the end in blocks that are first copied to a local buffer.
+ */
+
+#define DECODE_BLOCK_SIZE 256
+
+/* Decode num_block_elements elements from source to target using the (local) variables fill_value, valid_min,
+ * valid_max, scale_factor, add_offset, and nan.
+ */
+#define DECODE_LOOP(target_ctype, source, target, num_block_elements)                                                  \
+    for (i = 0; i < num_block_elements; i++)                                                                           \
+    {                                                                                                                  \
+        double value = (double)source[i];                                                                              \
+        double decoded_value = value * scale_factor + add_offset;                                                      \
+        int valid = (value != fill_value) & (value >= valid_min) & (value <= valid_max);                               \
+                                                                                                                       \
+        target[i] = (target_ctype)(valid ? decoded_value : nan);                                                       \
+    }
+
+#define DECODE_ELEMENTS(source_ctype, source_data, target_ctype, target_data)                                          \
+    {                                                                                                                  \
+        const source_ctype *source = (const source_ctype *)source_data;                                                \
+        target_ctype *target = target_data;                                                                            \
+                                                                                                                       \
+        if (sizeof(target_ctype) > sizeof(source_ctype))                                                               \
+        {                                                                                                              \
+            source_ctype block[DECODE_BLOCK_SIZE];                                                                     \
+            long block_start, block_end, block_length;                                                                 \
+            target_ctype *block_target;                                                                                \
+                                                                                                                       \
+            for (block_end = num_elements; block_end > 0; block_end = block_start)                                     \
+            {                                                                                                          \
+                block_start = block_end > DECODE_BLOCK_SIZE ? block_end - DECODE_BLOCK_SIZE : 0;                       \
+                block_length = block_end - block_start;                                                                \
+                memcpy(block, &source[block_start], block_length * sizeof(source_ctype));                              \
+                block_target = &target[block_start];                                                                   \
+                DECODE_LOOP(target_ctype, block, block_target, block_length);                                          \
+            }                                                                                                          \
+        }                                                                                                              \
+        else                                                                                                           \
+        {                                                                                                              \
+            DECODE_LOOP(target_ctype, source, target, num_elements);                                                   \
+        }                                                                                                              \
+    }
+
+/** Initialize a packing description such that decoding only converts the values to the target type.
+ * \param packing Packing description that should be initialized.
+ */
+void harp_packing_init(harp_packing *packing)
+{
+    packing->is_unsigned = 0;
+    packing->has_fill_value = 0;
+    packing->fill_value = 0;
+    packing->has_valid_min = 0;
+    packing->valid_min = 0;
+    packing->has_valid_max = 0;
+    packing->valid_max = 0;
+    packing->scale_factor = 1;
+    packing->add_offset = 0;
+}
+
+/** Decode packed values in place.
+ * The array should contain \a num_elements values of type \a source_type (interpreted as unsigned integers if
+ * packing->is_unsigned is set) and should be large enough to hold \a num_elements values of type \a target_type.
+ * Each value that equals the fill value or that is outside the valid range (both given in packed units) is set to NaN.
+ * All other values are converted using 'value * scale_factor + add_offset'. Values are converted to double before
+ * the comparison and scaling, so integers (up to 32 bits) are compared exactly.
+ * \param source_type Data type of the packed values.
+ * \param target_type Data type of the decoded values (#harp_type_float or #harp_type_double).
+ * \param num_elements Number of elements in the array.
+ * \param packing Description of the packing of the values.
+ * \param data Array to operate on.
+ */
+void harp_array_decode(harp_data_type source_type, harp_data_type target_type, long num_elements,
+                       const harp_packing *packing, harp_array data)
+{
+    double fill_value, valid_min, valid_max, scale_factor, add_offset, nan;
+    long i;
+
+    assert(target_type == harp_type_float || target_type == harp_type_double);
+
+    nan = harp_nan();
+    /* a NaN fill value (or min/max of -inf/+inf) does not exclude any value, which keeps the kernels branch free */
+    fill_value = packing->has_fill_value ? packing->fill_value : nan;
+    valid_min = packing->has_valid_min ? packing->valid_min : -harp_plusinf();
+    valid_max = packing->has_valid_max ? packing->valid_max : harp_plusinf();
+    scale_factor = packing->scale_factor;
+    add_offset = packing->add_offset;
+    if (add_offset == 0)
+    {
+        /* adding +0.0 would turn a -0.0 value into +0.0, whereas adding -0.0 leaves all values unchanged */
+        add_offset = -0.0;
+    }
+
+    if (target_type == harp_type_float)
+    {
+        switch (source_type)
+        {
+            case harp_type_int8:
+                if (packing->is_unsigned)
+                {
+                    DECODE_ELEMENTS(uint8_t, data.int8_data, float, data.float_data);
+                }
+                else
+                {
+                    DECODE_ELEMENTS(int8_t, data.int8_data, float, data.float_data);
+                }
+                break;
+            case harp_type_int16:
+                if (packing->is_unsigned)
+                {
+                    DECODE_ELEMENTS(uint16_t, data.int16_data, float, data.float_data);
+                }
+                else
+                {
+                    DECODE_ELEMENTS(int16_t, data.int16_data, float, data.float_data);
+                }
+                break;
+            case harp_type_int32:
+                if (packing->is_unsigned)
+                {
+                    DECODE_ELEMENTS(uint32_t, data.int32_data, float, data.float_data);
+                }
+                else
+                {
+                    DECODE_ELEMENTS(int32_t, data.int32_data, float, data.float_data);
+                }
+                break;
+            case harp_type_float:
+                DECODE_ELEMENTS(float, data.float_data, float, data.float_data);
+                break;
+            case harp_type_double:
+                DECODE_ELEMENTS(double, data.double_data, float, data.float_data);
+                break;
+            default:
+                assert(0);
+                exit(1);
+        }
+    }
+    else
+    {
+        switch (source_type)
+        {
+            case harp_type_int8:
+                if (packing->is_unsigned)
+                {
+                    DECODE_ELEMENTS(uint8_t, data.int8_data, double, data.double_data);
+                }
+                else
+                {
+                    DECODE_ELEMENTS(int8_t, data.int8_data, double, data.double_data);
+                }
+                break;
+            case harp_type_int16:
+                if (packing->is_unsigned)
+                {
+                    DECODE_ELEMENTS(uint16_t, data.int16_data, double, data.double_data);
+                }
+                else
+                {
+                    DECODE_ELEMENTS(int16_t, data.int16_data, double, data.double_data);
+                }
+                break;
+            case harp_type_int32:
+                if (packing->is_unsigned)
+                {
+                    DECODE_ELEMENTS(uint32_t, data.int32_data, double, data.double_data);
+                }
+                else
+                {
+                    DECODE_ELEMENTS(int32_t, data.int32_data, double, data.double_data);
+                }
+                break;
+            case harp_type_float:
+                DECODE_ELEMENTS(float, data.float_data, double, data.double_data);
+                break;
+            case harp_type_double:
+                DECODE_ELEMENTS(double, data.double_data, double, data.double_data);
+                break;
+            default:
+                assert(0);
+                exit(1);
+        }
+    }
+}
+
+#undef DECODE_ELEMENTS
+#undef DECODE_LOOP
+#undef DECODE_BLOCK_SIZE
@@ -0,0 +1,444 @@
+/*
+ * Copyright (C) 2015-2018 S[&]T, The Netherlands.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "harp-internal.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Gaps of at most this number of time samples between the time samples of a time selection are read as well (and are
+ * discarded afterwards), such that a selection is read using a small number of contiguous reads.
+ */
+#define MAX_TIME_GAP 32
+
+int harp_deferred_import_new(harp_deferred_import **new_import)
+{
+    harp_deferred_import *import;
+
+    import = (harp_deferred_import *)malloc(sizeof(harp_deferred_import));
+    if (import == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_deferred_import), __FILE__, __LINE__);
+        return -1;
+    }
+    import->file = NULL;
+    import->num_variables = 0;
+    import->variable = NULL;
+    import->variable_id = NULL;
+    import->read_data = NULL;
+    import->read_time_ranges = NULL;
+    import->close = NULL;
+    import->num_time_indices = 0;
+    import->time_index = NULL;
+    import->num_time_ranges = 0;
+    import->time_range_start = NULL;
+    import->time_range_length = NULL;
+
+    *new_import = import;
+    return 0;
+}
+
+/* Closes the file of the deferred import (the variables are owned by the product and are not deleted). */
+void harp_deferred_import_delete(harp_deferred_import *import)
+{
+    if (import == NULL)
+    {
+        return;
+    }
+    if (import->file != NULL)
+    {
+        import->close(import->file);
+    }
+    if (import->variable != NULL)
+    {
+        free(import->variable);
+    }
+    if (import->variable_id != NULL)
+    {
+        free(import->variable_id);
+    }
+    if (import->time_index != NULL)
+    {
+        free(import->time_index);
+    }
+    if (import->time_range_start != NULL)
+    {
+        free(import->time_range_start);
+    }
+    if (import->time_range_length != NULL)
+    {
+        free(import->time_range_length);
+    }
+    free(import);
+}
+
+/* Register a variable (created with harp_variable_new_without_data()) whose data can be read on request. */
+int harp_deferred_import_add_variable(harp_deferred_import *import, harp_variable *variable, int variable_id)
+{
+    if (import->num_variables % BLOCK_SIZE == 0)
+    {
+        harp_variable **new_variable;
+        int *new_variable_id;
+
+        new_variable = (harp_variable **)realloc(import->variable,
+                                                 (import->num_variables + BLOCK_SIZE) * sizeof(harp_variable *));
+        if (new_variable == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (import->num_variables + BLOCK_SIZE) * sizeof(harp_variable *), __FILE__, __LINE__);
+            return -1;
+        }
+        import->variable = new_variable;
+
+        new_variable_id = (int *)realloc(import->variable_id, (import->num_variables + BLOCK_SIZE) * sizeof(int));
+        if (new_variable_id == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (import->num_variables + BLOCK_SIZE) * sizeof(int), __FILE__, __LINE__);
+            return -1;
+        }
+        import->variable_id = new_variable_id;
+    }
+    import->variable[import->num_variables] = variable;
+    import->variable_id[import->num_variables] = variable_id;
+    import->num_variables++;
+
+    return 0;
+}
+
+static int get_variable_index(const harp_deferred_import *import, const harp_variable *variable)
+{
+    int i;
+
+    /* variables are matched by reference, since operations (e.g. rename) may have changed the name */
+    for (i = 0; i < import->num_variables; i++)
+    {
+        if (import->variable[i] == variable)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Read the selected time samples of a time dependent variable (see harp_deferred_import_select_time()). */
+static int read_time_selection(harp_deferred_import *import, int index, harp_variable *variable)
+{
+    long element_size = harp_get_size_for_type(variable->data_type);
+    long block_size;
+    long num_read = 0;
+    harp_array buffer;
+    long i, j, k;
+
+    if (variable->num_elements == 0)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < import->num_time_ranges; i++)
+    {
+        num_read += import->time_range_length[i];
+    }
+    if (num_read == import->num_time_indices)
+    {
+        /* the ranges do not contain any gaps, so the data can be read directly into the variable */
+        return import->read_time_ranges(import->file, import->variable_id[index], variable, import->num_time_ranges,
+                                        import->time_range_start, import->time_range_length, variable->data);
+    }
+
+    block_size = variable->num_elements / variable->dimension[0];
+    buffer.ptr = calloc((size_t)(num_read * block_size), element_size);
+    if (buffer.ptr == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_read * block_size * element_size, __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (import->read_time_ranges(import->file, import->variable_id[index], variable, import->num_time_ranges,
+                                 import->time_range_start, import->time_range_length, buffer) != 0)
+    {
+        free(buffer.ptr);
+        return -1;
+    }
+
+    /* only keep the selected time samples (j is the time sample in the buffer, k the time sample in the variable) */
+    j = 0;
+    k = 0;
+    for (i = 0; i < import->num_time_ranges; i++)
+    {
+        long time_index;
+
+        for (time_index = import->time_range_start[i];
+             time_index < import->time_range_start[i] + import->time_range_length[i]; time_index++)
+        {
+            if (k < import->num_time_indices && import->time_index[k] == time_index)
+            {
+                memcpy(&((char *)variable->data.ptr)[k * block_size * element_size],
+                       &((char *)buffer.ptr)[j * block_size * element_size], block_size * element_size);
+                k++;
+            }
+            else if (variable->data_type == harp_type_string)
+            {
+                long l;
+
+                for (l = j * block_size; l < (j + 1) * block_size; l++)
+                {
+                    if (buffer.string_data[l] != NULL)
+                    {
+                        free(buffer.string_data[l]);
+                    }
+                }
+            }
+            j++;
+        }
+    }
+    assert(k == import->num_time_indices);
+    free(buffer.ptr);
+
+    return 0;
+}
+
+/* Make sure the data of the variable is available.
+ * If the variable is a deferred variable without data, its data is read from the file and loaded is set to 1 (the
+ * data should then be released again with harp_deferred_import_unload_variable()). Otherwise loaded is set to 0.
+ * It is allowed to pass NULL for import, in which case the variable is left untouched.
+ */
+int harp_deferred_import_load_variable(harp_deferred_import *import, harp_variable *variable, int *loaded)
+{
+    harp_memory_subsystem previous_subsystem;
+    int result;
+    int index;
+
+    *loaded = 0;
+    if (import == NULL || variable->data.ptr != NULL)
+    {
+        return 0;
+    }
+
+    index = get_variable_index(import, variable);
+    if (index < 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_VARIABLE, "variable '%s' contains no data (%s:%u)", variable->name,
+                       __FILE__, __LINE__);
+        return -1;
+    }
+
+    /* the data is accounted to the import, even if it is loaded during e.g. an export */
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_import);
+    variable->data.ptr = harp_memory_alloc((size_t)variable->num_elements *
+                                           harp_get_size_for_type(variable->data_type));
+    harp_memory_set_subsystem(previous_subsystem);
+    if (variable->data.ptr == NULL)
+    {
+        return -1;
+    }
+    if (variable->data_type == harp_type_string)
+    {
+        memset(variable->data.ptr, 0, (size_t)variable->num_elements * harp_get_size_for_type(variable->data_type));
+    }
+
+    if (import->time_index != NULL && variable->num_dimensions > 0 &&
+        variable->dimension_type[0] == harp_dimension_time)
+    {
+        result = read_time_selection(import, index, variable);
+    }
+    else
+    {
+        result = import->read_data(import->file, import->variable_id[index], variable);
+    }
+    if (result != 0)
+    {
+        harp_deferred_import_unload_variable(import, variable);
+        return -1;
+    }
+    if (harp_variable_verify(variable) != 0)
+    {
+        harp_deferred_import_unload_variable(import, variable);
+        return -1;
+    }
+    *loaded = 1;
+
+    return 0;
+}
+
+/* Release the data of a deferred variable again (the variable will be left without data). */
+void harp_deferred_import_unload_variable(harp_deferred_import *import, harp_variable *variable)
+{
+    assert(import != NULL && get_variable_index(import, variable) >= 0);
+
+    if (variable->data.ptr == NULL)
+    {
+        return;
+    }
+    if (variable->data_type == harp_type_string)
+    {
+        long i;
+
+        for (i = 0; i < variable->num_elements; i++)
+        {
+            harp_variable_free_string(variable, variable->data.string_data[i]);
+        }
+    }
+    harp_memory_free(variable->data.ptr);
+    variable->data.ptr = NULL;
+    harp_variable_set_string_block(variable, NULL);
+}
+
+/* Only read the given time samples of time dependent variables of the product of the import.
+ * The time indices should be sorted, unique, and refer to time samples in the file. Time dependent variables that
+ * were already read are filtered directly, for the other variables the time dimension is reduced to the selected
+ * samples, which will be read (using a small number of contiguous reads) once their data is loaded.
+ * The time selection can only be set once and requires a format specific read_time_ranges function.
+ */
+int harp_deferred_import_select_time(harp_deferred_import *import, harp_product *product, long num_indices,
+                                     const long *index)
+{
+    long num_time = product->dimension[harp_dimension_time];
+    uint8_t *mask;
+    long i, j;
+
+    if (import->read_time_ranges == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "time selection is not supported for this format (%s:%u)",
+                       __FILE__, __LINE__);
+        return -1;
+    }
+    if (import->time_index != NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "time selection was already set (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (num_indices <= 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "invalid number of time indices (%ld) (%s:%u)", num_indices,
+                       __FILE__, __LINE__);
+        return -1;
+    }
+    for (i = 0; i < num_indices; i++)
+    {
+        if (index[i] < 0 || index[i] >= num_time || (i > 0 && index[i] <= index[i - 1]))
+        {
+            harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "time indices should be sorted, unique, and in the range "
+                           "[0,%ld) (%s:%u)", num_time, __FILE__, __LINE__);
+            return -1;
+        }
+    }
+
+    import->time_index = (long *)malloc(num_indices * sizeof(long));
+    if (import->time_index == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_indices * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    memcpy(import->time_index, index, num_indices * sizeof(long));
+    import->num_time_indices = num_indices;
+
+    /* merge time indices into ranges of consecutive time samples (including small gaps) */
+    import->num_time_ranges = 1;
+    for (i = 1; i < num_indices; i++)
+    {
+        if (index[i] - index[i - 1] - 1 > MAX_TIME_GAP)
+        {
+            import->num_time_ranges++;
+        }
+    }
+    import->time_range_start = (long *)malloc(import->num_time_ranges * sizeof(long));
+    if (import->time_range_start == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       import->num_time_ranges * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    import->time_range_length = (long *)malloc(import->num_time_ranges * sizeof(long));
+    if (import->time_range_length == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       import->num_time_ranges * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    j = 0;
+    import->time_range_start[0] = index[0];
+    for (i = 1; i < num_indices; i++)
+    {
+        if (index[i] - index[i - 1] - 1 > MAX_TIME_GAP)
+        {
+            import->time_range_length[j] = index[i - 1] + 1 - import->time_range_start[j];
+            j++;
+            import->time_range_start[j] = index[i];
+        }
+    }
+    import->time_range_length[j] = index[num_indices - 1] + 1 - import->time_range_start[j];
+
+    mask = (uint8_t *)calloc(num_time, sizeof(uint8_t));
+    if (mask == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_time * sizeof(uint8_t), __FILE__, __LINE__);
+        return -1;
+    }
+    for (i = 0; i < num_indices; i++)
+    {
+        mask[index[i]] = 1;
+    }
+
+    for (i = 0; i < product->num_variables; i++)
+    {
+        harp_variable *variable = product->variable[i];
+
+        if (variable->num_dimensions == 0 || variable->dimension_type[0] != harp_dimension_time)
+        {
+            continue;
+        }
+        if (variable->data.ptr != NULL)
+        {
+            if (harp_variable_filter_dimension(variable, 0, mask) != 0)
+            {
+                free(mask);
+                return -1;
+            }
+        }
+        else
+        {
+            variable->dimension[0] = num_indices;
+            variable->num_elements = harp_get_num_elements(variable->num_dimensions, variable->dimension);
+        }
+    }
+    product->dimension[harp_dimension_time] = num_indices;
+
+    free(mask);
+
+    return 0;
+}
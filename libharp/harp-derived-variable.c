@@ -570,6 +570,74 @@ static int find_and_execute_conversion(conversion_info *info)
     return -1;
 }
 
+/* same search as find_and_execute_conversion(), but only determines the conversion */
+static int find_conversion(conversion_info *info)
+{
+    int index;
+
+    index = hashtable_get_index_from_name(harp_derived_variable_conversions->hash_data, info->dimsvar_name);
+    if (index >= 0)
+    {
+        harp_variable_conversion_list *conversion_list =
+            harp_derived_variable_conversions->conversions_for_variable[index];
+        int i;
+
+        for (i = 0; i < conversion_list->num_conversions; i++)
+        {
+            harp_variable_conversion *conversion = conversion_list->conversion[i];
+            int j;
+
+            if (conversion->enabled != NULL && !conversion->enabled())
+            {
+                continue;
+            }
+            if (info->skip[index])
+            {
+                continue;
+            }
+
+            /* check if conversion has the right dimensions */
+            if (conversion->num_dimensions != info->num_dimensions)
+            {
+                continue;
+            }
+            for (j = 0; j < conversion->num_dimensions; j++)
+            {
+                if (conversion->dimension_type[j] != info->dimension_type[j])
+                {
+                    break;
+                }
+            }
+            if (j < conversion->num_dimensions)
+            {
+                continue;
+            }
+
+            info->skip[index] = 1;
+
+            for (j = 0; j < conversion->num_source_variables; j++)
+            {
+                if (find_source_variables(info, &conversion->source_definition[j]) != 0)
+                {
+                    /* source not found */
+                    break;
+                }
+            }
+
+            info->skip[index] = 0;
+
+            if (j == conversion->num_source_variables)
+            {
+                info->conversion = conversion;
+                return 0;
+            }
+        }
+    }
+
+    set_variable_not_found_error(info);
+    return -1;
+}
+
 static void print_conversion(conversion_info *info, int (*print) (const char *, ...));
 
 static int find_and_print_conversion(conversion_info *info, int (*print) (const char *, ...))
@@ -1145,6 +1213,7 @@ LIBHARP_API int harp_product_get_derived_variable(const harp_product *product, c
                                                   const harp_dimension_type *dimension_type, harp_variable **variable)
 {
     conversion_info info;
+    double trace_start;
 
     if (name == NULL)
     {
@@ -1191,6 +1260,7 @@ LIBHARP_API int harp_product_get_derived_variable(const harp_product *product, c
         }
     }
 
+    trace_start = harp_trace_begin();
     if (conversion_info_init_with_variable(&info, product, name, num_dimensions, dimension_type) != 0)
     {
         return -1;
@@ -1221,6 +1291,7 @@ LIBHARP_API int harp_product_get_derived_variable(const harp_product *product, c
             }
         }
     }
+    harp_trace_end_variable(trace_start, "derived_variable", "derive_variable", info.variable);
 
     *variable = info.variable;
     info.variable = NULL;
@@ -1230,6 +1301,48 @@ LIBHARP_API int harp_product_get_derived_variable(const harp_product *product, c
     return 0;
 }
 
+/* Determine the data type of the variable that harp_product_get_derived_variable() would return (without data type
+ * and unit arguments), without performing any conversion. The data of the variables in the product is not accessed, so
+ * the product can consist of variables without data. Returns -1 if the variable can not be derived.
+ */
+int harp_product_get_derived_variable_data_type(const harp_product *product, const char *name, int num_dimensions,
+                                                const harp_dimension_type *dimension_type, harp_data_type *data_type)
+{
+    conversion_info info;
+    harp_variable *variable;
+
+    if (harp_product_get_variable_by_name(product, name, &variable) == 0)
+    {
+        if (harp_variable_has_dimension_types(variable, num_dimensions, dimension_type))
+        {
+            *data_type = variable->data_type;
+            return 0;
+        }
+    }
+
+    if (harp_derived_variable_conversions == NULL)
+    {
+        if (harp_derived_variable_list_init() != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (conversion_info_init_with_variable(&info, product, name, num_dimensions, dimension_type) != 0)
+    {
+        return -1;
+    }
+    if (find_conversion(&info) != 0)
+    {
+        conversion_info_done(&info);
+        return -1;
+    }
+    *data_type = info.conversion->data_type;
+    conversion_info_done(&info);
+
+    return 0;
+}
+
 /** Create a derived variable and add it to the product.
  * \ingroup harp_product
  * If a similar named variable with the right dimensions was already in the product then that variable
@@ -35,15 +35,15 @@
 #include <stdlib.h>
 #include <string.h>
 
-static void free_string_data(char **first, char **last)
+/* The variable is the owner of the strings (or NULL if the strings are not owned by a variable). Strings that are part
+ * of the string block of the variable are not freed (the elements are only set to NULL).
+ */
+static void free_string_data(const harp_variable *variable, char **first, char **last)
 {
     for (; first != last; first++)
     {
-        if (*first != NULL)
-        {
-            free(*first);
-            *first = NULL;
-        }
+        harp_variable_free_string(variable, *first);
+        *first = NULL;
     }
 }
 
@@ -161,7 +161,7 @@ static void filter_array_double(long num_source_elements, const uint8_t *mask, c
 }
 
 static void filter_array_string(long num_source_elements, const uint8_t *mask, char **source,
-                                long num_target_elements, char **target)
+                                long num_target_elements, char **target, const harp_variable *variable)
 {
     char **source_end;
     char **target_end;
@@ -173,10 +173,7 @@ static void filter_array_string(long num_source_elements, const uint8_t *mask, c
         {
             if (target != source)
             {
-                if (*target != NULL)
-                {
-                    free(*target);
-                }
+                harp_variable_free_string(variable, *target);
 
                 *target = *source;
                 *source = NULL;
@@ -187,11 +184,11 @@ static void filter_array_string(long num_source_elements, const uint8_t *mask, c
         }
     }
 
-    free_string_data(target, target_end);
+    free_string_data(variable, target, target_end);
 }
 
 static void filter_array(harp_data_type data_type, long num_source_elements, const uint8_t *mask, harp_array source,
-                         long num_target_elements, harp_array target)
+                         long num_target_elements, harp_array target, const harp_variable *variable)
 {
     if (mask == NULL)
     {
@@ -201,7 +198,7 @@ static void filter_array(harp_data_type data_type, long num_source_elements, con
         {
             if (data_type == harp_type_string)
             {
-                free_string_data(target.string_data, target.string_data + num_target_elements);
+                free_string_data(variable, target.string_data, target.string_data + num_target_elements);
             }
 
             memcpy(target.ptr, source.ptr, num_target_elements * harp_get_size_for_type(data_type));
@@ -237,7 +234,7 @@ static void filter_array(harp_data_type data_type, long num_source_elements, con
                 break;
             case harp_type_string:
                 filter_array_string(num_source_elements, mask, source.string_data, num_target_elements,
-                                    target.string_data);
+                                    target.string_data, variable);
                 break;
             default:
                 assert(0);
@@ -246,21 +243,9 @@ static void filter_array(harp_data_type data_type, long num_source_elements, con
     }
 }
 
-/**
- * Filter the source array by copying elements to the target array for which the corresponding entry in the source mask
- * evaluates to true. The length of the source array is allowed to be larger than the length of the target array, as
- * long as the total number of elements that will be copied is smaller than or equal to the length of the target array.
- * \param data_type           Data type of source and target arrays
- * \param num_dimensions      Number of dimensions of source and target arrays
- * \param source_dimension    Dimension length for each source dimension
- * \param source_mask         Source mask; If NULL, all elements from the source array will be copied. Otherwise, the
- *     mask should have the same length as the source array.
- * \param source              Source array.
- * \param target_dimension    Resulting dimension length for each target dimension
- * \param target              Target array.
- */
-void harp_array_filter(harp_data_type data_type, int num_dimensions, const long *source_dimension,
-                       const uint8_t **source_mask, harp_array source, const long *target_dimension, harp_array target)
+static void array_filter(harp_data_type data_type, int num_dimensions, const long *source_dimension,
+                         const uint8_t **source_mask, harp_array source, const long *target_dimension,
+                         harp_array target, const harp_variable *variable)
 {
     long data_type_size;
     long source_stride[HARP_MAX_NUM_DIMS];
@@ -273,14 +258,14 @@ void harp_array_filter(harp_data_type data_type, int num_dimensions, const long
     /* Special case for scalars. */
     if (num_dimensions == 0)
     {
-        filter_array(data_type, 1, NULL, source, 1, target);
+        filter_array(data_type, 1, NULL, source, 1, target, variable);
         return;
     }
 
     if (num_dimensions == 1)
     {
         /* Special case for 1-D arrays. */
-        filter_array(data_type, *source_dimension, *source_mask, source, *target_dimension, target);
+        filter_array(data_type, *source_dimension, *source_mask, source, *target_dimension, target, variable);
         return;
     }
 
@@ -324,7 +309,16 @@ void harp_array_filter(harp_data_type data_type, int num_dimensions, const long
 
                 if (num_blocks > 0)
                 {
-                    harp_array_null(data_type, num_blocks * target_stride[dimension_index] / data_type_size, target);
+                    if (data_type == harp_type_string)
+                    {
+                        free_string_data(variable, target.string_data, target.string_data +
+                                         num_blocks * target_stride[dimension_index] / data_type_size);
+                    }
+                    else
+                    {
+                        harp_array_null(data_type, num_blocks * target_stride[dimension_index] / data_type_size,
+                                        target);
+                    }
                     target.ptr = (void *)(((char *)target.ptr) + num_blocks * target_stride[dimension_index]);
                 }
 
@@ -347,7 +341,7 @@ void harp_array_filter(harp_data_type data_type, int num_dimensions, const long
         {
             /* Filter the fastest running dimension. */
             filter_array(data_type, source_dimension[dimension_index], source_mask[dimension_index], source,
-                         target_dimension[dimension_index], target);
+                         target_dimension[dimension_index], target, variable);
 
             /* Move to the next index on the previous dimension. */
             source_index[dimension_index] = 0;
@@ -362,6 +356,25 @@ void harp_array_filter(harp_data_type data_type, int num_dimensions, const long
     }
 }
 
+/**
+ * Filter the source array by copying elements to the target array for which the corresponding entry in the source mask
+ * evaluates to true. The length of the source array is allowed to be larger than the length of the target array, as
+ * long as the total number of elements that will be copied is smaller than or equal to the length of the target array.
+ * \param data_type           Data type of source and target arrays
+ * \param num_dimensions      Number of dimensions of source and target arrays
+ * \param source_dimension    Dimension length for each source dimension
+ * \param source_mask         Source mask; If NULL, all elements from the source array will be copied. Otherwise, the
+ *     mask should have the same length as the source array.
+ * \param source              Source array.
+ * \param target_dimension    Resulting dimension length for each target dimension
+ * \param target              Target array.
+ */
+void harp_array_filter(harp_data_type data_type, int num_dimensions, const long *source_dimension,
+                       const uint8_t **source_mask, harp_array source, const long *target_dimension, harp_array target)
+{
+    array_filter(data_type, num_dimensions, source_dimension, source_mask, source, target_dimension, target, NULL);
+}
+
 int harp_variable_filter(harp_variable *variable, const harp_dimension_mask_set *dimension_mask_set)
 {
     const uint8_t *mask[HARP_MAX_NUM_DIMS] = { 0 };
@@ -444,8 +457,8 @@ int harp_variable_filter(harp_variable *variable, const harp_dimension_mask_set
 
     if (!has_2D_masks)
     {
-        harp_array_filter(variable->data_type, variable->num_dimensions, variable->dimension, mask, variable->data,
-                          new_dimension, variable->data);
+        array_filter(variable->data_type, variable->num_dimensions, variable->dimension, mask, variable->data,
+                     new_dimension, variable->data, variable);
     }
     else
     {
@@ -495,8 +508,8 @@ int harp_variable_filter(harp_variable *variable, const harp_dimension_mask_set
         {
             if (mask[0] == NULL || *mask[0])
             {
-                harp_array_filter(variable->data_type, variable->num_dimensions - 1, &variable->dimension[1], &mask[1],
-                                  source, &new_dimension[1], target);
+                array_filter(variable->data_type, variable->num_dimensions - 1, &variable->dimension[1], &mask[1],
+                             source, &new_dimension[1], target, variable);
 
                 target.ptr = (void *)(((char *)target.ptr) + target_stride);
             }
@@ -516,7 +529,7 @@ int harp_variable_filter(harp_variable *variable, const harp_dimension_mask_set
     /* Free any remaining string data. */
     if (variable->data_type == harp_type_string)
     {
-        free_string_data(variable->data.string_data + new_num_elements,
+        free_string_data(variable, variable->data.string_data + new_num_elements,
                          variable->data.string_data + variable->num_elements);
     }
 
@@ -525,11 +538,10 @@ int harp_variable_filter(harp_variable *variable, const harp_dimension_mask_set
     {
         void *new_data;
 
-        new_data = realloc(variable->data.ptr, new_num_elements * harp_get_size_for_type(variable->data_type));
+        new_data = harp_memory_realloc(variable->data.ptr,
+                                       new_num_elements * harp_get_size_for_type(variable->data_type));
         if (new_data == NULL)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %u bytes) (%s:%u)",
-                           new_num_elements * harp_get_size_for_type(variable->data_type), __FILE__, __LINE__);
             return -1;
         }
         variable->data.ptr = new_data;
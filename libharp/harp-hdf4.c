@@ -389,7 +389,37 @@ static int read_dimensions(int32 sds_id, int *num_dimensions, hdf4_dimension_typ
     return 0;
 }
 
-static int read_variable(harp_product *product, int32 sds_id)
+/* Read the data of a numeric variable. */
+static int read_numeric_variable_data(int32 sds_id, harp_variable *variable)
+{
+    char hdf4_name[MAX_HDF4_NAME_LENGTH + 1];
+    int32 hdf4_dimension[MAX_HDF4_VAR_DIMS];
+    int32 hdf4_start[MAX_HDF4_VAR_DIMS] = { 0 };
+    int32 hdf4_data_type;
+    int32 hdf4_num_dimensions;
+    int32 hdf4_dont_care;
+
+    assert(variable->data_type != harp_type_string);
+
+    if (SDgetinfo(sds_id, hdf4_name, &hdf4_num_dimensions, hdf4_dimension, &hdf4_data_type, &hdf4_dont_care) != 0)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
+    }
+
+    if (SDreaddata(sds_id, hdf4_start, NULL, hdf4_dimension, variable->data.ptr) != 0)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Read the definition and attributes of a variable. If import is not NULL numeric variables are created without data
+ * and their data will only be read on request.
+ */
+static int read_variable(harp_product *product, int32 sds_id, int32 sds_index, harp_deferred_import *import)
 {
     char hdf4_name[MAX_HDF4_NAME_LENGTH + 1];
     int32 hdf4_dimension[MAX_HDF4_VAR_DIMS];
@@ -501,7 +531,15 @@ static int read_variable(harp_product *product, int32 sds_id)
     }
 
     /* Create HARP variable. */
-    if (harp_variable_new(hdf4_name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
+    if (import != NULL && data_type != harp_type_string)
+    {
+        if (harp_variable_new_without_data(hdf4_name, data_type, num_dimensions, dimension_type, dimension,
+                                           &variable) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (harp_variable_new(hdf4_name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
     {
         return -1;
     }
@@ -513,51 +551,39 @@ static int read_variable(harp_product *product, int32 sds_id)
     }
 
     /* Read data. */
-    if (data_type == harp_type_string)
+    if (variable->data.ptr == NULL)
+    {
+        if (harp_deferred_import_add_variable(import, variable, (int)sds_index) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (data_type == harp_type_string)
     {
         char *buffer = NULL;
         long length = hdf4_dimension[hdf4_num_dimensions - 1];
 
-        buffer = malloc(variable->num_elements * length * sizeof(char));
+        /* the strings are read directly into a single block of memory (the string block of the variable) */
+        buffer = harp_string_block_new(variable->num_elements, length);
         if (buffer == NULL)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                           variable->num_elements * length * sizeof(char), __FILE__, __LINE__);
             return -1;
         }
 
         if (SDreaddata(sds_id, hdf4_start, NULL, hdf4_dimension, buffer) != 0)
         {
             harp_set_error(HARP_ERROR_HDF4, NULL);
-            free(buffer);
+            harp_memory_free(buffer);
             return -1;
         }
 
-        for (i = 0; i < variable->num_elements; i++)
-        {
-            char *str;
-
-            str = malloc((length + 1) * sizeof(char));
-            if (str == NULL)
-            {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               (length + 1) * sizeof(char), __FILE__, __LINE__);
-                free(buffer);
-                return -1;
-            }
-
-            memcpy(str, &buffer[i * length], length);
-            str[length] = '\0';
-            variable->data.string_data[i] = str;
-        }
-
-        free(buffer);
+        harp_string_block_distribute(buffer, variable->num_elements, length, variable->data.string_data);
+        harp_variable_set_string_block(variable, buffer);
     }
     else
     {
-        if (SDreaddata(sds_id, hdf4_start, NULL, hdf4_dimension, variable->data.ptr) != 0)
+        if (read_numeric_variable_data(sds_id, variable) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF4, NULL);
             return -1;
         }
     }
@@ -643,7 +669,7 @@ static int read_variable(harp_product *product, int32 sds_id)
     return 0;
 }
 
-static int read_product(harp_product *product, int32 sd_id)
+static int read_product(harp_product *product, int32 sd_id, harp_deferred_import *import)
 {
     int32 num_sds;
     int32 hdf4_num_attributes;
@@ -668,7 +694,7 @@ static int read_product(harp_product *product, int32 sd_id)
             return -1;
         }
 
-        if (read_variable(product, sds_id) != 0)
+        if (read_variable(product, sds_id, i, import) != 0)
         {
             SDendaccess(sds_id);
             return -1;
@@ -756,7 +782,7 @@ int harp_import_hdf4(const char *filename, harp_product **product)
         return -1;
     }
 
-    if (read_product(new_product, sd_id) != 0)
+    if (read_product(new_product, sd_id, NULL) != 0)
     {
         harp_add_error_message(" (%s)", filename);
         harp_product_delete(new_product);
@@ -770,6 +796,113 @@ int harp_import_hdf4(const char *filename, harp_product **product)
     return 0;
 }
 
+/* File information of a deferred import (see harp_import_deferred_hdf4()). */
+typedef struct hdf4_deferred_file_struct
+{
+    int32 sd_id;
+} hdf4_deferred_file;
+
+static int deferred_read_data(void *file, int variable_id, harp_variable *variable)
+{
+    hdf4_deferred_file *hdf4_file = (hdf4_deferred_file *)file;
+    int32 sds_id;
+
+    sds_id = SDselect(hdf4_file->sd_id, variable_id);
+    if (sds_id == -1)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
+    }
+
+    if (read_numeric_variable_data(sds_id, variable) != 0)
+    {
+        SDendaccess(sds_id);
+        return -1;
+    }
+
+    SDendaccess(sds_id);
+
+    return 0;
+}
+
+static int deferred_close(void *file)
+{
+    hdf4_deferred_file *hdf4_file = (hdf4_deferred_file *)file;
+    int result;
+
+    result = SDend(hdf4_file->sd_id);
+    free(hdf4_file);
+
+    if (result != 0)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Import the variables of a HARP HDF4 product without reading the data of numeric variables.
+ * The file is kept open until the deferred import is deleted.
+ */
+int harp_import_deferred_hdf4(const char *filename, harp_product **product, harp_deferred_import **import)
+{
+    harp_deferred_import *new_import;
+    harp_product *new_product;
+    hdf4_deferred_file *hdf4_file;
+
+    hdf4_file = (hdf4_deferred_file *)malloc(sizeof(hdf4_deferred_file));
+    if (hdf4_file == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(hdf4_deferred_file), __FILE__, __LINE__);
+        return -1;
+    }
+
+    hdf4_file->sd_id = SDstart(filename, DFACC_READ);
+    if (hdf4_file->sd_id == -1)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        harp_add_error_message(" (%s)", filename);
+        free(hdf4_file);
+        return -1;
+    }
+
+    if (verify_product(hdf4_file->sd_id) != 0)
+    {
+        SDend(hdf4_file->sd_id);
+        free(hdf4_file);
+        return -1;
+    }
+
+    if (harp_deferred_import_new(&new_import) != 0)
+    {
+        deferred_close(hdf4_file);
+        return -1;
+    }
+    new_import->file = hdf4_file;
+    new_import->read_data = deferred_read_data;
+    new_import->close = deferred_close;
+
+    if (harp_product_new(&new_product) != 0)
+    {
+        harp_deferred_import_delete(new_import);
+        return -1;
+    }
+
+    if (read_product(new_product, hdf4_file->sd_id, new_import) != 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        harp_product_delete(new_product);
+        harp_deferred_import_delete(new_import);
+        return -1;
+    }
+
+    *product = new_product;
+    *import = new_import;
+    return 0;
+}
+
 static int update_dimensions_with_variable(long dimension[], int32 sds_id)
 {
     char hdf4_name[MAX_HDF4_NAME_LENGTH + 1];
@@ -1099,12 +1232,14 @@ static int write_dimensions(int32 sds_id, int num_dimensions, const hdf4_dimensi
     return 0;
 }
 
-static int write_variable(harp_variable *variable, int32 sd_id)
+/* Create the SDS for a variable (without writing its data).
+ * For string variables, string_length is the length of the (additional) string dimension.
+ * On success, the SDS is left open and should be closed by the caller using SDendaccess().
+ */
+static int create_variable(const harp_variable *variable, int32 sd_id, long string_length, int32 *sds_id)
 {
     hdf4_dimension_type dimension_type[MAX_HDF4_VAR_DIMS];
     int32 dimension[MAX_HDF4_VAR_DIMS];
-    int32 start[MAX_HDF4_VAR_DIMS] = { 0 };
-    int32 sds_id;
     int32 num_dimensions;
     int i;
 
@@ -1124,73 +1259,37 @@ static int write_variable(harp_variable *variable, int32 sd_id)
         num_dimensions = variable->num_dimensions;
     }
 
-    /* Write data. */
     if (variable->data_type == harp_type_string)
     {
-        char *buffer;
-        long length;
-
-        if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data, 1, &length,
-                                                  &buffer) != 0)
-        {
-            return -1;
-        }
-
-        /* Add an additional dimension with a length equal to the length of the longest string, or 1 if the longest
-         * string is of length zero.
-         */
         dimension_type[num_dimensions] = hdf4_dimension_string;
-        dimension[num_dimensions] = length;
+        dimension[num_dimensions] = string_length;
         num_dimensions++;
 
-        sds_id = SDcreate(sd_id, variable->name, DFNT_CHAR, num_dimensions, dimension);
-        if (sds_id == -1)
-        {
-            harp_set_error(HARP_ERROR_HDF4, NULL);
-            free(buffer);
-            return -1;
-        }
-
-        if (SDwritedata(sds_id, start, NULL, dimension, buffer) != 0)
-        {
-            harp_set_error(HARP_ERROR_HDF4, NULL);
-            SDendaccess(sds_id);
-            free(buffer);
-            return -1;
-        }
-
-        free(buffer);
+        *sds_id = SDcreate(sd_id, variable->name, DFNT_CHAR, num_dimensions, dimension);
     }
     else
     {
-        sds_id = SDcreate(sd_id, variable->name, get_hdf4_type(variable->data_type), num_dimensions, dimension);
-        if (sds_id == -1)
-        {
-            harp_set_error(HARP_ERROR_HDF4, NULL);
-            return -1;
-        }
-
-        if (SDwritedata(sds_id, start, NULL, dimension, variable->data.ptr) != 0)
-        {
-            harp_set_error(HARP_ERROR_HDF4, NULL);
-            SDendaccess(sds_id);
-            return -1;
-        }
+        *sds_id = SDcreate(sd_id, variable->name, get_hdf4_type(variable->data_type), num_dimensions, dimension);
+    }
+    if (*sds_id == -1)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
     }
 
     /* Write dimensions. */
-    if (write_dimensions(sds_id, num_dimensions, dimension_type) != 0)
+    if (write_dimensions(*sds_id, num_dimensions, dimension_type) != 0)
     {
-        SDendaccess(sds_id);
+        SDendaccess(*sds_id);
         return -1;
     }
 
     /* Write attributes. */
     if (variable->description != NULL && strcmp(variable->description, "") != 0)
     {
-        if (write_string_attribute(sds_id, "description", variable->description) != 0)
+        if (write_string_attribute(*sds_id, "description", variable->description) != 0)
         {
-            SDendaccess(sds_id);
+            SDendaccess(*sds_id);
             return -1;
         }
     }
@@ -1199,9 +1298,9 @@ static int write_variable(harp_variable *variable, int32 sd_id)
     {
         const char *unit = variable->unit[0] == '\0' ? "1" : variable->unit;    /* convert "" to "1" */
 
-        if (write_string_attribute(sds_id, "units", unit) != 0)
+        if (write_string_attribute(*sds_id, "units", unit) != 0)
         {
-            SDendaccess(sds_id);
+            SDendaccess(*sds_id);
             return -1;
         }
     }
@@ -1210,18 +1309,18 @@ static int write_variable(harp_variable *variable, int32 sd_id)
     {
         if (!harp_is_valid_min_for_type(variable->data_type, variable->valid_min))
         {
-            if (write_numeric_attribute(sds_id, "valid_min", variable->data_type, variable->valid_min) != 0)
+            if (write_numeric_attribute(*sds_id, "valid_min", variable->data_type, variable->valid_min) != 0)
             {
-                SDendaccess(sds_id);
+                SDendaccess(*sds_id);
                 return -1;
             }
         }
 
         if (!harp_is_valid_max_for_type(variable->data_type, variable->valid_max))
         {
-            if (write_numeric_attribute(sds_id, "valid_max", variable->data_type, variable->valid_max) != 0)
+            if (write_numeric_attribute(*sds_id, "valid_max", variable->data_type, variable->valid_max) != 0)
             {
-                SDendaccess(sds_id);
+                SDendaccess(*sds_id);
                 return -1;
             }
         }
@@ -1233,33 +1332,128 @@ static int write_variable(harp_variable *variable, int32 sd_id)
 
         if (harp_variable_get_flag_values_string(variable, &attribute_value) != 0)
         {
+            SDendaccess(*sds_id);
             return -1;
         }
-        if (write_string_attribute(sds_id, "flag_values", attribute_value) != 0)
+        if (write_string_attribute(*sds_id, "flag_values", attribute_value) != 0)
         {
             free(attribute_value);
+            SDendaccess(*sds_id);
             return -1;
         }
         free(attribute_value);
 
         if (harp_variable_get_flag_meanings_string(variable, &attribute_value) != 0)
         {
+            SDendaccess(*sds_id);
             return -1;
         }
-        if (write_string_attribute(sds_id, "flag_meanings", attribute_value) != 0)
+        if (write_string_attribute(*sds_id, "flag_meanings", attribute_value) != 0)
         {
             free(attribute_value);
+            SDendaccess(*sds_id);
             return -1;
         }
         free(attribute_value);
     }
 
+    return 0;
+}
+
+/* Write the data of a variable to an SDS, starting at the given offset in the first dimension.
+ * For string variables, the strings are padded to the length (string_length) of the string dimension of the SDS.
+ */
+static int write_variable_data(int32 sds_id, const harp_variable *variable, long offset, long string_length)
+{
+    int32 start[MAX_HDF4_VAR_DIMS] = { 0 };
+    int32 edges[MAX_HDF4_VAR_DIMS];
+    int32 num_dimensions;
+    int i;
+
+    if (variable->num_dimensions == 0)
+    {
+        edges[0] = 1;
+        num_dimensions = 1;
+    }
+    else
+    {
+        for (i = 0; i < variable->num_dimensions; i++)
+        {
+            edges[i] = variable->dimension[i];
+        }
+        num_dimensions = variable->num_dimensions;
+    }
+    start[0] = offset;
+
+    if (variable->data_type == harp_type_string)
+    {
+        char *buffer;
+        long length;
+
+        if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data, string_length,
+                                                  &length, &buffer) != 0)
+        {
+            return -1;
+        }
+        assert(length == string_length);
+
+        edges[num_dimensions] = length;
+
+        if (SDwritedata(sds_id, start, NULL, edges, buffer) != 0)
+        {
+            harp_set_error(HARP_ERROR_HDF4, NULL);
+            free(buffer);
+            return -1;
+        }
+
+        free(buffer);
+    }
+    else
+    {
+        if (SDwritedata(sds_id, start, NULL, edges, variable->data.ptr) != 0)
+        {
+            harp_set_error(HARP_ERROR_HDF4, NULL);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int write_variable(harp_variable *variable, int32 sd_id)
+{
+    long string_length = 0;
+    int32 sds_id;
+
+    if (variable->data_type == harp_type_string)
+    {
+        /* The length of the string dimension equals the length of the longest string, or 1 if the longest string is
+         * of length zero.
+         */
+        string_length = harp_get_max_string_length(variable->num_elements, variable->data.string_data);
+        if (string_length == 0)
+        {
+            string_length = 1;
+        }
+    }
+
+    if (create_variable(variable, sd_id, string_length, &sds_id) != 0)
+    {
+        return -1;
+    }
+
+    if (write_variable_data(sds_id, variable, 0, string_length) != 0)
+    {
+        SDendaccess(sds_id);
+        return -1;
+    }
+
     SDendaccess(sds_id);
 
     return 0;
 }
 
-static int write_product(const harp_product *product, int32 sd_id)
+static int write_product(const harp_product *product, int32 sd_id, harp_deferred_import *import)
 {
     harp_scalar datetime_start;
     harp_scalar datetime_stop;
@@ -1304,16 +1498,35 @@ static int write_product(const harp_product *product, int32 sd_id)
     /* Write variables. */
     for (i = 0; i < product->num_variables; i++)
     {
-        if (write_variable(product->variable[i], sd_id) != 0)
+        double trace_start = harp_trace_begin();
+        int loaded;
+        int result;
+
+        /* the data of deferred variables is only kept in memory while the variable is being written */
+        if (harp_deferred_import_load_variable(import, product->variable[i], &loaded) != 0)
+        {
+            return -1;
+        }
+        result = write_variable(product->variable[i], sd_id);
+        if (loaded)
+        {
+            harp_deferred_import_unload_variable(import, product->variable[i]);
+        }
+        if (result != 0)
         {
             return -1;
         }
+        harp_trace_end_variable(trace_start, "export", "write_variable", product->variable[i]);
     }
 
     return 0;
 }
 
-int harp_export_hdf4(const char *filename, const harp_product *product)
+/* Export a product to a HARP HDF4 file.
+ * If import is not NULL, the product may contain deferred variables of that import, whose data will be read (and
+ * released again) one variable at a time.
+ */
+int harp_export_hdf4(const char *filename, const harp_product *product, harp_deferred_import *import)
 {
     int32 sd_id;
 
@@ -1337,7 +1550,7 @@ int harp_export_hdf4(const char *filename, const harp_product *product)
         return -1;
     }
 
-    if (write_product(product, sd_id) != 0)
+    if (write_product(product, sd_id, import) != 0)
     {
         harp_add_error_message(" (%s)", filename);
         SDend(sd_id);
@@ -1354,6 +1567,181 @@ int harp_export_hdf4(const char *filename, const harp_product *product)
     return 0;
 }
 
+typedef struct hdf4_writer_file_struct
+{
+    int32 sd_id;
+    const long *string_length;
+} hdf4_writer_file;
+
+static int writer_write_data(void *file, int variable_index, const harp_variable *variable, long time_offset)
+{
+    hdf4_writer_file *hdf4_file = (hdf4_writer_file *)file;
+    int32 sds_index;
+    int32 sds_id;
+
+    sds_index = SDnametoindex(hdf4_file->sd_id, variable->name);
+    if (sds_index == -1)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
+    }
+
+    sds_id = SDselect(hdf4_file->sd_id, sds_index);
+    if (sds_id == -1)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        return -1;
+    }
+
+    if (write_variable_data(sds_id, variable, time_offset, hdf4_file->string_length[variable_index]) != 0)
+    {
+        SDendaccess(sds_id);
+        return -1;
+    }
+
+    SDendaccess(sds_id);
+
+    return 0;
+}
+
+static int writer_write_datetime_range(void *file, int has_datetime_range, double datetime_start,
+                                       double datetime_stop)
+{
+    hdf4_writer_file *hdf4_file = (hdf4_writer_file *)file;
+    harp_scalar value;
+
+    if (!has_datetime_range)
+    {
+        return 0;
+    }
+
+    value.double_data = datetime_start;
+    if (write_numeric_attribute(hdf4_file->sd_id, "datetime_start", harp_type_double, value) != 0)
+    {
+        return -1;
+    }
+    value.double_data = datetime_stop;
+    if (write_numeric_attribute(hdf4_file->sd_id, "datetime_stop", harp_type_double, value) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int writer_close(void *file)
+{
+    hdf4_writer_file *hdf4_file = (hdf4_writer_file *)file;
+    int result = 0;
+
+    if (SDend(hdf4_file->sd_id) != 0)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        result = -1;
+    }
+    free(hdf4_file);
+
+    return result;
+}
+
+static int writer_write_product(int32 sd_id, const harp_product *product, const long *string_length)
+{
+    int i;
+
+    /* Write file convention. */
+    if (write_string_attribute(sd_id, "Conventions", HARP_CONVENTION) != 0)
+    {
+        return -1;
+    }
+
+    /* Write attributes (the datetime range is written when the writer is closed, since HDF4 attributes can not be
+     * removed again if none of the written blocks has a datetime range).
+     */
+    if (product->source_product != NULL && strcmp(product->source_product, "") != 0)
+    {
+        if (write_string_attribute(sd_id, "source_product", product->source_product) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (product->history != NULL && strcmp(product->history, "") != 0)
+    {
+        if (write_string_attribute(sd_id, "history", product->history) != 0)
+        {
+            return -1;
+        }
+    }
+
+    /* Create variables (only the data of time independent variables is written here). */
+    for (i = 0; i < product->num_variables; i++)
+    {
+        const harp_variable *variable = product->variable[i];
+        int32 sds_id;
+
+        if (create_variable(variable, sd_id, string_length[i], &sds_id) != 0)
+        {
+            return -1;
+        }
+        if (variable->num_dimensions == 0 || variable->dimension_type[0] != harp_dimension_time)
+        {
+            if (write_variable_data(sds_id, variable, 0, string_length[i]) != 0)
+            {
+                SDendaccess(sds_id);
+                return -1;
+            }
+        }
+        SDendaccess(sds_id);
+    }
+
+    return 0;
+}
+
+/* Create a HARP HDF4 file for the product of the writer (the time dependent data is written by writer_write_data).
+ * The template product is not needed for HDF4 files.
+ */
+int harp_product_writer_open_hdf4(const char *filename, const harp_product *template_product,
+                                  harp_product_writer *writer)
+{
+    hdf4_writer_file *hdf4_file;
+    int32 sd_id;
+
+    (void)template_product;
+
+    sd_id = SDstart(filename, DFACC_CREATE);
+    if (sd_id == -1)
+    {
+        harp_set_error(HARP_ERROR_HDF4, NULL);
+        harp_add_error_message(" (%s)", filename);
+        return -1;
+    }
+
+    if (writer_write_product(sd_id, writer->product, writer->string_length) != 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        SDend(sd_id);
+        return -1;
+    }
+
+    hdf4_file = (hdf4_writer_file *)malloc(sizeof(hdf4_writer_file));
+    if (hdf4_file == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(hdf4_writer_file), __FILE__, __LINE__);
+        SDend(sd_id);
+        return -1;
+    }
+    hdf4_file->sd_id = sd_id;
+    hdf4_file->string_length = writer->string_length;
+
+    writer->file = hdf4_file;
+    writer->write_data = writer_write_data;
+    writer->write_datetime_range = writer_write_datetime_range;
+    writer->close = writer_close;
+
+    return 0;
+}
+
 void harp_hdf4_add_error_message(void)
 {
     int error = HEvalue(1);
@@ -57,6 +57,12 @@
  */
 #define NC_DIMID_ATT_NAME "_Netcdf4Dimid"
 
+/* Names of the dimension scale and count dataset of vertical profiles that are stored as contiguous ragged arrays (see
+ * harp_set_option_ragged_vertical()).
+ */
+#define VERTICAL_SAMPLE_NAME "vertical_sample"
+#define VERTICAL_COUNT_NAME "vertical_count"
+
 /* List of shared dimensions. */
 typedef struct hdf5_dimensions_struct
 {
@@ -84,6 +90,9 @@ typedef struct hdf5_dimension_ids_struct
     int is_valid[HARP_NUM_DIM_TYPES];
     hdf5_object_id object_id[HARP_NUM_DIM_TYPES];
     long length[HARP_NUM_DIM_TYPES];
+    int has_vertical_sample;    /* the vertical sample dimension scale of ragged vertical profiles is present */
+    hdf5_object_id vertical_sample_object_id;
+    long vertical_sample_length;
 } hdf5_dimension_ids;
 
 static void dimensions_init(hdf5_dimensions *dimensions)
@@ -371,7 +380,7 @@ static int get_link_iteration_index_type(hid_t group_id, H5_index_t * index_type
     return 0;
 }
 
-static int set_compression(hid_t plist_id, harp_variable *variable)
+static int set_compression(hid_t plist_id, const harp_variable *variable)
 {
     int level = harp_get_option_hdf5_compression();
 
@@ -660,9 +669,12 @@ static herr_t hdf5_read_dimension_scale_func(hid_t dataset_id, unsigned dim, hid
     return 0;
 }
 
+/* Determine the dimensions of a dataset. For vertical profiles that are stored as a contiguous ragged array, the
+ * vertical sample dimension is expanded into the time and (padded) vertical dimension and is_ragged is set to 1.
+ */
 static int read_variable_dimensions(const char *variable_name, hid_t dataset_id,
                                     const hdf5_dimension_ids *dimension_ids, int *num_dimensions,
-                                    harp_dimension_type *dimension_type, long *dimension)
+                                    harp_dimension_type *dimension_type, long *dimension, int *is_ragged)
 {
     hid_t space_id;
     int hdf5_num_dimensions;
@@ -670,6 +682,8 @@ static int read_variable_dimensions(const char *variable_name, hid_t dataset_id,
     hsize_t hdf5_dimension[HARP_MAX_NUM_DIMS];
     int i, j;
 
+    *is_ragged = 0;
+
     space_id = H5Dget_space(dataset_id);
     if (space_id < 0)
     {
@@ -748,6 +762,20 @@ static int read_variable_dimensions(const char *variable_name, hid_t dataset_id,
 
             hdf5_dimension_type[i] = harp_dimension_independent;
 
+            if (dimension_ids->has_vertical_sample &&
+                dimension_ids->vertical_sample_object_id.fileno == hdf5_dimensions_id.fileno &&
+                dimension_ids->vertical_sample_object_id.addr == hdf5_dimensions_id.addr)
+            {
+                if (i != 0)
+                {
+                    harp_set_error(HARP_ERROR_IMPORT, "dimension '%s' of dataset '%s' is not the first dimension",
+                                   VERTICAL_SAMPLE_NAME, variable_name);
+                    return -1;
+                }
+                *is_ragged = 1;
+                continue;
+            }
+
             for (j = 0; j < HARP_NUM_DIM_TYPES; j++)
             {
                 if (!dimension_ids->is_valid[j])
@@ -771,6 +799,36 @@ static int read_variable_dimensions(const char *variable_name, hid_t dataset_id,
         }
     }
 
+    if (*is_ragged)
+    {
+        /* vertical profiles stored as a contiguous ragged array; the vertical sample dimension is expanded into the
+         * time and (padded) vertical dimension */
+        if (!dimension_ids->is_valid[harp_dimension_time] || !dimension_ids->is_valid[harp_dimension_vertical])
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "dataset '%s' is stored as ragged array, but the time/vertical "
+                           "dimensions are missing", variable_name);
+            return -1;
+        }
+        if (hdf5_num_dimensions + 1 > HARP_MAX_NUM_DIMS)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "dataspace has %d dimensions; expected <= %d", hdf5_num_dimensions + 1,
+                           HARP_MAX_NUM_DIMS);
+            return -1;
+        }
+        *num_dimensions = hdf5_num_dimensions + 1;
+        dimension_type[0] = harp_dimension_time;
+        dimension[0] = dimension_ids->length[harp_dimension_time];
+        dimension_type[1] = harp_dimension_vertical;
+        dimension[1] = dimension_ids->length[harp_dimension_vertical];
+        for (i = 1; i < hdf5_num_dimensions; i++)
+        {
+            dimension_type[i + 1] = hdf5_dimension_type[i];
+            dimension[i + 1] = (long)hdf5_dimension[i];
+        }
+
+        return 0;
+    }
+
     *num_dimensions = hdf5_num_dimensions;
     for (i = 0; i < hdf5_num_dimensions; i++)
     {
@@ -781,51 +839,59 @@ static int read_variable_dimensions(const char *variable_name, hid_t dataset_id,
     return 0;
 }
 
-static int read_variable(hid_t dataset_id, const char *name, const hdf5_dimension_ids *dimension_ids,
-                         harp_product *product)
+/* File information of a deferred import (see harp_import_deferred_hdf5()). */
+typedef struct hdf5_deferred_file_struct
 {
-    const char *variable_name;
-    harp_variable *variable;
-    harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
-    long dimension[HARP_MAX_NUM_DIMS];
-    harp_data_type data_type;
-    int num_dimensions;
-    herr_t result;
-
-    if (read_variable_data_type(dataset_id, &data_type) != 0)
-    {
-        return -1;
-    }
+    hid_t file_id;
+    hid_t root_id;
+    int num_datasets;
+    char **dataset_name;
+    long *vertical_count;       /* [time] vertical count of ragged vertical profiles (NULL if not present) */
+} hdf5_deferred_file;
 
-    if (read_variable_dimensions(name, dataset_id, dimension_ids, &num_dimensions, dimension_type, dimension) != 0)
+static int deferred_file_add_dataset_name(hdf5_deferred_file *hdf5_file, const char *name, int *index)
+{
+    if (hdf5_file->num_datasets % BLOCK_SIZE == 0)
     {
-        return -1;
-    }
+        char **new_dataset_name;
 
-    variable_name = name;
-    if (strncmp(name, "_nc4_non_coord_", 15) == 0)
-    {
-        variable_name = &name[15];
+        new_dataset_name = (char **)realloc(hdf5_file->dataset_name,
+                                            (hdf5_file->num_datasets + BLOCK_SIZE) * sizeof(char *));
+        if (new_dataset_name == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (hdf5_file->num_datasets + BLOCK_SIZE) * sizeof(char *), __FILE__, __LINE__);
+            return -1;
+        }
+        hdf5_file->dataset_name = new_dataset_name;
     }
-    if (harp_variable_new(variable_name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
+    hdf5_file->dataset_name[hdf5_file->num_datasets] = strdup(name);
+    if (hdf5_file->dataset_name[hdf5_file->num_datasets] == NULL)
     {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                       __LINE__);
         return -1;
     }
+    *index = hdf5_file->num_datasets;
+    hdf5_file->num_datasets++;
 
-    if (harp_product_add_variable(product, variable) != 0)
-    {
-        harp_variable_delete(variable);
-        return -1;
-    }
+    return 0;
+}
 
-    /* Read variable data. */
-    if (variable->data_type == harp_type_string)
+/* Read the selected elements of the file space of a dataset into the memory space, which should contain num_elements
+ * elements (if the file and memory space are H5S_ALL, all elements of the dataset are read).
+ * For string data, the strings are stored in a single block of memory that is returned in string_block if string_block
+ * is not NULL (otherwise each string is allocated separately).
+ */
+static int read_variable_data(hid_t dataset_id, harp_data_type data_type, hid_t mem_space_id, hid_t file_space_id,
+                              long num_elements, harp_array data, char **string_block)
+{
+    if (data_type == harp_type_string)
     {
         char *buffer;
         hid_t type_id;
         hsize_t type_size;
         hid_t mem_type_id;
-        long i;
 
         type_id = H5Dget_type(dataset_id);
         if (type_id < 0)
@@ -865,1544 +931,2937 @@ static int read_variable(hid_t dataset_id, const char *name, const hdf5_dimensio
             return -1;
         }
 
-        buffer = malloc(variable->num_elements * type_size * sizeof(char));
+        /* the strings are read directly into a single block of memory */
+        buffer = harp_string_block_new(num_elements, (long)type_size);
         if (buffer == NULL)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                           variable->num_elements * type_size * sizeof(char), __FILE__, __LINE__);
             H5Tclose(mem_type_id);
             return -1;
         }
 
-        if (H5Dread(dataset_id, mem_type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer) < 0)
+        if (H5Dread(dataset_id, mem_type_id, mem_space_id, file_space_id, H5P_DEFAULT, buffer) < 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
-            free(buffer);
+            harp_memory_free(buffer);
             H5Tclose(mem_type_id);
             return -1;
         }
 
         H5Tclose(mem_type_id);
 
-        for (i = 0; i < variable->num_elements; i++)
+        harp_string_block_distribute(buffer, num_elements, (long)type_size, data.string_data);
+        if (string_block != NULL)
         {
-            char *str;
+            *string_block = buffer;
+        }
+        else
+        {
+            long i;
 
-            str = malloc((type_size + 1) * sizeof(char));
-            if (str == NULL)
+            for (i = 0; i < num_elements; i++)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               (type_size + 1) * sizeof(char), __FILE__, __LINE__);
-                free(buffer);
-                return -1;
+                data.string_data[i] = strdup(data.string_data[i]);
+                if (data.string_data[i] == NULL)
+                {
+                    harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)",
+                                   __FILE__, __LINE__);
+                    while (i > 0)
+                    {
+                        i--;
+                        free(data.string_data[i]);
+                        data.string_data[i] = NULL;
+                    }
+                    harp_memory_free(buffer);
+                    return -1;
+                }
             }
-
-            memcpy(str, &buffer[i * type_size], type_size);
-            str[type_size] = '\0';
-            variable->data.string_data[i] = str;
+            harp_memory_free(buffer);
         }
-
-        free(buffer);
     }
     else
     {
-        if (H5Dread(dataset_id, get_hdf5_type(variable->data_type), H5S_ALL, H5S_ALL, H5P_DEFAULT,
-                    variable->data.ptr) < 0)
+        if (H5Dread(dataset_id, get_hdf5_type(data_type), mem_space_id, file_space_id, H5P_DEFAULT, data.ptr) < 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
             return -1;
         }
     }
 
-    /* Read variable attributes. */
-    result = H5Aexists(dataset_id, "description");
-    if (result > 0)
+    return 0;
+}
+
+/* Read the given ranges of the first dimension of a dataset (in that order) into data, using a single read of the
+ * union of the hyperslabs of the ranges. Ranges should not be empty.
+ */
+static int read_variable_time_ranges(hid_t dataset_id, harp_data_type data_type, long num_ranges,
+                                     const long *range_start, const long *range_length, harp_array data)
+{
+    hsize_t dimension[HARP_MAX_NUM_DIMS];
+    hsize_t start[HARP_MAX_NUM_DIMS];
+    hsize_t count[HARP_MAX_NUM_DIMS];
+    hid_t file_space_id;
+    hid_t mem_space_id;
+    long num_elements;
+    int num_dimensions;
+    long i;
+
+    file_space_id = H5Dget_space(dataset_id);
+    if (file_space_id < 0)
     {
-        if (read_string_attribute(dataset_id, "description", &variable->description) != 0)
-        {
-            return -1;
-        }
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
     }
-    else if (result < 0)
+
+    num_dimensions = H5Sget_simple_extent_dims(file_space_id, dimension, NULL);
+    if (num_dimensions < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(file_space_id);
         return -1;
     }
 
-    result = H5Aexists(dataset_id, "units");
-    if (result > 0)
+    for (i = 0; i < num_dimensions; i++)
     {
-        if (read_string_attribute(dataset_id, "units", &variable->unit) != 0)
+        start[i] = 0;
+        count[i] = dimension[i];
+    }
+    for (i = 0; i < num_ranges; i++)
+    {
+        start[0] = (hsize_t)range_start[i];
+        count[0] = (hsize_t)range_length[i];
+        if (H5Sselect_hyperslab(file_space_id, i == 0 ? H5S_SELECT_SET : H5S_SELECT_OR, start, NULL, count, NULL) < 0)
         {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Sclose(file_space_id);
             return -1;
         }
-        if (strcmp(variable->unit, "1") == 0)
-        {
-            /* convert "1" to "" */
-            variable->unit[0] = '\0';
-        }
     }
-    else if (result < 0)
+
+    num_elements = (long)H5Sget_select_npoints(file_space_id);
+    if (num_elements < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(file_space_id);
         return -1;
     }
 
-    result = H5Aexists(dataset_id, "valid_min");
-    if (result > 0)
+    /* the memory space contains the selected time samples without gaps */
+    count[0] = 0;
+    for (i = 0; i < num_ranges; i++)
     {
-        harp_data_type attr_data_type;
-
-        if (read_numeric_attribute(dataset_id, "valid_min", &attr_data_type, &variable->valid_min) != 0)
-        {
-            return -1;
-        }
-
-        if (attr_data_type != variable->data_type)
-        {
-            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_min' of dataset '%s' has invalid type", name);
-            return -1;
-        }
+        count[0] += (hsize_t)range_length[i];
     }
-    else if (result < 0)
+    mem_space_id = H5Screate_simple(num_dimensions, count, NULL);
+    if (mem_space_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(file_space_id);
         return -1;
     }
 
-    result = H5Aexists(dataset_id, "valid_max");
-    if (result > 0)
+    if (read_variable_data(dataset_id, data_type, mem_space_id, file_space_id, num_elements, data, NULL) != 0)
     {
-        harp_data_type attr_data_type;
+        H5Sclose(mem_space_id);
+        H5Sclose(file_space_id);
+        return -1;
+    }
 
-        if (read_numeric_attribute(dataset_id, "valid_max", &attr_data_type, &variable->valid_max) != 0)
-        {
-            return -1;
-        }
+    H5Sclose(mem_space_id);
+    H5Sclose(file_space_id);
 
-        if (attr_data_type != variable->data_type)
-        {
-            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_max' of dataset '%s' has invalid type", name);
-            return -1;
-        }
+    return 0;
+}
+
+/* Determine the number of elements of a dataset and the number of elements per element of its first dimension. */
+static int get_dataset_size(hid_t dataset_id, int *num_dimensions, long *num_elements, long *block_size)
+{
+    hsize_t dimension[HARP_MAX_NUM_DIMS];
+    hid_t space_id;
+    int i;
+
+    space_id = H5Dget_space(dataset_id);
+    if (space_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
     }
-    else if (result < 0)
+    *num_dimensions = H5Sget_simple_extent_dims(space_id, dimension, NULL);
+    H5Sclose(space_id);
+    if (*num_dimensions < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    if (data_type == harp_type_int8)
+    *block_size = 1;
+    for (i = 1; i < *num_dimensions; i++)
     {
-        result = H5Aexists(dataset_id, "flag_meanings");
-        if (result > 0)
-        {
-            char *flag_meanings;
-
-            if (read_string_attribute(dataset_id, "flag_meanings", &flag_meanings) != 0)
-            {
-                return -1;
-            }
-            if (harp_variable_set_enumeration_values_using_flag_meanings(variable, flag_meanings) != 0)
-            {
-                free(flag_meanings);
-                return -1;
-            }
-            free(flag_meanings);
-        }
+        *block_size *= (long)dimension[i];
     }
+    *num_elements = (*num_dimensions > 0 ? (long)dimension[0] : 1) * *block_size;
 
     return 0;
 }
 
-/* don't use -1 on error, otherwise the HDF5 library starts printing error messages to the console */
-static herr_t hdf5_find_dimensions_func(hid_t group_id, const char *name, const H5L_info_t * info, void *user_data)
+/* Read the vertical profiles of a variable that are stored as a contiguous ragged array and distribute them over the
+ * (padded) data of the variable. For string data, the strings are stored in a single block of memory that is returned
+ * in string_block if string_block is not NULL (otherwise each string is allocated separately).
+ */
+static int read_ragged_variable_data(hid_t dataset_id, const long *vertical_count, const harp_variable *variable,
+                                     harp_array data, char **string_block)
 {
-    H5O_info_t object_info;
-    hdf5_dimension_ids *dimension_ids;
-    hid_t dataset_id;
-    htri_t is_dimension_scale;
-    harp_dimension_type dimension_type;
-    hsize_t length = 0;
+    char *empty_string = NULL;
+    harp_array packed;
+    long num_elements;
+    long block_size;
+    int num_dimensions;
+    int result;
 
-    (void)info;
-    dimension_ids = (hdf5_dimension_ids *)user_data;
+    if (get_dataset_size(dataset_id, &num_dimensions, &num_elements, &block_size) != 0)
+    {
+        return -1;
+    }
 
-    if (H5Oget_info_by_name(group_id, name, &object_info, H5P_DEFAULT) < 0)
+    packed.ptr = calloc(num_elements + 1, harp_get_size_for_type(variable->data_type));
+    if (packed.ptr == NULL)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        return 1;
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (num_elements + 1) * harp_get_size_for_type(variable->data_type), __FILE__, __LINE__);
+        return -1;
     }
 
-    if (object_info.type != H5O_TYPE_DATASET)
+    if (read_variable_data(dataset_id, variable->data_type, H5S_ALL, H5S_ALL, num_elements, packed, string_block) != 0)
     {
-        return 0;
+        free(packed.ptr);
+        return -1;
     }
 
-    dataset_id = H5Dopen(group_id, name);
-    if (dataset_id < 0)
+    if (variable->data_type == harp_type_string && string_block != NULL)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        return 1;
+        hid_t type_id;
+        size_t type_size;
+
+        type_id = H5Dget_type(dataset_id);
+        if (type_id < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            free(packed.ptr);
+            return -1;
+        }
+        type_size = H5Tget_size(type_id);
+        H5Tclose(type_id);
+
+        /* the padding of a ragged array uses the empty string at the end of the block */
+        empty_string = &(*string_block)[num_elements * ((long)type_size + 1)];
     }
 
-    is_dimension_scale = H5DSis_scale(dataset_id);
-    if (is_dimension_scale < 0)
+    /* this transfers ownership of any strings to the variable data */
+    result = harp_variable_unpack_ragged_vertical(variable, variable->dimension[0], packed, vertical_count,
+                                                  empty_string, data);
+    free(packed.ptr);
+
+    return result;
+}
+
+/* Read the given ranges of time samples of a variable whose vertical profiles are stored as a contiguous ragged array
+ * (in that order) into data. The packed samples of the profiles of all ranges are read with a single read and are then
+ * distributed over the (padded) profiles.
+ */
+static int read_ragged_variable_time_ranges(hid_t dataset_id, const long *vertical_count,
+                                            const harp_variable *variable, long num_ranges, const long *range_start,
+                                            const long *range_length, harp_array data)
+{
+    long element_size = harp_get_size_for_type(variable->data_type);
+    long *file_start;
+    long *file_length;
+    long num_file_ranges = 0;
+    long num_elements = 0;
+    long block_size;
+    long packed_offset;
+    long offset;
+    long time_index = 0;
+    harp_array packed;
+    int num_dimensions;
+    long i;
+
+    if (get_dataset_size(dataset_id, &num_dimensions, &num_elements, &block_size) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Dclose(dataset_id);
-        return 1;
+        return -1;
     }
 
-    if (is_dimension_scale)
+    file_start = (long *)malloc(2 * num_ranges * sizeof(long));
+    if (file_start == NULL)
     {
-        hid_t space_id;
-        int hdf5_num_dimensions;
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       2 * num_ranges * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    file_length = &file_start[num_ranges];
 
-        space_id = H5Dget_space(dataset_id);
-        if (space_id < 0)
+    /* the ranges are sorted, so the offsets of the packed samples are determined in a single pass (ranges without any
+     * packed samples are not read) */
+    num_elements = 0;
+    offset = 0;
+    for (i = 0; i < num_ranges; i++)
+    {
+        for (; time_index < range_start[i]; time_index++)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Dclose(dataset_id);
-            return 1;
+            offset += vertical_count[time_index];
         }
-
-        if (H5Sis_simple(space_id) <= 0)
+        file_start[num_file_ranges] = offset;
+        for (; time_index < range_start[i] + range_length[i]; time_index++)
         {
-            harp_set_error(HARP_ERROR_IMPORT, "dataspace is complex; only simple dataspaces are supported");
-            H5Sclose(space_id);
-            H5Dclose(dataset_id);
-            return 1;
+            offset += vertical_count[time_index];
         }
-
-        hdf5_num_dimensions = H5Sget_simple_extent_ndims(space_id);
-        if (hdf5_num_dimensions < 0)
+        file_length[num_file_ranges] = offset - file_start[num_file_ranges];
+        if (file_length[num_file_ranges] > 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Sclose(space_id);
-            H5Dclose(dataset_id);
-            return 1;
+            num_elements += file_length[num_file_ranges] * block_size;
+            num_file_ranges++;
         }
+    }
 
-        if (hdf5_num_dimensions != 1)
+    packed.ptr = calloc(num_elements + 1, element_size);
+    if (packed.ptr == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (num_elements + 1) * element_size, __FILE__, __LINE__);
+        free(file_start);
+        return -1;
+    }
+
+    if (num_file_ranges > 0)
+    {
+        if (read_variable_time_ranges(dataset_id, variable->data_type, num_file_ranges, file_start, file_length,
+                                      packed) != 0)
         {
-            harp_set_error(HARP_ERROR_IMPORT, "dataspace for dimensions scale has %d dimensions; expected 1",
-                           hdf5_num_dimensions);
-            H5Sclose(space_id);
-            H5Dclose(dataset_id);
-            return 1;
-        }
-
-        if (H5Sget_simple_extent_dims(space_id, &length, NULL) < 0)
-        {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Sclose(space_id);
-            H5Dclose(dataset_id);
-            return 1;
+            free(packed.ptr);
+            free(file_start);
+            return -1;
         }
-
-        H5Sclose(space_id);
     }
+    free(file_start);
 
-    H5Dclose(dataset_id);
-
-    if (is_dimension_scale
-        && harp_parse_dimension_type(name, &dimension_type) == 0
-        && dimension_type != harp_dimension_independent && !dimension_ids->is_valid[dimension_type])
+    packed_offset = 0;
+    offset = 0;
+    for (i = 0; i < num_ranges; i++)
     {
-        dimension_ids->is_valid[dimension_type] = 1;
-        dimension_ids->object_id[dimension_type].fileno = object_info.fileno;
-        dimension_ids->object_id[dimension_type].addr = object_info.addr;
-        dimension_ids->length[dimension_type] = (long)length;
-    }
-
-    return 0;
-}
-
-static int find_dimensions(hid_t group_id, hdf5_dimension_ids *dimension_ids)
-{
-    H5_index_t index_type;
+        harp_array range_packed;
+        harp_array range_data;
+        long j;
 
-    if (get_link_iteration_index_type(group_id, &index_type) != 0)
-    {
-        return -1;
-    }
+        range_packed.ptr = &((char *)packed.ptr)[packed_offset * element_size];
+        range_data.ptr = &((char *)data.ptr)[offset * element_size];
 
-    if (H5Literate(group_id, index_type, H5_ITER_NATIVE, NULL, hdf5_find_dimensions_func, dimension_ids) != 0)
-    {
-        return -1;
+        /* this transfers ownership of any strings to the variable data */
+        if (harp_variable_unpack_ragged_vertical(variable, range_length[i], range_packed,
+                                                 &vertical_count[range_start[i]], NULL, range_data) != 0)
+        {
+            free(packed.ptr);
+            return -1;
+        }
+        for (j = range_start[i]; j < range_start[i] + range_length[i]; j++)
+        {
+            packed_offset += vertical_count[j] * block_size;
+        }
+        offset += range_length[i] * variable->dimension[1] * block_size;
     }
+    free(packed.ptr);
 
     return 0;
 }
 
-/* Additional arguments for hdf5_read_variable_func(), which is a visitor function that is called for all variables in
- * the root group via H5Literate(), see also read_variables().
- */
-typedef struct hdf5_read_variable_func_args_struct
-{
-    hdf5_dimension_ids *dimension_ids;
-    harp_product *product;
-} hdf5_read_variable_func_args;
-
-/* don't use -1 on error, otherwise the HDF5 library starts printing error messages to the console */
-static herr_t hdf5_read_variable_func(hid_t group_id, const char *name, const H5L_info_t * info, void *user_data)
+/* Read the count dataset of vertical profiles that are stored as contiguous ragged arrays. */
+static int read_vertical_count(hid_t group_id, const hdf5_dimension_ids *dimension_ids, long **vertical_count)
 {
-    hdf5_read_variable_func_args *args;
-    H5O_info_t object_info;
+    char *sample_dimension;
     hid_t dataset_id;
-    htri_t is_dimension_scale;
-
-    (void)info;
+    long num_elements;
+    long block_size;
+    long total = 0;
+    long *count;
+    int num_dimensions;
+    htri_t result;
+    long i;
 
-    args = (hdf5_read_variable_func_args *)user_data;
+    if (!dimension_ids->is_valid[harp_dimension_time] || !dimension_ids->is_valid[harp_dimension_vertical])
+    {
+        harp_set_error(HARP_ERROR_IMPORT, "product has dimension '%s', but the time/vertical dimensions are missing",
+                       VERTICAL_SAMPLE_NAME);
+        return -1;
+    }
 
-    if (H5Oget_info_by_name(group_id, name, &object_info, H5P_DEFAULT) < 0)
+    result = H5Lexists(group_id, VERTICAL_COUNT_NAME, H5P_DEFAULT);
+    if (result < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
-        return 1;
+        return -1;
     }
-
-    if (object_info.type != H5O_TYPE_DATASET)
+    if (result == 0)
     {
-        /* Skip everything that is not a dataset. */
-        return 0;
+        harp_set_error(HARP_ERROR_IMPORT, "product has dimension '%s', but no count dataset '%s'",
+                       VERTICAL_SAMPLE_NAME, VERTICAL_COUNT_NAME);
+        return -1;
     }
 
-    dataset_id = H5Dopen(group_id, name);
+    dataset_id = H5Dopen(group_id, VERTICAL_COUNT_NAME);
     if (dataset_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
-        return 1;
+        return -1;
     }
 
-    is_dimension_scale = H5DSis_scale(dataset_id);
-    if (is_dimension_scale < 0)
+    if (read_string_attribute(dataset_id, "sample_dimension", &sample_dimension) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
         H5Dclose(dataset_id);
-        return 1;
+        return -1;
     }
-
-    if (is_dimension_scale)
+    result = strcmp(sample_dimension, VERTICAL_SAMPLE_NAME);
+    free(sample_dimension);
+    if (result != 0)
     {
-        char scale_name[255];
-
-        if (H5DSget_scale_name(dataset_id, scale_name, sizeof(scale_name)) < 0)
-        {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Dclose(dataset_id);
-            return 1;
-        }
-
-        if (strncmp(scale_name, DIM_WITHOUT_VARIABLE, sizeof(DIM_WITHOUT_VARIABLE) - 1) == 0)
-        {
-            /* Skip dimension scales without a coordinate variable. */
-            H5Dclose(dataset_id);
-            return 0;
-        }
+        harp_set_error(HARP_ERROR_IMPORT, "invalid count dataset '%s' for ragged vertical profiles",
+                       VERTICAL_COUNT_NAME);
+        H5Dclose(dataset_id);
+        return -1;
     }
 
-    if (read_variable(dataset_id, name, args->dimension_ids, args->product) != 0)
+    if (get_dataset_size(dataset_id, &num_dimensions, &num_elements, &block_size) != 0)
     {
         H5Dclose(dataset_id);
-        return 1;
+        return -1;
     }
-
-    H5Dclose(dataset_id);
-
-    return 0;
-}
-
-static int read_variables(hid_t group_id, hdf5_dimension_ids *dimension_ids, harp_product *product)
-{
-    hdf5_read_variable_func_args args;
-    H5_index_t index_type;
-
-    if (get_link_iteration_index_type(group_id, &index_type) != 0)
+    if (num_dimensions != 1 || num_elements != dimension_ids->length[harp_dimension_time])
     {
+        harp_set_error(HARP_ERROR_IMPORT, "invalid count dataset '%s' for ragged vertical profiles",
+                       VERTICAL_COUNT_NAME);
+        H5Dclose(dataset_id);
         return -1;
     }
 
-    args.dimension_ids = dimension_ids;
-    args.product = product;
-
-    return (H5Literate(group_id, index_type, H5_ITER_INC, NULL, hdf5_read_variable_func, &args) != 0 ? -1 : 0);
-}
-
-static int read_attributes(hid_t group_id, harp_product *product)
-{
-    htri_t result;
-
-    result = H5Aexists(group_id, "source_product");
-    if (result > 0)
+    count = (long *)malloc((num_elements + 1) * sizeof(long));
+    if (count == NULL)
     {
-        if (read_string_attribute(group_id, "source_product", &product->source_product) != 0)
-        {
-            return -1;
-        }
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (num_elements + 1) * sizeof(long), __FILE__, __LINE__);
+        H5Dclose(dataset_id);
+        return -1;
     }
-    else if (result < 0)
+    if (H5Dread(dataset_id, H5T_NATIVE_LONG, H5S_ALL, H5S_ALL, H5P_DEFAULT, count) < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        free(count);
+        H5Dclose(dataset_id);
         return -1;
     }
+    H5Dclose(dataset_id);
 
-    result = H5Aexists(group_id, "history");
-    if (result > 0)
+    for (i = 0; i < num_elements; i++)
     {
-        if (read_string_attribute(group_id, "history", &product->history) != 0)
+        if (count[i] < 0 || count[i] > dimension_ids->length[harp_dimension_vertical])
         {
+            harp_set_error(HARP_ERROR_IMPORT, "invalid value (%ld) in count dataset '%s' for ragged vertical "
+                           "profiles", count[i], VERTICAL_COUNT_NAME);
+            free(count);
             return -1;
         }
+        total += count[i];
     }
-    else if (result < 0)
+    if (total != dimension_ids->vertical_sample_length)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
+        harp_set_error(HARP_ERROR_IMPORT, "sum of count dataset '%s' (%ld) does not match length of dimension '%s' "
+                       "(%ld)", VERTICAL_COUNT_NAME, total, VERTICAL_SAMPLE_NAME,
+                       dimension_ids->vertical_sample_length);
+        free(count);
         return -1;
     }
 
+    *vertical_count = count;
+
     return 0;
 }
 
-static int read_product(hid_t file_id, harp_product *product)
+/* Read the definition and attributes of a variable. If import is not NULL numeric variables are created without data
+ * and their data will only be read on request.
+ */
+static int read_variable(hid_t dataset_id, const char *name, const hdf5_dimension_ids *dimension_ids,
+                         const long *vertical_count, harp_product *product, harp_deferred_import *import)
 {
-    hdf5_dimension_ids dimension_ids = { {0}, {{0, 0}}, {0} };
-    hid_t root_id;
+    const char *variable_name;
+    harp_variable *variable;
+    harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
+    long dimension[HARP_MAX_NUM_DIMS];
+    harp_data_type data_type;
+    char *string_block = NULL;
+    int num_dimensions;
+    int is_ragged;
+    herr_t result;
 
-    root_id = H5Gopen(file_id, "/");
-    if (root_id < 0)
+    if (read_variable_data_type(dataset_id, &data_type) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    /* Find dimension scales. */
-    if (find_dimensions(root_id, &dimension_ids) != 0)
+    if (read_variable_dimensions(name, dataset_id, dimension_ids, &num_dimensions, dimension_type, dimension,
+                                 &is_ragged) != 0)
     {
-        H5Gclose(root_id);
         return -1;
     }
+    assert(!is_ragged || vertical_count != NULL);
 
-    /* Read variables. */
-    if (read_variables(root_id, &dimension_ids, product) != 0)
+    variable_name = name;
+    if (strncmp(name, "_nc4_non_coord_", 15) == 0)
+    {
+        variable_name = &name[15];
+    }
+    if (import != NULL && data_type != harp_type_string)
+    {
+        if (harp_variable_new_without_data(variable_name, data_type, num_dimensions, dimension_type, dimension,
+                                           &variable) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (harp_variable_new(variable_name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
     {
-        H5Gclose(root_id);
         return -1;
     }
 
-    /* Read attributes. */
-    if (read_attributes(root_id, product) != 0)
+    if (harp_product_add_variable(product, variable) != 0)
     {
-        H5Gclose(root_id);
+        harp_variable_delete(variable);
         return -1;
     }
 
-    H5Gclose(root_id);
-
-    return 0;
-}
+    if (variable->data.ptr == NULL)
+    {
+        int variable_id;
 
-static int verify_product(hid_t file_id)
-{
-    int result;
-    char *convention_str;
+        if (deferred_file_add_dataset_name((hdf5_deferred_file *)import->file, name, &variable_id) != 0)
+        {
+            return -1;
+        }
+        if (harp_deferred_import_add_variable(import, variable, variable_id) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (is_ragged)
+    {
+        if (read_ragged_variable_data(dataset_id, vertical_count, variable, variable->data, &string_block) != 0)
+        {
+            return -1;
+        }
+        harp_variable_set_string_block(variable, string_block);
+    }
+    else
+    {
+        if (read_variable_data(dataset_id, variable->data_type, H5S_ALL, H5S_ALL, variable->num_elements,
+                               variable->data, &string_block) != 0)
+        {
+            return -1;
+        }
+        harp_variable_set_string_block(variable, string_block);
+    }
 
-    result = H5Aexists(file_id, "Conventions");
+    /* Read variable attributes. */
+    result = H5Aexists(dataset_id, "description");
     if (result > 0)
     {
-        if (read_string_attribute(file_id, "Conventions", &convention_str) == 0)
+        if (read_string_attribute(dataset_id, "description", &variable->description) != 0)
         {
-            int major, minor;
-
-            if (harp_parse_file_convention(convention_str, &major, &minor) == 0)
-            {
-                free(convention_str);
-                if (major > HARP_FORMAT_VERSION_MAJOR
-                    || (major == HARP_FORMAT_VERSION_MAJOR && minor > HARP_FORMAT_VERSION_MINOR))
-                {
-                    harp_set_error(HARP_ERROR_FILE_OPEN, "unsupported HARP format version %d.%d", major, minor);
-                    return -1;
-                }
-                return 0;
-            }
-            free(convention_str);
+            return -1;
         }
     }
-
-    harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, "not a HARP product");
-
-    return -1;
-}
-
-int harp_import_hdf5(const char *filename, harp_product **product)
-{
-    harp_product *new_product;
-    hid_t file_id;
-
-    file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-    if (file_id < 0)
+    else if (result < 0)
     {
-        harp_add_error_message(" (%s)", filename);
         harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    if (verify_product(file_id) != 0)
+    result = H5Aexists(dataset_id, "units");
+    if (result > 0)
     {
-        H5Fclose(file_id);
-        return -1;
+        if (read_string_attribute(dataset_id, "units", &variable->unit) != 0)
+        {
+            return -1;
+        }
+        if (strcmp(variable->unit, "1") == 0)
+        {
+            /* convert "1" to "" */
+            variable->unit[0] = '\0';
+        }
     }
-
-    if (harp_product_new(&new_product) != 0)
+    else if (result < 0)
     {
-        H5Fclose(file_id);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    if (read_product(file_id, new_product) != 0)
+    result = H5Aexists(dataset_id, "valid_min");
+    if (result > 0)
+    {
+        harp_data_type attr_data_type;
+
+        if (read_numeric_attribute(dataset_id, "valid_min", &attr_data_type, &variable->valid_min) != 0)
+        {
+            return -1;
+        }
+
+        if (attr_data_type != variable->data_type)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_min' of dataset '%s' has invalid type", name);
+            return -1;
+        }
+    }
+    else if (result < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    result = H5Aexists(dataset_id, "valid_max");
+    if (result > 0)
+    {
+        harp_data_type attr_data_type;
+
+        if (read_numeric_attribute(dataset_id, "valid_max", &attr_data_type, &variable->valid_max) != 0)
+        {
+            return -1;
+        }
+
+        if (attr_data_type != variable->data_type)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_max' of dataset '%s' has invalid type", name);
+            return -1;
+        }
+    }
+    else if (result < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (data_type == harp_type_int8)
+    {
+        result = H5Aexists(dataset_id, "flag_meanings");
+        if (result > 0)
+        {
+            char *flag_meanings;
+
+            if (read_string_attribute(dataset_id, "flag_meanings", &flag_meanings) != 0)
+            {
+                return -1;
+            }
+            if (harp_variable_set_enumeration_values_using_flag_meanings(variable, flag_meanings) != 0)
+            {
+                free(flag_meanings);
+                return -1;
+            }
+            free(flag_meanings);
+        }
+    }
+
+    return 0;
+}
+
+/* don't use -1 on error, otherwise the HDF5 library starts printing error messages to the console */
+static herr_t hdf5_find_dimensions_func(hid_t group_id, const char *name, const H5L_info_t * info, void *user_data)
+{
+    H5O_info_t object_info;
+    hdf5_dimension_ids *dimension_ids;
+    hid_t dataset_id;
+    htri_t is_dimension_scale;
+    harp_dimension_type dimension_type;
+    hsize_t length = 0;
+
+    (void)info;
+    dimension_ids = (hdf5_dimension_ids *)user_data;
+
+    if (H5Oget_info_by_name(group_id, name, &object_info, H5P_DEFAULT) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return 1;
+    }
+
+    if (object_info.type != H5O_TYPE_DATASET)
+    {
+        return 0;
+    }
+
+    dataset_id = H5Dopen(group_id, name);
+    if (dataset_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return 1;
+    }
+
+    is_dimension_scale = H5DSis_scale(dataset_id);
+    if (is_dimension_scale < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Dclose(dataset_id);
+        return 1;
+    }
+
+    if (is_dimension_scale)
+    {
+        hid_t space_id;
+        int hdf5_num_dimensions;
+
+        space_id = H5Dget_space(dataset_id);
+        if (space_id < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Dclose(dataset_id);
+            return 1;
+        }
+
+        if (H5Sis_simple(space_id) <= 0)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "dataspace is complex; only simple dataspaces are supported");
+            H5Sclose(space_id);
+            H5Dclose(dataset_id);
+            return 1;
+        }
+
+        hdf5_num_dimensions = H5Sget_simple_extent_ndims(space_id);
+        if (hdf5_num_dimensions < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Sclose(space_id);
+            H5Dclose(dataset_id);
+            return 1;
+        }
+
+        if (hdf5_num_dimensions != 1)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "dataspace for dimensions scale has %d dimensions; expected 1",
+                           hdf5_num_dimensions);
+            H5Sclose(space_id);
+            H5Dclose(dataset_id);
+            return 1;
+        }
+
+        if (H5Sget_simple_extent_dims(space_id, &length, NULL) < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Sclose(space_id);
+            H5Dclose(dataset_id);
+            return 1;
+        }
+
+        H5Sclose(space_id);
+    }
+
+    H5Dclose(dataset_id);
+
+    if (is_dimension_scale && strcmp(name, VERTICAL_SAMPLE_NAME) == 0)
+    {
+        dimension_ids->has_vertical_sample = 1;
+        dimension_ids->vertical_sample_object_id.fileno = object_info.fileno;
+        dimension_ids->vertical_sample_object_id.addr = object_info.addr;
+        dimension_ids->vertical_sample_length = (long)length;
+    }
+    else if (is_dimension_scale
+             && harp_parse_dimension_type(name, &dimension_type) == 0
+             && dimension_type != harp_dimension_independent && !dimension_ids->is_valid[dimension_type])
+    {
+        dimension_ids->is_valid[dimension_type] = 1;
+        dimension_ids->object_id[dimension_type].fileno = object_info.fileno;
+        dimension_ids->object_id[dimension_type].addr = object_info.addr;
+        dimension_ids->length[dimension_type] = (long)length;
+    }
+
+    return 0;
+}
+
+static int find_dimensions(hid_t group_id, hdf5_dimension_ids *dimension_ids)
+{
+    H5_index_t index_type;
+
+    if (get_link_iteration_index_type(group_id, &index_type) != 0)
+    {
+        return -1;
+    }
+
+    if (H5Literate(group_id, index_type, H5_ITER_NATIVE, NULL, hdf5_find_dimensions_func, dimension_ids) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Additional arguments for hdf5_read_variable_func(), which is a visitor function that is called for all variables in
+ * the root group via H5Literate(), see also read_variables().
+ */
+typedef struct hdf5_read_variable_func_args_struct
+{
+    hdf5_dimension_ids *dimension_ids;
+    const long *vertical_count;
+    harp_product *product;
+    harp_deferred_import *import;
+} hdf5_read_variable_func_args;
+
+/* don't use -1 on error, otherwise the HDF5 library starts printing error messages to the console */
+static herr_t hdf5_read_variable_func(hid_t group_id, const char *name, const H5L_info_t * info, void *user_data)
+{
+    hdf5_read_variable_func_args *args;
+    H5O_info_t object_info;
+    hid_t dataset_id;
+    htri_t is_dimension_scale;
+
+    (void)info;
+
+    args = (hdf5_read_variable_func_args *)user_data;
+
+    if (H5Oget_info_by_name(group_id, name, &object_info, H5P_DEFAULT) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return 1;
+    }
+
+    if (object_info.type != H5O_TYPE_DATASET)
+    {
+        /* Skip everything that is not a dataset. */
+        return 0;
+    }
+
+    if (args->vertical_count != NULL && strcmp(name, VERTICAL_COUNT_NAME) == 0)
+    {
+        /* Skip the count dataset of ragged vertical profiles. */
+        return 0;
+    }
+
+    dataset_id = H5Dopen(group_id, name);
+    if (dataset_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return 1;
+    }
+
+    is_dimension_scale = H5DSis_scale(dataset_id);
+    if (is_dimension_scale < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Dclose(dataset_id);
+        return 1;
+    }
+
+    if (is_dimension_scale)
+    {
+        char scale_name[255];
+
+        if (H5DSget_scale_name(dataset_id, scale_name, sizeof(scale_name)) < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Dclose(dataset_id);
+            return 1;
+        }
+
+        if (strncmp(scale_name, DIM_WITHOUT_VARIABLE, sizeof(DIM_WITHOUT_VARIABLE) - 1) == 0)
+        {
+            /* Skip dimension scales without a coordinate variable. */
+            H5Dclose(dataset_id);
+            return 0;
+        }
+    }
+
+    if (read_variable(dataset_id, name, args->dimension_ids, args->vertical_count, args->product, args->import) != 0)
+    {
+        H5Dclose(dataset_id);
+        return 1;
+    }
+
+    H5Dclose(dataset_id);
+
+    return 0;
+}
+
+static int read_variables(hid_t group_id, hdf5_dimension_ids *dimension_ids, const long *vertical_count,
+                          harp_product *product, harp_deferred_import *import)
+{
+    hdf5_read_variable_func_args args;
+    H5_index_t index_type;
+
+    if (get_link_iteration_index_type(group_id, &index_type) != 0)
+    {
+        return -1;
+    }
+
+    args.dimension_ids = dimension_ids;
+    args.vertical_count = vertical_count;
+    args.product = product;
+    args.import = import;
+
+    return (H5Literate(group_id, index_type, H5_ITER_INC, NULL, hdf5_read_variable_func, &args) != 0 ? -1 : 0);
+}
+
+static int read_attributes(hid_t group_id, harp_product *product)
+{
+    htri_t result;
+
+    result = H5Aexists(group_id, "source_product");
+    if (result > 0)
+    {
+        if (read_string_attribute(group_id, "source_product", &product->source_product) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (result < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    result = H5Aexists(group_id, "history");
+    if (result > 0)
+    {
+        if (read_string_attribute(group_id, "history", &product->history) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (result < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Read the product. If vertical_count_out is not NULL, the vertical count of ragged vertical profiles is returned in
+ * it (or NULL if the product has no ragged vertical profiles).
+ */
+static int read_product(hid_t file_id, harp_product *product, harp_deferred_import *import, long **vertical_count_out)
+{
+    hdf5_dimension_ids dimension_ids = { {0}, {{0, 0}}, {0}, 0, {0, 0}, 0 };
+    long *vertical_count = NULL;
+    hid_t root_id;
+
+    root_id = H5Gopen(file_id, "/");
+    if (root_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    /* Find dimension scales. */
+    if (find_dimensions(root_id, &dimension_ids) != 0)
+    {
+        H5Gclose(root_id);
+        return -1;
+    }
+
+    /* Read the vertical count of ragged vertical profiles. */
+    if (dimension_ids.has_vertical_sample)
+    {
+        if (read_vertical_count(root_id, &dimension_ids, &vertical_count) != 0)
+        {
+            H5Gclose(root_id);
+            return -1;
+        }
+    }
+
+    /* Read variables. */
+    if (read_variables(root_id, &dimension_ids, vertical_count, product, import) != 0)
+    {
+        if (vertical_count != NULL)
+        {
+            free(vertical_count);
+        }
+        H5Gclose(root_id);
+        return -1;
+    }
+
+    /* Read attributes. */
+    if (read_attributes(root_id, product) != 0)
+    {
+        if (vertical_count != NULL)
+        {
+            free(vertical_count);
+        }
+        H5Gclose(root_id);
+        return -1;
+    }
+
+    H5Gclose(root_id);
+
+    if (vertical_count_out != NULL)
+    {
+        *vertical_count_out = vertical_count;
+    }
+    else if (vertical_count != NULL)
+    {
+        free(vertical_count);
+    }
+
+    return 0;
+}
+
+static int verify_product(hid_t file_id)
+{
+    int result;
+    char *convention_str;
+
+    result = H5Aexists(file_id, "Conventions");
+    if (result > 0)
+    {
+        if (read_string_attribute(file_id, "Conventions", &convention_str) == 0)
+        {
+            int major, minor;
+
+            if (harp_parse_file_convention(convention_str, &major, &minor) == 0)
+            {
+                free(convention_str);
+                if (major > HARP_FORMAT_VERSION_MAJOR
+                    || (major == HARP_FORMAT_VERSION_MAJOR && minor > HARP_FORMAT_VERSION_MINOR))
+                {
+                    harp_set_error(HARP_ERROR_FILE_OPEN, "unsupported HARP format version %d.%d", major, minor);
+                    return -1;
+                }
+                return 0;
+            }
+            free(convention_str);
+        }
+    }
+
+    harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, "not a HARP product");
+
+    return -1;
+}
+
+int harp_import_hdf5(const char *filename, harp_product **product)
+{
+    harp_product *new_product;
+    hid_t file_id;
+
+    file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file_id < 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (verify_product(file_id) != 0)
+    {
+        H5Fclose(file_id);
+        return -1;
+    }
+
+    if (harp_product_new(&new_product) != 0)
+    {
+        H5Fclose(file_id);
+        return -1;
+    }
+
+    if (read_product(file_id, new_product, NULL, NULL) != 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        harp_product_delete(new_product);
+        H5Fclose(file_id);
+        return -1;
+    }
+
+    *product = new_product;
+
+    H5Fclose(file_id);
+
+    return 0;
+}
+
+/* Returns 1 if the vertical profiles of the deferred variable are stored as a contiguous ragged array (i.e. if the
+ * time and vertical dimension of the variable are stored as a single vertical sample dimension), 0 otherwise.
+ */
+static int is_ragged_dataset(const hdf5_deferred_file *hdf5_file, hid_t dataset_id, const harp_variable *variable)
+{
+    hid_t space_id;
+    int num_dimensions;
+
+    if (hdf5_file->vertical_count == NULL || !harp_variable_has_ragged_vertical_layout(variable))
+    {
+        return 0;
+    }
+    space_id = H5Dget_space(dataset_id);
+    if (space_id < 0)
+    {
+        return 0;
+    }
+    num_dimensions = H5Sget_simple_extent_ndims(space_id);
+    H5Sclose(space_id);
+
+    return num_dimensions == variable->num_dimensions - 1;
+}
+
+static int deferred_read_data(void *file, int variable_id, harp_variable *variable)
+{
+    hdf5_deferred_file *hdf5_file = (hdf5_deferred_file *)file;
+    char *string_block = NULL;
+    hid_t dataset_id;
+
+    dataset_id = H5Dopen(hdf5_file->root_id, hdf5_file->dataset_name[variable_id]);
+    if (dataset_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (is_ragged_dataset(hdf5_file, dataset_id, variable))
+    {
+        if (read_ragged_variable_data(dataset_id, hdf5_file->vertical_count, variable, variable->data,
+                                      &string_block) != 0)
+        {
+            H5Dclose(dataset_id);
+            return -1;
+        }
+    }
+    else if (read_variable_data(dataset_id, variable->data_type, H5S_ALL, H5S_ALL, variable->num_elements,
+                                variable->data, &string_block) != 0)
+    {
+        H5Dclose(dataset_id);
+        return -1;
+    }
+    harp_variable_set_string_block(variable, string_block);
+
+    H5Dclose(dataset_id);
+
+    return 0;
+}
+
+static int deferred_read_time_ranges(void *file, int variable_id, const harp_variable *variable, long num_ranges,
+                                     const long *range_start, const long *range_length, harp_array data)
+{
+    hdf5_deferred_file *hdf5_file = (hdf5_deferred_file *)file;
+    hid_t dataset_id;
+
+    dataset_id = H5Dopen(hdf5_file->root_id, hdf5_file->dataset_name[variable_id]);
+    if (dataset_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (is_ragged_dataset(hdf5_file, dataset_id, variable))
+    {
+        if (read_ragged_variable_time_ranges(dataset_id, hdf5_file->vertical_count, variable, num_ranges, range_start,
+                                             range_length, data) != 0)
+        {
+            H5Dclose(dataset_id);
+            return -1;
+        }
+    }
+    else if (read_variable_time_ranges(dataset_id, variable->data_type, num_ranges, range_start, range_length,
+                                       data) != 0)
+    {
+        H5Dclose(dataset_id);
+        return -1;
+    }
+
+    H5Dclose(dataset_id);
+
+    return 0;
+}
+
+static int deferred_close(void *file)
+{
+    hdf5_deferred_file *hdf5_file = (hdf5_deferred_file *)file;
+    int i;
+
+    if (hdf5_file->dataset_name != NULL)
+    {
+        for (i = 0; i < hdf5_file->num_datasets; i++)
+        {
+            free(hdf5_file->dataset_name[i]);
+        }
+        free(hdf5_file->dataset_name);
+    }
+    if (hdf5_file->vertical_count != NULL)
+    {
+        free(hdf5_file->vertical_count);
+    }
+    if (hdf5_file->root_id >= 0)
+    {
+        H5Gclose(hdf5_file->root_id);
+    }
+    H5Fclose(hdf5_file->file_id);
+    free(hdf5_file);
+
+    return 0;
+}
+
+/* Import the variables of a HARP HDF5 product without reading the data of numeric variables.
+ * The file is kept open until the deferred import is deleted.
+ */
+int harp_import_deferred_hdf5(const char *filename, harp_product **product, harp_deferred_import **import)
+{
+    harp_deferred_import *new_import;
+    harp_product *new_product;
+    hdf5_deferred_file *hdf5_file;
+
+    hdf5_file = (hdf5_deferred_file *)malloc(sizeof(hdf5_deferred_file));
+    if (hdf5_file == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(hdf5_deferred_file), __FILE__, __LINE__);
+        return -1;
+    }
+    hdf5_file->root_id = -1;
+    hdf5_file->num_datasets = 0;
+    hdf5_file->dataset_name = NULL;
+    hdf5_file->vertical_count = NULL;
+
+    hdf5_file->file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (hdf5_file->file_id < 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        free(hdf5_file);
+        return -1;
+    }
+
+    if (verify_product(hdf5_file->file_id) != 0)
+    {
+        deferred_close(hdf5_file);
+        return -1;
+    }
+
+    hdf5_file->root_id = H5Gopen(hdf5_file->file_id, "/");
+    if (hdf5_file->root_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        deferred_close(hdf5_file);
+        return -1;
+    }
+
+    if (harp_deferred_import_new(&new_import) != 0)
+    {
+        deferred_close(hdf5_file);
+        return -1;
+    }
+    new_import->file = hdf5_file;
+    new_import->read_data = deferred_read_data;
+    new_import->read_time_ranges = deferred_read_time_ranges;
+    new_import->close = deferred_close;
+
+    if (harp_product_new(&new_product) != 0)
+    {
+        harp_deferred_import_delete(new_import);
+        return -1;
+    }
+
+    if (read_product(hdf5_file->file_id, new_product, new_import, &hdf5_file->vertical_count) != 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        harp_product_delete(new_product);
+        harp_deferred_import_delete(new_import);
+        return -1;
+    }
+
+    *product = new_product;
+    *import = new_import;
+    return 0;
+}
+
+int harp_import_global_attributes_hdf5(const char *filename, double *datetime_start, double *datetime_stop,
+                                       long dimension[], char **source_product)
+{
+    char *attr_source_product = NULL;
+    harp_scalar attr_datetime_start;
+    harp_scalar attr_datetime_stop;
+    harp_data_type attr_data_type;
+    long attr_dimension[HARP_NUM_DIM_TYPES];
+    hid_t file_id;
+    hid_t root_id;
+    int result;
+    int i;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file_id < 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (verify_product(file_id) != 0)
+    {
+        H5Fclose(file_id);
+        return -1;
+    }
+
+    root_id = H5Gopen(file_id, "/");
+    if (root_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Fclose(file_id);
+        return -1;
+    }
+
+    if (datetime_start != NULL)
+    {
+        result = H5Aexists(root_id, "datetime_start");
+        if (result > 0)
+        {
+            if (read_numeric_attribute(root_id, "datetime_start", &attr_data_type, &attr_datetime_start) != 0)
+            {
+                H5Gclose(root_id);
+                H5Fclose(file_id);
+                return -1;
+            }
+            if (attr_data_type != harp_type_double)
+            {
+                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_start' has invalid type");
+                H5Gclose(root_id);
+                H5Fclose(file_id);
+                return -1;
+            }
+        }
+        else if (result < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Gclose(root_id);
+            H5Fclose(file_id);
+            return -1;
+        }
+        else
+        {
+            attr_datetime_start.double_data = harp_mininf();
+        }
+    }
+
+    if (datetime_stop != NULL)
+    {
+        result = H5Aexists(root_id, "datetime_stop");
+        if (result > 0)
+        {
+            if (read_numeric_attribute(root_id, "datetime_stop", &attr_data_type, &attr_datetime_stop) != 0)
+            {
+                H5Gclose(root_id);
+                H5Fclose(file_id);
+                return -1;
+            }
+            if (attr_data_type != harp_type_double)
+            {
+                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_stop' has invalid type");
+                H5Gclose(root_id);
+                H5Fclose(file_id);
+                return -1;
+            }
+        }
+        else if (result < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Gclose(root_id);
+            H5Fclose(file_id);
+            return -1;
+        }
+        else
+        {
+            attr_datetime_stop.double_data = harp_plusinf();
+        }
+    }
+
+    if (dimension != NULL)
+    {
+        hdf5_dimension_ids dimension_ids = { {0}, {{0, 0}}, {0}, 0, {0, 0}, 0 };
+
+        /* Find dimension scales. */
+        if (find_dimensions(root_id, &dimension_ids) != 0)
+        {
+            H5Gclose(root_id);
+            H5Fclose(file_id);
+            return -1;
+        }
+
+        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        {
+            if (dimension_ids.is_valid[i])
+            {
+                attr_dimension[i] = dimension_ids.length[i];
+            }
+            else
+            {
+                attr_dimension[i] = -1;
+            }
+        }
+    }
+
+    if (source_product != NULL)
+    {
+        result = H5Aexists(root_id, "source_product");
+        if (result > 0)
+        {
+            if (read_string_attribute(root_id, "source_product", &attr_source_product) != 0)
+            {
+                H5Gclose(root_id);
+                H5Fclose(file_id);
+                return -1;
+            }
+        }
+        else if (result < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Gclose(root_id);
+            H5Fclose(file_id);
+            return -1;
+        }
+        else
+        {
+            /* use filename if there is no source_product attribute */
+            attr_source_product = strdup(harp_basename(filename));
+            if (attr_source_product == NULL)
+            {
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                               __LINE__);
+                H5Gclose(root_id);
+                H5Fclose(file_id);
+                return -1;
+            }
+        }
+    }
+
+    H5Fclose(file_id);
+
+    if (datetime_start != NULL)
+    {
+        *datetime_start = attr_datetime_start.double_data;
+    }
+
+    if (datetime_stop != NULL)
+    {
+        *datetime_stop = attr_datetime_stop.double_data;
+    }
+
+    if (source_product != NULL)
+    {
+        *source_product = attr_source_product;
+    }
+
+    if (dimension != NULL)
+    {
+        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        {
+            if (attr_dimension[i] >= 0)
+            {
+                dimension[i] = attr_dimension[i];
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int write_string_attribute(hid_t obj_id, const char *name, const char *data)
+{
+    hid_t attr_id;
+    hid_t space_id;
+    hid_t data_type_id;
+
+    data_type_id = H5Tcopy(H5T_C_S1);
+    if (data_type_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (strlen(data) == 0)
+    {
+        space_id = H5Screate(H5S_NULL);
+        if (space_id < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Tclose(data_type_id);
+            return -1;
+        }
+
+        attr_id = H5Acreate(obj_id, name, data_type_id, space_id, H5P_DEFAULT);
+        H5Sclose(space_id);
+        H5Tclose(data_type_id);
+        if (attr_id < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            return -1;
+        }
+        H5Aclose(attr_id);
+
+        return 0;
+    }
+
+    if (H5Tset_size(data_type_id, strlen(data)) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Tclose(data_type_id);
+        return -1;
+    }
+
+    space_id = H5Screate(H5S_SCALAR);
+    if (space_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Tclose(data_type_id);
+        return -1;
+    }
+
+    attr_id = H5Acreate(obj_id, name, data_type_id, space_id, H5P_DEFAULT);
+    if (attr_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(space_id);
+        H5Tclose(data_type_id);
+        return -1;
+    }
+    H5Sclose(space_id);
+
+    if (H5Awrite(attr_id, data_type_id, data) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Aclose(attr_id);
+        H5Tclose(data_type_id);
+        return -1;
+    }
+
+    H5Aclose(attr_id);
+    H5Tclose(data_type_id);
+    return 0;
+}
+
+static int write_numeric_attribute(hid_t obj_id, const char *name, harp_data_type data_type, harp_scalar data)
+{
+    hid_t attr_id;
+    hid_t space_id;
+    herr_t result;
+
+    space_id = H5Screate(H5S_SCALAR);
+    if (space_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    attr_id = H5Acreate(obj_id, name, get_hdf5_type(data_type), space_id, H5P_DEFAULT);
+    if (attr_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(space_id);
+        return -1;
+    }
+    H5Sclose(space_id);
+
+    switch (data_type)
+    {
+        case harp_type_int8:
+            result = H5Awrite(attr_id, H5T_NATIVE_SCHAR, &data.int8_data);
+            break;
+        case harp_type_int16:
+            result = H5Awrite(attr_id, H5T_NATIVE_SHORT, &data.int16_data);
+            break;
+        case harp_type_int32:
+            result = H5Awrite(attr_id, H5T_NATIVE_INT, &data.int32_data);
+            break;
+        case harp_type_float:
+            result = H5Awrite(attr_id, H5T_NATIVE_FLOAT, &data.float_data);
+            break;
+        case harp_type_double:
+            result = H5Awrite(attr_id, H5T_NATIVE_DOUBLE, &data.double_data);
+            break;
+        default:
+            assert(0);
+            exit(1);
+    }
+
+    if (result < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Aclose(attr_id);
+        return -1;
+    }
+
+    H5Aclose(attr_id);
+    return 0;
+}
+
+/* Create a fixed length string data type (strings are padded with NUL characters). */
+static hid_t create_string_type(long length)
+{
+    hid_t data_type_id;
+
+    data_type_id = H5Tcopy(H5T_C_S1);
+    if (data_type_id < 0)
     {
-        harp_add_error_message(" (%s)", filename);
-        harp_product_delete(new_product);
-        H5Fclose(file_id);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    *product = new_product;
+    if (H5Tset_size(data_type_id, length) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Tclose(data_type_id);
+        return -1;
+    }
 
-    H5Fclose(file_id);
+    if (H5Tset_strpad(data_type_id, H5T_STR_NULLPAD) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Tclose(data_type_id);
+        return -1;
+    }
 
-    return 0;
+    return data_type_id;
 }
 
-int harp_import_global_attributes_hdf5(const char *filename, double *datetime_start, double *datetime_stop,
-                                       long dimension[], char **source_product)
+/* Create the dataset for a variable (without writing its data).
+ * If compression is enabled, the chunk size is based on the dimensions of chunk_variable (which is the variable itself
+ * for regular exports and the variable of a single block of time samples for a product writer).
+ */
+static int create_dataset(hid_t group_id, const char *name, const harp_variable *variable, hid_t data_type_id,
+                          const harp_variable *chunk_variable, hid_t *dataset_id)
 {
-    char *attr_source_product = NULL;
-    harp_scalar attr_datetime_start;
-    harp_scalar attr_datetime_stop;
-    harp_data_type attr_data_type;
-    long attr_dimension[HARP_NUM_DIM_TYPES];
-    hid_t file_id;
-    hid_t root_id;
-    int result;
+    hsize_t dimension[HARP_MAX_NUM_DIMS];
+    hid_t space_id;
+    hid_t dcpl_id;
     int i;
 
-    if (filename == NULL)
+    for (i = 0; i < variable->num_dimensions; i++)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        dimension[i] = (hsize_t)variable->dimension[i];
+    }
+
+    space_id = H5Screate_simple(variable->num_dimensions, dimension, NULL);
+    if (space_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-    if (file_id < 0)
+    /* Setup dataset creation property list to enable attribute creation order tracking and indexing. */
+    dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    if (dcpl_id < 0)
     {
-        harp_add_error_message(" (%s)", filename);
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(space_id);
         return -1;
     }
 
-    if (verify_product(file_id) != 0)
+    if (H5Pset_attr_creation_order(dcpl_id, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED) < 0)
     {
-        H5Fclose(file_id);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Pclose(dcpl_id);
+        H5Sclose(space_id);
         return -1;
     }
 
-    root_id = H5Gopen(file_id, "/");
-    if (root_id < 0)
+    if (set_compression(dcpl_id, chunk_variable) != 0)
+    {
+        H5Pclose(dcpl_id);
+        H5Sclose(space_id);
+        return -1;
+    }
+
+    *dataset_id = H5Dcreate(group_id, name, data_type_id, space_id, dcpl_id);
+    if (*dataset_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Fclose(file_id);
+        H5Pclose(dcpl_id);
+        H5Sclose(space_id);
         return -1;
     }
 
-    if (datetime_start != NULL)
+    H5Pclose(dcpl_id);
+    H5Sclose(space_id);
+
+    return 0;
+}
+
+static int write_variable_attributes(hid_t dataset_id, const harp_variable *variable)
+{
+    if (variable->description != NULL && strcmp(variable->description, "") != 0)
     {
-        result = H5Aexists(root_id, "datetime_start");
-        if (result > 0)
-        {
-            if (read_numeric_attribute(root_id, "datetime_start", &attr_data_type, &attr_datetime_start) != 0)
-            {
-                H5Gclose(root_id);
-                H5Fclose(file_id);
-                return -1;
-            }
-            if (attr_data_type != harp_type_double)
-            {
-                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_start' has invalid type");
-                H5Gclose(root_id);
-                H5Fclose(file_id);
-                return -1;
-            }
-        }
-        else if (result < 0)
+        if (write_string_attribute(dataset_id, "description", variable->description) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Gclose(root_id);
-            H5Fclose(file_id);
             return -1;
         }
-        else
+    }
+
+    if (variable->unit != NULL)
+    {
+        if (write_string_attribute(dataset_id, "units", variable->unit) != 0)
         {
-            attr_datetime_start.double_data = harp_mininf();
+            return -1;
         }
     }
 
-    if (datetime_stop != NULL)
+    if (variable->data_type != harp_type_string)
     {
-        result = H5Aexists(root_id, "datetime_stop");
-        if (result > 0)
+        if (!harp_is_valid_min_for_type(variable->data_type, variable->valid_min))
         {
-            if (read_numeric_attribute(root_id, "datetime_stop", &attr_data_type, &attr_datetime_stop) != 0)
+            if (write_numeric_attribute(dataset_id, "valid_min", variable->data_type, variable->valid_min) != 0)
             {
-                H5Gclose(root_id);
-                H5Fclose(file_id);
                 return -1;
             }
-            if (attr_data_type != harp_type_double)
+        }
+
+        if (!harp_is_valid_max_for_type(variable->data_type, variable->valid_max))
+        {
+            if (write_numeric_attribute(dataset_id, "valid_max", variable->data_type, variable->valid_max) != 0)
             {
-                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_stop' has invalid type");
-                H5Gclose(root_id);
-                H5Fclose(file_id);
                 return -1;
             }
         }
-        else if (result < 0)
-        {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Gclose(root_id);
-            H5Fclose(file_id);
-            return -1;
-        }
-        else
-        {
-            attr_datetime_stop.double_data = harp_plusinf();
-        }
     }
 
-    if (dimension != NULL)
+    if (variable->num_enum_values > 0 && variable->data_type == harp_type_int8)
     {
-        hdf5_dimension_ids dimension_ids = { {0}, {{0, 0}}, {0} };
+        char *attribute_value;
 
-        /* Find dimension scales. */
-        if (find_dimensions(root_id, &dimension_ids) != 0)
+        if (harp_variable_get_flag_values_string(variable, &attribute_value) != 0)
         {
-            H5Gclose(root_id);
-            H5Fclose(file_id);
             return -1;
         }
-
-        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        if (write_string_attribute(dataset_id, "flag_values", attribute_value) != 0)
         {
-            if (dimension_ids.is_valid[i])
-            {
-                attr_dimension[i] = dimension_ids.length[i];
-            }
-            else
-            {
-                attr_dimension[i] = -1;
-            }
+            free(attribute_value);
+            return -1;
         }
-    }
+        free(attribute_value);
 
-    if (source_product != NULL)
-    {
-        result = H5Aexists(root_id, "source_product");
-        if (result > 0)
-        {
-            if (read_string_attribute(root_id, "source_product", &attr_source_product) != 0)
-            {
-                H5Gclose(root_id);
-                H5Fclose(file_id);
-                return -1;
-            }
-        }
-        else if (result < 0)
+        if (harp_variable_get_flag_meanings_string(variable, &attribute_value) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Gclose(root_id);
-            H5Fclose(file_id);
             return -1;
         }
-        else
+        if (write_string_attribute(dataset_id, "flag_meanings", attribute_value) != 0)
         {
-            /* use filename if there is no source_product attribute */
-            attr_source_product = strdup(harp_basename(filename));
-            if (attr_source_product == NULL)
-            {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
-                               __LINE__);
-                H5Gclose(root_id);
-                H5Fclose(file_id);
-                return -1;
-            }
+            free(attribute_value);
+            return -1;
         }
+        free(attribute_value);
     }
 
-    H5Fclose(file_id);
-
-    if (datetime_start != NULL)
-    {
-        *datetime_start = attr_datetime_start.double_data;
-    }
+    return 0;
+}
 
-    if (datetime_stop != NULL)
-    {
-        *datetime_stop = attr_datetime_stop.double_data;
-    }
+static int write_variable(hid_t group_id, const char *name, harp_variable *variable)
+{
+    hid_t dataset_id;
 
-    if (source_product != NULL)
+    if (variable->data_type == harp_type_string)
     {
-        *source_product = attr_source_product;
-    }
+        hid_t data_type_id;
+        long length;
+        char *buffer;
 
-    if (dimension != NULL)
-    {
-        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data, 1, &length,
+                                                  &buffer) != 0)
         {
-            if (attr_dimension[i] >= 0)
-            {
-                dimension[i] = attr_dimension[i];
-            }
+            return -1;
         }
-    }
-
-    return 0;
-}
 
-static int write_string_attribute(hid_t obj_id, const char *name, const char *data)
-{
-    hid_t attr_id;
-    hid_t space_id;
-    hid_t data_type_id;
+        data_type_id = create_string_type(length);
+        if (data_type_id < 0)
+        {
+            free(buffer);
+            return -1;
+        }
 
-    data_type_id = H5Tcopy(H5T_C_S1);
-    if (data_type_id < 0)
-    {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        return -1;
-    }
+        if (create_dataset(group_id, name, variable, data_type_id, variable, &dataset_id) != 0)
+        {
+            H5Tclose(data_type_id);
+            free(buffer);
+            return -1;
+        }
 
-    if (strlen(data) == 0)
-    {
-        space_id = H5Screate(H5S_NULL);
-        if (space_id < 0)
+        if (H5Dwrite(dataset_id, data_type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer) < 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Dclose(dataset_id);
             H5Tclose(data_type_id);
+            free(buffer);
             return -1;
         }
 
-        attr_id = H5Acreate(obj_id, name, data_type_id, space_id, H5P_DEFAULT);
-        H5Sclose(space_id);
         H5Tclose(data_type_id);
-        if (attr_id < 0)
+        free(buffer);
+    }
+    else
+    {
+        if (create_dataset(group_id, name, variable, get_hdf5_type(variable->data_type), variable, &dataset_id) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
             return -1;
         }
-        H5Aclose(attr_id);
 
-        return 0;
+        if (H5Dwrite(dataset_id, get_hdf5_type(variable->data_type), H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                     variable->data.ptr) < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Dclose(dataset_id);
+            return -1;
+        }
     }
 
-    if (H5Tset_size(data_type_id, strlen(data)) < 0)
+    if (write_variable_attributes(dataset_id, variable) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Tclose(data_type_id);
+        H5Dclose(dataset_id);
         return -1;
     }
 
-    space_id = H5Screate(H5S_SCALAR);
+    H5Dclose(dataset_id);
+
+    return 0;
+}
+
+static int write_dimension_scale(hid_t group_id, const char *name, long length, hid_t *dimensions_id)
+{
+    hid_t space_id;
+    hid_t dcpl_id;
+    hid_t dataset_id;
+    hsize_t dimension[1];
+
+    dimension[0] = length;
+
+    space_id = H5Screate_simple(1, dimension, NULL);
     if (space_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Tclose(data_type_id);
         return -1;
     }
 
-    attr_id = H5Acreate(obj_id, name, data_type_id, space_id, H5P_DEFAULT);
-    if (attr_id < 0)
+    /* Setup dataset creation property list to enable attribute creation order tracking and indexing. */
+    dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    if (dcpl_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
         H5Sclose(space_id);
-        H5Tclose(data_type_id);
         return -1;
     }
-    H5Sclose(space_id);
 
-    if (H5Awrite(attr_id, data_type_id, data) < 0)
+    if (H5Pset_attr_creation_order(dcpl_id, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED) < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Aclose(attr_id);
-        H5Tclose(data_type_id);
+        H5Pclose(dcpl_id);
+        H5Sclose(space_id);
         return -1;
     }
 
-    H5Aclose(attr_id);
-    H5Tclose(data_type_id);
-    return 0;
-}
-
-static int write_numeric_attribute(hid_t obj_id, const char *name, harp_data_type data_type, harp_scalar data)
-{
-    hid_t attr_id;
-    hid_t space_id;
-    herr_t result;
-
-    space_id = H5Screate(H5S_SCALAR);
-    if (space_id < 0)
+    dataset_id = H5Dcreate(group_id, name, H5T_NATIVE_FLOAT, space_id, dcpl_id);
+    if (dataset_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Pclose(dcpl_id);
+        H5Sclose(space_id);
         return -1;
     }
 
-    attr_id = H5Acreate(obj_id, name, get_hdf5_type(data_type), space_id, H5P_DEFAULT);
-    if (attr_id < 0)
+    H5Pclose(dcpl_id);
+    H5Sclose(space_id);
+
+    if (H5DSset_scale(dataset_id, DIM_WITHOUT_VARIABLE) < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Sclose(space_id);
+        H5Dclose(dataset_id);
         return -1;
     }
-    H5Sclose(space_id);
 
-    switch (data_type)
+    if (dimensions_id != NULL)
     {
-        case harp_type_int8:
-            result = H5Awrite(attr_id, H5T_NATIVE_SCHAR, &data.int8_data);
-            break;
-        case harp_type_int16:
-            result = H5Awrite(attr_id, H5T_NATIVE_SHORT, &data.int16_data);
-            break;
-        case harp_type_int32:
-            result = H5Awrite(attr_id, H5T_NATIVE_INT, &data.int32_data);
-            break;
-        case harp_type_float:
-            result = H5Awrite(attr_id, H5T_NATIVE_FLOAT, &data.float_data);
-            break;
-        case harp_type_double:
-            result = H5Awrite(attr_id, H5T_NATIVE_DOUBLE, &data.double_data);
-            break;
-        default:
-            assert(0);
-            exit(1);
+        *dimensions_id = dataset_id;
     }
-
-    if (result < 0)
+    else
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Aclose(attr_id);
-        return -1;
+        H5Dclose(dataset_id);
     }
 
-    H5Aclose(attr_id);
     return 0;
 }
 
-static int write_variable(hid_t group_id, const char *name, harp_variable *variable)
+static int write_dimension(hid_t group_id, harp_dimension_type dimension_type, long length, hid_t *dimensions_id)
 {
-    hsize_t dimension[HARP_MAX_NUM_DIMS];
-    hid_t space_id;
-    hid_t dcpl_id;
-    hid_t dataset_id;
-    int i;
-
-    for (i = 0; i < variable->num_dimensions; i++)
+    if (dimension_type == harp_dimension_independent)
     {
-        dimension[i] = (hsize_t)variable->dimension[i];
+        char dataset_name[64];
+
+        sprintf(dataset_name, "independent_%ld", length);
+        return write_dimension_scale(group_id, dataset_name, length, dimensions_id);
     }
 
-    if (variable->data_type == harp_type_string)
+    return write_dimension_scale(group_id, harp_get_dimension_type_name(dimension_type), length, dimensions_id);
+}
+
+static int write_dimensions(hid_t group_id, const harp_product *product, hdf5_dimensions *dimensions)
+{
+    harp_scalar netcdf4_dimension_id;
+    int i;
+
+    netcdf4_dimension_id.int32_data = 0;
+
+    /* Order netCDF dimension ids such that physical dimensions appear before independent dimensions. */
+
+    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
     {
-        hid_t data_type_id;
-        long length;
-        char *buffer;
+        harp_variable *variable;
+        harp_dimension_type dimension_type;
+        hid_t dataset_id;
 
-        if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data, 1, &length,
-                                                  &buffer) != 0)
+        if (product->dimension[i] == 0)
         {
-            return -1;
+            /* Product does not depend on this dimension. */
+            continue;
         }
 
-        data_type_id = H5Tcopy(H5T_C_S1);
-        if (data_type_id < 0)
+        dimension_type = (harp_dimension_type)i;
+        if (harp_product_get_variable_by_name(product, harp_get_dimension_type_name(dimension_type), &variable) < 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            free(buffer);
-            return -1;
+            if (harp_errno != HARP_ERROR_VARIABLE_NOT_FOUND)
+            {
+                return -1;
+            }
+
+            /* Intentional fall-through. */
+        }
+        else if (variable->num_dimensions == 1 && *variable->dimension_type == dimension_type)
+        {
+            /* This variable will be upgraded to a dimension scale in finalize_dimensions(). */
+            netcdf4_dimension_id.int32_data++;
+            continue;
         }
 
-        if (H5Tset_size(data_type_id, length) < 0)
+        /* Write a dimension scale without a coordinate variable attached to it. */
+        if (write_dimension(group_id, dimension_type, product->dimension[i], &dataset_id) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Tclose(data_type_id);
-            free(buffer);
+            H5Dclose(dataset_id);
             return -1;
         }
 
-        if (H5Tset_strpad(data_type_id, H5T_STR_NULLPAD) < 0)
+        if (write_numeric_attribute(dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Tclose(data_type_id);
-            free(buffer);
+            H5Dclose(dataset_id);
             return -1;
         }
 
-        space_id = H5Screate_simple(variable->num_dimensions, dimension, NULL);
-        if (space_id < 0)
+        if (dimensions_add(dimensions, dimension_type, product->dimension[i], dataset_id) < 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Tclose(data_type_id);
-            free(buffer);
+            H5Dclose(dataset_id);
             return -1;
         }
 
-        /* Setup dataset creation property list to enable attribute creation order tracking and indexing. */
-        dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
-        if (dcpl_id < 0)
+        netcdf4_dimension_id.int32_data++;
+    }
+
+    for (i = 0; i < product->num_variables; i++)
+    {
+        harp_variable *variable;
+        int j;
+
+        variable = product->variable[i];
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            hid_t dataset_id;
+
+            if (variable->dimension_type[j] != harp_dimension_independent)
+            {
+                continue;
+            }
+
+            if (dimensions_find(dimensions, harp_dimension_independent, variable->dimension[j]) >= 0)
+            {
+                continue;
+            }
+
+            /* Write a dimension scale without a coordinate variable attached to it. */
+            if (write_dimension(group_id, harp_dimension_independent, variable->dimension[j], &dataset_id) != 0)
+            {
+                H5Dclose(dataset_id);
+                return -1;
+            }
+
+            if (write_numeric_attribute(dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
+            {
+                H5Dclose(dataset_id);
+                return -1;
+            }
+
+            if (dimensions_add(dimensions, harp_dimension_independent, variable->dimension[j], dataset_id) < 0)
+            {
+                H5Dclose(dataset_id);
+                return -1;
+            }
+
+            netcdf4_dimension_id.int32_data++;
+        }
+    }
+
+    return 0;
+}
+
+static int finalize_dimensions(hid_t group_id, const harp_product *product, hdf5_dimensions *dimensions)
+{
+    harp_scalar netcdf4_dimension_id;
+    int i;
+
+    netcdf4_dimension_id.int32_data = 0;
+
+    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    {
+        const char *dataset_name;
+        harp_dimension_type dimension_type;
+        hid_t dataset_id;
+
+        if (product->dimension[i] == 0)
+        {
+            /* Product does not depend on this dimension. */
+            continue;
+        }
+
+        dimension_type = (harp_dimension_type)i;
+        dataset_name = harp_get_dimension_type_name(dimension_type);
+
+        if (dimensions_find(dimensions, dimension_type, product->dimension[i]) >= 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Sclose(space_id);
-            H5Tclose(data_type_id);
-            free(buffer);
-            return -1;
+            netcdf4_dimension_id.int32_data++;
+            continue;
         }
 
-        if (H5Pset_attr_creation_order(dcpl_id, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED) < 0)
+        dataset_id = H5Dopen(group_id, dataset_name);
+        if (dataset_id < 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Pclose(dcpl_id);
-            H5Sclose(space_id);
-            H5Tclose(data_type_id);
-            free(buffer);
+            harp_set_error(HARP_ERROR_EXPORT, "dataset '%s' does not exist", dataset_name);
             return -1;
         }
 
-        if (set_compression(dcpl_id, variable) != 0)
+        /* Upgrade dataset to a dimension scale. The dataset acts as the attached coordinate variable. */
+        if (H5DSset_scale(dataset_id, DIM_WITH_VARIABLE) != 0)
         {
-            H5Pclose(dcpl_id);
-            H5Sclose(space_id);
-            H5Tclose(data_type_id);
-            free(buffer);
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Dclose(dataset_id);
             return -1;
         }
 
-        dataset_id = H5Dcreate(group_id, name, data_type_id, space_id, dcpl_id);
-        if (dataset_id < 0)
+        /* Re-order netCDF dimension ids such that physical dimensions appear before independent dimensions. */
+        if (write_numeric_attribute(dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Pclose(dcpl_id);
-            H5Sclose(space_id);
-            H5Tclose(data_type_id);
-            free(buffer);
+            H5Dclose(dataset_id);
             return -1;
         }
 
-        H5Pclose(dcpl_id);
-        H5Sclose(space_id);
-
-        if (H5Dwrite(dataset_id, data_type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer) < 0)
+        if (dimensions_add(dimensions, dimension_type, product->dimension[i], dataset_id) < 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
             H5Dclose(dataset_id);
-            H5Tclose(data_type_id);
-            free(buffer);
             return -1;
         }
 
-        H5Tclose(data_type_id);
-        free(buffer);
+        netcdf4_dimension_id.int32_data++;
     }
-    else
+
+    return 0;
+}
+
+/* Attach the dimension scales to the datasets of all variables. If vertical_sample_id is not negative, the vertical
+ * profiles of the product are stored as contiguous ragged arrays and vertical_sample_id is the vertical sample
+ * dimension scale.
+ */
+static int attach_dimensions(hid_t group_id, const harp_product *product, const hdf5_dimensions *dimensions,
+                             hid_t vertical_sample_id)
+{
+    int i;
+
+    for (i = 0; i < product->num_variables; i++)
     {
-        space_id = H5Screate_simple(variable->num_dimensions, dimension, NULL);
-        if (space_id < 0)
+        const harp_variable *variable;
+        char *name;
+        hid_t dataset_id;
+        int j;
+
+        variable = product->variable[i];
+        if (variable->num_dimensions == 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            return -1;
+            continue;
         }
 
-        /* Setup dataset creation property list to enable attribute creation order tracking and indexing. */
-        dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
-        if (dcpl_id < 0)
+        name = get_hdf5_variable_name(product, variable);
+        if (name == NULL)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Sclose(space_id);
             return -1;
         }
-
-        if (H5Pset_attr_creation_order(dcpl_id, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED) < 0)
+        dataset_id = H5Dopen(group_id, name);
+        free(name);
+        if (dataset_id < 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Pclose(dcpl_id);
-            H5Sclose(space_id);
             return -1;
         }
 
-        if (set_compression(dcpl_id, variable) != 0)
+        if (variable->num_dimensions == 1)
         {
-            H5Pclose(dcpl_id);
-            H5Sclose(space_id);
-            return -1;
+            htri_t is_dimension_scale;
+
+            is_dimension_scale = H5DSis_scale(dataset_id);
+            if (is_dimension_scale < 0)
+            {
+                H5Dclose(dataset_id);
+                harp_set_error(HARP_ERROR_HDF5, NULL);
+                return -1;
+            }
+
+            if (is_dimension_scale)
+            {
+                /* Dimension scales cannot be attached to other dimension scales. */
+                H5Dclose(dataset_id);
+                continue;
+            }
+        }
+
+        j = 0;
+        if (vertical_sample_id >= 0 && harp_variable_has_ragged_vertical_layout(variable))
+        {
+            /* the time and vertical dimension are stored as a single vertical sample dimension */
+            if (H5DSattach_scale(dataset_id, vertical_sample_id, 0) != 0)
+            {
+                harp_set_error(HARP_ERROR_HDF5, NULL);
+                H5Dclose(dataset_id);
+                return -1;
+            }
+            j = 2;
+        }
+        for (; j < variable->num_dimensions; j++)
+        {
+            int index;
+
+            index = dimensions_find(dimensions, variable->dimension_type[j], variable->dimension[j]);
+            if (index < 0)
+            {
+                harp_set_error(HARP_ERROR_EXPORT, "no dimension of type '%s' and length %ld",
+                               harp_get_dimension_type_name(variable->dimension_type[j]), variable->dimension[j]);
+                H5Dclose(dataset_id);
+                return -1;
+            }
+
+            if (H5DSattach_scale(dataset_id, dimensions->dataset_id[index],
+                                 vertical_sample_id >= 0 && harp_variable_has_ragged_vertical_layout(variable) ?
+                                 j - 1 : j) != 0)
+            {
+                harp_set_error(HARP_ERROR_HDF5, NULL);
+                H5Dclose(dataset_id);
+                return -1;
+            }
         }
 
-        dataset_id = H5Dcreate(group_id, name, get_hdf5_type(variable->data_type), space_id, dcpl_id);
+        H5Dclose(dataset_id);
+    }
+
+    if (vertical_sample_id >= 0)
+    {
+        hid_t dataset_id;
+        int index;
+
+        index = dimensions_find(dimensions, harp_dimension_time, product->dimension[harp_dimension_time]);
+        assert(index >= 0);
+
+        dataset_id = H5Dopen(group_id, VERTICAL_COUNT_NAME);
         if (dataset_id < 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
-            H5Pclose(dcpl_id);
-            H5Sclose(space_id);
             return -1;
         }
-
-        H5Pclose(dcpl_id);
-        H5Sclose(space_id);
-
-        if (H5Dwrite(dataset_id, get_hdf5_type(variable->data_type), H5S_ALL, H5S_ALL, H5P_DEFAULT,
-                     variable->data.ptr) < 0)
+        if (H5DSattach_scale(dataset_id, dimensions->dataset_id[index], 0) != 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
             H5Dclose(dataset_id);
             return -1;
         }
+        H5Dclose(dataset_id);
     }
 
-    /* Write attributes. */
-    if (variable->description != NULL && strcmp(variable->description, "") != 0)
+    return 0;
+}
+
+/* Determine whether the vertical profiles of the product should be stored as contiguous ragged arrays (see
+ * harp_set_option_ragged_vertical()). If so, the number of vertical levels to store for each time sample is returned
+ * in vertical_count (which should be released with free()) and the total number of stored levels in num_samples.
+ * Otherwise vertical_count is set to NULL.
+ */
+static int get_vertical_count(const harp_product *product, harp_deferred_import *import, long **vertical_count,
+                              long *num_samples)
+{
+    long *count;
+    long i;
+
+    *vertical_count = NULL;
+    *num_samples = 0;
+
+    if (!harp_option_ragged_vertical || product->dimension[harp_dimension_time] == 0 ||
+        product->dimension[harp_dimension_vertical] == 0 || harp_product_has_variable(product, VERTICAL_COUNT_NAME) ||
+        harp_product_has_variable(product, VERTICAL_SAMPLE_NAME))
     {
-        if (write_string_attribute(dataset_id, "description", variable->description) != 0)
-        {
-            H5Dclose(dataset_id);
-            return -1;
-        }
+        return 0;
     }
 
-    if (variable->unit != NULL)
+    count = malloc(product->dimension[harp_dimension_time] * sizeof(long));
+    if (count == NULL)
     {
-        if (write_string_attribute(dataset_id, "units", variable->unit) != 0)
-        {
-            H5Dclose(dataset_id);
-            return -1;
-        }
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       product->dimension[harp_dimension_time] * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    if (harp_product_get_vertical_count(product, import, count) != 0)
+    {
+        free(count);
+        return -1;
+    }
+    for (i = 0; i < product->dimension[harp_dimension_time]; i++)
+    {
+        *num_samples += count[i];
     }
 
-    if (variable->data_type != harp_type_string)
+    /* only use ragged arrays if this actually removes padding (and, as for netCDF, never use an empty dimension) */
+    if (*num_samples == 0 ||
+        *num_samples == product->dimension[harp_dimension_time] * product->dimension[harp_dimension_vertical])
     {
-        if (!harp_is_valid_min_for_type(variable->data_type, variable->valid_min))
+        free(count);
+        *num_samples = 0;
+        return 0;
+    }
+
+    *vertical_count = count;
+
+    return 0;
+}
+
+/* Write the dimension scale of the vertical samples of ragged vertical profiles. */
+static int write_vertical_sample_dimension(hid_t group_id, const harp_product *product,
+                                           const hdf5_dimensions *dimensions, long num_samples, hid_t *dataset_id)
+{
+    harp_scalar netcdf4_dimension_id;
+    int i;
+
+    /* the vertical sample dimension gets the netCDF dimension id after those of write_dimensions() */
+    netcdf4_dimension_id.int32_data = 0;
+    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    {
+        if (product->dimension[i] > 0)
         {
-            if (write_numeric_attribute(dataset_id, "valid_min", variable->data_type, variable->valid_min) != 0)
-            {
-                H5Dclose(dataset_id);
-                return -1;
-            }
+            netcdf4_dimension_id.int32_data++;
         }
-
-        if (!harp_is_valid_max_for_type(variable->data_type, variable->valid_max))
+    }
+    for (i = 0; i < dimensions->num_dimensions; i++)
+    {
+        if (dimensions->type[i] == harp_dimension_independent)
         {
-            if (write_numeric_attribute(dataset_id, "valid_max", variable->data_type, variable->valid_max) != 0)
-            {
-                H5Dclose(dataset_id);
-                return -1;
-            }
+            netcdf4_dimension_id.int32_data++;
         }
     }
 
-    if (variable->num_enum_values > 0 && variable->data_type == harp_type_int8)
+    if (write_dimension_scale(group_id, VERTICAL_SAMPLE_NAME, num_samples, dataset_id) != 0)
+    {
+        return -1;
+    }
+    if (write_numeric_attribute(*dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
+    {
+        H5Dclose(*dataset_id);
+        *dataset_id = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Write the vertical profiles of a variable as a contiguous ragged array (i.e. only the first vertical_count[i] levels
+ * of each time sample i), with the time and vertical dimension replaced by a single vertical sample dimension.
+ */
+static int write_ragged_variable(hid_t group_id, const char *name, const harp_variable *variable,
+                                 const long *vertical_count, long num_samples)
+{
+    harp_variable packed_variable;
+    int result;
+    int i;
+
+    /* use a shallow copy of the variable that refers to the packed data (strings are not duplicated) */
+    packed_variable = *variable;
+    if (harp_variable_pack_ragged_vertical(variable, vertical_count, &packed_variable.data,
+                                           &packed_variable.num_elements) != 0)
+    {
+        return -1;
+    }
+    packed_variable.num_dimensions = variable->num_dimensions - 1;
+    packed_variable.dimension_type[0] = harp_dimension_independent;
+    packed_variable.dimension[0] = num_samples;
+    for (i = 1; i < packed_variable.num_dimensions; i++)
+    {
+        packed_variable.dimension_type[i] = variable->dimension_type[i + 1];
+        packed_variable.dimension[i] = variable->dimension[i + 1];
+    }
+
+    result = write_variable(group_id, name, &packed_variable);
+    free(packed_variable.data.ptr);
+
+    return result;
+}
+
+/* Write the count dataset of ragged vertical profiles. */
+static int write_vertical_count(hid_t group_id, const harp_product *product, const long *vertical_count)
+{
+    harp_dimension_type dimension_type = harp_dimension_time;
+    harp_variable *variable;
+    hid_t dataset_id;
+    long i;
+
+    if (harp_variable_new(VERTICAL_COUNT_NAME, harp_type_int32, 1, &dimension_type,
+                          &product->dimension[harp_dimension_time], &variable) != 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < variable->num_elements; i++)
+    {
+        variable->data.int32_data[i] = (int32_t)vertical_count[i];
+    }
+    if (harp_variable_set_description(variable, "number of vertical levels stored for each time sample") != 0)
+    {
+        harp_variable_delete(variable);
+        return -1;
+    }
+    if (write_variable(group_id, VERTICAL_COUNT_NAME, variable) != 0)
+    {
+        harp_variable_delete(variable);
+        return -1;
+    }
+    harp_variable_delete(variable);
+
+    dataset_id = H5Dopen(group_id, VERTICAL_COUNT_NAME);
+    if (dataset_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+    if (write_string_attribute(dataset_id, "sample_dimension", VERTICAL_SAMPLE_NAME) != 0)
+    {
+        H5Dclose(dataset_id);
+        return -1;
+    }
+    H5Dclose(dataset_id);
+
+    return 0;
+}
+
+static int write_nc3_strict_attribute(hid_t group_id)
+{
+    harp_scalar nc3_strict;
+
+    nc3_strict.int32_data = 1;
+    return write_numeric_attribute(group_id, NC3_STRICT_ATT_NAME, harp_type_int32, nc3_strict);
+}
+
+static int write_attributes(hid_t group_id, const harp_product *product)
+{
+    harp_scalar datetime_start;
+    harp_scalar datetime_stop;
+
+    if (harp_product_get_datetime_range(product, &datetime_start.double_data, &datetime_stop.double_data) == 0)
     {
-        char *attribute_value;
-
-        if (harp_variable_get_flag_values_string(variable, &attribute_value) != 0)
+        if (write_numeric_attribute(group_id, "datetime_start", harp_type_double, datetime_start) != 0)
         {
             return -1;
         }
-        if (write_string_attribute(dataset_id, "flag_values", attribute_value) != 0)
+
+        if (write_numeric_attribute(group_id, "datetime_stop", harp_type_double, datetime_stop) != 0)
         {
-            free(attribute_value);
             return -1;
         }
-        free(attribute_value);
+    }
 
-        if (harp_variable_get_flag_meanings_string(variable, &attribute_value) != 0)
+    if (product->source_product != NULL && strcmp(product->source_product, "") != 0)
+    {
+        if (write_string_attribute(group_id, "source_product", product->source_product) != 0)
         {
             return -1;
         }
-        if (write_string_attribute(dataset_id, "flag_meanings", attribute_value) != 0)
+    }
+
+    if (product->history != NULL && strcmp(product->history, "") != 0)
+    {
+        if (write_string_attribute(group_id, "history", product->history) != 0)
         {
-            free(attribute_value);
             return -1;
         }
-        free(attribute_value);
     }
 
-    H5Dclose(dataset_id);
-
     return 0;
 }
 
-static int write_dimension(hid_t group_id, harp_dimension_type dimension_type, long length, hid_t *dimensions_id)
+static int write_product(hid_t file_id, const harp_product *product, harp_deferred_import *import)
 {
-    hid_t space_id;
-    hid_t dcpl_id;
-    hid_t dataset_id;
-    hsize_t dimension[1];
-
-    dimension[0] = length;
+    hid_t root_id;
+    hid_t vertical_sample_id = -1;
+    hdf5_dimensions dimensions;
+    long *vertical_count = NULL;
+    long num_samples;
+    int i;
 
-    space_id = H5Screate_simple(1, dimension, NULL);
-    if (space_id < 0)
+    root_id = H5Gopen(file_id, "/");
+    if (root_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
         return -1;
     }
 
-    /* Setup dataset creation property list to enable attribute creation order tracking and indexing. */
-    dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
-    if (dcpl_id < 0)
+    /* Mark the file as a netCDF classic netCDF-4 file. */
+    if (write_nc3_strict_attribute(root_id) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Sclose(space_id);
+        H5Gclose(root_id);
         return -1;
     }
 
-    if (H5Pset_attr_creation_order(dcpl_id, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED) < 0)
+    /* Write file convention. */
+    if (write_string_attribute(root_id, "Conventions", HARP_CONVENTION) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Pclose(dcpl_id);
-        H5Sclose(space_id);
+        H5Gclose(root_id);
         return -1;
     }
 
-    if (dimension_type == harp_dimension_independent)
-    {
-        char dataset_name[64];
-
-        sprintf(dataset_name, "independent_%ld", length);
-        dataset_id = H5Dcreate(group_id, dataset_name, H5T_NATIVE_FLOAT, space_id, dcpl_id);
-    }
-    else
-    {
-        dataset_id = H5Dcreate(group_id, harp_get_dimension_type_name(dimension_type), H5T_NATIVE_FLOAT, space_id,
-                               dcpl_id);
-    }
-
-    if (dataset_id < 0)
+    /* Write product attributes. */
+    if (write_attributes(root_id, product) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Pclose(dcpl_id);
-        H5Sclose(space_id);
+        H5Gclose(root_id);
         return -1;
     }
 
-    H5Pclose(dcpl_id);
-    H5Sclose(space_id);
+    /* Write dimensions and variables. */
+    dimensions_init(&dimensions);
 
-    if (H5DSset_scale(dataset_id, DIM_WITHOUT_VARIABLE) < 0)
+    if (write_dimensions(root_id, product, &dimensions) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        H5Dclose(dataset_id);
-        return -1;
+        goto error;
     }
 
-    if (dimensions_id != NULL)
+    if (get_vertical_count(product, import, &vertical_count, &num_samples) != 0)
     {
-        *dimensions_id = dataset_id;
+        goto error;
     }
-    else
+    if (vertical_count != NULL)
     {
-        H5Dclose(dataset_id);
+        if (write_vertical_sample_dimension(root_id, product, &dimensions, num_samples, &vertical_sample_id) != 0)
+        {
+            goto error;
+        }
     }
 
-    return 0;
-}
-
-static int write_dimensions(hid_t group_id, const harp_product *product, hdf5_dimensions *dimensions)
-{
-    harp_scalar netcdf4_dimension_id;
-    int i;
-
-    netcdf4_dimension_id.int32_data = 0;
-
-    /* Order netCDF dimension ids such that physical dimensions appear before independent dimensions. */
-
-    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    for (i = 0; i < product->num_variables; i++)
     {
-        harp_variable *variable;
-        harp_dimension_type dimension_type;
-        hid_t dataset_id;
+        double trace_start = harp_trace_begin();
+        harp_variable *variable = product->variable[i];
+        char *name;
+        int loaded;
+        int result;
 
-        if (product->dimension[i] == 0)
+        name = get_hdf5_variable_name(product, variable);
+        if (name == NULL)
         {
-            /* Product does not depend on this dimension. */
-            continue;
+            goto error;
         }
-
-        dimension_type = (harp_dimension_type)i;
-        if (harp_product_get_variable_by_name(product, harp_get_dimension_type_name(dimension_type), &variable) < 0)
+        /* the data of deferred variables is only kept in memory while the variable is being written */
+        if (harp_deferred_import_load_variable(import, variable, &loaded) != 0)
         {
-            if (harp_errno != HARP_ERROR_VARIABLE_NOT_FOUND)
-            {
-                return -1;
-            }
-
-            /* Intentional fall-through. */
+            free(name);
+            goto error;
         }
-        else if (variable->num_dimensions == 1 && *variable->dimension_type == dimension_type)
+        if (vertical_count != NULL && harp_variable_has_ragged_vertical_layout(variable))
         {
-            /* This variable will be upgraded to a dimension scale in finalize_dimensions(). */
-            netcdf4_dimension_id.int32_data++;
-            continue;
+            result = write_ragged_variable(root_id, name, variable, vertical_count, num_samples);
         }
-
-        /* Write a dimension scale without a coordinate variable attached to it. */
-        if (write_dimension(group_id, dimension_type, product->dimension[i], &dataset_id) != 0)
+        else
         {
-            H5Dclose(dataset_id);
-            return -1;
+            result = write_variable(root_id, name, variable);
         }
-
-        if (write_numeric_attribute(dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
+        if (loaded)
         {
-            H5Dclose(dataset_id);
-            return -1;
+            harp_deferred_import_unload_variable(import, variable);
+        }
+        free(name);
+        if (result != 0)
+        {
+            goto error;
         }
+        harp_trace_end_variable(trace_start, "export", "write_variable", variable);
+    }
 
-        if (dimensions_add(dimensions, dimension_type, product->dimension[i], dataset_id) < 0)
+    if (vertical_count != NULL)
+    {
+        if (write_vertical_count(root_id, product, vertical_count) != 0)
         {
-            H5Dclose(dataset_id);
-            return -1;
+            goto error;
         }
+    }
 
-        netcdf4_dimension_id.int32_data++;
+    if (finalize_dimensions(root_id, product, &dimensions) != 0)
+    {
+        goto error;
     }
 
-    for (i = 0; i < product->num_variables; i++)
+    if (attach_dimensions(root_id, product, &dimensions, vertical_sample_id) != 0)
     {
-        harp_variable *variable;
-        int j;
+        goto error;
+    }
 
-        variable = product->variable[i];
-        for (j = 0; j < variable->num_dimensions; j++)
-        {
-            hid_t dataset_id;
+    if (vertical_sample_id >= 0)
+    {
+        H5Dclose(vertical_sample_id);
+    }
+    free(vertical_count);
+    dimensions_done(&dimensions);
+    H5Gclose(root_id);
 
-            if (variable->dimension_type[j] != harp_dimension_independent)
-            {
-                continue;
-            }
+    return 0;
 
-            if (dimensions_find(dimensions, harp_dimension_independent, variable->dimension[j]) >= 0)
-            {
-                continue;
-            }
+  error:
+    if (vertical_sample_id >= 0)
+    {
+        H5Dclose(vertical_sample_id);
+    }
+    free(vertical_count);
+    dimensions_done(&dimensions);
+    H5Gclose(root_id);
 
-            /* Write a dimension scale without a coordinate variable attached to it. */
-            if (write_dimension(group_id, harp_dimension_independent, variable->dimension[j], &dataset_id) != 0)
-            {
-                H5Dclose(dataset_id);
-                return -1;
-            }
+    return -1;
+}
 
-            if (write_numeric_attribute(dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
-            {
-                H5Dclose(dataset_id);
-                return -1;
-            }
+/* Export a product to a HARP HDF5 file.
+ * If import is not NULL, the product may contain deferred variables of that import, whose data will be read (and
+ * released again) one variable at a time.
+ */
+int harp_export_hdf5(const char *filename, const harp_product *product, harp_deferred_import *import)
+{
+    hid_t file_id;
+    hid_t fcpl_id;
 
-            if (dimensions_add(dimensions, harp_dimension_independent, variable->dimension[j], dataset_id) < 0)
-            {
-                H5Dclose(dataset_id);
-                return -1;
-            }
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL");
+        return -1;
+    }
 
-            netcdf4_dimension_id.int32_data++;
-        }
+    if (product == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL");
+        return -1;
+    }
+
+    /* Setup file creation property list to enable link and attribute creation
+     * order tracking and indexing.
+     */
+    fcpl_id = H5Pcreate(H5P_FILE_CREATE);
+    if (fcpl_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
+
+    if (H5Pset_link_creation_order(fcpl_id, (H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED)) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Pclose(fcpl_id);
+        return -1;
+    }
+
+    if (H5Pset_attr_creation_order(fcpl_id, (H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED)) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Pclose(fcpl_id);
+        return -1;
+    }
+
+    file_id = H5Fcreate(filename, H5F_ACC_TRUNC, fcpl_id, H5P_DEFAULT);
+    if (file_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        harp_add_error_message(" (%s)", filename);
+        H5Pclose(fcpl_id);
+        return -1;
+    }
+
+    H5Pclose(fcpl_id);
+
+    if (write_product(file_id, product, import) != 0)
+    {
+        harp_add_error_message(" (%s)", filename);
+        H5Fclose(file_id);
+        return -1;
+    }
+
+    if (H5Fclose(file_id) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        harp_add_error_message(" (%s)", filename);
+        return -1;
     }
 
     return 0;
 }
 
-static int finalize_dimensions(hid_t group_id, const harp_product *product, hdf5_dimensions *dimensions)
+/* File information of a product writer (see harp_product_writer_open_hdf5()). */
+typedef struct hdf5_writer_file_struct
 {
-    harp_scalar netcdf4_dimension_id;
+    hid_t file_id;
+    hid_t root_id;
+    int num_datasets;
+    char **dataset_name;        /* [num_datasets] HDF5 dataset name of each variable of the product of the writer */
+    const long *string_length;
+} hdf5_writer_file;
+
+static int writer_write_data(void *file, int variable_index, const harp_variable *variable, long time_offset)
+{
+    hdf5_writer_file *hdf5_file = (hdf5_writer_file *)file;
+    hsize_t start[HARP_MAX_NUM_DIMS];
+    hsize_t count[HARP_MAX_NUM_DIMS];
+    hid_t dataset_id;
+    hid_t file_space_id;
+    hid_t mem_space_id;
+    hid_t data_type_id;
+    char *buffer = NULL;
     int i;
 
-    netcdf4_dimension_id.int32_data = 0;
+    for (i = 0; i < variable->num_dimensions; i++)
+    {
+        start[i] = 0;
+        count[i] = (hsize_t)variable->dimension[i];
+    }
+    start[0] = (hsize_t)time_offset;
 
-    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    dataset_id = H5Dopen(hdf5_file->root_id, hdf5_file->dataset_name[variable_index]);
+    if (dataset_id < 0)
     {
-        const char *dataset_name;
-        harp_dimension_type dimension_type;
-        hid_t dataset_id;
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        return -1;
+    }
 
-        if (product->dimension[i] == 0)
-        {
-            /* Product does not depend on this dimension. */
-            continue;
-        }
+    file_space_id = H5Dget_space(dataset_id);
+    if (file_space_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Dclose(dataset_id);
+        return -1;
+    }
 
-        dimension_type = (harp_dimension_type)i;
-        dataset_name = harp_get_dimension_type_name(dimension_type);
+    if (H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(file_space_id);
+        H5Dclose(dataset_id);
+        return -1;
+    }
 
-        if (dimensions_find(dimensions, dimension_type, product->dimension[i]) >= 0)
-        {
-            netcdf4_dimension_id.int32_data++;
-            continue;
-        }
+    mem_space_id = H5Screate_simple(variable->num_dimensions, count, NULL);
+    if (mem_space_id < 0)
+    {
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        H5Sclose(file_space_id);
+        H5Dclose(dataset_id);
+        return -1;
+    }
 
-        dataset_id = H5Dopen(group_id, dataset_name);
-        if (dataset_id < 0)
+    if (variable->data_type == harp_type_string)
+    {
+        long length;
+
+        /* strings are padded to the fixed string length of the dataset */
+        if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data,
+                                                  hdf5_file->string_length[variable_index], &length, &buffer) != 0)
         {
-            harp_set_error(HARP_ERROR_EXPORT, "dataset '%s' does not exist", dataset_name);
+            H5Sclose(mem_space_id);
+            H5Sclose(file_space_id);
+            H5Dclose(dataset_id);
             return -1;
         }
+        assert(length == hdf5_file->string_length[variable_index]);
 
-        /* Upgrade dataset to a dimension scale. The dataset acts as the attached coordinate variable. */
-        if (H5DSset_scale(dataset_id, DIM_WITH_VARIABLE) != 0)
+        data_type_id = create_string_type(length);
+        if (data_type_id < 0)
         {
-            harp_set_error(HARP_ERROR_HDF5, NULL);
+            free(buffer);
+            H5Sclose(mem_space_id);
+            H5Sclose(file_space_id);
             H5Dclose(dataset_id);
             return -1;
         }
 
-        /* Re-order netCDF dimension ids such that physical dimensions appear before independent dimensions. */
-        if (write_numeric_attribute(dataset_id, NC_DIMID_ATT_NAME, harp_type_int32, netcdf4_dimension_id) != 0)
+        if (H5Dwrite(dataset_id, data_type_id, mem_space_id, file_space_id, H5P_DEFAULT, buffer) < 0)
         {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Tclose(data_type_id);
+            free(buffer);
+            H5Sclose(mem_space_id);
+            H5Sclose(file_space_id);
             H5Dclose(dataset_id);
             return -1;
         }
 
-        if (dimensions_add(dimensions, dimension_type, product->dimension[i], dataset_id) < 0)
+        H5Tclose(data_type_id);
+        free(buffer);
+    }
+    else
+    {
+        if (H5Dwrite(dataset_id, get_hdf5_type(variable->data_type), mem_space_id, file_space_id, H5P_DEFAULT,
+                     variable->data.ptr) < 0)
         {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            H5Sclose(mem_space_id);
+            H5Sclose(file_space_id);
             H5Dclose(dataset_id);
             return -1;
         }
-
-        netcdf4_dimension_id.int32_data++;
     }
 
+    H5Sclose(mem_space_id);
+    H5Sclose(file_space_id);
+    H5Dclose(dataset_id);
+
     return 0;
 }
 
-static int attach_dimensions(hid_t group_id, const harp_product *product, const hdf5_dimensions *dimensions)
+static int writer_write_datetime_range(void *file, int has_datetime_range, double datetime_start,
+                                       double datetime_stop)
 {
-    int i;
+    hdf5_writer_file *hdf5_file = (hdf5_writer_file *)file;
+    harp_scalar value;
 
-    for (i = 0; i < product->num_variables; i++)
+    /* replace the initial values that were written by harp_product_writer_open_hdf5() */
+    if (H5Aexists(hdf5_file->root_id, "datetime_start") > 0)
     {
-        const harp_variable *variable;
-        char *name;
-        hid_t dataset_id;
-        int j;
-
-        variable = product->variable[i];
-        if (variable->num_dimensions == 0)
-        {
-            continue;
-        }
-
-        name = get_hdf5_variable_name(product, variable);
-        if (name == NULL)
+        if (H5Adelete(hdf5_file->root_id, "datetime_start") < 0)
         {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
             return -1;
         }
-        dataset_id = H5Dopen(group_id, name);
-        free(name);
-        if (dataset_id < 0)
+    }
+    if (H5Aexists(hdf5_file->root_id, "datetime_stop") > 0)
+    {
+        if (H5Adelete(hdf5_file->root_id, "datetime_stop") < 0)
         {
             harp_set_error(HARP_ERROR_HDF5, NULL);
             return -1;
         }
+    }
+    if (!has_datetime_range)
+    {
+        return 0;
+    }
 
-        if (variable->num_dimensions == 1)
-        {
-            htri_t is_dimension_scale;
+    value.double_data = datetime_start;
+    if (write_numeric_attribute(hdf5_file->root_id, "datetime_start", harp_type_double, value) != 0)
+    {
+        return -1;
+    }
+    value.double_data = datetime_stop;
+    if (write_numeric_attribute(hdf5_file->root_id, "datetime_stop", harp_type_double, value) != 0)
+    {
+        return -1;
+    }
 
-            is_dimension_scale = H5DSis_scale(dataset_id);
-            if (is_dimension_scale < 0)
-            {
-                H5Dclose(dataset_id);
-                harp_set_error(HARP_ERROR_HDF5, NULL);
-                return -1;
-            }
+    return 0;
+}
 
-            if (is_dimension_scale)
-            {
-                /* Dimension scales cannot be attached to other dimension scales. */
-                H5Dclose(dataset_id);
-                continue;
-            }
-        }
+static int writer_close(void *file)
+{
+    hdf5_writer_file *hdf5_file = (hdf5_writer_file *)file;
+    int result = 0;
+    int i;
 
-        for (j = 0; j < variable->num_dimensions; j++)
+    if (hdf5_file->dataset_name != NULL)
+    {
+        for (i = 0; i < hdf5_file->num_datasets; i++)
         {
-            int index;
-
-            index = dimensions_find(dimensions, variable->dimension_type[j], variable->dimension[j]);
-            if (index < 0)
-            {
-                harp_set_error(HARP_ERROR_EXPORT, "no dimension of type '%s' and length %ld",
-                               harp_get_dimension_type_name(variable->dimension_type[j]), variable->dimension[j]);
-                H5Dclose(dataset_id);
-                return -1;
-            }
-
-            if (H5DSattach_scale(dataset_id, dimensions->dataset_id[index], j) != 0)
+            if (hdf5_file->dataset_name[i] != NULL)
             {
-                harp_set_error(HARP_ERROR_HDF5, NULL);
-                H5Dclose(dataset_id);
-                return -1;
+                free(hdf5_file->dataset_name[i]);
             }
         }
-
-        H5Dclose(dataset_id);
+        free(hdf5_file->dataset_name);
     }
+    if (hdf5_file->root_id >= 0)
+    {
+        H5Gclose(hdf5_file->root_id);
+    }
+    if (hdf5_file->file_id >= 0)
+    {
+        if (H5Fclose(hdf5_file->file_id) < 0)
+        {
+            harp_set_error(HARP_ERROR_HDF5, NULL);
+            result = -1;
+        }
+    }
+    free(hdf5_file);
 
-    return 0;
-}
-
-static int write_nc3_strict_attribute(hid_t group_id)
-{
-    harp_scalar nc3_strict;
-
-    nc3_strict.int32_data = 1;
-    return write_numeric_attribute(group_id, NC3_STRICT_ATT_NAME, harp_type_int32, nc3_strict);
+    return result;
 }
 
-static int write_attributes(hid_t group_id, const harp_product *product)
+/* Create the dataset of a time dependent variable of a product writer (the data is written by writer_write_data). */
+static int writer_create_variable(hdf5_writer_file *hdf5_file, int index, const harp_variable *variable,
+                                  const harp_variable *template_variable)
 {
-    harp_scalar datetime_start;
-    harp_scalar datetime_stop;
+    const harp_variable *chunk_variable = template_variable;
+    hid_t data_type_id;
+    hid_t dataset_id;
 
-    if (harp_product_get_datetime_range(product, &datetime_start.double_data, &datetime_stop.double_data) == 0)
+    if (template_variable->dimension[0] > variable->dimension[0])
     {
-        if (write_numeric_attribute(group_id, "datetime_start", harp_type_double, datetime_start) != 0)
-        {
-            return -1;
-        }
+        chunk_variable = variable;
+    }
 
-        if (write_numeric_attribute(group_id, "datetime_stop", harp_type_double, datetime_stop) != 0)
+    if (variable->data_type == harp_type_string)
+    {
+        data_type_id = create_string_type(hdf5_file->string_length[index]);
+        if (data_type_id < 0)
         {
             return -1;
         }
     }
+    else
+    {
+        data_type_id = get_hdf5_type(variable->data_type);
+    }
 
-    if (product->source_product != NULL && strcmp(product->source_product, "") != 0)
+    if (create_dataset(hdf5_file->root_id, hdf5_file->dataset_name[index], variable, data_type_id, chunk_variable,
+                       &dataset_id) != 0)
     {
-        if (write_string_attribute(group_id, "source_product", product->source_product) != 0)
+        if (variable->data_type == harp_type_string)
         {
-            return -1;
+            H5Tclose(data_type_id);
         }
+        return -1;
+    }
+    if (variable->data_type == harp_type_string)
+    {
+        H5Tclose(data_type_id);
     }
 
-    if (product->history != NULL && strcmp(product->history, "") != 0)
+    if (write_variable_attributes(dataset_id, variable) != 0)
     {
-        if (write_string_attribute(group_id, "history", product->history) != 0)
-        {
-            return -1;
-        }
+        H5Dclose(dataset_id);
+        return -1;
     }
 
+    H5Dclose(dataset_id);
+
     return 0;
 }
 
-static int write_product(hid_t file_id, const harp_product *product)
+static int writer_write_product(hdf5_writer_file *hdf5_file, const harp_product *template_product,
+                                const harp_product *product)
 {
-    hid_t root_id;
     hdf5_dimensions dimensions;
     int i;
 
-    root_id = H5Gopen(file_id, "/");
-    if (root_id < 0)
-    {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
-        return -1;
-    }
-
     /* Mark the file as a netCDF classic netCDF-4 file. */
-    if (write_nc3_strict_attribute(root_id) != 0)
+    if (write_nc3_strict_attribute(hdf5_file->root_id) != 0)
     {
-        H5Gclose(root_id);
         return -1;
     }
 
     /* Write file convention. */
-    if (write_string_attribute(root_id, "Conventions", HARP_CONVENTION) != 0)
+    if (write_string_attribute(hdf5_file->root_id, "Conventions", HARP_CONVENTION) != 0)
     {
-        H5Gclose(root_id);
         return -1;
     }
 
-    /* Write product attributes. */
-    if (write_attributes(root_id, product) != 0)
+    /* Write product attributes (the datetime range is updated when the writer is closed). */
+    if (write_attributes(hdf5_file->root_id, template_product) != 0)
     {
-        H5Gclose(root_id);
         return -1;
     }
 
-    /* Write dimensions and variables. */
     dimensions_init(&dimensions);
 
-    if (write_dimensions(root_id, product, &dimensions) != 0)
+    if (write_dimensions(hdf5_file->root_id, product, &dimensions) != 0)
     {
         dimensions_done(&dimensions);
-        H5Gclose(root_id);
         return -1;
     }
 
     for (i = 0; i < product->num_variables; i++)
     {
-        char *name;
+        harp_variable *variable = product->variable[i];
+        int result;
 
-        name = get_hdf5_variable_name(product, product->variable[i]);
-        if (name == NULL)
+        if (variable->num_dimensions > 0 && variable->dimension_type[0] == harp_dimension_time)
         {
-            return -1;
+            result = writer_create_variable(hdf5_file, i, variable, template_product->variable[i]);
         }
-        if (write_variable(root_id, name, product->variable[i]) != 0)
+        else
+        {
+            result = write_variable(hdf5_file->root_id, hdf5_file->dataset_name[i], variable);
+        }
+        if (result != 0)
         {
-            free(name);
             dimensions_done(&dimensions);
-            H5Gclose(root_id);
             return -1;
         }
-        free(name);
     }
 
-    if (finalize_dimensions(root_id, product, &dimensions) != 0)
+    if (finalize_dimensions(hdf5_file->root_id, product, &dimensions) != 0)
     {
         dimensions_done(&dimensions);
-        H5Gclose(root_id);
         return -1;
     }
 
-    if (attach_dimensions(root_id, product, &dimensions) != 0)
+    if (attach_dimensions(hdf5_file->root_id, product, &dimensions, -1) != 0)
     {
         dimensions_done(&dimensions);
-        H5Gclose(root_id);
         return -1;
     }
 
     dimensions_done(&dimensions);
-    H5Gclose(root_id);
 
     return 0;
 }
 
-int harp_export_hdf5(const char *filename, const harp_product *product)
+/* Create a HARP HDF5 file for the product of the writer (the time dependent data is written by writer_write_data).
+ * The template product provides the initial datetime range and the chunk size of time dependent variables.
+ */
+int harp_product_writer_open_hdf5(const char *filename, const harp_product *template_product,
+                                  harp_product_writer *writer)
 {
-    hid_t file_id;
+    hdf5_writer_file *hdf5_file;
     hid_t fcpl_id;
+    int i;
 
-    if (filename == NULL)
+    hdf5_file = (hdf5_writer_file *)malloc(sizeof(hdf5_writer_file));
+    if (hdf5_file == NULL)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL");
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(hdf5_writer_file), __FILE__, __LINE__);
         return -1;
     }
+    hdf5_file->file_id = -1;
+    hdf5_file->root_id = -1;
+    hdf5_file->num_datasets = 0;
+    hdf5_file->dataset_name = NULL;
+    hdf5_file->string_length = writer->string_length;
 
-    if (product == NULL)
+    if (writer->product->num_variables > 0)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL");
-        return -1;
+        hdf5_file->dataset_name = (char **)malloc(writer->product->num_variables * sizeof(char *));
+        if (hdf5_file->dataset_name == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           writer->product->num_variables * sizeof(char *), __FILE__, __LINE__);
+            writer_close(hdf5_file);
+            return -1;
+        }
+        for (i = 0; i < writer->product->num_variables; i++)
+        {
+            hdf5_file->dataset_name[i] = get_hdf5_variable_name(writer->product, writer->product->variable[i]);
+            if (hdf5_file->dataset_name[i] == NULL)
+            {
+                writer_close(hdf5_file);
+                return -1;
+            }
+            hdf5_file->num_datasets++;
+        }
     }
 
     /* Setup file creation property list to enable link and attribute creation
@@ -2412,6 +3871,7 @@ int harp_export_hdf5(const char *filename, const harp_product *product)
     if (fcpl_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
+        writer_close(hdf5_file);
         return -1;
     }
 
@@ -2419,6 +3879,7 @@ int harp_export_hdf5(const char *filename, const harp_product *product)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
         H5Pclose(fcpl_id);
+        writer_close(hdf5_file);
         return -1;
     }
 
@@ -2426,34 +3887,42 @@ int harp_export_hdf5(const char *filename, const harp_product *product)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
         H5Pclose(fcpl_id);
+        writer_close(hdf5_file);
         return -1;
     }
 
-    file_id = H5Fcreate(filename, H5F_ACC_TRUNC, fcpl_id, H5P_DEFAULT);
-    if (file_id < 0)
+    hdf5_file->file_id = H5Fcreate(filename, H5F_ACC_TRUNC, fcpl_id, H5P_DEFAULT);
+    if (hdf5_file->file_id < 0)
     {
         harp_set_error(HARP_ERROR_HDF5, NULL);
         harp_add_error_message(" (%s)", filename);
         H5Pclose(fcpl_id);
+        writer_close(hdf5_file);
         return -1;
     }
 
     H5Pclose(fcpl_id);
 
-    if (write_product(file_id, product) != 0)
+    hdf5_file->root_id = H5Gopen(hdf5_file->file_id, "/");
+    if (hdf5_file->root_id < 0)
     {
-        harp_add_error_message(" (%s)", filename);
-        H5Fclose(file_id);
+        harp_set_error(HARP_ERROR_HDF5, NULL);
+        writer_close(hdf5_file);
         return -1;
     }
 
-    if (H5Fclose(file_id) < 0)
+    if (writer_write_product(hdf5_file, template_product, writer->product) != 0)
     {
-        harp_set_error(HARP_ERROR_HDF5, NULL);
         harp_add_error_message(" (%s)", filename);
+        writer_close(hdf5_file);
         return -1;
     }
 
+    writer->file = hdf5_file;
+    writer->write_data = writer_write_data;
+    writer->write_datetime_range = writer_write_datetime_range;
+    writer->close = writer_close;
+
     return 0;
 }
 
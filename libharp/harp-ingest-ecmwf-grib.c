@@ -40,6 +40,9 @@
 
 #define SECONDS_FROM_1993_TO_2000 (220838400 + 5)
 
+/* number of longitudes that are copied together when reordering to [longitude,vertical] */
+#define LONGITUDE_BLOCK_SIZE 64
+
 /* The parameter id values and their link to GRIB1 table2Version/indicatorOfParameter and
  * GRIB2 discipline/parameterCategory/parameterNumber values are taken from
  * http://apps.ecmwf.int/codes/grib/param-db
@@ -266,6 +269,12 @@ typedef struct ingest_info_struct
 
     int has_parameter[NUM_GRIB_PARAMETERS];
     long *grid_data_index;      /* [NUM_GRIB_PARAMETERS, num_levels] */
+
+    /* decoded grid data of the parameter that is currently being read */
+    int cache_parameter;        /* grib_parameter for which the data is cached (-1 if none) */
+    long cache_num_levels;      /* number of levels of cache_parameter that are cached */
+    long cache_num_planes;      /* number of planes that fit in cache_data */
+    float *cache_data;  /* [cache_num_planes, num_latitudes, num_longitudes] (one plane per GRIB message) */
 } ingest_info;
 
 
@@ -351,6 +360,66 @@ static int grib_get_gaussian_latitudes(long trunc, double *lats)
     return 0;
 }
 
+/* Process-wide cache of Gaussian latitudes.
+ * The latitudes of a Gaussian grid only depend on N, but their computation is O(N^2) (e.g. several seconds for an N1280
+ * grid), so they are computed only once for each N. Entries are never modified once they are added to the cache, so
+ * the latitudes can be shared by all ingestions that use a grid with the same N.
+ */
+typedef struct gaussian_latitudes_struct
+{
+    long N;
+    double *latitude;   /* [2 * N] */
+    struct gaussian_latitudes_struct *next;
+} gaussian_latitudes;
+
+static gaussian_latitudes *gaussian_latitudes_cache = NULL;
+
+static int get_gaussian_latitudes(long N, const double **latitude)
+{
+    gaussian_latitudes *entry;
+
+    for (entry = gaussian_latitudes_cache; entry != NULL; entry = entry->next)
+    {
+        if (entry->N == N)
+        {
+            *latitude = entry->latitude;
+            return 0;
+        }
+    }
+
+    entry = malloc(sizeof(gaussian_latitudes));
+    if (entry == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(gaussian_latitudes), __FILE__, __LINE__);
+        return -1;
+    }
+    entry->N = N;
+    entry->latitude = malloc(2 * N * sizeof(double));
+    if (entry->latitude == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       2 * N * sizeof(double), __FILE__, __LINE__);
+        free(entry);
+        return -1;
+    }
+    if (grib_get_gaussian_latitudes(N, entry->latitude) != 0)
+    {
+        harp_set_error(HARP_ERROR_INGESTION, "could not determine latitudes of Gaussian grid (N=%ld)", N);
+        free(entry->latitude);
+        free(entry);
+        return -1;
+    }
+
+    /* only add the entry once it is complete */
+    entry->next = gaussian_latitudes_cache;
+    gaussian_latitudes_cache = entry;
+
+    *latitude = entry->latitude;
+
+    return 0;
+}
+
 static grib_parameter get_grib1_parameter(int parameter_ref)
 {
     uint8_t table2Version = (parameter_ref >> 8) & 0xff;
@@ -800,50 +869,148 @@ static grib_parameter get_grib_parameter(int parameter_ref)
     return get_grib2_parameter(parameter_ref & 0xffffff);
 }
 
-static int read_grid_data(ingest_info *info, long grid_data_index, long latitude_index, harp_array data)
+/* Release the decoded grid data once the last latitude row of a variable has been read.
+ * This keeps the cache from holding on to the data of a (possibly large) 3D parameter for the rest of the ingestion.
+ */
+static void release_grid_data_cache(ingest_info *info)
 {
-    /* flip latitude dimension, so it becomes ascending */
-    latitude_index = info->num_latitudes - latitude_index - 1;
+    if (info->cache_data != NULL)
+    {
+        free(info->cache_data);
+        info->cache_data = NULL;
+    }
+    info->cache_parameter = -1;
+    info->cache_num_levels = 0;
+    info->cache_num_planes = 0;
+}
+
+/* Make sure that the fully decoded data of each GRIB message of the parameter is available in the cache.
+ * Each GRIB message is decoded with a single read (instead of one partial read per latitude row) and the rows are then
+ * served from memory. Only the data for one parameter is kept, since the ingestion reads one variable at a time, and
+ * it is released again after the last row of the variable has been served.
+ */
+static int cache_grid_data(ingest_info *info, grib_parameter parameter, long num_planes)
+{
+    long plane_size = info->num_latitudes * info->num_longitudes;
+    long i;
+
+    if (info->cache_parameter == (int)parameter && info->cache_num_levels >= num_planes)
+    {
+        return 0;
+    }
+    info->cache_parameter = -1;
+
+    if (num_planes > info->cache_num_planes)
+    {
+        float *cache_data;
+
+        cache_data = realloc(info->cache_data, num_planes * plane_size * sizeof(float));
+        if (cache_data == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           num_planes * plane_size * sizeof(float), __FILE__, __LINE__);
+            return -1;
+        }
+        info->cache_data = cache_data;
+        info->cache_num_planes = num_planes;
+    }
 
-    assert(grid_data_index >= 0);
-    return coda_cursor_read_float_partial_array(&info->parameter_cursor[grid_data_index],
-                                                latitude_index * info->num_longitudes, info->num_longitudes,
-                                                data.float_data);
+    for (i = 0; i < num_planes; i++)
+    {
+        long grid_data_index = info->grid_data_index[parameter * info->num_levels + i];
+        long num_elements;
+
+        assert(grid_data_index >= 0);
+        if (coda_cursor_get_num_elements(&info->parameter_cursor[grid_data_index], &num_elements) != 0)
+        {
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            return -1;
+        }
+        if (num_elements != plane_size)
+        {
+            harp_set_error(HARP_ERROR_INGESTION, "GRIB message has %ld values; expected %ld", num_elements, plane_size);
+            return -1;
+        }
+        if (coda_cursor_read_float_array(&info->parameter_cursor[grid_data_index], &info->cache_data[i * plane_size],
+                                         coda_array_ordering_c) != 0)
+        {
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            return -1;
+        }
+    }
+    info->cache_parameter = parameter;
+    info->cache_num_levels = num_planes;
+
+    return 0;
 }
 
 static int read_2d_grid_data(ingest_info *info, grib_parameter parameter, long index, harp_array data)
 {
     assert(info->has_parameter[parameter]);
-    return read_grid_data(info, info->grid_data_index[parameter * info->num_levels], index, data);
+
+    if (cache_grid_data(info, parameter, 1) != 0)
+    {
+        return -1;
+    }
+
+    /* flip latitude dimension, so it becomes ascending */
+    index = info->num_latitudes - index - 1;
+
+    memcpy(data.float_data, &info->cache_data[index * info->num_longitudes], info->num_longitudes * sizeof(float));
+
+    if (index == 0)
+    {
+        /* this was the last latitude row of the variable */
+        release_grid_data_cache(info);
+    }
+
+    return 0;
 }
 
 static int read_3d_grid_data(ingest_info *info, grib_parameter parameter, long index, harp_array data)
 {
-    long dimension_transpose[2];
-    long i;
+    long plane_size = info->num_latitudes * info->num_longitudes;
+    long num_levels = info->num_levels;
+    long block_start;
 
     assert(info->has_parameter[parameter]);
 
-    dimension_transpose[0] = info->num_levels;
-    dimension_transpose[1] = info->num_longitudes;
+    if (cache_grid_data(info, parameter, num_levels) != 0)
+    {
+        return -1;
+    }
 
-    /* we read the data as [vertical,longitude] */
-    for (i = 0; i < info->num_levels; i++)
+    /* flip latitude dimension, so it becomes ascending */
+    index = info->num_latitudes - index - 1;
+
+    /* copy the rows of all levels directly into [longitude,vertical] order; the copy is done in blocks of longitudes
+     * such that both the source rows and the destination block stay in cache */
+    for (block_start = 0; block_start < info->num_longitudes; block_start += LONGITUDE_BLOCK_SIZE)
     {
-        harp_array subgrid;
+        long block_end = block_start + LONGITUDE_BLOCK_SIZE;
+        long i;
 
-        subgrid.float_data = &data.float_data[i * info->num_longitudes];
-        /* invert the loop because level 0 = TOA */
-        if (read_grid_data(info, info->grid_data_index[(parameter + 1) * info->num_levels - 1 - i], index, subgrid) !=
-            0)
+        if (block_end > info->num_longitudes)
         {
-            return -1;
+            block_end = info->num_longitudes;
+        }
+        for (i = 0; i < num_levels; i++)
+        {
+            /* invert the level order because level 0 = TOA */
+            const float *row = &info->cache_data[(num_levels - 1 - i) * plane_size + index * info->num_longitudes];
+            long k;
+
+            for (k = block_start; k < block_end; k++)
+            {
+                data.float_data[k * num_levels + i] = row[k];
+            }
         }
     }
-    /* and then reorder dimensions from [vertical,longitude] to [longitude,vertical] */
-    if (harp_array_transpose(harp_type_float, 2, dimension_transpose, NULL, data) != 0)
+
+    if (index == 0)
     {
-        return -1;
+        /* this was the last latitude row of the variable */
+        release_grid_data_cache(info);
     }
 
     return 0;
@@ -1829,15 +1996,18 @@ static int get_lat_lon_grid(coda_cursor *cursor, int grib_version, ingest_info *
         }
         if (is_gaussian)
         {
+            const double *gaussian_latitude;
+
             if (N != info->num_latitudes / 2)
             {
                 harp_set_error(HARP_ERROR_INGESTION, "invalid value for N for Gaussian grid");
                 return -1;
             }
-            if (grib_get_gaussian_latitudes(N, info->latitude) != 0)
+            if (get_gaussian_latitudes(N, &gaussian_latitude) != 0)
             {
                 return -1;
             }
+            memcpy(info->latitude, gaussian_latitude, info->num_latitudes * sizeof(double));
         }
         else
         {
@@ -2494,6 +2664,10 @@ static void ingest_info_delete(ingest_info *info)
         {
             free(info->grid_data_index);
         }
+        if (info->cache_data != NULL)
+        {
+            free(info->cache_data);
+        }
         free(info);
     }
 }
@@ -2540,6 +2714,10 @@ static int ingest_info_new(coda_product *product, ingest_info **new_info)
     info->num_grib_levels = 0;
     info->coordinate_values = NULL;
     info->grid_data_index = NULL;
+    info->cache_parameter = -1;
+    info->cache_num_levels = 0;
+    info->cache_num_planes = 0;
+    info->cache_data = NULL;
 
     for (i = 0; i < NUM_GRIB_PARAMETERS; i++)
     {
@@ -2896,6 +3074,18 @@ static void add_value_variable_mapping(harp_variable_definition *variable_defini
     }
 }
 
+void harp_ingestion_module_ecmwf_grib_done(void)
+{
+    while (gaussian_latitudes_cache != NULL)
+    {
+        gaussian_latitudes *entry = gaussian_latitudes_cache;
+
+        gaussian_latitudes_cache = entry->next;
+        free(entry->latitude);
+        free(entry);
+    }
+}
+
 int harp_ingestion_module_ecmwf_grib_init(void)
 {
     harp_dimension_type dimension_type[5] = {
@@ -87,6 +87,7 @@ typedef struct ingest_info_struct
     int *band_nr_fastest_band;
     int *index_of_fastest_timer_in_list_of_timers;
     short *readout_offset;      /* First valid readout in MDR record: 1 (if first readout is skipped) or 0 (default) */
+    long *first_time_index;     /* Index of the first valid readout of the MDR record in the time dimension */
 
     /* Data about the VIADR_SMR-records */
     long num_viadr_smr_records;
@@ -139,6 +140,10 @@ static void ingestion_done(void *user_data)
     {
         free(info->readout_offset);
     }
+    if (info->first_time_index != NULL)
+    {
+        free(info->first_time_index);
+    }
     free(info);
 }
 
@@ -511,14 +516,44 @@ static int get_main_cloud_data(ingest_info *info, long mdr_record, int fit_numbe
     return 0;
 }
 
+/* Store the (band) values in num_rows consecutive rows of the spectral data, starting at element 'offset' */
+static void copy_band_values_to_rows(const double *values, long num_pixels, long num_rows, long row_length,
+                                     harp_data_type data_type, long offset, harp_array data)
+{
+    long i, j;
+
+    for (i = 0; i < num_rows; i++)
+    {
+        if (data_type == harp_type_float)
+        {
+            for (j = 0; j < num_pixels; j++)
+            {
+                data.float_data[offset + i * row_length + j] = (float)values[j];
+            }
+        }
+        else
+        {
+            for (j = 0; j < num_pixels; j++)
+            {
+                data.double_data[offset + i * row_length + j] = values[j];
+            }
+        }
+    }
+}
+
+/* Read the rows first_row ... first_row + num_rows - 1 (the readouts, not counting skipped readouts) of a single band
+ * of an MDR record. The values are stored starting at element 'offset' of 'data'. Rows for which the band has no
+ * valid measurement are left untouched.
+ */
 static int get_spectral_data_per_band(coda_cursor cursor_start_of_band, ingest_info *info, const char *fieldname,
-                                      spectral_variable_type var_type, long mdr_record, int band_nr,
-                                      double *data_startposition)
+                                      spectral_variable_type var_type, long mdr_record, int band_nr, long first_row,
+                                      long num_rows, double *values, harp_data_type data_type, long offset,
+                                      harp_array data)
 {
     const double undefined_int32_vsf_value = -2147483648.0E128;
-    coda_cursor cursor, start_of_band_array_element;
-    double *double_data, *dest_data, rad, nan, integration_time_this_band;
-    long i, j, k, double_data_row;
+    coda_cursor cursor;
+    double nan, integration_time_this_band;
+    long rows_per_rec, rec, rec_first_row, rec_num_rows, j;
     uint16_t num_recs_of_band;
 
     cursor = cursor_start_of_band;
@@ -541,32 +576,51 @@ static int get_spectral_data_per_band(coda_cursor cursor_start_of_band, ingest_i
                 harp_set_error(HARP_ERROR_CODA, NULL);
                 return -1;
             }
-            cursor = cursor_start_of_band;
-            if (coda_cursor_goto_record_field_by_name(&cursor, band_name_in_file[band_nr]) != 0)
+            if (num_recs_of_band == 0)
             {
-                harp_set_error(HARP_ERROR_CODA, NULL);
-                return -1;
+                return 0;
             }
-            if (coda_cursor_goto_first_array_element(&cursor) != 0)
+            cursor = cursor_start_of_band;
+            if (coda_cursor_goto_record_field_by_name(&cursor, band_name_in_file[band_nr]) != 0)
             {
                 harp_set_error(HARP_ERROR_CODA, NULL);
                 return -1;
             }
-            double_data_row = 0;
-            for (i = 0; i < num_recs_of_band; i++)
+            /* Each measurement of the band covers rows_per_rec readouts; readout r (counting skipped readouts) is
+             * row r - readout_offset, and a measurement that starts in a skipped readout is not ingested.
+             */
+            rows_per_rec = MAX_READOUTS_PER_MDR_RECORD / num_recs_of_band;
+            rec = (first_row + info->readout_offset[mdr_record]) / rows_per_rec;
+            while (rec * rows_per_rec - info->readout_offset[mdr_record] < first_row + num_rows)
             {
-                double_data = data_startposition + (info->total_num_pixels_all_bands * double_data_row);
-                for (j = 0; j < info->num_pixels[band_nr]; j++)
+                rec_first_row = rec * rows_per_rec - info->readout_offset[mdr_record];
+                rec_num_rows = rows_per_rec;
+                if (rec_first_row < first_row)
+                {
+                    rec_num_rows -= first_row - rec_first_row;
+                    rec_first_row = first_row;
+                }
+                if (rec_first_row + rec_num_rows > first_row + num_rows)
+                {
+                    rec_num_rows = first_row + num_rows - rec_first_row;
+                }
+                if (rec >= info->readout_offset[mdr_record] && rec < num_recs_of_band)
                 {
-                    start_of_band_array_element = cursor;
-                    if (coda_cursor_goto_record_field_by_name(&cursor, fieldname) != 0)
+                    coda_cursor band_cursor = cursor;
+
+                    if (coda_cursor_goto_array_element_by_index(&band_cursor, rec * info->num_pixels[band_nr]) != 0)
                     {
                         harp_set_error(HARP_ERROR_CODA, NULL);
                         return -1;
                     }
-                    if (i >= info->readout_offset[mdr_record])
+                    for (j = 0; j < info->num_pixels[band_nr]; j++)
                     {
-                        if (coda_cursor_read_double(&cursor, &rad) != 0)
+                        if (coda_cursor_goto_record_field_by_name(&band_cursor, fieldname) != 0)
+                        {
+                            harp_set_error(HARP_ERROR_CODA, NULL);
+                            return -1;
+                        }
+                        if (coda_cursor_read_double(&band_cursor, &values[j]) != 0)
                         {
                             harp_set_error(HARP_ERROR_CODA, NULL);
                             return -1;
@@ -576,36 +630,26 @@ static int get_spectral_data_per_band(coda_cursor cursor_start_of_band, ingest_i
                          * may sometimes incorrectly return false due to
                          * rounding issues.
                          */
-                        if (fabs(rad - undefined_int32_vsf_value) > fabs(undefined_int32_vsf_value * 1E-12))
+                        if (fabs(values[j] - undefined_int32_vsf_value) <= fabs(undefined_int32_vsf_value * 1E-12))
                         {
-                            *double_data = rad;
+                            values[j] = nan;
                         }
-                        else
+                        coda_cursor_goto_parent(&band_cursor);
+                        if (j < (info->num_pixels[band_nr] - 1))
                         {
-                            *double_data = nan;
-                        }
-                        copy_double_data_to_following_rows(num_recs_of_band, info->total_num_pixels_all_bands,
-                                                           double_data);
-                        double_data++;
-                    }
-                    cursor = start_of_band_array_element;
-                    if ((j < (info->num_pixels[band_nr] - 1)) || (i < (num_recs_of_band - 1)))
-                    {
-                        if (coda_cursor_goto_next_array_element(&cursor) != 0)
-                        {
-                            harp_set_error(HARP_ERROR_CODA, NULL);
-                            return -1;
+                            if (coda_cursor_goto_next_array_element(&band_cursor) != 0)
+                            {
+                                harp_set_error(HARP_ERROR_CODA, NULL);
+                                return -1;
+                            }
                         }
                     }
+                    copy_band_values_to_rows(values, info->num_pixels[band_nr], rec_num_rows,
+                                             info->total_num_pixels_all_bands, data_type,
+                                             offset + (rec_first_row - first_row) * info->total_num_pixels_all_bands,
+                                             data);
                 }
-                if (i >= info->readout_offset[mdr_record])
-                {
-                    double_data_row += (MAX_READOUTS_PER_MDR_RECORD / num_recs_of_band);
-                }
-                else
-                {
-                    double_data_row += (MAX_READOUTS_PER_MDR_RECORD / num_recs_of_band) - 1;
-                }
+                rec++;
             }
             break;
 
@@ -615,36 +659,14 @@ static int get_spectral_data_per_band(coda_cursor cursor_start_of_band, ingest_i
                 harp_set_error(HARP_ERROR_CODA, NULL);
                 return -1;
             }
-            if (coda_cursor_goto_first_array_element(&cursor) != 0)
+            if (coda_cursor_read_double_partial_array(&cursor, 0, info->num_pixels[band_nr], values) != 0)
             {
                 harp_set_error(HARP_ERROR_CODA, NULL);
                 return -1;
             }
-            double_data = data_startposition;
-            for (j = 0; j < info->num_pixels[band_nr]; j++)
-            {
-                if (coda_cursor_read_double(&cursor, double_data) != 0)
-                {
-                    harp_set_error(HARP_ERROR_CODA, NULL);
-                    return -1;
-                }
-                /* Copy the wavelength value to the rows below it */
-                dest_data = double_data + info->total_num_pixels_all_bands;
-                for (k = 1; k <= (31 - info->readout_offset[mdr_record]); k++)
-                {
-                    *dest_data = *double_data;
-                    dest_data += info->total_num_pixels_all_bands;
-                }
-                double_data++;
-                if (j < (info->num_pixels[band_nr] - 1))
-                {
-                    if (coda_cursor_goto_next_array_element(&cursor) != 0)
-                    {
-                        harp_set_error(HARP_ERROR_CODA, NULL);
-                        return -1;
-                    }
-                }
-            }
+            /* The wavelengths are the same for all readouts of the MDR */
+            copy_band_values_to_rows(values, info->num_pixels[band_nr], num_rows, info->total_num_pixels_all_bands,
+                                     data_type, offset, data);
             break;
 
         case INTEGRATION_TIME:
@@ -658,7 +680,6 @@ static int get_spectral_data_per_band(coda_cursor cursor_start_of_band, ingest_i
                 harp_set_error(HARP_ERROR_CODA, NULL);
                 return -1;
             }
-            double_data = data_startposition;
             if (coda_cursor_read_double(&cursor, &integration_time_this_band) != 0)
             {
                 harp_set_error(HARP_ERROR_CODA, NULL);
@@ -666,67 +687,89 @@ static int get_spectral_data_per_band(coda_cursor cursor_start_of_band, ingest_i
             }
             for (j = 0; j < info->num_pixels[band_nr]; j++)
             {
-                dest_data = double_data;
-                for (k = 0; k <= (31 - info->readout_offset[mdr_record]); k++)
-                {
-                    *dest_data = integration_time_this_band;
-                    dest_data += info->total_num_pixels_all_bands;
-                }
-                double_data++;
+                values[j] = integration_time_this_band;
             }
+            copy_band_values_to_rows(values, info->num_pixels[band_nr], num_rows, info->total_num_pixels_all_bands,
+                                     data_type, offset, data);
             break;
     }
 
     return 0;
 }
 
+/* Read the time samples index_offset ... index_offset + index_length - 1 of a spectral variable.
+ * Only the MDR records that overlap with the range and only the ingested band(s) are read.
+ */
 static int get_spectral_data(ingest_info *info, const char *fieldname, spectral_variable_type var_type,
-                             double *double_data_array)
+                             harp_data_type data_type, long index_offset, long index_length, harp_array data)
 {
     coda_cursor cursor;
-    double *double_data, nan;
-    long i, j;
+    double *values;
+    long num_elements, mdr_record, first_row, num_rows, index, low, high, i;
     int band_nr;
 
     /* set all values to NaN */
-    nan = coda_NaN();
-    double_data = double_data_array;
-    for (i = 0; i < info->num_mdr_records; i++)
+    num_elements = index_length * info->total_num_pixels_all_bands;
+    for (i = 0; i < num_elements; i++)
     {
-        for (j = (info->readout_offset[i] * info->total_num_pixels_all_bands);
-             j < (MAX_READOUTS_PER_MDR_RECORD * info->total_num_pixels_all_bands); j++)
+        if (data_type == harp_type_float)
         {
-            *double_data = nan;
-            double_data++;
+            data.float_data[i] = (float)coda_NaN();
+        }
+        else
+        {
+            data.double_data[i] = coda_NaN();
         }
     }
 
-    double_data = double_data_array;
-    for (i = 0; i < info->num_mdr_records; i++)
+    /* find the MDR record that contains the first time sample of the range */
+    low = 0;
+    high = info->num_mdr_records - 1;
+    while (low < high)
     {
-        cursor = info->mdr_lightsource_cursors[i];
-        if (info->band_nr < 0)
+        mdr_record = (low + high + 1) / 2;
+        if (info->first_time_index[mdr_record] <= index_offset)
         {
-            /* Ingest all bands */
-            for (band_nr = 0; band_nr < MAX_NR_BANDS; band_nr++)
-            {
-                if (get_spectral_data_per_band
-                    (cursor, info, fieldname, var_type, i, band_nr, double_data + info->offset_of_band[band_nr]) != 0)
-                {
-                    return -1;
-                }
-            }
+            low = mdr_record;
         }
         else
         {
-            /* Ingest only this band */
-            if (get_spectral_data_per_band(cursor, info, fieldname, var_type, i, info->band_nr, double_data) != 0)
+            high = mdr_record - 1;
+        }
+    }
+
+    CHECKED_MALLOC(values, MAX_PIXELS * sizeof(double));
+
+    index = index_offset;
+    for (mdr_record = low; mdr_record < info->num_mdr_records && index < index_offset + index_length; mdr_record++)
+    {
+        cursor = info->mdr_lightsource_cursors[mdr_record];
+        first_row = index - info->first_time_index[mdr_record];
+        num_rows = MAX_READOUTS_PER_MDR_RECORD - info->readout_offset[mdr_record] - first_row;
+        if (index + num_rows > index_offset + index_length)
+        {
+            num_rows = index_offset + index_length - index;
+        }
+        for (band_nr = 0; band_nr < MAX_NR_BANDS; band_nr++)
+        {
+            if (info->band_nr >= 0 && band_nr != info->band_nr)
             {
+                continue;
+            }
+            if (get_spectral_data_per_band(cursor, info, fieldname, var_type, mdr_record, band_nr, first_row,
+                                           num_rows, values, data_type, (index - index_offset) *
+                                           info->total_num_pixels_all_bands +
+                                           (info->band_nr < 0 ? info->offset_of_band[band_nr] : 0), data) != 0)
+            {
+                free(values);
                 return -1;
             }
         }
-        double_data += (MAX_READOUTS_PER_MDR_RECORD - info->readout_offset[i]) * info->total_num_pixels_all_bands;
+        index += num_rows;
     }
+
+    free(values);
+
     return 0;
 }
 
@@ -833,34 +876,50 @@ static int read_longitude_bounds(void *user_data, harp_array data)
     return 0;
 }
 
-static int read_wavelength_photon_radiance(void *user_data, harp_array data)
+static long get_optimal_range_length(void *user_data)
 {
-    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, data.double_data);
+    (void)user_data;
+
+    /* the spectra are stored per MDR record, so read (at most) a full MDR record at a time */
+    return MAX_READOUTS_PER_MDR_RECORD;
 }
 
-static int read_transmittance(void *user_data, harp_array data)
+static int read_wavelength_photon_radiance(void *user_data, long index_offset, long index_length, harp_array data)
 {
-    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, data.double_data);
+    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, harp_type_double, index_offset, index_length,
+                             data);
 }
 
-static int read_sun_wavelength_photon_irradiance(void *user_data, harp_array data)
+static int read_transmittance(void *user_data, long index_offset, long index_length, harp_array data)
 {
-    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, data.double_data);
+    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, harp_type_double, index_offset, index_length,
+                             data);
 }
 
-static int read_moon_wavelength_photon_irradiance(void *user_data, harp_array data)
+static int read_sun_wavelength_photon_irradiance(void *user_data, long index_offset, long index_length,
+                                                 harp_array data)
 {
-    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, data.double_data);
+    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, harp_type_double, index_offset, index_length,
+                             data);
 }
 
-static int read_wavelength(void *user_data, harp_array data)
+static int read_moon_wavelength_photon_irradiance(void *user_data, long index_offset, long index_length,
+                                                  harp_array data)
 {
-    return get_spectral_data((ingest_info *)user_data, NULL, WAVELENGTH, data.double_data);
+    return get_spectral_data((ingest_info *)user_data, "RAD", RADIANCE, harp_type_double, index_offset, index_length,
+                             data);
 }
 
-static int read_integration_time(void *user_data, harp_array data)
+static int read_wavelength(void *user_data, long index_offset, long index_length, harp_array data)
 {
-    return get_spectral_data((ingest_info *)user_data, NULL, INTEGRATION_TIME, data.double_data);
+    return get_spectral_data((ingest_info *)user_data, NULL, WAVELENGTH, harp_type_double, index_offset, index_length,
+                             data);
+}
+
+static int read_integration_time(void *user_data, long index_offset, long index_length, harp_array data)
+{
+    return get_spectral_data((ingest_info *)user_data, NULL, INTEGRATION_TIME, harp_type_float, index_offset,
+                             index_length, data);
 }
 
 static int read_scan_subindex(void *user_data, harp_array data)
@@ -1263,6 +1322,7 @@ static int init_measurements_dimensions(ingest_info *info)
     CHECKED_MALLOC(info->band_nr_fastest_band, valid_mdr_record * sizeof(int));
     CHECKED_MALLOC(info->index_of_fastest_timer_in_list_of_timers, valid_mdr_record * sizeof(int));
     CHECKED_MALLOC(info->readout_offset, valid_mdr_record * sizeof(short));
+    CHECKED_MALLOC(info->first_time_index, valid_mdr_record * sizeof(long));
 
     if (coda_cursor_goto_first_array_element(&cursor) != 0)
     {
@@ -1364,6 +1424,13 @@ static int init_measurements_dimensions(ingest_info *info)
     }
     info->num_mdr_records = valid_mdr_record;
 
+    offset = 0L;
+    for (mdr_record = 0; mdr_record < info->num_mdr_records; mdr_record++)
+    {
+        info->first_time_index[mdr_record] = offset;
+        offset += MAX_READOUTS_PER_MDR_RECORD - info->readout_offset[mdr_record];
+    }
+
     coda_cursor_goto_root(&cursor);
 
     offset = 0L;
@@ -1498,18 +1565,19 @@ static void register_variables_radiance_transmittance_fields(harp_product_defini
         /* wavelength_photon_radiance */
         description = "measured radiances";
         variable_definition =
-            harp_ingestion_register_variable_full_read(product_definition, "wavelength_photon_radiance",
-                                                       harp_type_double, 2, dimension_type, NULL, description,
-                                                       "count/s/cm2/sr/nm", NULL, read_wavelength_photon_radiance);
+            harp_ingestion_register_variable_range_read(product_definition, "wavelength_photon_radiance",
+                                                        harp_type_double, 2, dimension_type, NULL, description,
+                                                        "count/s/cm2/sr/nm", NULL, get_optimal_range_length,
+                                                        read_wavelength_photon_radiance);
     }
     else
     {
         /* transmittance */
         description = "transmittance";
         variable_definition =
-            harp_ingestion_register_variable_full_read(product_definition, "transmittance", harp_type_double, 2,
-                                                       dimension_type, NULL, description, HARP_UNIT_DIMENSIONLESS, NULL,
-                                                       read_transmittance);
+            harp_ingestion_register_variable_range_read(product_definition, "transmittance", harp_type_double, 2,
+                                                        dimension_type, NULL, description, HARP_UNIT_DIMENSIONLESS,
+                                                        NULL, get_optimal_range_length, read_transmittance);
     }
     path = "/MDR[]/Earthshine/BAND_1A[,]/RAD, /MDR[]/Earthshine/BAND_1B[,]/RAD, /MDR[]/Earthshine/BAND_2A[,]/RAD, "
         "/MDR[]/Earthshine/BAND_2B[,]/RAD, /MDR[]/Earthshine/BAND_3[,]/RAD, /MDR[]/Earthshine/BAND_4[,]/RAD";
@@ -1518,8 +1586,9 @@ static void register_variables_radiance_transmittance_fields(harp_product_defini
     /* wavelength */
     description = "nominal wavelength assignment for each of the detector pixels";
     variable_definition =
-        harp_ingestion_register_variable_full_read(product_definition, "wavelength", harp_type_double, 2,
-                                                   dimension_type, NULL, description, "nm", NULL, read_wavelength);
+        harp_ingestion_register_variable_range_read(product_definition, "wavelength", harp_type_double, 2,
+                                                    dimension_type, NULL, description, "nm", NULL,
+                                                    get_optimal_range_length, read_wavelength);
     path = "/MDR[]/Earthshine/WAVELENGTH_1A[], /MDR[]/Earthshine/WAVELENGTH_1B[], /MDR[]/Earthshine/WAVELENGTH_2A[], "
         "/MDR/Earthshine[]/WAVELENGTH_2B[], /MDR[]/Earthshine/WAVELENGTH_3[], /MDR[]/Earthshine/WAVELENGTH_4[]";
     harp_variable_definition_add_mapping(variable_definition, NULL, NULL, path, NULL);
@@ -1527,8 +1596,9 @@ static void register_variables_radiance_transmittance_fields(harp_product_defini
     /* integration_time */
     description = "integration time for each pixel";
     variable_definition =
-        harp_ingestion_register_variable_full_read(product_definition, "integration_time", harp_type_double, 2,
-                                                   dimension_type, NULL, description, "s", NULL, read_integration_time);
+        harp_ingestion_register_variable_range_read(product_definition, "integration_time", harp_type_float, 2,
+                                                    dimension_type, NULL, description, "s", NULL,
+                                                    get_optimal_range_length, read_integration_time);
     path = "/MDR[]/Earthshine/INTEGRATION_TIMES[]";
     harp_variable_definition_add_mapping(variable_definition, NULL, NULL, path, NULL);
 
@@ -1670,10 +1740,10 @@ static void register_variables_irradiance_fields(harp_product_definition *produc
     /* wavelength_photon_irradiance of the sun */
     description = "measured sun irradiances";
     variable_definition =
-        harp_ingestion_register_variable_full_read(product_definition, "wavelength_photon_irradiance_sun",
-                                                   harp_type_double, 2, dimension_type, NULL, description,
-                                                   "count/s/cm2/nm", exclude_when_not_sun,
-                                                   read_sun_wavelength_photon_irradiance);
+        harp_ingestion_register_variable_range_read(product_definition, "wavelength_photon_irradiance_sun",
+                                                    harp_type_double, 2, dimension_type, NULL, description,
+                                                    "count/s/cm2/nm", exclude_when_not_sun, get_optimal_range_length,
+                                                    read_sun_wavelength_photon_irradiance);
     path = "/MDR[]/Sun/BAND_1A[,]/RAD, /MDR[]/Sun/BAND_1B[,]/RAD, /MDR[]/Sun/BAND_2A[,]/RAD, "
         "/MDR[]/Sun/BAND_2B[,]/RAD, /MDR[]/Sun/BAND_3[,]/RAD, /MDR[]/Sun/BAND_4[,]/RAD";
     harp_variable_definition_add_mapping(variable_definition, "data=sun", NULL, path, NULL);
@@ -1681,10 +1751,10 @@ static void register_variables_irradiance_fields(harp_product_definition *produc
     /* wavelength_photon_irradiance of the moon */
     description = "measured moon irradiances";
     variable_definition =
-        harp_ingestion_register_variable_full_read(product_definition, "wavelength_photon_irradiance_moon",
-                                                   harp_type_double, 2, dimension_type, NULL, description,
-                                                   "count/s/cm2/nm", exclude_when_not_moon,
-                                                   read_moon_wavelength_photon_irradiance);
+        harp_ingestion_register_variable_range_read(product_definition, "wavelength_photon_irradiance_moon",
+                                                    harp_type_double, 2, dimension_type, NULL, description,
+                                                    "count/s/cm2/nm", exclude_when_not_moon, get_optimal_range_length,
+                                                    read_moon_wavelength_photon_irradiance);
     path = "/MDR[]/Moon/BAND_1A[,]/RAD, /MDR[]/Moon/BAND_1B[,]/RAD, /MDR[]/Moon/BAND_2A[,]/RAD, "
         "/MDR[]/Moon/BAND_2B[,]/RAD, /MDR[]/Moon/BAND_3[,]/RAD, /MDR[]/Moon/BAND_4[,]/RAD";
     harp_variable_definition_add_mapping(variable_definition, "data=moon", NULL, path, NULL);
@@ -1692,8 +1762,9 @@ static void register_variables_irradiance_fields(harp_product_definition *produc
     /* wavelength */
     description = "nominal wavelength assignment for each of the detector pixels";
     variable_definition =
-        harp_ingestion_register_variable_full_read(product_definition, "wavelength", harp_type_double, 2,
-                                                   dimension_type, NULL, description, "nm", NULL, read_wavelength);
+        harp_ingestion_register_variable_range_read(product_definition, "wavelength", harp_type_double, 2,
+                                                    dimension_type, NULL, description, "nm", NULL,
+                                                    get_optimal_range_length, read_wavelength);
     path = "/MDR[]/Sun/WAVELENGTH_1A[], /MDR[]/Sun/WAVELENGTH_1B[], /MDR[]/Sun/WAVELENGTH_2A[], "
         "/MDR[]/Sun/WAVELENGTH_2B[], /MDR[]/Sun/WAVELENGTH_3[], /MDR[]/Sun/WAVELENGTH_4[]";
     harp_variable_definition_add_mapping(variable_definition, "data=sun", NULL, path, NULL);
@@ -1704,8 +1775,9 @@ static void register_variables_irradiance_fields(harp_product_definition *produc
     /* integration_time */
     description = "integration time for each pixel";
     variable_definition =
-        harp_ingestion_register_variable_full_read(product_definition, "integration_time", harp_type_double, 2,
-                                                   dimension_type, NULL, description, "s", NULL, read_integration_time);
+        harp_ingestion_register_variable_range_read(product_definition, "integration_time", harp_type_float, 2,
+                                                    dimension_type, NULL, description, "s", NULL,
+                                                    get_optimal_range_length, read_integration_time);
     path = "/MDR[]/Sun/INTEGRATION_TIMES[]";
     harp_variable_definition_add_mapping(variable_definition, "data=sun", NULL, path, NULL);
     path = "/MDR[]/Moon/INTEGRATION_TIMES[]";
@@ -133,7 +133,7 @@ static int read_variable(coda_cursor *cursor, const char *name, int num_dimensio
     long num_elements;
     long coda_dimension[CODA_MAX_NUM_DIMS];
     int num_coda_dimensions;
-    long i;
+    harp_packing packing;
 
     if (coda_cursor_goto_record_field_by_name(cursor, name) != 0)
     {
@@ -180,13 +180,10 @@ static int read_variable(coda_cursor *cursor, const char *name, int num_dimensio
     }
 
     /* replace missing values by NaN */
-    for (i = 0; i < num_elements; i++)
-    {
-        if (data.double_data[i] == missing_value)
-        {
-            data.double_data[i] = coda_NaN();
-        }
-    }
+    harp_packing_init(&packing);
+    packing.has_fill_value = 1;
+    packing.fill_value = missing_value;
+    harp_array_decode(harp_type_double, harp_type_double, num_elements, &packing, data);
 
     coda_cursor_goto_parent(cursor);
 
@@ -63,6 +63,14 @@ typedef struct ingest_info_struct
     int16_t *scale_factors;
     int16_t *channel_first;
     int16_t *channel_last;
+    double *band_scale; /* [nr_scale_factors] 10^(-scale_factor) for each band */
+    int32_t spectrum_first_channel;     /* IDefNsfirst1b for which the channel ranges of the bands were verified */
+    long spectrum_length;       /* number of pixels in a spectrum that are covered by a band (-1 if not verified) */
+    long wavenumber_mdr_index;  /* index of the MDR for which the wavenumber grid is cached */
+    double wavenumber_sample_width;     /* IDefSpectDWn1b of the cached wavenumber grid */
+    int32_t wavenumber_first_sample;    /* IDefNsfirst1b of the cached wavenumber grid */
+    int32_t wavenumber_last_sample;     /* IDefNslast1b of the cached wavenumber grid */
+    float *wavenumber;  /* [num_pixels] cached wavenumber grid */
 } ingest_info;
 
 static int get_main_data(ingest_info *info, const char *fieldname, main_data_variable var_type,
@@ -123,17 +131,43 @@ static int get_main_data(ingest_info *info, const char *fieldname, main_data_var
     return 0;
 }
 
+/* Verify that the channel range of each band lies within a spectrum.
+ * The pixel index of a channel within GS1cSpect depends on IDefNsfirst1b of the MDR, so the ranges are only verified
+ * again when IDefNsfirst1b changes (which is normally never within a product).
+ */
+static int verify_band_ranges(ingest_info *info, int32_t first_channel)
+{
+    int16_t scale_nr;
+
+    info->spectrum_length = 0;
+    for (scale_nr = 0; scale_nr < info->nr_scale_factors; scale_nr++)
+    {
+        long offset = info->channel_first[scale_nr] - first_channel;
+        long length = info->channel_last[scale_nr] - info->channel_first[scale_nr] + 1;
+
+        if (offset < 0 || length < 0 || offset + length > info->num_pixels ||
+            info->spectrum_length + length > info->num_pixels)
+        {
+            harp_set_error(HARP_ERROR_INGESTION, "product error detected (channel range of scale factor %d does not "
+                           "match spectrum)", (int)scale_nr);
+            info->spectrum_length = -1;
+            return -1;
+        }
+        info->spectrum_length += length;
+    }
+    info->spectrum_first_channel = first_channel;
+
+    return 0;
+}
+
 static int get_spectra_sample_data(ingest_info *info, long row, float *float_data_array)
 {
     int32_t first_channel;
     int16_t measured_spectrum_data[8700];
-    int16_t *spectrum_data;
     coda_cursor cursor;
     float *float_data;
-    int16_t scale_nr, channel_nr;
-    int16_t *start_of_this_spectrum;
+    int16_t scale_nr;
 
-    float_data = float_data_array;
     cursor = info->mdr_cursors[row / SPECTRA_PER_SCANLINE];
     if (coda_cursor_goto_record_field_by_name(&cursor, "IDefNsfirst1b") != 0)
     {
@@ -146,6 +180,13 @@ static int get_spectra_sample_data(ingest_info *info, long row, float *float_dat
         return -1;
     }
     coda_cursor_goto_parent(&cursor);
+    if (info->spectrum_length < 0 || first_channel != info->spectrum_first_channel)
+    {
+        if (verify_band_ranges(info, first_channel) != 0)
+        {
+            return -1;
+        }
+    }
 
     /* GS1cSpect contains int16 and has the following dimensions: */
     /* dim[0] = SCANS_PER_SCANLINE (fixed at 30)                  */
@@ -163,22 +204,27 @@ static int get_spectra_sample_data(ingest_info *info, long row, float *float_dat
         harp_set_error(HARP_ERROR_CODA, NULL);
         return -1;
     }
-    spectrum_data = measured_spectrum_data;
 
-    start_of_this_spectrum = spectrum_data;
+    /* the bands are stored consecutively in the output (which normally means the pixels end up at the same index) */
+    float_data = float_data_array;
     for (scale_nr = 0; scale_nr < info->nr_scale_factors; scale_nr++)
     {
-        spectrum_data = start_of_this_spectrum + info->channel_first[scale_nr] - first_channel;
-        for (channel_nr = info->channel_first[scale_nr]; channel_nr <= info->channel_last[scale_nr]; channel_nr++)
-        {
-            /* Because this data has limited precision (it was stored in */
-            /* an int16), we store the radiance in a float.              */
-            *float_data = (float)((*spectrum_data) * pow(10.0, -(info->scale_factors[scale_nr])));
-            float_data++;
-            spectrum_data++;
-        }
+        long offset = info->channel_first[scale_nr] - first_channel;
+        long length = info->channel_last[scale_nr] - info->channel_first[scale_nr] + 1;
+        harp_packing packing;
+        harp_array data;
+
+        /* Because this data has limited precision (it was stored in an int16), we store the radiance in a float.
+         * The int16 readouts of the band are placed at the start of the (larger) float elements of the band and are
+         * then converted in place.
+         */
+        memcpy(float_data, &measured_spectrum_data[offset], (size_t)length * sizeof(int16_t));
+        harp_packing_init(&packing);
+        packing.scale_factor = info->band_scale[scale_nr];
+        data.float_data = float_data;
+        harp_array_decode(harp_type_int16, harp_type_float, length, &packing, data);
+        float_data += length;
     }
-    spectrum_data = start_of_this_spectrum + info->num_pixels;
 
     return 0;
 }
@@ -188,11 +234,18 @@ static int get_wavenumber_sample_data(ingest_info *info, long row, float *float_
     double sample_width;
     int32_t first_sample, last_sample, sample;
     coda_cursor cursor;
-    float *float_data;
+    long mdr_index = row / SPECTRA_PER_SCANLINE;
     long i;
 
-    float_data = float_data_array;
-    cursor = info->mdr_cursors[row / SPECTRA_PER_SCANLINE];
+    if (mdr_index == info->wavenumber_mdr_index)
+    {
+        /* all spectra of a scanline share the same wavenumber grid */
+        memcpy(float_data_array, info->wavenumber,
+               (info->wavenumber_last_sample - info->wavenumber_first_sample + 1) * sizeof(float));
+        return 0;
+    }
+
+    cursor = info->mdr_cursors[mdr_index];
     if (coda_cursor_goto_record_field_by_name(&cursor, "IDefSpectDWn1b") != 0)
     {
         harp_set_error(HARP_ERROR_CODA, NULL);
@@ -235,15 +288,23 @@ static int get_wavenumber_sample_data(ingest_info *info, long row, float *float_
         harp_set_error(HARP_SUCCESS, "product error detected (IDefNslast1b - IDefNsfirst1b + 1 > 8700)");
         return -1;
     }
-    for (sample = first_sample, i = 0; sample <= last_sample; sample++, i++)
-    {
-        *float_data = (float)(sample_width * sample);
-        float_data++;
-    }
-    for (; i < info->num_pixels; i++)
+
+    /* the wavenumber grid is normally constant for the whole orbit, so only recompute it when it changes */
+    if (info->wavenumber_mdr_index < 0 || sample_width != info->wavenumber_sample_width ||
+        first_sample != info->wavenumber_first_sample || last_sample != info->wavenumber_last_sample)
     {
-        float_data++;
+        for (sample = first_sample, i = 0; sample <= last_sample; sample++, i++)
+        {
+            info->wavenumber[i] = (float)(sample_width * sample);
+        }
+        info->wavenumber_sample_width = sample_width;
+        info->wavenumber_first_sample = first_sample;
+        info->wavenumber_last_sample = last_sample;
     }
+    info->wavenumber_mdr_index = mdr_index;
+
+    memcpy(float_data_array, info->wavenumber, (last_sample - first_sample + 1) * sizeof(float));
+
     return 0;
 }
 
@@ -263,6 +324,14 @@ static void ingestion_done(void *user_data)
     {
         free(info->channel_last);
     }
+    if (info->band_scale != NULL)
+    {
+        free(info->band_scale);
+    }
+    if (info->wavenumber != NULL)
+    {
+        free(info->wavenumber);
+    }
 
     free(info);
 }
@@ -303,6 +372,41 @@ static int read_datetime(void *user_data, harp_array data)
     return retval;
 }
 
+static int read_datetime_range(void *user_data, double *datetime_start, double *datetime_stop)
+{
+    ingest_info *info = (ingest_info *)user_data;
+    double datetime[2];
+    coda_cursor cursor;
+    int i;
+
+    /* the scanlines are in chronological order, so only the start times of the first and last scanline are needed */
+    for (i = 0; i < 2; i++)
+    {
+        cursor = info->mdr_cursors[i == 0 ? 0 : info->valid_scanlines - 1];
+        if (coda_cursor_goto(&cursor, "RECORD_HEADER/RECORD_START_TIME") != 0)
+        {
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            return -1;
+        }
+        if (coda_cursor_read_double(&cursor, &datetime[i]) != 0)
+        {
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            return -1;
+        }
+    }
+    /* the last measurement is the last scan of the last scanline (see read_datetime()) */
+    datetime[1] += (SCANS_PER_SCANLINE - 1) * 8.0 / 37;
+
+    if (harp_convert_unit("seconds since 2000-01-01", "days since 2000-01-01", 2, datetime) != 0)
+    {
+        return -1;
+    }
+    *datetime_start = datetime[0];
+    *datetime_stop = datetime[1];
+
+    return 0;
+}
+
 static int read_orbit_index(void *user_data, harp_array data)
 {
     ingest_info *info = (ingest_info *)user_data;
@@ -455,6 +559,7 @@ static int read_GIADR_scalefactors(ingest_info *info)
 {
     coda_cursor cursor;
     long max_scale_factors;
+    long i;
 
     if (coda_cursor_set_product(&cursor, info->product) != 0)
     {
@@ -520,6 +625,21 @@ static int read_GIADR_scalefactors(ingest_info *info)
         harp_set_error(HARP_ERROR_CODA, NULL);
         return -1;
     }
+
+    if (info->nr_scale_factors < 0 || info->nr_scale_factors > max_scale_factors)
+    {
+        harp_set_error(HARP_ERROR_INGESTION, "product error detected (invalid number of scale factors (%d))",
+                       (int)info->nr_scale_factors);
+        return -1;
+    }
+
+    /* the scale factors are constant for the whole product, so determine the multiplication factors only once */
+    CHECKED_MALLOC(info->band_scale, max_scale_factors * sizeof(double));
+    for (i = 0; i < info->nr_scale_factors; i++)
+    {
+        info->band_scale[i] = pow(10.0, -(info->scale_factors[i]));
+    }
+
     return 0;
 }
 
@@ -542,12 +662,22 @@ static int ingestion_init(const harp_ingestion_module *module, coda_product *pro
     info->product = product;
     info->format_version = format_version;
     info->valid_scanlines = 0;
+    info->spectrum_length = -1;
+    info->wavenumber_mdr_index = -1;
 
     if (init_dimensions(info) != 0)
     {
         ingestion_done(info);
         return -1;
     }
+    info->wavenumber = malloc(info->num_pixels * sizeof(float));
+    if (info->wavenumber == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       info->num_pixels * sizeof(float), __FILE__, __LINE__);
+        ingestion_done(info);
+        return -1;
+    }
     if (read_GIADR_scalefactors(info) != 0)
     {
         ingestion_done(info);
@@ -576,6 +706,7 @@ int harp_ingestion_module_iasi_l1_init(void)
 
     description = "IASI Level 1 product";
     product_definition = harp_ingestion_register_product(module, "IASI_L1", description, read_dimensions);
+    harp_product_definition_set_read_datetime_range(product_definition, read_datetime_range);
     description = "IASI Level 1 products contain a number of scanlines, each scanline contains 30 scans, each scan "
         "contains 4 spectra and each spectrum contains 8700 measurements";
     harp_product_definition_add_mapping(product_definition, description, NULL);
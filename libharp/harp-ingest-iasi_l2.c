@@ -642,6 +642,7 @@ int harp_ingestion_module_iasi_l2_init(void)
         harp_ingestion_register_variable_block_read(product_definition, "datetime", harp_type_double, 1,
                                                     dimension_type, NULL, description, "seconds since 2000-01-01",
                                                     NULL, read_time);
+    harp_variable_definition_set_time_monotonic(variable_definition);
     path = "/MDR[]/MDR/RECORD_HEADER/RECORD_START_TIME";
     description = "The time for a scan is the MDR start time + the scan id (0..29) times 8 / 37. Each part of the 2x2 "
         "matrix of a scan will get assigned the same measurement time (i.e. there are 30 unique time values "
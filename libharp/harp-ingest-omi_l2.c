@@ -213,19 +213,16 @@ static void calculate_corner_coordinates(long num_time, long num_xtrack, const d
 static void transform_array_double(long num_elements, double *data, double missing_value, double scale_factor,
                                    double offset)
 {
-    double *data_end;
-
-    for (data_end = data + num_elements; data != data_end; data++)
-    {
-        if (*data == missing_value)
-        {
-            *data = coda_NaN();
-        }
-        else
-        {
-            *data = offset + scale_factor * (*data);
-        }
-    }
+    harp_packing packing;
+    harp_array array;
+
+    harp_packing_init(&packing);
+    packing.has_fill_value = 1;
+    packing.fill_value = missing_value;
+    packing.scale_factor = scale_factor;
+    packing.add_offset = offset;
+    array.double_data = data;
+    harp_array_decode(harp_type_double, harp_type_double, num_elements, &packing, array);
 }
 
 static void broadcast_array_double(long num_time, long num_xtrack, double *data)
@@ -130,8 +130,9 @@ static int read_data_set(ingest_info *info, const char *data_set_name, double *b
     double missing_value;
     double scale_factor;
     double offset;
+    harp_packing packing;
+    harp_array data;
     long num_elements;
-    long i;
 
     cursor = info->grid_cursor;
 
@@ -162,17 +163,13 @@ static int read_data_set(ingest_info *info, const char *data_set_name, double *b
     }
 
     /* apply scaling and filter for NaN */
-    for (i = 0; i < num_elements; i++)
-    {
-        if (buffer[i] == missing_value)
-        {
-            buffer[i] = coda_NaN();
-        }
-        else
-        {
-            buffer[i] = offset + scale_factor * buffer[i];
-        }
-    }
+    harp_packing_init(&packing);
+    packing.has_fill_value = 1;
+    packing.fill_value = missing_value;
+    packing.scale_factor = scale_factor;
+    packing.add_offset = offset;
+    data.double_data = buffer;
+    harp_array_decode(harp_type_double, harp_type_double, num_elements, &packing, data);
 
     return 0;
 }
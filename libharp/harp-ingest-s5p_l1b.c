@@ -66,6 +66,7 @@ typedef struct ingest_info_struct
 
     coda_cursor wavelength_cursor;
     harp_scalar wavelength_fill_value;
+    float *wavelength;  /* #pixels x #channels wavelength grid (read on first use) */
     coda_cursor observable_cursor;
     harp_scalar observable_fill_value;
 } ingest_info;
@@ -357,7 +358,13 @@ static int parse_option_band(ingest_info *info, const harp_ingestion_options *op
 
 static void ingestion_done(void *user_data)
 {
-    free(user_data);
+    ingest_info *info = (ingest_info *)user_data;
+
+    if (info->wavelength != NULL)
+    {
+        free(info->wavelength);
+    }
+    free(info);
 }
 
 static int ingestion_init_s5p_l1b_ir(const harp_ingestion_module *module, coda_product *product,
@@ -377,6 +384,7 @@ static int ingestion_init_s5p_l1b_ir(const harp_ingestion_module *module, coda_p
     }
     info->product = product;
     info->band = 1;
+    info->wavelength = NULL;
 
     if (parse_option_band(info, options) != 0)
     {
@@ -456,6 +464,7 @@ static int ingestion_init_s5p_l1b_ra(const harp_ingestion_module *module, coda_p
     }
     info->product = product;
     info->band = -1;
+    info->wavelength = NULL;
 
     if (init_cursors(info, NULL) != 0)
     {
@@ -743,27 +752,60 @@ static int read_viewing_zenith_angle(void *user_data, harp_array data)
     return read_dataset(info->geo_data_cursor, "viewing_zenith_angle", info->num_scanlines * info->num_pixels, data);
 }
 
-static int read_wavelength(void *user_data, long index, harp_array data)
+static long get_optimal_range_length(void *user_data)
 {
     ingest_info *info = (ingest_info *)user_data;
-    long offset;
 
-    /* Compute the offset into an array of dimensions #pixels x #channels (either calibrated_wavelength or
-     * nominal_wavelength) using a pixel index derived from the provided index on the time dimension (of length
-     * #scanlines x #pixels).
-     */
-    offset = (index - (index / info->num_pixels) * info->num_pixels) * info->num_channels;
+    /* the spectral datasets are stored per scanline, so read a full scanline (all pixels) at a time */
+    return info->num_pixels;
+}
 
-    return read_partial_dataset(&info->wavelength_cursor, offset, info->num_channels, data,
-                                info->wavelength_fill_value);
+static int read_wavelength(void *user_data, long index_offset, long index_length, harp_array data)
+{
+    ingest_info *info = (ingest_info *)user_data;
+    long pixel_size = info->num_channels * sizeof(float);
+    long i;
+
+    if (info->wavelength == NULL)
+    {
+        harp_array wavelength;
+
+        /* the wavelength grid (either calibrated_wavelength or nominal_wavelength) only depends on the pixel, so it is
+         * read once and then replicated for each scanline */
+        info->wavelength = malloc(info->num_pixels * pixel_size);
+        if (info->wavelength == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           info->num_pixels * pixel_size, __FILE__, __LINE__);
+            return -1;
+        }
+        wavelength.float_data = info->wavelength;
+        if (read_partial_dataset(&info->wavelength_cursor, 0, info->num_pixels * info->num_channels, wavelength,
+                                 info->wavelength_fill_value) != 0)
+        {
+            free(info->wavelength);
+            info->wavelength = NULL;
+            return -1;
+        }
+    }
+
+    /* the pixel index is the index on the time dimension (of length #scanlines x #pixels) modulo #pixels */
+    for (i = 0; i < index_length; i++)
+    {
+        long pixel = (index_offset + i) % info->num_pixels;
+
+        memcpy(&data.float_data[i * info->num_channels], &info->wavelength[pixel * info->num_channels], pixel_size);
+    }
+
+    return 0;
 }
 
-static int read_observable(void *user_data, long index, harp_array data)
+static int read_observable(void *user_data, long index_offset, long index_length, harp_array data)
 {
     ingest_info *info = (ingest_info *)user_data;
 
-    return read_partial_dataset(&info->observable_cursor, index * info->num_channels, info->num_channels, data,
-                                info->observable_fill_value);
+    return read_partial_dataset(&info->observable_cursor, index_offset * info->num_channels,
+                                index_length * info->num_channels, data, info->observable_fill_value);
 }
 
 static void register_irradiance_product_variables(harp_product_definition *product_definition,
@@ -805,16 +847,17 @@ static void register_irradiance_product_variables(harp_product_definition *produ
     /* Irradiance. */
     description = "calibrated wavelength";
     variable_definition =
-        harp_ingestion_register_variable_block_read(product_definition, "wavelength", harp_type_float, 2,
-                                                    dimension_type, NULL, description, "nm", NULL, read_wavelength);
+        harp_ingestion_register_variable_range_read(product_definition, "wavelength", harp_type_float, 2,
+                                                    dimension_type, NULL, description, "nm", NULL,
+                                                    get_optimal_range_length, read_wavelength);
     snprintf(path, MAX_PATH_LENGTH, "/%s/STANDARD_MODE/INSTRUMENT/calibrated_wavelength[]", product_group_name);
     harp_variable_definition_add_mapping(variable_definition, NULL, NULL, path, NULL);
 
     description = "spectral photon irradiance";
     variable_definition =
-        harp_ingestion_register_variable_block_read(product_definition, "photon_irradiance", harp_type_float, 2,
+        harp_ingestion_register_variable_range_read(product_definition, "photon_irradiance", harp_type_float, 2,
                                                     dimension_type, NULL, description, "mol/(s.m^2.nm)", NULL,
-                                                    read_observable);
+                                                    get_optimal_range_length, read_observable);
     snprintf(path, MAX_PATH_LENGTH, "/%s/STANDARD_MODE/OBSERVATIONS/irradiance[]", product_group_name);
     harp_variable_definition_add_mapping(variable_definition, NULL, NULL, path, NULL);
 }
@@ -961,16 +1004,17 @@ static void register_radiance_product_variables(harp_product_definition *product
     /* Radiance. */
     description = "nominal wavelength";
     variable_definition =
-        harp_ingestion_register_variable_block_read(product_definition, "wavelength", harp_type_float, 2,
-                                                    dimension_type, NULL, description, "nm", NULL, read_wavelength);
+        harp_ingestion_register_variable_range_read(product_definition, "wavelength", harp_type_float, 2,
+                                                    dimension_type, NULL, description, "nm", NULL,
+                                                    get_optimal_range_length, read_wavelength);
     snprintf(path, MAX_PATH_LENGTH, "/%s/STANDARD_MODE/INSTRUMENT/nominal_wavelength[]", product_group_name);
     harp_variable_definition_add_mapping(variable_definition, NULL, NULL, path, NULL);
 
     description = "spectral photon radiance";
     variable_definition =
-        harp_ingestion_register_variable_block_read(product_definition, "photon_radiance", harp_type_float, 2,
+        harp_ingestion_register_variable_range_read(product_definition, "photon_radiance", harp_type_float, 2,
                                                     dimension_type, NULL, description, "mol/(s.m^2.nm.sr)", NULL,
-                                                    read_observable);
+                                                    get_optimal_range_length, read_observable);
     snprintf(path, MAX_PATH_LENGTH, "/%s/STANDARD_MODE/OBSERVATIONS/radiance[]", product_group_name);
     harp_variable_definition_add_mapping(variable_definition, NULL, NULL, path, NULL);
 }
@@ -838,6 +838,45 @@ static int read_dataset(coda_cursor cursor, const char *dataset_name, harp_data_
     return 0;
 }
 
+/* Read a single element (using C-order indexing) from a double dataset; fill values are returned as NaN */
+static int read_dataset_element(coda_cursor cursor, const char *dataset_name, long index, double *value)
+{
+    double fill_value;
+
+    if (coda_cursor_goto_record_field_by_name(&cursor, dataset_name) != 0)
+    {
+        harp_set_error(HARP_ERROR_CODA, NULL);
+        return -1;
+    }
+    if (coda_cursor_goto_array_element_by_index(&cursor, index) != 0)
+    {
+        harp_set_error(HARP_ERROR_CODA, NULL);
+        return -1;
+    }
+    if (coda_cursor_read_double(&cursor, value) != 0)
+    {
+        harp_set_error(HARP_ERROR_CODA, NULL);
+        return -1;
+    }
+    coda_cursor_goto_parent(&cursor);
+    if (coda_cursor_goto(&cursor, "@FillValue[0]") != 0)
+    {
+        harp_set_error(HARP_ERROR_CODA, NULL);
+        return -1;
+    }
+    if (coda_cursor_read_double(&cursor, &fill_value) != 0)
+    {
+        harp_set_error(HARP_ERROR_CODA, NULL);
+        return -1;
+    }
+    if (*value == fill_value)
+    {
+        *value = harp_nan();
+    }
+
+    return 0;
+}
+
 static int read_dimensions(void *user_data, long dimension[HARP_NUM_DIM_TYPES])
 {
     ingest_info *info = (ingest_info *)user_data;
@@ -967,6 +1006,60 @@ static int read_time_coverage_resolution(void *user_data, harp_array data)
     return 0;
 }
 
+static int read_datetime_range(void *user_data, double *datetime_start, double *datetime_stop)
+{
+    ingest_info *info = (ingest_info *)user_data;
+    harp_array data;
+    double time_reference;
+    double datetime[2];
+    double datetime_length;
+    long last_index;
+
+    /* the scanlines are in chronological order, so only the first and last delta_time value are needed */
+    data.ptr = &time_reference;
+    if (read_dataset(info->product_cursor, "time", harp_type_double, 1, data) != 0)
+    {
+        return -1;
+    }
+    last_index = info->num_scanlines - 1;
+    if (s5p_delta_time_num_dims[info->product_type] != 2)
+    {
+        last_index = info->num_scanlines * info->num_pixels - 1;
+    }
+    if (read_dataset_element(info->product_cursor, "delta_time", 0, &datetime[0]) != 0)
+    {
+        return -1;
+    }
+    if (read_dataset_element(info->product_cursor, "delta_time", last_index, &datetime[1]) != 0)
+    {
+        return -1;
+    }
+    if (harp_isnan(datetime[0]) || harp_isnan(datetime[1]))
+    {
+        /* let HARP determine the range from the full datetime_start variable */
+        return 1;
+    }
+
+    data.ptr = &datetime_length;
+    if (read_time_coverage_resolution(info, data) != 0)
+    {
+        return -1;
+    }
+
+    /* convert to seconds since 2010-01-01 (see read_datetime()) and take the stop time of the last measurement */
+    datetime[0] = time_reference + datetime[0] / 1e3;
+    datetime[1] = time_reference + datetime[1] / 1e3 + datetime_length;
+    if (harp_convert_unit("seconds since 2010-01-01", "days since 2000-01-01", 2, datetime) != 0)
+    {
+        return -1;
+    }
+
+    *datetime_start = datetime[0];
+    *datetime_stop = datetime[1];
+
+    return 0;
+}
+
 static int read_orbit_index(void *user_data, harp_array data)
 {
     ingest_info *info = (ingest_info *)user_data;
@@ -3638,6 +3731,8 @@ static void register_core_variables(harp_product_definition *product_definition,
     harp_variable_definition *variable_definition;
     harp_dimension_type dimension_type[1] = { harp_dimension_time };
 
+    harp_product_definition_set_read_datetime_range(product_definition, read_datetime_range);
+
     /* scan_subindex */
     description = "pixel index (0-based) within the scanline";
     variable_definition =
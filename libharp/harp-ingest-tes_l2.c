@@ -188,7 +188,7 @@ static int read_variable(coda_cursor *cursor, const char *name, int num_dimensio
     long num_elements;
     long coda_dimension[CODA_MAX_NUM_DIMS];
     int num_coda_dimensions;
-    long i;
+    harp_packing packing;
 
     if (coda_cursor_goto_record_field_by_name(cursor, name) != 0)
     {
@@ -235,17 +235,12 @@ static int read_variable(coda_cursor *cursor, const char *name, int num_dimensio
     }
 
     /* apply scaling and filter for NaN */
-    for (i = 0; i < num_elements; i++)
-    {
-        if (data.double_data[i] == missing_value)
-        {
-            data.double_data[i] = coda_NaN();
-        }
-        else
-        {
-            data.double_data[i] = offset + scale_factor * data.double_data[i];
-        }
-    }
+    harp_packing_init(&packing);
+    packing.has_fill_value = 1;
+    packing.fill_value = missing_value;
+    packing.scale_factor = scale_factor;
+    packing.add_offset = offset;
+    harp_array_decode(harp_type_double, harp_type_double, num_elements, &packing, data);
 
     coda_cursor_goto_parent(cursor);
 
@@ -97,6 +97,9 @@ int harp_ingestion_module_smr_l2_init(void);
 int harp_ingestion_module_temis_init(void);
 int harp_ingestion_module_tes_l2_init(void);
 
+/* Module cleanup functions (for modules that keep process-wide caches). */
+void harp_ingestion_module_ecmwf_grib_done(void);
+
 /* Module initialization functions. */
 typedef int (module_init_func_t) (void);
 
@@ -312,6 +315,7 @@ static int variable_definition_new(const char *name, harp_data_type data_type, i
     variable_definition->read_range = read_range;
     variable_definition->get_optimal_range_length = get_optimal_range_length;
     variable_definition->read_block = read_block;
+    variable_definition->is_time_monotonic = 0;
 
     variable_definition->num_mappings = 0;
     variable_definition->mapping = NULL;
@@ -387,6 +391,7 @@ static int product_definition_new(const char *name, const char *description,
     product_definition->variable_definition = NULL;
     product_definition->variable_definition_hash_data = NULL;
     product_definition->read_dimensions = read_dimensions;
+    product_definition->read_datetime_range = NULL;
     product_definition->ingestion_option = NULL;
     product_definition->mapping_description = NULL;
 
@@ -1077,6 +1082,21 @@ int harp_variable_definition_has_dimension_type(const harp_variable_definition *
     return harp_variable_definition_has_dimension_types(variable_definition, 1, &dimension_type);
 }
 
+/* Declare that the values of a variable do not decrease along its time dimension (fill values excepted).
+ * This allows the datetime range of a product to be determined from the first and last sample only (see
+ * harp_ingest_global_attributes()). The variable needs to have the time dimension as its first dimension and needs
+ * to provide a read_range or read_block function.
+ */
+void harp_variable_definition_set_time_monotonic(harp_variable_definition *variable_definition)
+{
+    assert(variable_definition != NULL);
+    assert(variable_definition->num_dimensions > 0);
+    assert(variable_definition->dimension_type[0] == harp_dimension_time);
+    assert(variable_definition->read_range != NULL || variable_definition->read_block != NULL);
+
+    variable_definition->is_time_monotonic = 1;
+}
+
 int harp_variable_definition_exclude(const harp_variable_definition *variable_definition, void *user_data)
 {
     return (variable_definition->exclude != NULL && variable_definition->exclude(user_data));
@@ -1113,6 +1133,22 @@ void harp_product_definition_add_mapping(harp_product_definition *product_defini
     }
 }
 
+/* Set a function that determines the datetime range (as days since 2000-01-01) of a product without reading the
+ * datetime variables in full (e.g. from global attributes or from the first and last scanline).
+ * The function should return 0 on success, 1 if the range could not be determined this way (the datetime variables
+ * will then be read instead), and -1 on error.
+ */
+void harp_product_definition_set_read_datetime_range(harp_product_definition *product_definition,
+                                                     int (*read_datetime_range) (void *user_data,
+                                                                                 double *datetime_start,
+                                                                                 double *datetime_stop))
+{
+    assert(product_definition != NULL);
+    assert(read_datetime_range != NULL);
+
+    product_definition->read_datetime_range = read_datetime_range;
+}
+
 int harp_product_definition_has_dimension_type(const harp_product_definition *product_definition,
                                                harp_dimension_type dimension_type)
 {
@@ -1206,7 +1242,43 @@ int harp_ingestion_module_validate_options(harp_ingestion_module *module, const
     return 0;
 }
 
-int harp_ingestion_find_module(const char *filename, harp_ingestion_module **module, coda_product **cproduct)
+/* Open a product using the CODA product class/type/version of the cached product (i.e. without the automatic product
+ * type detection of coda_open()) and verify it using the verify_product_type() function of the cached module.
+ * Returns 1 if the product was opened as the cached product type and 0 otherwise.
+ */
+static int open_as_cached_product_type(const char *filename, const harp_ingestion_module_cache *cache,
+                                       coda_product **cproduct)
+{
+    coda_product *product;
+
+    if (cache->module->verify_product_type(cache->module, filename) != 0)
+    {
+        return 0;
+    }
+    if (cache->product_class == NULL)
+    {
+        /* custom ingestion module */
+        return 1;
+    }
+    if (coda_open_as(filename, cache->product_class, cache->product_type, cache->product_version, &product) != 0)
+    {
+        /* let the regular product type detection deal with the product (and report any errors) */
+        return 0;
+    }
+    *cproduct = product;
+
+    return 1;
+}
+
+/* Find the ingestion module for a product.
+ * If a cache is given (e.g. with the product type of the previous file of a batch ingestion), the product type of the
+ * cache is tried first. If the cached module can verify products itself (verify_product_type()), the product is opened
+ * directly as the cached CODA product class/type/version, which skips the product type detection of CODA. Otherwise
+ * the product type detected by CODA is compared against the cached product type, which avoids the search over all
+ * registered modules. The cache is updated with the product type of the product.
+ */
+static int find_module(const char *filename, harp_ingestion_module_cache *cache, harp_ingestion_module **module,
+                       coda_product **cproduct)
 {
     coda_product *product;
     int result;
@@ -1216,6 +1288,15 @@ int harp_ingestion_find_module(const char *filename, harp_ingestion_module **mod
     assert(filename != NULL);
     assert(cproduct != NULL);
 
+    if (cache != NULL && cache->module != NULL && cache->module->verify_product_type != NULL)
+    {
+        if (open_as_cached_product_type(filename, cache, cproduct))
+        {
+            *module = cache->module;
+            return 0;
+        }
+    }
+
     /* Try to identify the product using CODA. */
     result = coda_open(filename, &product);
     if (result != 0 && coda_errno == CODA_ERROR_FILE_OPEN && coda_get_option_use_mmap())
@@ -1232,6 +1313,7 @@ int harp_ingestion_find_module(const char *filename, harp_ingestion_module **mod
     {
         const char *product_class;
         const char *product_type;
+        int product_version;
 
         if (coda_get_product_class(product, &product_class) != 0)
         {
@@ -1245,10 +1327,25 @@ int harp_ingestion_find_module(const char *filename, harp_ingestion_module **mod
             coda_close(product);
             return -1;
         }
+        if (coda_get_product_version(product, &product_version) != 0)
+        {
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            coda_close(product);
+            return -1;
+        }
 
         /* Look for a compatible ingestion module by comparing product_class and product_type. */
         if (product_class != NULL && product_type != NULL)
         {
+            if (cache != NULL && cache->product_class != NULL && strcmp(cache->product_class, product_class) == 0 &&
+                strcmp(cache->product_type, product_type) == 0)
+            {
+                cache->product_version = product_version;
+                *module = cache->module;
+                *cproduct = product;
+                return 0;
+            }
+
             for (i = 0; i < module_register->num_ingestion_modules; i++)
             {
                 harp_ingestion_module *ingestion_module;
@@ -1269,6 +1366,14 @@ int harp_ingestion_find_module(const char *filename, harp_ingestion_module **mod
                     continue;
                 }
 
+                if (cache != NULL)
+                {
+                    /* the module owns a copy of the product class/type strings */
+                    cache->module = ingestion_module;
+                    cache->product_class = ingestion_module->product_class;
+                    cache->product_type = ingestion_module->product_type;
+                    cache->product_version = product_version;
+                }
                 *module = ingestion_module;
                 *cproduct = product;
                 return 0;
@@ -1300,11 +1405,23 @@ int harp_ingestion_find_module(const char *filename, harp_ingestion_module **mod
             {
                 continue;
             }
+            if (cache != NULL && ingestion_module == cache->module && cache->product_class == NULL)
+            {
+                /* was already verified above */
+                continue;
+            }
             if (ingestion_module->verify_product_type(ingestion_module, filename) != 0)
             {
                 continue;
             }
 
+            if (cache != NULL)
+            {
+                cache->module = ingestion_module;
+                cache->product_class = NULL;
+                cache->product_type = NULL;
+                cache->product_version = -1;
+            }
             *module = ingestion_module;
             return 0;
         }
@@ -1314,6 +1431,36 @@ int harp_ingestion_find_module(const char *filename, harp_ingestion_module **mod
     return -1;
 }
 
+int harp_ingestion_find_module(const char *filename, harp_ingestion_module **module, coda_product **cproduct)
+{
+    double trace_start = harp_trace_begin();
+
+    if (find_module(filename, NULL, module, cproduct) != 0)
+    {
+        return -1;
+    }
+    harp_trace_end(trace_start, "ingestion", "find_module", (*module)->name, -1, -1);
+
+    return 0;
+}
+
+/* Same as harp_ingestion_find_module(), but first try the product type of the given cache (which is updated with the
+ * product type of the product).
+ */
+int harp_ingestion_find_module_cached(const char *filename, harp_ingestion_module_cache *cache,
+                                      harp_ingestion_module **module, coda_product **cproduct)
+{
+    double trace_start = harp_trace_begin();
+
+    if (find_module(filename, cache, module, cproduct) != 0)
+    {
+        return -1;
+    }
+    harp_trace_end(trace_start, "ingestion", "find_module", (*module)->name, -1, -1);
+
+    return 0;
+}
+
 int harp_ingestion_init(void)
 {
     int i;
@@ -1398,6 +1545,8 @@ void harp_ingestion_done(void)
         free(module_register);
         module_register = NULL;
 
+        harp_ingestion_module_ecmwf_grib_done();
+
         coda_done();
     }
 }
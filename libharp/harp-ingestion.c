@@ -41,9 +41,16 @@
 #include "harp-program.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 typedef struct read_buffer_struct
 {
@@ -79,6 +86,17 @@ typedef struct ingest_info_struct
     long block_buffer_num_blocks;       /* number of blocks that can fit in the buffer */
 } ingest_info;
 
+struct harp_ingestion_session_struct
+{
+    harp_program *program;      /* operations to perform on each product (owned by the caller) */
+    harp_ingestion_options *option_list;        /* parsed ingestion options */
+    harp_ingestion_module_cache module_cache;   /* product type of the most recent product (options are validated
+                                                 * for its module) */
+    read_buffer *block_buffer;  /* 'read_all'/'read_range' buffer that is handed over from one product to the next */
+    int perform_conversions;    /* libcoda option value to restore when the session ends */
+    int perform_boundary_checks;        /* libcoda option value to restore when the session ends */
+};
+
 static void read_buffer_free_string_data(read_buffer *buffer)
 {
     if (buffer->data_type == harp_type_string)
@@ -227,6 +245,7 @@ static int ingestion_init(ingest_info **new_info)
     info->product = NULL;
     info->block_buffer = NULL;
     info->block_buffer_read_all = NULL;
+    info->block_buffer_read_range = NULL;
 
     if (harp_dimension_mask_set_new(&info->dimension_mask_set) != 0)
     {
@@ -1740,6 +1759,7 @@ static int evaluate_ingestion_mask(ingest_info *info, harp_program *program)
  */
 static int get_product(ingest_info *info, harp_program *program)
 {
+    double trace_start;
     int i;
 
     if (harp_product_new(&info->product) != 0)
@@ -1777,10 +1797,12 @@ static int get_product(ingest_info *info, harp_program *program)
         return 0;
     }
 
+    trace_start = harp_trace_begin();
     if (evaluate_ingestion_mask(info, program))
     {
         return -1;
     }
+    harp_trace_end(trace_start, "ingestion", "evaluate_ingestion_mask", info->product_definition->name, -1, -1);
 
     if (info->product_mask == 0)
     {
@@ -1797,11 +1819,13 @@ static int get_product(ingest_info *info, harp_program *program)
             continue;
         }
 
+        trace_start = harp_trace_begin();
         if (get_variable(info, info->product_definition->variable_definition[i], info->dimension_mask_set,
                          &variable) != 0)
         {
             return -1;
         }
+        harp_trace_end_variable(trace_start, "ingestion", "read_variable", variable);
 
         if (harp_product_add_variable(info->product, variable) != 0)
         {
@@ -1825,29 +1849,39 @@ static int get_product(ingest_info *info, harp_program *program)
     return 0;
 }
 
-static int ingest(const char *filename, harp_program *program, const harp_ingestion_options *option_list,
-                  harp_product **product)
+static int ingest(harp_ingestion_session *session, const char *filename, harp_product **product)
 {
+    harp_ingestion_module *previous_module = session->module_cache.module;
+    harp_ingestion_module *module;
     ingest_info *info;
 
     if (ingestion_init(&info) != 0)
     {
         return -1;
     }
-    if (harp_ingestion_find_module(filename, &info->module, &info->cproduct) != 0)
+    if (harp_ingestion_find_module_cached(filename, &session->module_cache, &info->module, &info->cproduct) != 0)
     {
         ingestion_done(info);
         return -1;
     }
-    if (harp_ingestion_module_validate_options(info->module, option_list) != 0)
+    module = info->module;
+    if (module != previous_module)
     {
-        ingestion_done(info);
-        return -1;
+        /* the options only need to be validated again if the product is handled by a different module */
+        if (harp_ingestion_module_validate_options(module, session->option_list) != 0)
+        {
+            /* make sure that the options are validated again for the next product */
+            session->module_cache.module = NULL;
+            session->module_cache.product_class = NULL;
+            session->module_cache.product_type = NULL;
+            ingestion_done(info);
+            return -1;
+        }
     }
-    if (info->cproduct != NULL && info->module->ingestion_init_coda != NULL)
+    if (info->cproduct != NULL && module->ingestion_init_coda != NULL)
     {
-        if (info->module->ingestion_init_coda(info->module, info->cproduct, option_list, &info->product_definition,
-                                              &info->user_data) != 0)
+        if (module->ingestion_init_coda(module, info->cproduct, session->option_list, &info->product_definition,
+                                        &info->user_data) != 0)
         {
             ingestion_done(info);
             return -1;
@@ -1855,9 +1889,9 @@ static int ingest(const char *filename, harp_program *program, const harp_ingest
     }
     else
     {
-        assert(info->module->ingestion_init_custom != NULL);
-        if (info->module->ingestion_init_custom(info->module, filename, option_list, &info->product_definition,
-                                                &info->user_data) != 0)
+        assert(module->ingestion_init_custom != NULL);
+        if (module->ingestion_init_custom(module, filename, session->option_list, &info->product_definition,
+                                          &info->user_data) != 0)
         {
             ingestion_done(info);
             return -1;
@@ -1867,8 +1901,12 @@ static int ingest(const char *filename, harp_program *program, const harp_ingest
 
     info->basename = harp_basename(filename);
 
+    /* reuse the read buffer of the previous product (its content is invalidated by the NULL read callbacks) */
+    info->block_buffer = session->block_buffer;
+    session->block_buffer = NULL;
+
     /* ingest the product */
-    if (get_product(info, program) != 0)
+    if (get_product(info, session->program) != 0)
     {
         ingestion_done(info);
         return -1;
@@ -1877,17 +1915,118 @@ static int ingest(const char *filename, harp_program *program, const harp_ingest
     *product = info->product;
     info->product = NULL;
 
+    if (info->block_buffer != NULL)
+    {
+        read_buffer_free_string_data(info->block_buffer);
+        session->block_buffer = info->block_buffer;
+        info->block_buffer = NULL;
+    }
+
     ingestion_done(info);
 
     return 0;
 }
 
+/* Start an ingestion session for ingesting a series of products with the same operations and options.
+ * The session pins the parsed ingestion options and the product type (ingestion module and CODA product
+ * class/type/version) of the last product. For each product the pinned product type is tried first (see
+ * harp_ingestion_find_module_cached()), and the options are only validated again when a product requires a different
+ * module.
+ * The program is not copied and should remain available until the session is deleted.
+ * The libcoda options that are required for ingestion are set for the lifetime of the session.
+ */
+int harp_ingestion_session_new(harp_program *program, const char *options, harp_ingestion_session **new_session)
+{
+    harp_ingestion_session *session;
+
+    if (harp_ingestion_init() != 0)
+    {
+        return -1;
+    }
+
+    session = (harp_ingestion_session *)malloc(sizeof(harp_ingestion_session));
+    if (session == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_ingestion_session), __FILE__, __LINE__);
+        return -1;
+    }
+    session->program = program;
+    session->option_list = NULL;
+    session->module_cache.module = NULL;
+    session->module_cache.product_class = NULL;
+    session->module_cache.product_type = NULL;
+    session->module_cache.product_version = -1;
+    session->block_buffer = NULL;
+
+    if (options == NULL)
+    {
+        if (harp_ingestion_options_new(&session->option_list) != 0)
+        {
+            free(session);
+            return -1;
+        }
+    }
+    else
+    {
+        if (harp_ingestion_options_from_string(options, &session->option_list) != 0)
+        {
+            free(session);
+            return -1;
+        }
+    }
+
+    /* all ingestion routines that use CODA are build on the assumption that 'perform conversions' is enabled, so we
+     * explicitly enable it here just in case it was disabled somewhere else */
+    session->perform_conversions = coda_get_option_perform_conversions();
+    coda_set_option_perform_conversions(1);
+
+    /* we also disable the boundary checks of libcoda for increased ingestion performance */
+    session->perform_boundary_checks = coda_get_option_perform_boundary_checks();
+    coda_set_option_perform_boundary_checks(0);
+
+    *new_session = session;
+    return 0;
+}
+
+void harp_ingestion_session_delete(harp_ingestion_session *session)
+{
+    if (session != NULL)
+    {
+        /* set the libcoda options back to their original values */
+        coda_set_option_perform_boundary_checks(session->perform_boundary_checks);
+        coda_set_option_perform_conversions(session->perform_conversions);
+
+        harp_ingestion_options_delete(session->option_list);
+        read_buffer_delete(session->block_buffer);
+        free(session);
+    }
+}
+
+/* Ingest a product using the operations and options of the session.
+ * The caller is responsible for resetting the program of the session (see harp_program_reset()).
+ */
+int harp_ingestion_session_ingest(harp_ingestion_session *session, const char *filename, harp_product **product)
+{
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (product == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    return ingest(session, filename, product);
+}
+
 int harp_ingest(const char *filename, const char *operations, const char *options, harp_product **product)
 {
+    harp_ingestion_session *session;
     harp_program *program;
-    harp_ingestion_options *option_list;
-    int perform_conversions;
-    int perform_boundary_checks;
     int status;
 
     if (filename == NULL)
@@ -1922,47 +2061,188 @@ int harp_ingest(const char *filename, const char *operations, const char *option
         }
     }
 
-    if (options == NULL)
+    if (harp_ingestion_session_new(program, options, &session) != 0)
     {
-        if (harp_ingestion_options_new(&option_list) != 0)
+        harp_program_delete(program);
+        return -1;
+    }
+
+    status = ingest(session, filename, product);
+
+    harp_ingestion_session_delete(session);
+    harp_program_delete(program);
+    return status;
+}
+
+/* Determine the datetime range using only the first and last time sample of each datetime variable.
+ * This is only possible if all datetime variables are either time independent or are declared as monotonic in time
+ * (and can be read per sample). Returns 1 if this approach is not applicable (or if one of the boundary samples is
+ * invalid), in which case the datetime variables need to be read in full.
+ */
+static int read_boundary_datetime_range(ingest_info *info, double *datetime_start, double *datetime_stop)
+{
+    harp_product *product;
+    long num_samples;
+    long last_index;
+    int has_time_dimension = 0;
+    int i;
+
+    for (i = 0; i < info->product_definition->num_variable_definitions; i++)
+    {
+        harp_variable_definition *variable_def = info->product_definition->variable_definition[i];
+        int k;
+
+        if (strncmp(variable_def->name, "datetime", 8) != 0)
         {
-            harp_program_delete(program);
-            return -1;
+            continue;
+        }
+        if (harp_variable_definition_exclude(variable_def, info->user_data))
+        {
+            return 1;
+        }
+        if (variable_def->num_dimensions == 0)
+        {
+            continue;
+        }
+        if (!variable_def->is_time_monotonic)
+        {
+            return 1;
         }
+        for (k = 1; k < variable_def->num_dimensions; k++)
+        {
+            if (variable_def->dimension_type[k] != harp_dimension_independent)
+            {
+                return 1;
+            }
+        }
+        has_time_dimension = 1;
     }
-    else
+    if (!has_time_dimension)
     {
-        if (harp_ingestion_options_from_string(options, &option_list) != 0)
+        return 1;
+    }
+
+    last_index = info->dimension[harp_dimension_time] - 1;
+    num_samples = last_index > 0 ? 2 : 1;
+
+    if (harp_product_new(&product) != 0)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < info->product_definition->num_variable_definitions; i++)
+    {
+        harp_variable_definition *variable_def = info->product_definition->variable_definition[i];
+        harp_variable *variable;
+        long dimension[HARP_MAX_NUM_DIMS];
+        long j;
+        int k;
+
+        if (strncmp(variable_def->name, "datetime", 8) != 0)
+        {
+            continue;
+        }
+
+        if (variable_def->num_dimensions == 0)
+        {
+            if (get_variable(info, variable_def, NULL, &variable) != 0)
+            {
+                harp_product_delete(product);
+                return -1;
+            }
+        }
+        else
+        {
+            harp_array block;
+
+            dimension[0] = num_samples;
+            for (k = 1; k < variable_def->num_dimensions; k++)
+            {
+                dimension[k] = variable_def->dimension[k];
+            }
+            if (harp_variable_new(variable_def->name, variable_def->data_type, variable_def->num_dimensions,
+                                  variable_def->dimension_type, dimension, &variable) != 0)
+            {
+                harp_product_delete(product);
+                return -1;
+            }
+            if (variable_def->unit != NULL)
+            {
+                if (harp_variable_set_unit(variable, variable_def->unit) != 0)
+                {
+                    harp_variable_delete(variable);
+                    harp_product_delete(product);
+                    return -1;
+                }
+            }
+            variable->valid_min = variable_def->valid_min;
+            variable->valid_max = variable_def->valid_max;
+
+            /* read the first and last sample */
+            block = variable->data;
+            if (read_block(info, variable_def, 0, block) != 0)
+            {
+                harp_variable_delete(variable);
+                harp_product_delete(product);
+                return -1;
+            }
+            if (num_samples > 1)
+            {
+                block.ptr = (void *)((char *)block.ptr + (variable->num_elements / num_samples) *
+                                     harp_get_size_for_type(variable->data_type));
+                if (read_block(info, variable_def, last_index, block) != 0)
+                {
+                    harp_variable_delete(variable);
+                    harp_product_delete(product);
+                    return -1;
+                }
+            }
+        }
+
+        if (harp_variable_convert_data_type(variable, harp_type_double) != 0)
         {
-            harp_program_delete(program);
+            harp_variable_delete(variable);
+            harp_product_delete(product);
             return -1;
         }
-    }
+        for (j = 0; j < variable->num_elements; j++)
+        {
+            double value = variable->data.double_data[j];
 
-    /* all ingestion routines that use CODA are build on the assumption that 'perform conversions' is enabled, so we
-     * explicitly enable it here just in case it was disabled somewhere else */
-    perform_conversions = coda_get_option_perform_conversions();
-    coda_set_option_perform_conversions(1);
+            if (harp_isnan(value) || value < variable->valid_min.double_data ||
+                value > variable->valid_max.double_data)
+            {
+                /* the boundary samples can not be used to determine the range */
+                harp_variable_delete(variable);
+                harp_product_delete(product);
+                return 1;
+            }
+        }
 
-    /* we also disable the boundary checks of libcoda for increased ingestion performance */
-    perform_boundary_checks = coda_get_option_perform_boundary_checks();
-    coda_set_option_perform_boundary_checks(0);
+        if (harp_product_add_variable(product, variable) != 0)
+        {
+            harp_variable_delete(variable);
+            harp_product_delete(product);
+            return -1;
+        }
+    }
 
-    status = ingest(filename, program, option_list, product);
+    if (harp_product_get_datetime_range(product, datetime_start, datetime_stop) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
 
-    /* set the libcoda options back to their original values */
-    coda_set_option_perform_boundary_checks(perform_boundary_checks);
-    coda_set_option_perform_conversions(perform_conversions);
+    harp_product_delete(product);
 
-    harp_ingestion_options_delete(option_list);
-    harp_program_delete(program);
-    return status;
+    return 0;
 }
 
 static int ingest_metadata(const char *filename, const harp_ingestion_options *option_list, double *datetime_start,
                            double *datetime_stop, long dimension[])
 {
     ingest_info *info;
+    int status;
     int i;
 
     if (ingestion_init(&info) != 0)
@@ -2030,6 +2310,23 @@ static int ingest_metadata(const char *filename, const harp_ingestion_options *o
         return 0;
     }
 
+    if (info->product_definition->read_datetime_range != NULL)
+    {
+        status = info->product_definition->read_datetime_range(info->user_data, datetime_start, datetime_stop);
+        if (status != 1)
+        {
+            ingestion_done(info);
+            return status;
+        }
+    }
+
+    status = read_boundary_datetime_range(info, datetime_start, datetime_stop);
+    if (status != 1)
+    {
+        ingestion_done(info);
+        return status;
+    }
+
     /* read all variables whose name starts with 'datetime' */
     for (i = 0; i < info->product_definition->num_variable_definitions; i++)
     {
@@ -2138,171 +2435,631 @@ int harp_ingest_global_attributes(const char *filename, const char *options, dou
     return 0;
 }
 
-/** returns:
- * -1 = initialization problem (e.g. harp initialization, file could not be opened, ...)
- *      harp_errno will be set
- * 0 = no problems
- * 1 = product ingestion results in errors for at least one set of options
- *     error is already printed, harp_errno should be ignored
- */
-int harp_ingest_test(const char *filename, int (*print) (const char *, ...))
+static int ingest_estimate(const char *filename, const harp_ingestion_options *option_list,
+                           harp_product_estimate **estimate)
 {
-    coda_product *product = NULL;
+    harp_product_estimate *new_estimate;
     ingest_info *info;
-    harp_program *program;
-    harp_ingestion_options *option_list;
-    harp_ingestion_module *module;
-    int perform_conversions;
-    int perform_boundary_checks;
-    int num_options = 0;
-    int *option_choice = NULL;
-    int result;
-    int depth, i;
+    int i;
 
-    if (filename == NULL)
+    if (ingestion_init(&info) != 0)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
         return -1;
     }
-
-    if (harp_ingestion_init() != 0)
+    if (harp_ingestion_find_module(filename, &info->module, &info->cproduct) != 0)
     {
+        ingestion_done(info);
         return -1;
     }
-
-    if (harp_program_new(&program) != 0)
+    if (harp_ingestion_module_validate_options(info->module, option_list) != 0)
     {
+        ingestion_done(info);
         return -1;
     }
-
-    if (harp_ingestion_options_new(&option_list) != 0)
+    if (info->cproduct != NULL && info->module->ingestion_init_coda != NULL)
     {
-        harp_program_delete(program);
-        return -1;
+        if (info->module->ingestion_init_coda(info->module, info->cproduct, option_list, &info->product_definition,
+                                              &info->user_data) != 0)
+        {
+            ingestion_done(info);
+            return -1;
+        }
     }
+    else
+    {
+        assert(info->module->ingestion_init_custom != NULL);
+        if (info->module->ingestion_init_custom(info->module, filename, option_list, &info->product_definition,
+                                                &info->user_data) != 0)
+        {
+            ingestion_done(info);
+            return -1;
+        }
+    }
+    assert(info->product_definition != NULL);
+
+    if (harp_product_estimate_new(&new_estimate) != 0)
+    {
+        ingestion_done(info);
+        return -1;
+    }
+
+    if (init_product_dimensions(info) != 0)
+    {
+        harp_product_estimate_delete(new_estimate);
+        ingestion_done(info);
+        return -1;
+    }
+    if (product_has_empty_dimensions(info))
+    {
+        /* empty product is not considered an error */
+        *estimate = new_estimate;
+        ingestion_done(info);
+        return 0;
+    }
+
+    if (init_variable_mask(info) != 0)
+    {
+        harp_product_estimate_delete(new_estimate);
+        ingestion_done(info);
+        return -1;
+    }
+
+    /* the variable definitions provide the data type and dimensions of each variable; no data is read */
+    for (i = 0; i < info->product_definition->num_variable_definitions; i++)
+    {
+        const harp_variable_definition *variable_def;
+        long dimension[HARP_MAX_NUM_DIMS];
+        int j;
+
+        if (!info->variable_mask[i])
+        {
+            continue;
+        }
+
+        variable_def = info->product_definition->variable_definition[i];
+        for (j = 0; j < variable_def->num_dimensions; j++)
+        {
+            if (variable_def->dimension_type[j] == harp_dimension_independent)
+            {
+                dimension[j] = variable_def->dimension[j];
+            }
+            else
+            {
+                dimension[j] = info->dimension[variable_def->dimension_type[j]];
+            }
+        }
+
+        if (harp_product_estimate_add_variable(new_estimate, variable_def->name, variable_def->data_type,
+                                               variable_def->num_dimensions, variable_def->dimension_type,
+                                               dimension) != 0)
+        {
+            harp_product_estimate_delete(new_estimate);
+            ingestion_done(info);
+            return -1;
+        }
+    }
+
+    *estimate = new_estimate;
+
+    ingestion_done(info);
+
+    return 0;
+}
+
+/* Estimate the dimensions and variables of an ingested product without reading any variable data.
+ * Only the dimension lengths (as provided by the ingestion module) and the variable definitions are used.
+ */
+int harp_ingest_estimate(const char *filename, const char *options, harp_product_estimate **estimate)
+{
+    harp_ingestion_options *option_list;
+    int perform_conversions;
+    int perform_boundary_checks;
+    int status;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (harp_ingestion_init() != 0)
+    {
+        return -1;
+    }
+
+    if (options == NULL)
+    {
+        if (harp_ingestion_options_new(&option_list) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if (harp_ingestion_options_from_string(options, &option_list) != 0)
+        {
+            return -1;
+        }
+    }
+
+    /* all ingestion routines that use CODA are build on the assumption that 'perform conversions' is enabled, so we
+     * explicitly enable it here just in case it was disabled somewhere else */
+    perform_conversions = coda_get_option_perform_conversions();
+    coda_set_option_perform_conversions(1);
 
-    /* all ingestion routines that use CODA are build on the assumption that 'perform conversions' is enabled, so we
-     * explicitly enable it here just in case it was disabled somewhere else */
-    perform_conversions = coda_get_option_perform_conversions();
-    coda_set_option_perform_conversions(1);
-
     /* we also disable the boundary checks of libcoda for increased ingestion performance */
     perform_boundary_checks = coda_get_option_perform_boundary_checks();
     coda_set_option_perform_boundary_checks(0);
 
-    result = harp_ingestion_find_module(filename, &module, &product);
-    if (result == 0)
+    status = ingest_estimate(filename, option_list, estimate);
+
+    /* set the libcoda options back to their original values */
+    coda_set_option_perform_boundary_checks(perform_boundary_checks);
+    coda_set_option_perform_conversions(perform_conversions);
+
+    harp_ingestion_options_delete(option_list);
+
+    return status;
+}
+
+/* stream to which the report of an ingestion test is written when the test is run in a separate worker process */
+static FILE *test_report_stream = NULL;
+
+static int print_test_report(const char *message, ...)
+{
+    va_list ap;
+    int result;
+
+    va_start(ap, message);
+    result = vfprintf(test_report_stream, message, ap);
+    va_end(ap);
+
+    return result;
+}
+
+/* Set the option choices for the given combination index.
+ * Combinations are enumerated with the last option varying fastest, where for each option the first choice is to not
+ * provide the option (choice -1), followed by each of its allowed values.
+ */
+static void get_test_option_choice(const harp_ingestion_module *module, long index, int *option_choice)
+{
+    int i;
+
+    for (i = module->num_option_definitions - 1; i >= 0; i--)
     {
-        num_options = module->num_option_definitions;
-        option_choice = malloc(num_options * sizeof(int));
-        if (option_choice == NULL)
+        long num_choices = module->option_definition[i]->num_allowed_values + 1;
+
+        option_choice[i] = (int)(index % num_choices) - 1;
+        index /= num_choices;
+    }
+}
+
+/* Print the start of the report line of an option combination (the options that are set). */
+static void print_test_options(const harp_ingestion_module *module, const int *option_choice,
+                               int (*print) (const char *, ...))
+{
+    int i;
+
+    print("ingestion:");
+    for (i = 0; i < module->num_option_definitions; i++)
+    {
+        if (i > 0)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                           num_options * sizeof(int), __FILE__, __LINE__);
-            result = -1;
+            print(",");
+        }
+        print(" %s ", module->option_definition[i]->name);
+        if (option_choice[i] >= 0)
+        {
+            print("= %s", module->option_definition[i]->allowed_value[option_choice[i]]);
         }
         else
         {
-            for (i = 0; i < num_options; i++)
+            print("unset");
+        }
+    }
+    fflush(stdout);
+}
+
+/* Finish the report line of an option combination with a failure and the current HARP error. */
+static void print_test_failure(int (*print) (const char *, ...))
+{
+    print(" [FAIL]\n");
+    print("ERROR: %s\n", harp_errno_to_string(harp_errno));
+}
+
+/** returns:
+ * -1 = initialization problem, harp_errno will be set (the failure is already printed)
+ * 0 = ingestion succeeded
+ * 1 = ingestion failed, error is already printed
+ */
+static int ingest_test_options(const char *filename, harp_ingestion_module *module, coda_product *product,
+                               harp_program *program, const int *option_choice, int (*print) (const char *, ...))
+{
+    harp_ingestion_options *option_list;
+    ingest_info *info;
+    int num_options = module->num_option_definitions;
+    int status;
+    int i;
+
+    print_test_options(module, option_choice, print);
+
+    if (harp_ingestion_options_new(&option_list) != 0)
+    {
+        print_test_failure(print);
+        return -1;
+    }
+    for (i = 0; i < num_options; i++)
+    {
+        if (option_choice[i] >= 0)
+        {
+            if (harp_ingestion_options_set_option(option_list, module->option_definition[i]->name,
+                                                  module->option_definition[i]->allowed_value[option_choice[i]]) != 0)
             {
-                option_choice[i] = -1;  /* -1 means that the option is not provided */
+                print_test_failure(print);
+                harp_ingestion_options_delete(option_list);
+                return -1;
             }
         }
     }
 
-    depth = num_options;
-    while (result >= 0 && depth >= 0)
+    if (ingestion_init(&info) != 0)
+    {
+        print_test_failure(print);
+        harp_ingestion_options_delete(option_list);
+        return -1;
+    }
+    info->cproduct = product;
+    info->basename = harp_basename(filename);
+    info->module = module;
+
+    if (info->cproduct != NULL && info->module->ingestion_init_coda != NULL)
+    {
+        status = info->module->ingestion_init_coda(info->module, info->cproduct, option_list,
+                                                   &info->product_definition, &info->user_data);
+    }
+    else
+    {
+        assert(info->module->ingestion_init_custom != NULL);
+        status = info->module->ingestion_init_custom(info->module, filename, option_list, &info->product_definition,
+                                                     &info->user_data);
+    }
+    if (status == 0)
+    {
+        assert(info->product_definition != NULL);
+        if (num_options > 0)
+        {
+            print(" =>");
+        }
+        print(" %s", info->product_definition->name);
+        fflush(stdout);
+
+        status = get_product(info, program);
+    }
+    if (status == 0)
+    {
+        print(" [OK]\n");
+    }
+    else
+    {
+        print_test_failure(print);
+    }
+
+    info->cproduct = NULL;
+    ingestion_done(info);
+    harp_ingestion_options_delete(option_list);
+
+    return (status == 0) ? 0 : 1;
+}
+
+static int ingest_test_serial(const char *filename, harp_ingestion_module *module, coda_product *product,
+                              harp_program *program, long num_combinations, int *option_choice,
+                              int (*print) (const char *, ...))
+{
+    int result = 0;
+    long k;
+
+    for (k = 0; k < num_combinations; k++)
+    {
+        int status;
+
+        get_test_option_choice(module, k, option_choice);
+        status = ingest_test_options(filename, module, product, program, option_choice, print);
+        if (status < 0)
+        {
+            /* no sense to try other options */
+            return -1;
+        }
+        if (status != 0)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+#ifndef WIN32
+/* Run a single option combination in a forked worker process.
+ * The worker inherits the detected ingestion module and, if it can be safely shared, the opened CODA product.
+ * Products that are accessed via a file position (i.e. anything that is not a memory mapped ascii/binary product) are
+ * reopened by the worker, since the underlying file descriptor (and its position) is shared with the parent process.
+ * The exit code of the worker is the result of ingest_test_options(), with initialization problems reported as 1.
+ */
+static void ingest_test_worker(const char *filename, harp_ingestion_module *module, coda_product *product,
+                               int share_product, harp_program *program, int *option_choice, FILE *report)
+{
+    int status;
+
+    /* the trace file belongs to the parent process */
+    harp_trace_enabled = 0;
+
+    /* don't buffer the report, such that partial output is retained if the ingestion crashes */
+    setvbuf(report, NULL, _IONBF, 0);
+    test_report_stream = report;
+
+    if (product != NULL && !share_product)
+    {
+        if (coda_open(filename, &product) != 0)
+        {
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            print_test_options(module, option_choice, print_test_report);
+            print_test_failure(print_test_report);
+            fflush(report);
+            _exit(1);
+        }
+    }
+
+    status = ingest_test_options(filename, module, product, program, option_choice, print_test_report);
+    if (status < 0)
+    {
+        /* the failure is already reported by ingest_test_options() */
+        status = 1;
+    }
+    fflush(report);
+
+    /* use _exit() such that no atexit() handlers are run and no stdio buffers of the parent are flushed again */
+    _exit(status);
+}
+
+static int print_test_worker_report(FILE *report, int wait_status, int (*print) (const char *, ...))
+{
+    char buffer[4096];
+    size_t length;
+    int result;
+
+    rewind(report);
+    while ((length = fread(buffer, 1, sizeof(buffer) - 1, report)) > 0)
+    {
+        buffer[length] = '\0';
+        print("%s", buffer);
+    }
+    fclose(report);
+
+    if (WIFEXITED(wait_status))
+    {
+        result = WEXITSTATUS(wait_status);
+    }
+    else
+    {
+        result = 1;
+        if (WIFSIGNALED(wait_status))
+        {
+            print(" [FAIL]\nERROR: ingestion terminated by signal %d\n", WTERMSIG(wait_status));
+        }
+        else
+        {
+            print(" [FAIL]\nERROR: ingestion terminated abnormally\n");
+        }
+    }
+    fflush(stdout);
+
+    return result == 0 ? 0 : 1;
+}
+
+/* Test all option combinations using at most num_workers concurrent worker processes.
+ * Each worker writes its report to a temporary file, which is printed by the parent process in the order in which the
+ * combinations are enumerated, so the output is identical to that of ingest_test_serial().
+ */
+static int ingest_test_parallel(const char *filename, harp_ingestion_module *module, coda_product *product,
+                                harp_program *program, long num_combinations, int num_workers, int *option_choice,
+                                int (*print) (const char *, ...))
+{
+    FILE **report;
+    pid_t *pid;
+    int *wait_status;
+    int share_product = 0;
+    int result = 0;
+    long num_started = 0;
+    long num_printed = 0;
+    long num_running = 0;
+    long k;
+
+    if (product != NULL)
     {
-        if (depth == num_options)
+        coda_format format;
+
+        if (coda_get_product_format(product, &format) != 0)
         {
-            int status;
+            harp_set_error(HARP_ERROR_CODA, NULL);
+            return -1;
+        }
+        share_product = (format == coda_format_ascii || format == coda_format_binary) && coda_get_option_use_mmap();
+    }
 
-            status = ingestion_init(&info);
-            if (status != 0)
+    report = malloc(num_combinations * sizeof(FILE *));
+    pid = malloc(num_combinations * sizeof(pid_t));
+    wait_status = malloc(num_combinations * sizeof(int));
+    if (report == NULL || pid == NULL || wait_status == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_combinations * (sizeof(FILE *) + sizeof(pid_t) + sizeof(int)), __FILE__, __LINE__);
+        free(wait_status);
+        free(pid);
+        free(report);
+        return -1;
+    }
+
+    while (num_printed < num_combinations)
+    {
+        /* start new workers for pending combinations */
+        while (result >= 0 && num_running < num_workers && num_started < num_combinations)
+        {
+            report[num_started] = tmpfile();
+            if (report[num_started] == NULL)
             {
-                /* no sense to try other options */
+                harp_set_error(HARP_ERROR_FILE_OPEN, "could not create temporary file (%s) (%s:%u)", strerror(errno),
+                               __FILE__, __LINE__);
                 result = -1;
                 break;
             }
-            info->cproduct = product;
-            info->basename = harp_basename(filename);
-            info->module = module;
+            get_test_option_choice(module, num_started, option_choice);
 
-            print("ingestion:");
-            for (i = 0; i < num_options; i++)
-            {
-                if (i > 0)
-                {
-                    print(",");
-                }
-                print(" %s ", module->option_definition[i]->name);
-                if (option_choice[i] >= 0)
-                {
-                    print("= %s", module->option_definition[i]->allowed_value[option_choice[i]]);
-                }
-                else
-                {
-                    print("unset");
-                }
-            }
+            /* make sure the worker does not inherit pending output */
             fflush(stdout);
+            fflush(stderr);
 
-            if (info->cproduct != NULL && info->module->ingestion_init_coda != NULL)
+            pid[num_started] = fork();
+            if (pid[num_started] < 0)
             {
-                status = info->module->ingestion_init_coda(info->module, info->cproduct, option_list,
-                                                           &info->product_definition, &info->user_data);
+                harp_set_error(HARP_ERROR_OPERATION, "could not start worker process (%s) (%s:%u)", strerror(errno),
+                               __FILE__, __LINE__);
+                fclose(report[num_started]);
+                result = -1;
+                break;
             }
-            else
+            if (pid[num_started] == 0)
             {
-                assert(info->module->ingestion_init_custom != NULL);
-                status = info->module->ingestion_init_custom(info->module, filename, option_list,
-                                                             &info->product_definition, &info->user_data);
+                ingest_test_worker(filename, module, product, share_product, program, option_choice,
+                                   report[num_started]);
             }
-            if (status == 0)
-            {
-                assert(info->product_definition != NULL);
-                if (num_options > 0)
-                {
-                    print(" =>");
-                }
-                print(" %s", info->product_definition->name);
-                fflush(stdout);
+            num_started++;
+            num_running++;
+        }
+        if (num_printed == num_started)
+        {
+            /* nothing left to wait for (this only happens when starting a worker failed) */
+            break;
+        }
 
-                status = get_product(info, program);
+        /* reap any worker that has finished; if none did, block on the oldest running worker (whose report is the
+         * next one to be printed) */
+        for (k = num_printed; k < num_started; k++)
+        {
+            if (pid[k] > 0 && waitpid(pid[k], &wait_status[k], WNOHANG) == pid[k])
+            {
+                pid[k] = 0;
+                num_running--;
             }
-            if (status == 0)
+        }
+        if (pid[num_printed] > 0)
+        {
+            while (waitpid(pid[num_printed], &wait_status[num_printed], 0) < 0)
             {
-                print(" [OK]\n");
+                if (errno != EINTR)
+                {
+                    /* treat the worker as having terminated abnormally */
+                    wait_status[num_printed] = -1;
+                    break;
+                }
             }
-            else
+            pid[num_printed] = 0;
+            num_running--;
+        }
+
+        /* print the reports of all finished workers in enumeration order */
+        while (num_printed < num_started && pid[num_printed] == 0)
+        {
+            if (print_test_worker_report(report[num_printed], wait_status[num_printed], print) != 0 &&
+                result == 0)
             {
-                print(" [FAIL]\n");
-                print("ERROR: %s\n", harp_errno_to_string(harp_errno));
                 result = 1;
             }
+            num_printed++;
+        }
+    }
 
-            info->cproduct = NULL;
-            ingestion_done(info);
+    free(wait_status);
+    free(pid);
+    free(report);
 
-            depth--;
+    return result;
+}
+#endif
+
+/** returns:
+ * -1 = initialization problem (e.g. harp initialization, file could not be opened, ...)
+ *      harp_errno will be set
+ * 0 = no problems
+ * 1 = product ingestion results in errors for at least one set of options
+ *     error is already printed, harp_errno should be ignored
+ */
+int harp_ingest_test(const char *filename, int (*print) (const char *, ...))
+{
+    coda_product *product = NULL;
+    harp_program *program;
+    harp_ingestion_module *module;
+    int perform_conversions;
+    int perform_boundary_checks;
+    int *option_choice = NULL;
+    long num_combinations = 1;
+    int result;
+    int i;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (harp_ingestion_init() != 0)
+    {
+        return -1;
+    }
+
+    if (harp_program_new(&program) != 0)
+    {
+        return -1;
+    }
+
+    /* all ingestion routines that use CODA are build on the assumption that 'perform conversions' is enabled, so we
+     * explicitly enable it here just in case it was disabled somewhere else */
+    perform_conversions = coda_get_option_perform_conversions();
+    coda_set_option_perform_conversions(1);
+
+    /* we also disable the boundary checks of libcoda for increased ingestion performance */
+    perform_boundary_checks = coda_get_option_perform_boundary_checks();
+    coda_set_option_perform_boundary_checks(0);
+
+    /* the module detection (and opening of the product) is only performed once and shared by all option tests */
+    result = harp_ingestion_find_module(filename, &module, &product);
+    if (result == 0)
+    {
+        /* one extra choice per option for leaving the option unset (the malloc size is at least 1) */
+        for (i = 0; i < module->num_option_definitions; i++)
+        {
+            num_combinations *= module->option_definition[i]->num_allowed_values + 1;
         }
-        if (depth >= 0)
+        option_choice = malloc((module->num_option_definitions + 1) * sizeof(int));
+        if (option_choice == NULL)
         {
-            if (option_choice[depth] < module->option_definition[depth]->num_allowed_values - 1)
-            {
-                const char *value;
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (module->num_option_definitions + 1) * sizeof(int), __FILE__, __LINE__);
+            result = -1;
+        }
+    }
 
-                option_choice[depth]++;
-                value = module->option_definition[depth]->allowed_value[option_choice[depth]];
-                harp_ingestion_options_set_option(option_list, module->option_definition[depth]->name, value);
-                depth = num_options;
-            }
-            else
-            {
-                option_choice[depth] = -1;
-                harp_ingestion_options_remove_option(option_list, module->option_definition[depth]->name);
-                depth--;
-            }
+    if (result == 0)
+    {
+#ifndef WIN32
+        if (harp_option_test_num_workers > 1 && num_combinations > 1)
+        {
+            result = ingest_test_parallel(filename, module, product, program, num_combinations,
+                                          harp_option_test_num_workers, option_choice, print);
+        }
+        else
+#endif
+        {
+            result = ingest_test_serial(filename, module, product, program, num_combinations, option_choice, print);
         }
     }
 
@@ -2319,7 +3076,6 @@ int harp_ingest_test(const char *filename, int (*print) (const char *, ...))
     coda_set_option_perform_boundary_checks(perform_boundary_checks);
     coda_set_option_perform_conversions(perform_conversions);
 
-    harp_ingestion_options_delete(option_list);
     harp_program_delete(program);
 
     return result;
@@ -33,6 +33,7 @@
 #define HARP_INGESTION_H
 
 #include "harp-internal.h"
+#include "harp-program.h"
 #include "coda.h"
 
 typedef struct harp_ingestion_option_struct
@@ -85,6 +86,9 @@ typedef struct harp_variable_definition_struct
     long (*get_optimal_range_length) (void *user_data);
     int (*read_block) (void *user_data, long index, harp_array data);
 
+    /* values are non-decreasing along the time dimension (only the first and last sample are needed for a range) */
+    int is_time_monotonic;
+
     int num_mappings;
     harp_mapping_description **mapping;
 } harp_variable_definition;
@@ -99,6 +103,7 @@ typedef struct harp_product_definition_struct
     struct hashtable_struct *variable_definition_hash_data;
 
     int (*read_dimensions) (void *user_data, long dimension[HARP_NUM_DIM_TYPES]);
+    int (*read_datetime_range) (void *user_data, double *datetime_start, double *datetime_stop);
 
     char *ingestion_option;
     char *mapping_description;
@@ -167,6 +172,7 @@ void harp_variable_definition_set_valid_range_double(harp_variable_definition *v
                                                      double valid_max);
 void harp_variable_definition_set_enumeration_values(harp_variable_definition *variable_definition, int num_enum_values,
                                                      const char **enum_name);
+void harp_variable_definition_set_time_monotonic(harp_variable_definition *variable_definition);
 
 int harp_variable_definition_has_dimension_types(const harp_variable_definition *variable_definition,
                                                  int num_dimensions, const harp_dimension_type *dimension_type);
@@ -177,6 +183,10 @@ int harp_variable_definition_exclude(const harp_variable_definition *variable_de
 /* Product definition. */
 void harp_product_definition_add_mapping(harp_product_definition *product_definition, const char *mapping_description,
                                          const char *ingestion_option);
+void harp_product_definition_set_read_datetime_range(harp_product_definition *product_definition,
+                                                     int (*read_datetime_range) (void *user_data,
+                                                                                 double *datetime_start,
+                                                                                 double *datetime_stop));
 int harp_product_definition_has_dimension_type(const harp_product_definition *product_definition,
                                                harp_dimension_type dimension_type);
 int harp_product_definition_has_variable(const harp_product_definition *product_definition, const char *name);
@@ -187,10 +197,28 @@ int harp_product_definition_get_variable_index(const harp_product_definition *pr
 /* Ingestion module. */
 int harp_ingestion_module_validate_options(harp_ingestion_module *module, const harp_ingestion_options *options);
 
+/* Product type of the most recent product of a batch ingestion, which is tried first for the next product. */
+typedef struct harp_ingestion_module_cache_struct
+{
+    harp_ingestion_module *module;      /* NULL if no product was identified yet */
+    const char *product_class;  /* CODA product class of the product (NULL if the product was not opened with CODA) */
+    const char *product_type;   /* CODA product type of the product (NULL if the product was not opened with CODA) */
+    int product_version;        /* CODA product format version of the product */
+} harp_ingestion_module_cache;
+
 /* Module register. */
 int harp_ingestion_find_module(const char *filename, harp_ingestion_module **module, coda_product **product);
+int harp_ingestion_find_module_cached(const char *filename, harp_ingestion_module_cache *cache,
+                                      harp_ingestion_module **module, coda_product **product);
 harp_ingestion_module_register *harp_ingestion_get_module_register(void);
 
+/* Ingestion session (for ingesting a series of products with the same operations and options). */
+typedef struct harp_ingestion_session_struct harp_ingestion_session;
+
+int harp_ingestion_session_new(harp_program *program, const char *options, harp_ingestion_session **new_session);
+void harp_ingestion_session_delete(harp_ingestion_session *session);
+int harp_ingestion_session_ingest(harp_ingestion_session *session, const char *filename, harp_product **product);
+
 /* Convenience functions. */
 harp_ingestion_module *harp_ingestion_register_module_coda
     (const char *name, const char *product_group, const char *product_class, const char *product_type,
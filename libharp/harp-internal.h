@@ -64,6 +64,9 @@
 
 extern int harp_option_enable_aux_afgl86;
 extern int harp_option_enable_aux_usstd76;
+extern int harp_option_ragged_vertical;
+extern int64_t harp_option_memory_limit;
+extern int harp_option_test_num_workers;
 
 typedef int (*harp_conversion_function) (harp_variable *variable, const harp_variable **source_variable);
 typedef int (*harp_conversion_enabled_function) (void);
@@ -122,6 +125,97 @@ typedef struct harp_derived_variable_list_struct
 
 extern harp_derived_variable_list *harp_derived_variable_conversions;
 
+/* A gather plan describes how the elements of a dimension are rearranged (see harp_variable_rearrange_dimension()).
+ * The plan is derived once from a list of dim_element_ids and can then be applied to all variables that depend on the
+ * dimension. Consecutive target elements that come from consecutive source elements are combined into runs, such that
+ * each run can be moved with a single memcpy() per group. Permutations are applied in place by following their cycles.
+ * Other rearrangements gather into a newly allocated data block that replaces the data block of the variable.
+ */
+typedef struct harp_gather_run_struct
+{
+    long source_id;
+    long target_id;
+    long length;
+} harp_gather_run;
+
+typedef struct harp_gather_plan_struct
+{
+    long source_length; /* length of the dimension before rearranging */
+    long target_length; /* length of the dimension after rearranging */
+    long *source_id;    /* [target_length] source element for each target element */
+    long *first_target_id;      /* [source_length] first target element for each source element (or -1 if unused) */
+    long num_runs;
+    harp_gather_run *run;
+    int is_identity;    /* the rearrangement does not change anything */
+    int is_compaction;  /* source ids are strictly increasing (i.e. elements are only removed) */
+    int is_permutation; /* each source element is used exactly once */
+    long num_cycles;
+    long *cycle_start;  /* [num_cycles] one (target) element of each cycle of a permutation */
+} harp_gather_plan;
+
+/* A deferred import provides the variables of a HARP product without their data. The data of a variable is only read
+ * from the file (using the format specific read_data function) when it is requested, which allows a product to be
+ * converted one variable at a time without having the full product in memory.
+ * The variable_id is the format specific identifier of a variable in the file (e.g. the netCDF variable id).
+ * If a time selection is set (see harp_deferred_import_select_time()), time dependent variables are read using the
+ * (optional) format specific read_time_ranges function, which reads the given ranges of time samples (in that order)
+ * into data.
+ */
+typedef struct harp_deferred_import_struct
+{
+    void *file; /* format specific file information */
+    int num_variables;
+    harp_variable **variable;   /* variables that were created without data (variables are owned by the product) */
+    int *variable_id;
+    int (*read_data) (void *file, int variable_id, harp_variable *variable);
+    int (*read_time_ranges) (void *file, int variable_id, const harp_variable *variable, long num_ranges,
+                             const long *range_start, const long *range_length, harp_array data);
+    int (*close) (void *file);
+    /* time selection */
+    long num_time_indices;
+    long *time_index;   /* sorted indices of the time samples in the file that are read */
+    long num_time_ranges;
+    long *time_range_start;
+    long *time_range_length;    /* ranges also include the gaps between time indices that are read anyway */
+} harp_deferred_import;
+
+/* A product writer creates a HARP product file of which the time dependent variables are written one block of time
+ * samples at a time. The format specific open function creates the file with all dimensions, variables, and attributes
+ * and writes the data of the time independent variables. Afterwards, write_data is called for each time dependent
+ * variable of each block. The variable_index is the index of the variable in the product of the writer.
+ * When the writer is closed, write_datetime_range sets the datetime_start/datetime_stop attributes to the datetime
+ * range of all written blocks (or removes them if has_datetime_range is 0).
+ */
+struct harp_product_writer_struct
+{
+    harp_product *product;      /* definition of the file content (time dependent variables have no data) */
+    long *string_length;        /* [num_variables] length of the string dimension for variables of type string */
+    long time_offset;   /* number of time samples that have been written */
+    int has_datetime_range;
+    double datetime_start;
+    double datetime_stop;
+    void *file; /* format specific file information */
+    int (*write_data) (void *file, int variable_index, const harp_variable *variable, long time_offset);
+    int (*write_datetime_range) (void *file, int has_datetime_range, double datetime_start, double datetime_stop);
+    int (*close) (void *file);
+};
+
+/* A packing description gives the encoding of values as they are stored in a product (see harp_array_decode()).
+ * The fill value and valid range are in packed units (i.e. before scale_factor and add_offset are applied).
+ */
+typedef struct harp_packing_struct
+{
+    int is_unsigned;    /* integer values should be interpreted as unsigned */
+    int has_fill_value;
+    double fill_value;
+    int has_valid_min;
+    double valid_min;
+    int has_valid_max;
+    double valid_max;
+    double scale_factor;
+    double add_offset;
+} harp_packing;
+
 /* Utility functions */
 int harp_path_find_file(const char *searchpath, const char *filename, char **location);
 int harp_path_from_path(const char *initialpath, int is_filepath, const char *appendpath, char **resultpath);
@@ -131,6 +225,9 @@ long harp_parse_double(const char *buffer, long buffer_length, double *dst, int
 long harp_get_max_string_length(long num_strings, char **string_data);
 int harp_get_char_array_from_string_array(long num_strings, char **string_data, long min_string_length,
                                           long *string_length, char **char_data);
+char *harp_string_block_new(long num_strings, long string_length);
+void harp_string_block_distribute(char *block, long num_strings, long string_length, char **string_data);
+int harp_string_array_copy(long num_strings, char **source_data, char **target_data, char **block);
 long harp_get_num_elements(int num_dimensions, const long *dimension);
 void harp_array_null(harp_data_type data_type, long num_elements, harp_array data);
 void harp_array_replace_fill_value(harp_data_type data_type, long num_elements, harp_array data,
@@ -138,6 +235,9 @@ void harp_array_replace_fill_value(harp_data_type data_type, long num_elements,
 int harp_array_invert(harp_data_type data_type, int dim_id, int num_dimensions, const long *dimension, harp_array data);
 int harp_array_transpose(harp_data_type data_type, int num_dimensions, const long *dimension, const int *order,
                          harp_array data);
+void harp_packing_init(harp_packing *packing);
+void harp_array_decode(harp_data_type source_type, harp_data_type target_type, long num_elements,
+                       const harp_packing *packing, harp_array data);
 
 /* Auxiliary data sources */
 int harp_aux_afgl86_get_profile(const char *name, double datetime, double latitude, int *num_vertical,
@@ -153,6 +253,25 @@ void harp_hdf5_add_error_message(void);
 #endif
 void harp_add_coda_cursor_path_to_error_message(const coda_cursor *cursor);
 
+/* Tracing */
+extern int harp_trace_enabled;
+#define harp_trace_begin() (harp_trace_enabled ? harp_trace_get_time() : 0.0)
+double harp_trace_get_time(void);
+void harp_trace_end(double start_time, const char *category, const char *name, const char *detail, long num_elements,
+                    int64_t num_bytes);
+void harp_trace_end_variable(double start_time, const char *category, const char *name, const harp_variable *variable);
+void harp_trace_end_product(double start_time, const char *category, const char *name, const char *detail,
+                            const harp_product *product);
+int harp_trace_init(void);
+
+/* Memory */
+harp_memory_subsystem harp_memory_set_subsystem(harp_memory_subsystem subsystem);
+int64_t harp_memory_get_available(void);
+void *harp_memory_alloc(size_t size);
+void *harp_memory_realloc(void *ptr, size_t size);
+size_t harp_memory_get_size(const void *ptr);
+void harp_memory_free(void *ptr);
+
 /* Variables */
 int harp_variable_get_flag_values_string(const harp_variable *variable, char **flag_values);
 int harp_variable_get_flag_meanings_string(const harp_variable *variable, char **flag_meanings);
@@ -161,9 +280,24 @@ int harp_variable_add_dimension(harp_variable *variable, int dim_index, harp_dim
                                 long length);
 int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, long num_dim_elements,
                                       const long *dim_element_ids);
+int harp_gather_plan_new(long source_length, long num_dim_elements, const long *dim_element_ids,
+                         harp_gather_plan **new_plan);
+void harp_gather_plan_delete(harp_gather_plan *plan);
+int harp_variable_rearrange_dimension_with_plan(harp_variable *variable, int dim_index, harp_gather_plan *plan);
 int harp_variable_filter_dimension(harp_variable *variable, int dim_index, const uint8_t *mask);
 int harp_variable_resize_dimension(harp_variable *variable, int dim_index, long length);
 int harp_variable_remove_dimension(harp_variable *variable, int dim_index, long index);
+int harp_variable_has_ragged_vertical_layout(const harp_variable *variable);
+int harp_variable_pack_ragged_vertical(const harp_variable *variable, const long *vertical_count, harp_array *packed,
+                                       long *num_elements);
+int harp_variable_unpack_ragged_vertical(const harp_variable *variable, long num_time, harp_array packed,
+                                         const long *vertical_count, char *empty_string, harp_array data);
+int harp_variable_new_without_data(const char *name, harp_data_type data_type, int num_dimensions,
+                                   const harp_dimension_type *dimension_type, const long *dimension,
+                                   harp_variable **new_variable);
+void harp_variable_set_string_block(harp_variable *variable, char *string_block);
+int harp_variable_is_block_string(const harp_variable *variable, const char *string);
+void harp_variable_free_string(const harp_variable *variable, char *string);
 
 /* Products */
 int harp_product_rearrange_dimension(harp_product *product, harp_dimension_type dimension_type, long num_dim_elements,
@@ -174,13 +308,24 @@ int harp_product_remove_dimension(harp_product *product, harp_dimension_type dim
 void harp_product_remove_all_variables(harp_product *product);
 int harp_product_get_datetime_range(const harp_product *product, double *datetime_start, double *datetime_stop);
 int harp_product_get_derived_bounds_for_grid(harp_product *product, harp_variable *grid, harp_variable **bounds);
+int harp_product_get_derived_variable_data_type(const harp_product *product, const char *name, int num_dimensions,
+                                                const harp_dimension_type *dimension_type, harp_data_type *data_type);
 int harp_product_get_storage_size(const harp_product *product, int with_attributes, int64_t *size);
+int harp_product_concatenate(int num_products, harp_product **product, harp_product **merged_product);
+int harp_product_get_vertical_count(const harp_product *product, harp_deferred_import *import, long *count);
 int harp_product_bin_full(harp_product *product);
 int harp_product_bin_spatial_full(harp_product *product, long num_latitude_edges, double *latitude_edges,
                                   long num_longitude_edges, double *longitude_edges);
 int harp_product_bin_with_collocated_dataset(harp_product *product, harp_collocation_result *collocation_result);
 int harp_product_bin_with_variable(harp_product *product, const char *variable_name);
 
+/* Product estimate */
+int harp_product_estimate_new(harp_product_estimate **new_estimate);
+int harp_product_estimate_add_variable(harp_product_estimate *estimate, const char *name, harp_data_type data_type,
+                                       int num_dimensions, const harp_dimension_type *dimension_type,
+                                       const long *dimension);
+int harp_product_estimate_from_product(const harp_product *product, harp_product_estimate **new_estimate);
+
 /* Import */
 #ifdef HAVE_HDF4
 int harp_import_hdf4(const char *filename, harp_product **product);
@@ -189,14 +334,44 @@ int harp_import_hdf4(const char *filename, harp_product **product);
 int harp_import_hdf5(const char *filename, harp_product **product);
 #endif
 int harp_import_netcdf(const char *filename, harp_product **product);
+int harp_import_estimate_netcdf(const char *filename, harp_product_estimate **estimate);
+
+/* Deferred import */
+int harp_deferred_import_new(harp_deferred_import **new_import);
+void harp_deferred_import_delete(harp_deferred_import *import);
+int harp_deferred_import_add_variable(harp_deferred_import *import, harp_variable *variable, int variable_id);
+int harp_deferred_import_load_variable(harp_deferred_import *import, harp_variable *variable, int *loaded);
+void harp_deferred_import_unload_variable(harp_deferred_import *import, harp_variable *variable);
+int harp_deferred_import_select_time(harp_deferred_import *import, harp_product *product, long num_indices,
+                                     const long *index);
+#ifdef HAVE_HDF4
+int harp_import_deferred_hdf4(const char *filename, harp_product **product, harp_deferred_import **import);
+#endif
+#ifdef HAVE_HDF5
+int harp_import_deferred_hdf5(const char *filename, harp_product **product, harp_deferred_import **import);
+#endif
+int harp_import_deferred_netcdf(const char *filename, harp_product **product, harp_deferred_import **import);
+
+#ifdef HAVE_HDF4
+int harp_export_hdf4(const char *filename, const harp_product *product, harp_deferred_import *import);
+#endif
+#ifdef HAVE_HDF5
+int harp_export_hdf5(const char *filename, const harp_product *product, harp_deferred_import *import);
+#endif
+int harp_export_netcdf(const char *filename, const harp_product *product, harp_deferred_import *import);
+int harp_export_append_netcdf(const char *filename, const harp_product *product);
 
+/* Product writer */
 #ifdef HAVE_HDF4
-int harp_export_hdf4(const char *filename, const harp_product *product);
+int harp_product_writer_open_hdf4(const char *filename, const harp_product *template_product,
+                                  harp_product_writer *writer);
 #endif
 #ifdef HAVE_HDF5
-int harp_export_hdf5(const char *filename, const harp_product *product);
+int harp_product_writer_open_hdf5(const char *filename, const harp_product *template_product,
+                                  harp_product_writer *writer);
 #endif
-int harp_export_netcdf(const char *filename, const harp_product *product);
+int harp_product_writer_open_netcdf(const char *filename, const harp_product *template_product,
+                                    harp_product_writer *writer);
 
 #ifdef HAVE_HDF4
 int harp_import_global_attributes_hdf4(const char *filename, double *datetime_start, double *datetime_stop,
@@ -215,6 +390,7 @@ int harp_ingest(const char *filename, const char *operations, const char *option
 int harp_ingest_test(const char *filename, int (*print) (const char *, ...));
 int harp_ingest_global_attributes(const char *filename, const char *options, double *datetime_start,
                                   double *datetime_stop, long dimension[], char **source_product);
+int harp_ingest_estimate(const char *filename, const char *options, harp_product_estimate **estimate);
 void harp_ingestion_done(void);
 
 /* Units */
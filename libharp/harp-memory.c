@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2015-2018 S[&]T, The Netherlands.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "harp-internal.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/* Each tracked block is prefixed by a header that records the size of the block and the subsystem that owns it.
+ * The header is padded to 16 bytes such that the memory returned to the caller is suitably aligned for all HARP data
+ * types.
+ * The usage counters (and the active subsystem) are process wide and are updated without any locking, so the memory
+ * accounting (including the memory limit) assumes that HARP is used from a single thread at a time.
+ */
+typedef union memory_header_union
+{
+    struct
+    {
+        size_t size;
+        int subsystem;
+    } info;
+    int64_t align_int64;
+    double align_double;
+    char padding[16];
+} memory_header;
+
+static void *(*memory_malloc) (size_t) = malloc;
+static void *(*memory_realloc) (void *, size_t) = realloc;
+static void (*memory_free) (void *) = free;
+
+static harp_memory_subsystem current_subsystem = harp_memory_subsystem_general;
+
+static int64_t total_current = 0;
+static int64_t total_peak = 0;
+static int64_t subsystem_current[HARP_NUM_MEMORY_SUBSYSTEMS] = { 0 };
+static int64_t subsystem_peak[HARP_NUM_MEMORY_SUBSYSTEMS] = { 0 };
+
+static void add_usage(int subsystem, int64_t size)
+{
+    total_current += size;
+    if (total_current > total_peak)
+    {
+        total_peak = total_current;
+    }
+    subsystem_current[subsystem] += size;
+    if (subsystem_current[subsystem] > subsystem_peak[subsystem])
+    {
+        subsystem_peak[subsystem] = subsystem_current[subsystem];
+    }
+}
+
+static void remove_usage(int subsystem, int64_t size)
+{
+    total_current -= size;
+    subsystem_current[subsystem] -= size;
+    assert(total_current >= 0 && subsystem_current[subsystem] >= 0);
+}
+
+static int check_limit(size_t size, int64_t size_increase)
+{
+    if (harp_option_memory_limit > 0 && size_increase > 0 && total_current + size_increase > harp_option_memory_limit)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "memory limit exceeded (could not allocate %lu bytes; %ld of %ld "
+                       "bytes in use) (%s:%u)", (unsigned long)size, (long)total_current,
+                       (long)harp_option_memory_limit, __FILE__, __LINE__);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Select the subsystem to which new allocations will be accounted.
+ * Returns the previously active subsystem, such that the caller can restore it afterwards.
+ */
+harp_memory_subsystem harp_memory_set_subsystem(harp_memory_subsystem subsystem)
+{
+    harp_memory_subsystem previous_subsystem = current_subsystem;
+
+    assert(subsystem >= 0 && subsystem < HARP_NUM_MEMORY_SUBSYSTEMS);
+    current_subsystem = subsystem;
+
+    return previous_subsystem;
+}
+
+/* Returns the number of bytes that can still be allocated before the memory limit is reached, or -1 if no memory
+ * limit is set.
+ */
+int64_t harp_memory_get_available(void)
+{
+    if (harp_option_memory_limit <= 0)
+    {
+        return -1;
+    }
+    if (total_current >= harp_option_memory_limit)
+    {
+        return 0;
+    }
+
+    return harp_option_memory_limit - total_current;
+}
+
+/* Allocate a tracked block of memory.
+ * Unlike malloc() this will return a valid (unique) pointer for a size of 0.
+ * On failure the HARP error is set and NULL is returned.
+ */
+void *harp_memory_alloc(size_t size)
+{
+    memory_header *header;
+
+    if (check_limit(size, (int64_t)size) != 0)
+    {
+        return NULL;
+    }
+
+    header = (memory_header *)memory_malloc(sizeof(memory_header) + size);
+    if (header == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (unsigned long)size, __FILE__, __LINE__);
+        return NULL;
+    }
+    header->info.size = size;
+    header->info.subsystem = current_subsystem;
+    add_usage(current_subsystem, (int64_t)size);
+
+    return header + 1;
+}
+
+/* Resize a tracked block of memory (ptr may be NULL, in which case this is equal to harp_memory_alloc()).
+ * The resized block will be accounted to the currently active subsystem.
+ * On failure the HARP error is set, NULL is returned, and the original block is left untouched.
+ */
+void *harp_memory_realloc(void *ptr, size_t size)
+{
+    memory_header *header;
+    size_t old_size;
+    int old_subsystem;
+
+    if (ptr == NULL)
+    {
+        return harp_memory_alloc(size);
+    }
+
+    header = ((memory_header *)ptr) - 1;
+    old_size = header->info.size;
+    old_subsystem = header->info.subsystem;
+
+    if (check_limit(size, (int64_t)size - (int64_t)old_size) != 0)
+    {
+        return NULL;
+    }
+
+    header = (memory_header *)memory_realloc(header, sizeof(memory_header) + size);
+    if (header == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (unsigned long)size, __FILE__, __LINE__);
+        return NULL;
+    }
+    remove_usage(old_subsystem, (int64_t)old_size);
+    header->info.size = size;
+    header->info.subsystem = current_subsystem;
+    add_usage(current_subsystem, (int64_t)size);
+
+    return header + 1;
+}
+
+/* Returns the size of a block of memory that was allocated with harp_memory_alloc() or harp_memory_realloc(). */
+size_t harp_memory_get_size(const void *ptr)
+{
+    return (((const memory_header *)ptr) - 1)->info.size;
+}
+
+/* Free a block of memory that was allocated with harp_memory_alloc() or harp_memory_realloc().
+ * Passing NULL is allowed (and is a no-op).
+ */
+void harp_memory_free(void *ptr)
+{
+    memory_header *header;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    header = ((memory_header *)ptr) - 1;
+    remove_usage(header->info.subsystem, (int64_t)header->info.size);
+    memory_free(header);
+}
+
+/** \addtogroup harp_general
+ * @{
+ */
+
+/** Set the functions that HARP uses to allocate the data blocks of variables.
+ * By default the malloc(), realloc(), and free() functions of the C library are used. This function allows an
+ * application to plug in its own allocator (e.g. a pool allocator or an allocator that reports to an application wide
+ * memory budget). Passing NULL for all three functions will restore the default allocator.
+ * The allocator can only be changed when no memory is currently allocated via the HARP memory allocator (i.e. before
+ * any product is imported or created, or after all products have been deleted).
+ * The memory accounting is not thread-safe: the usage counters are shared by the whole process and are updated without
+ * locking, so HARP should not allocate variable data from multiple threads at the same time.
+ * \param malloc_function Function that allocates a block of memory (with the same semantics as malloc()).
+ * \param realloc_function Function that resizes a block of memory (with the same semantics as realloc()).
+ * \param free_function Function that releases a block of memory (with the same semantics as free()).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_set_memory_allocator(void *(*malloc_function) (size_t), void *(*realloc_function) (void *, size_t),
+                                          void (*free_function) (void *))
+{
+    if (malloc_function == NULL && realloc_function == NULL && free_function == NULL)
+    {
+        malloc_function = malloc;
+        realloc_function = realloc;
+        free_function = free;
+    }
+    if (malloc_function == NULL || realloc_function == NULL || free_function == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "either all or none of the allocator functions should be NULL "
+                       "(%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (total_current != 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "cannot change memory allocator while memory is in use (%s:%u)",
+                       __FILE__, __LINE__);
+        return -1;
+    }
+
+    memory_malloc = malloc_function;
+    memory_realloc = realloc_function;
+    memory_free = free_function;
+
+    return 0;
+}
+
+/** Retrieve the amount of memory that is in use by the data blocks of HARP variables.
+ * The amount of memory used for string values, metadata, and temporary buffers is not included.
+ * The usage is only accurate if HARP is used from a single thread at a time (see harp_set_memory_allocator()).
+ * \param current_usage Pointer to the variable where the number of bytes that are currently allocated will be
+ * stored (can be NULL).
+ * \param peak_usage Pointer to the variable where the maximum number of bytes that were allocated at the same time
+ * will be stored (can be NULL).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_get_memory_usage(int64_t *current_usage, int64_t *peak_usage)
+{
+    if (current_usage != NULL)
+    {
+        *current_usage = total_current;
+    }
+    if (peak_usage != NULL)
+    {
+        *peak_usage = total_peak;
+    }
+
+    return 0;
+}
+
+/** Retrieve the amount of memory that is in use by the data blocks of HARP variables for a single subsystem.
+ * Memory is accounted to the subsystem that was active at the time the memory was (re)allocated. Memory allocated
+ * during harp_import() is accounted to #harp_memory_subsystem_import, memory allocated while performing operations
+ * is accounted to #harp_memory_subsystem_operations, memory allocated during harp_export() is accounted to
+ * #harp_memory_subsystem_export, and all other allocations are accounted to #harp_memory_subsystem_general.
+ * \param subsystem Subsystem for which to retrieve the memory usage.
+ * \param current_usage Pointer to the variable where the number of bytes that are currently allocated will be
+ * stored (can be NULL).
+ * \param peak_usage Pointer to the variable where the maximum number of bytes that were allocated at the same time
+ * will be stored (can be NULL).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_get_memory_usage_for_subsystem(harp_memory_subsystem subsystem, int64_t *current_usage,
+                                                    int64_t *peak_usage)
+{
+    if (subsystem < 0 || subsystem >= HARP_NUM_MEMORY_SUBSYSTEMS)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "subsystem argument (%d) is not valid (%s:%u)", (int)subsystem,
+                       __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (current_usage != NULL)
+    {
+        *current_usage = subsystem_current[subsystem];
+    }
+    if (peak_usage != NULL)
+    {
+        *peak_usage = subsystem_peak[subsystem];
+    }
+
+    return 0;
+}
+
+/** Retrieve the name of a memory subsystem.
+ * \param subsystem Subsystem for which to return the name.
+ * \return Name of the subsystem (or "unknown" if the subsystem is not valid).
+ */
+LIBHARP_API const char *harp_get_memory_subsystem_name(harp_memory_subsystem subsystem)
+{
+    switch (subsystem)
+    {
+        case harp_memory_subsystem_general:
+            return "general";
+        case harp_memory_subsystem_import:
+            return "import";
+        case harp_memory_subsystem_operations:
+            return "operations";
+        case harp_memory_subsystem_export:
+            return "export";
+    }
+
+    return "unknown";
+}
+
+/** @} */
@@ -31,7 +31,10 @@
 
 #include "harp-internal.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -46,7 +49,8 @@ typedef enum netcdf_dimension_type_enum
     netcdf_dimension_vertical,
     netcdf_dimension_spectral,
     netcdf_dimension_independent,
-    netcdf_dimension_string
+    netcdf_dimension_string,
+    netcdf_dimension_vertical_sample
 } netcdf_dimension_type;
 
 typedef struct netcdf_dimensions_struct
@@ -74,6 +78,8 @@ static const char *get_dimension_type_name(netcdf_dimension_type dimension_type)
             return "independent";
         case netcdf_dimension_string:
             return "string";
+        case netcdf_dimension_vertical_sample:
+            return "vertical_sample";
         default:
             assert(0);
             exit(1);
@@ -105,6 +111,10 @@ static int parse_dimension_type(const char *str, netcdf_dimension_type *dimensio
     {
         *dimension_type = netcdf_dimension_vertical;
     }
+    else if (strcmp(str, get_dimension_type_name(netcdf_dimension_vertical_sample)) == 0)
+    {
+        *dimension_type = netcdf_dimension_vertical_sample;
+    }
     else if (sscanf(str, "independent_%ld%n", &length, &num_consumed) == 1 && (size_t)num_consumed == strlen(str))
     {
         *dimension_type = netcdf_dimension_independent;
@@ -425,87 +435,162 @@ static int read_numeric_attribute(int ncid, int varid, const char *name, harp_da
     return 0;
 }
 
-static int read_variable(harp_product *product, int ncid, int varid, netcdf_dimensions *dimensions)
+/* Determine the HARP data type and dimensions of a netCDF variable. For vertical profiles that are stored as a
+ * contiguous ragged array, the vertical sample dimension is expanded into the time and (padded) vertical dimension and
+ * is_ragged is set to 1.
+ */
+static int get_variable_layout(const char *netcdf_name, nc_type netcdf_data_type, int netcdf_num_dimensions,
+                               const int *netcdf_dim_id, netcdf_dimensions *dimensions, int has_vertical_count,
+                               harp_data_type *data_type, int *num_dimensions, harp_dimension_type *dimension_type,
+                               long *dimension, int *is_ragged)
 {
-    harp_variable *variable;
-    harp_data_type data_type;
-    int num_dimensions;
-    harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
-    long dimension[HARP_MAX_NUM_DIMS];
-    char netcdf_name[NC_MAX_NAME + 1];
-    nc_type netcdf_data_type;
-    int netcdf_num_dimensions;
-    int netcdf_dim_id[NC_MAX_VAR_DIMS];
-    int result;
     long i;
 
-    result = nc_inq_var(ncid, varid, netcdf_name, &netcdf_data_type, &netcdf_num_dimensions, netcdf_dim_id, NULL);
-    if (result != NC_NOERR)
-    {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        return -1;
-    }
-
-    if (get_harp_type(netcdf_data_type, &data_type) != 0)
+    if (get_harp_type(netcdf_data_type, data_type) != 0)
     {
         harp_add_error_message(" (variable '%s')", netcdf_name);
         return -1;
     }
 
-    num_dimensions = netcdf_num_dimensions;
+    *num_dimensions = netcdf_num_dimensions;
+    *is_ragged = 0;
 
-    if (data_type == harp_type_string)
+    if (*data_type == harp_type_string)
     {
-        if (num_dimensions == 0)
+        if (*num_dimensions == 0)
         {
             harp_set_error(HARP_ERROR_IMPORT, "variable '%s' of type '%s' has 0 dimensions; expected >= 1",
                            netcdf_name, harp_get_data_type_name(harp_type_string));
             return -1;
         }
 
-        if (dimensions->type[netcdf_dim_id[num_dimensions - 1]] != netcdf_dimension_string)
+        if (dimensions->type[netcdf_dim_id[*num_dimensions - 1]] != netcdf_dimension_string)
         {
             harp_set_error(HARP_ERROR_IMPORT, "inner-most dimension of variable '%s' is of type '%s'; expected '%s'",
-                           netcdf_name, get_dimension_type_name(dimensions->type[netcdf_dim_id[num_dimensions - 1]]),
+                           netcdf_name, get_dimension_type_name(dimensions->type[netcdf_dim_id[*num_dimensions - 1]]),
                            get_dimension_type_name(netcdf_dimension_string));
             return -1;
         }
 
-        num_dimensions--;
+        (*num_dimensions)--;
     }
 
-    if (num_dimensions > HARP_MAX_NUM_DIMS)
+    if (*num_dimensions > 0 && dimensions->type[netcdf_dim_id[0]] == netcdf_dimension_vertical_sample)
     {
-        harp_set_error(HARP_ERROR_IMPORT, "variable '%s' has too many dimensions", netcdf_name);
-        return -1;
-    }
+        int time_dim_id;
+        int vertical_dim_id;
 
-    for (i = 0; i < num_dimensions; i++)
+        /* vertical profiles stored as a contiguous ragged array; the vertical sample dimension is expanded into the
+         * time and (padded) vertical dimension */
+        time_dim_id = dimensions_find(dimensions, netcdf_dimension_time, -1);
+        vertical_dim_id = dimensions_find(dimensions, netcdf_dimension_vertical, -1);
+        if (!has_vertical_count || time_dim_id < 0 || vertical_dim_id < 0)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "variable '%s' is stored as ragged array, but the time/vertical "
+                           "dimensions or the vertical count variable are missing", netcdf_name);
+            return -1;
+        }
+        if (*num_dimensions + 1 > HARP_MAX_NUM_DIMS)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "variable '%s' has too many dimensions", netcdf_name);
+            return -1;
+        }
+
+        dimension_type[0] = harp_dimension_time;
+        dimension[0] = dimensions->length[time_dim_id];
+        dimension_type[1] = harp_dimension_vertical;
+        dimension[1] = dimensions->length[vertical_dim_id];
+        for (i = 1; i < *num_dimensions; i++)
+        {
+            if (get_harp_dimension_type(dimensions->type[netcdf_dim_id[i]], &dimension_type[i + 1]) != 0)
+            {
+                harp_add_error_message(" (variable '%s')", netcdf_name);
+                return -1;
+            }
+            dimension[i + 1] = dimensions->length[netcdf_dim_id[i]];
+        }
+        (*num_dimensions)++;
+        *is_ragged = 1;
+    }
+    else
     {
-        if (get_harp_dimension_type(dimensions->type[netcdf_dim_id[i]], &dimension_type[i]) != 0)
+        if (*num_dimensions > HARP_MAX_NUM_DIMS)
         {
-            harp_add_error_message(" (variable '%s')", netcdf_name);
+            harp_set_error(HARP_ERROR_IMPORT, "variable '%s' has too many dimensions", netcdf_name);
             return -1;
         }
+
+        for (i = 0; i < *num_dimensions; i++)
+        {
+            if (get_harp_dimension_type(dimensions->type[netcdf_dim_id[i]], &dimension_type[i]) != 0)
+            {
+                harp_add_error_message(" (variable '%s')", netcdf_name);
+                return -1;
+            }
+        }
+
+        for (i = 0; i < *num_dimensions; i++)
+        {
+            dimension[i] = dimensions->length[netcdf_dim_id[i]];
+        }
     }
 
-    for (i = 0; i < num_dimensions; i++)
+    return 0;
+}
+
+static int read_variable_data(int ncid, int varid, netcdf_dimensions *dimensions, const long *vertical_count,
+                              harp_variable *variable)
+{
+    harp_data_type data_type;
+    int num_dimensions;
+    harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
+    long dimension[HARP_MAX_NUM_DIMS];
+    nc_type netcdf_data_type;
+    int netcdf_num_dimensions;
+    int netcdf_dim_id[NC_MAX_VAR_DIMS];
+    harp_array data;
+    char *empty_string = NULL;
+    long num_elements;
+    int is_ragged;
+    int result;
+    long i;
+
+    result = nc_inq_var(ncid, varid, NULL, &netcdf_data_type, &netcdf_num_dimensions, netcdf_dim_id, NULL);
+    if (result != NC_NOERR)
     {
-        dimension[i] = dimensions->length[netcdf_dim_id[i]];
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
     }
 
-    if (harp_variable_new(netcdf_name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
+    if (get_variable_layout(variable->name, netcdf_data_type, netcdf_num_dimensions, netcdf_dim_id, dimensions,
+                            vertical_count != NULL, &data_type, &num_dimensions, dimension_type, dimension,
+                            &is_ragged) != 0)
     {
         return -1;
     }
 
-    if (harp_product_add_variable(product, variable) != 0)
+    /* Read data (for ragged arrays the data is read into a packed buffer first). */
+    data = variable->data;
+    num_elements = variable->num_elements;
+    if (is_ragged)
     {
-        harp_variable_delete(variable);
-        return -1;
+        num_elements = dimensions->length[netcdf_dim_id[0]];
+        for (i = 1; i < netcdf_num_dimensions; i++)
+        {
+            if (data_type != harp_type_string || i < netcdf_num_dimensions - 1)
+            {
+                num_elements *= dimensions->length[netcdf_dim_id[i]];
+            }
+        }
+        data.ptr = calloc(num_elements + 1, harp_get_size_for_type(data_type));
+        if (data.ptr == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (num_elements + 1) * harp_get_size_for_type(data_type), __FILE__, __LINE__);
+            return -1;
+        }
     }
 
-    /* Read data. */
     if (data_type == harp_type_string)
     {
         char *buffer;
@@ -514,60 +599,47 @@ static int read_variable(harp_product *product, int ncid, int varid, netcdf_dime
         assert(netcdf_num_dimensions > 0);
         length = dimensions->length[netcdf_dim_id[netcdf_num_dimensions - 1]];
 
-        buffer = malloc(variable->num_elements * length * sizeof(char));
+        /* the strings are read directly into a single block of memory (the string block of the variable) */
+        buffer = harp_string_block_new(num_elements, length);
         if (buffer == NULL)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                           variable->num_elements * length * sizeof(char), __FILE__, __LINE__);
-            return -1;
-        }
-
-        result = nc_get_var_text(ncid, varid, buffer);
-        if (result != NC_NOERR)
-        {
-            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-            free(buffer);
-            return -1;
+            result = NC_ENOMEM;
         }
-
-        for (i = 0; i < variable->num_elements; i++)
+        else
         {
-            char *str;
-
-            str = malloc((length + 1) * sizeof(char));
-            if (str == NULL)
+            result = nc_get_var_text(ncid, varid, buffer);
+            if (result != NC_NOERR)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               (length + 1) * sizeof(char), __FILE__, __LINE__);
-                free(buffer);
-                return -1;
+                harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+                harp_memory_free(buffer);
+            }
+            else
+            {
+                harp_string_block_distribute(buffer, num_elements, length, data.string_data);
+                harp_variable_set_string_block(variable, buffer);
+                /* the padding of a ragged array uses the empty string at the end of the block */
+                empty_string = &buffer[num_elements * (length + 1)];
             }
-
-            memcpy(str, &buffer[i * length], length);
-            str[length] = '\0';
-            variable->data.string_data[i] = str;
         }
-
-        free(buffer);
     }
     else
     {
         switch (data_type)
         {
             case harp_type_int8:
-                result = nc_get_var_schar(ncid, varid, variable->data.int8_data);
+                result = nc_get_var_schar(ncid, varid, data.int8_data);
                 break;
             case harp_type_int16:
-                result = nc_get_var_short(ncid, varid, variable->data.int16_data);
+                result = nc_get_var_short(ncid, varid, data.int16_data);
                 break;
             case harp_type_int32:
-                result = nc_get_var_int(ncid, varid, variable->data.int32_data);
+                result = nc_get_var_int(ncid, varid, data.int32_data);
                 break;
             case harp_type_float:
-                result = nc_get_var_float(ncid, varid, variable->data.float_data);
+                result = nc_get_var_float(ncid, varid, data.float_data);
                 break;
             case harp_type_double:
-                result = nc_get_var_double(ncid, varid, variable->data.double_data);
+                result = nc_get_var_double(ncid, varid, data.double_data);
                 break;
             default:
                 assert(0);
@@ -577,262 +649,1905 @@ static int read_variable(harp_product *product, int ncid, int varid, netcdf_dime
         if (result != NC_NOERR)
         {
             harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-            return -1;
         }
     }
 
-    /* Read attributes. */
-    result = nc_inq_att(ncid, varid, "description", NULL, NULL);
-    if (result == NC_NOERR)
+    if (is_ragged)
     {
-        if (read_string_attribute(ncid, varid, "description", &variable->description) != 0)
+        if (result == NC_NOERR)
         {
-            harp_add_error_message(" (variable '%s')", netcdf_name);
-            return -1;
+            /* this transfers ownership of any strings to the variable */
+            if (harp_variable_unpack_ragged_vertical(variable, variable->dimension[0], data, vertical_count,
+                                                     empty_string, variable->data) != 0)
+            {
+                result = NC_ENOMEM;
+            }
         }
+        free(data.ptr);
     }
-    else if (result != NC_ENOTATT)
+
+    if (result != NC_NOERR)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
         return -1;
     }
 
-    result = nc_inq_att(ncid, varid, "units", NULL, NULL);
-    if (result == NC_NOERR)
+    return 0;
+}
+
+static int get_vara(int ncid, int varid, harp_data_type data_type, const size_t *start, const size_t *count, void *data)
+{
+    switch (data_type)
     {
-        if (read_string_attribute(ncid, varid, "units", &variable->unit) != 0)
-        {
-            harp_add_error_message(" (variable '%s')", netcdf_name);
-            return -1;
-        }
+        case harp_type_int8:
+            return nc_get_vara_schar(ncid, varid, start, count, (signed char *)data);
+        case harp_type_int16:
+            return nc_get_vara_short(ncid, varid, start, count, (short *)data);
+        case harp_type_int32:
+            return nc_get_vara_int(ncid, varid, start, count, (int *)data);
+        case harp_type_float:
+            return nc_get_vara_float(ncid, varid, start, count, (float *)data);
+        case harp_type_double:
+            return nc_get_vara_double(ncid, varid, start, count, (double *)data);
+        case harp_type_string:
+            return nc_get_vara_text(ncid, varid, start, count, (char *)data);
     }
-    else if (result != NC_ENOTATT)
+
+    assert(0);
+    exit(1);
+}
+
+/* Read the given ranges of time samples of a time dependent variable (in that order) into data, using one
+ * nc_get_vara call per range. For vertical profiles that are stored as a contiguous ragged array, the packed samples of
+ * the profiles of each range are read and distributed over the (padded) profiles.
+ */
+static int read_variable_time_ranges(int ncid, int varid, netcdf_dimensions *dimensions, const long *vertical_count,
+                                     const harp_variable *variable, long num_ranges, const long *range_start,
+                                     const long *range_length, harp_array data)
+{
+    harp_data_type data_type;
+    int num_dimensions;
+    harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
+    long dimension[HARP_MAX_NUM_DIMS];
+    nc_type netcdf_data_type;
+    int netcdf_num_dimensions;
+    int netcdf_dim_id[NC_MAX_VAR_DIMS];
+    size_t start[NC_MAX_VAR_DIMS];
+    size_t count[NC_MAX_VAR_DIMS];
+    long *file_start;
+    long *file_length;
+    long element_size;
+    long block_size;
+    long string_length = 1;
+    long num_elements;
+    long offset;
+    harp_array buffer;
+    char *string_buffer = NULL;
+    int is_ragged;
+    int result;
+    long i;
+
+    result = nc_inq_var(ncid, varid, NULL, &netcdf_data_type, &netcdf_num_dimensions, netcdf_dim_id, NULL);
+    if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
         return -1;
     }
 
-    result = nc_inq_att(ncid, varid, "valid_min", NULL, NULL);
-    if (result == NC_NOERR)
+    if (get_variable_layout(variable->name, netcdf_data_type, netcdf_num_dimensions, netcdf_dim_id, dimensions,
+                            vertical_count != NULL, &data_type, &num_dimensions, dimension_type, dimension,
+                            &is_ragged) != 0)
     {
-        harp_data_type attr_data_type;
-
-        if (read_numeric_attribute(ncid, varid, "valid_min", &attr_data_type, &variable->valid_min) != 0)
-        {
-            harp_add_error_message(" (variable '%s')", netcdf_name);
-            return -1;
-        }
+        return -1;
+    }
+    assert(num_dimensions > 0 && dimension_type[0] == harp_dimension_time);
+    element_size = harp_get_size_for_type(data_type);
 
-        if (attr_data_type != data_type)
+    /* number of elements per time sample (or per vertical sample of a ragged array) in the file */
+    block_size = 1;
+    for (i = 0; i < netcdf_num_dimensions; i++)
+    {
+        start[i] = 0;
+        count[i] = dimensions->length[netcdf_dim_id[i]];
+        if (i > 0)
         {
-            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_min' of variable '%s' has invalid type", netcdf_name);
-            return -1;
+            if (data_type == harp_type_string && i == netcdf_num_dimensions - 1)
+            {
+                string_length = (long)count[i];
+            }
+            else
+            {
+                block_size *= (long)count[i];
+            }
         }
     }
-    else if (result != NC_ENOTATT)
+
+    /* determine the ranges to read from the file (for ragged arrays these are ranges of vertical samples) */
+    file_start = (long *)malloc(2 * num_ranges * sizeof(long));
+    if (file_start == NULL)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       2 * num_ranges * sizeof(long), __FILE__, __LINE__);
         return -1;
     }
-
-    result = nc_inq_att(ncid, varid, "valid_max", NULL, NULL);
-    if (result == NC_NOERR)
+    file_length = &file_start[num_ranges];
+    num_elements = 0;
+    if (is_ragged)
     {
-        harp_data_type attr_data_type;
+        long time_index = 0;
 
-        if (read_numeric_attribute(ncid, varid, "valid_max", &attr_data_type, &variable->valid_max) != 0)
+        /* the ranges are sorted, so the offsets of the packed samples are determined in a single pass */
+        offset = 0;
+        for (i = 0; i < num_ranges; i++)
         {
-            harp_add_error_message(" (variable '%s')", netcdf_name);
-            return -1;
+            for (; time_index < range_start[i]; time_index++)
+            {
+                offset += vertical_count[time_index];
+            }
+            file_start[i] = offset;
+            for (; time_index < range_start[i] + range_length[i]; time_index++)
+            {
+                offset += vertical_count[time_index];
+            }
+            file_length[i] = offset - file_start[i];
+            num_elements += file_length[i] * block_size;
         }
 
-        if (attr_data_type != data_type)
+        buffer.ptr = calloc(num_elements + 1, element_size);
+        if (buffer.ptr == NULL)
         {
-            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_max' of variable '%s' has invalid type", netcdf_name);
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (num_elements + 1) * element_size, __FILE__, __LINE__);
+            free(file_start);
             return -1;
         }
     }
-    else if (result != NC_ENOTATT)
+    else
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        return -1;
+        for (i = 0; i < num_ranges; i++)
+        {
+            file_start[i] = range_start[i];
+            file_length[i] = range_length[i];
+            num_elements += file_length[i] * block_size;
+        }
+        buffer = data;
     }
 
-    if (data_type == harp_type_int8)
+    if (data_type == harp_type_string)
     {
-        result = nc_inq_att(ncid, varid, "flag_meanings", NULL, NULL);
-        if (result == NC_NOERR)
+        /* the target array is not owned by a variable, so each string will get its own allocation */
+        string_buffer = malloc((size_t)(num_elements * string_length) + 1);
+        if (string_buffer == NULL)
         {
-            char *flag_meanings;
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           num_elements * string_length + 1, __FILE__, __LINE__);
+            if (is_ragged)
+            {
+                free(buffer.ptr);
+            }
+            free(file_start);
+            return -1;
+        }
+    }
 
-            if (read_string_attribute(ncid, varid, "flag_meanings", &flag_meanings) != 0)
+    offset = 0;
+    for (i = 0; i < num_ranges; i++)
+    {
+        if (file_length[i] == 0)
+        {
+            continue;
+        }
+        start[0] = (size_t)file_start[i];
+        count[0] = (size_t)file_length[i];
+        if (data_type == harp_type_string)
+        {
+            result = get_vara(ncid, varid, data_type, start, count, &string_buffer[offset * string_length]);
+        }
+        else
+        {
+            result = get_vara(ncid, varid, data_type, start, count, &((char *)buffer.ptr)[offset * element_size]);
+        }
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            if (string_buffer != NULL)
             {
-                harp_add_error_message(" (variable '%s')", netcdf_name);
-                return -1;
+                free(string_buffer);
             }
-            if (harp_variable_set_enumeration_values_using_flag_meanings(variable, flag_meanings) != 0)
+            if (is_ragged)
             {
-                free(flag_meanings);
-                return -1;
+                free(buffer.ptr);
             }
-            free(flag_meanings);
+            free(file_start);
+            return -1;
         }
+        offset += file_length[i] * block_size;
     }
 
-    return 0;
-}
-
-static int verify_product(int ncid)
-{
-    int result;
-    char *convention_str;
-
-    result = nc_inq_att(ncid, NC_GLOBAL, "Conventions", NULL, NULL);
-    if (result == NC_NOERR)
+    if (data_type == harp_type_string)
     {
-        if (read_string_attribute(ncid, NC_GLOBAL, "Conventions", &convention_str) == 0)
+        for (i = 0; i < num_elements; i++)
         {
-            int major, minor;
-
-            if (harp_parse_file_convention(convention_str, &major, &minor) == 0)
+            buffer.string_data[i] = malloc((size_t)string_length + 1);
+            if (buffer.string_data[i] == NULL)
             {
-                free(convention_str);
-                if (major > HARP_FORMAT_VERSION_MAJOR ||
-                    (major == HARP_FORMAT_VERSION_MAJOR && minor > HARP_FORMAT_VERSION_MINOR))
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                               string_length + 1, __FILE__, __LINE__);
+                while (i > 0)
                 {
-                    harp_set_error(HARP_ERROR_FILE_OPEN, "unsupported HARP format version %d.%d", major, minor);
-                    return -1;
+                    i--;
+                    free(buffer.string_data[i]);
+                    buffer.string_data[i] = NULL;
                 }
-                return 0;
+                free(string_buffer);
+                if (is_ragged)
+                {
+                    free(buffer.ptr);
+                }
+                free(file_start);
+                return -1;
             }
-            free(convention_str);
+            memcpy(buffer.string_data[i], &string_buffer[i * string_length], string_length);
+            buffer.string_data[i][string_length] = '\0';
         }
+        free(string_buffer);
     }
 
-    harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, "not a HARP product");
+    if (is_ragged)
+    {
+        long packed_offset = 0;
 
-    return -1;
-}
+        offset = 0;
+        for (i = 0; i < num_ranges; i++)
+        {
+            harp_array packed;
+            harp_array target;
 
-static int read_product(int ncid, harp_product *product, netcdf_dimensions *dimensions)
-{
-    int num_dimensions;
+            packed.ptr = &((char *)buffer.ptr)[packed_offset * element_size];
+            target.ptr = &((char *)data.ptr)[offset * element_size];
+
+            /* this transfers ownership of any strings to the variable data */
+            if (harp_variable_unpack_ragged_vertical(variable, range_length[i], packed, &vertical_count[range_start[i]],
+                                                     NULL, target) != 0)
+            {
+                free(buffer.ptr);
+                free(file_start);
+                return -1;
+            }
+            packed_offset += file_length[i] * block_size;
+            offset += range_length[i] * dimension[1] * block_size;
+        }
+        free(buffer.ptr);
+    }
+
+    free(file_start);
+
+    return 0;
+}
+
+/* Read the definition and attributes of a variable. If import is not NULL the variable is created without data and
+ * its data will only be read on request (string data is always read, since it is needed to determine the string
+ * dimension of a product that is exported).
+ */
+static int read_variable(harp_product *product, int ncid, int varid, netcdf_dimensions *dimensions,
+                         const long *vertical_count, harp_deferred_import *import)
+{
+    harp_variable *variable;
+    harp_data_type data_type;
+    int num_dimensions;
+    harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
+    long dimension[HARP_MAX_NUM_DIMS];
+    char netcdf_name[NC_MAX_NAME + 1];
+    nc_type netcdf_data_type;
+    int netcdf_num_dimensions;
+    int netcdf_dim_id[NC_MAX_VAR_DIMS];
+    int is_ragged;
+    int result;
+
+    result = nc_inq_var(ncid, varid, netcdf_name, &netcdf_data_type, &netcdf_num_dimensions, netcdf_dim_id, NULL);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (get_variable_layout(netcdf_name, netcdf_data_type, netcdf_num_dimensions, netcdf_dim_id, dimensions,
+                            vertical_count != NULL, &data_type, &num_dimensions, dimension_type, dimension,
+                            &is_ragged) != 0)
+    {
+        return -1;
+    }
+
+    if (import != NULL && data_type != harp_type_string)
+    {
+        if (harp_variable_new_without_data(netcdf_name, data_type, num_dimensions, dimension_type, dimension,
+                                           &variable) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (harp_variable_new(netcdf_name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
+    {
+        return -1;
+    }
+
+    if (harp_product_add_variable(product, variable) != 0)
+    {
+        harp_variable_delete(variable);
+        return -1;
+    }
+
+    if (variable->data.ptr == NULL)
+    {
+        if (harp_deferred_import_add_variable(import, variable, varid) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (read_variable_data(ncid, varid, dimensions, vertical_count, variable) != 0)
+    {
+        return -1;
+    }
+
+    /* Read attributes. */
+    result = nc_inq_att(ncid, varid, "description", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        if (read_string_attribute(ncid, varid, "description", &variable->description) != 0)
+        {
+            harp_add_error_message(" (variable '%s')", netcdf_name);
+            return -1;
+        }
+    }
+    else if (result != NC_ENOTATT)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    result = nc_inq_att(ncid, varid, "units", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        if (read_string_attribute(ncid, varid, "units", &variable->unit) != 0)
+        {
+            harp_add_error_message(" (variable '%s')", netcdf_name);
+            return -1;
+        }
+    }
+    else if (result != NC_ENOTATT)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    result = nc_inq_att(ncid, varid, "valid_min", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        harp_data_type attr_data_type;
+
+        if (read_numeric_attribute(ncid, varid, "valid_min", &attr_data_type, &variable->valid_min) != 0)
+        {
+            harp_add_error_message(" (variable '%s')", netcdf_name);
+            return -1;
+        }
+
+        if (attr_data_type != data_type)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_min' of variable '%s' has invalid type", netcdf_name);
+            return -1;
+        }
+    }
+    else if (result != NC_ENOTATT)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    result = nc_inq_att(ncid, varid, "valid_max", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        harp_data_type attr_data_type;
+
+        if (read_numeric_attribute(ncid, varid, "valid_max", &attr_data_type, &variable->valid_max) != 0)
+        {
+            harp_add_error_message(" (variable '%s')", netcdf_name);
+            return -1;
+        }
+
+        if (attr_data_type != data_type)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "attribute 'valid_max' of variable '%s' has invalid type", netcdf_name);
+            return -1;
+        }
+    }
+    else if (result != NC_ENOTATT)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (data_type == harp_type_int8)
+    {
+        result = nc_inq_att(ncid, varid, "flag_meanings", NULL, NULL);
+        if (result == NC_NOERR)
+        {
+            char *flag_meanings;
+
+            if (read_string_attribute(ncid, varid, "flag_meanings", &flag_meanings) != 0)
+            {
+                harp_add_error_message(" (variable '%s')", netcdf_name);
+                return -1;
+            }
+            if (harp_variable_set_enumeration_values_using_flag_meanings(variable, flag_meanings) != 0)
+            {
+                free(flag_meanings);
+                return -1;
+            }
+            free(flag_meanings);
+        }
+    }
+
+    return 0;
+}
+
+static int verify_product(int ncid)
+{
+    int result;
+    char *convention_str;
+
+    result = nc_inq_att(ncid, NC_GLOBAL, "Conventions", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        if (read_string_attribute(ncid, NC_GLOBAL, "Conventions", &convention_str) == 0)
+        {
+            int major, minor;
+
+            if (harp_parse_file_convention(convention_str, &major, &minor) == 0)
+            {
+                free(convention_str);
+                if (major > HARP_FORMAT_VERSION_MAJOR ||
+                    (major == HARP_FORMAT_VERSION_MAJOR && minor > HARP_FORMAT_VERSION_MINOR))
+                {
+                    harp_set_error(HARP_ERROR_FILE_OPEN, "unsupported HARP format version %d.%d", major, minor);
+                    return -1;
+                }
+                return 0;
+            }
+            free(convention_str);
+        }
+    }
+
+    harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, "not a HARP product");
+
+    return -1;
+}
+
+static int read_dimensions(int ncid, int num_dimensions, netcdf_dimensions *dimensions)
+{
+    int result;
+    int i;
+
+    for (i = 0; i < num_dimensions; i++)
+    {
+        netcdf_dimension_type dimension_type;
+        char name[NC_MAX_NAME + 1];
+        size_t length;
+
+        result = nc_inq_dim(ncid, i, name, &length);
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            return -1;
+        }
+
+        if (parse_dimension_type(name, &dimension_type) != 0)
+        {
+            return -1;
+        }
+
+        if (dimensions_add(dimensions, dimension_type, (long)length) != i)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "duplicate dimensions with name '%s'", name);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Find the count variable of vertical profiles that are stored as contiguous ragged arrays (a variable with a
+ * 'sample_dimension' attribute that refers to the vertical sample dimension). If the product has no vertical sample
+ * dimension, count_varid is set to -1.
+ */
+static int find_vertical_count(int ncid, int num_variables, netcdf_dimensions *dimensions, int *count_varid)
+{
+    int varid;
+
+    *count_varid = -1;
+
+    if (dimensions_find(dimensions, netcdf_dimension_vertical_sample, -1) < 0)
+    {
+        return 0;
+    }
+
+    for (varid = 0; varid < num_variables; varid++)
+    {
+        char name[NC_MAX_NAME + 1];
+        char *sample_dimension;
+        nc_type data_type;
+        int num_dimensions;
+        int dim_id[NC_MAX_VAR_DIMS];
+        int result;
+
+        result = nc_inq_att(ncid, varid, "sample_dimension", NULL, NULL);
+        if (result == NC_ENOTATT)
+        {
+            continue;
+        }
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            return -1;
+        }
+        if (read_string_attribute(ncid, varid, "sample_dimension", &sample_dimension) != 0)
+        {
+            return -1;
+        }
+        result = strcmp(sample_dimension, get_dimension_type_name(netcdf_dimension_vertical_sample));
+        free(sample_dimension);
+        if (result != 0)
+        {
+            continue;
+        }
+
+        result = nc_inq_var(ncid, varid, name, &data_type, &num_dimensions, dim_id, NULL);
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            return -1;
+        }
+        if (num_dimensions != 1 || dimensions->type[dim_id[0]] != netcdf_dimension_time || data_type == NC_CHAR ||
+            dimensions_find(dimensions, netcdf_dimension_vertical, -1) < 0)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "invalid count variable '%s' for ragged vertical profiles", name);
+            return -1;
+        }
+
+        *count_varid = varid;
+        return 0;
+    }
+
+    harp_set_error(HARP_ERROR_IMPORT, "missing count variable for dimension '%s'",
+                   get_dimension_type_name(netcdf_dimension_vertical_sample));
+    return -1;
+}
+
+/* Find and read the count variable of vertical profiles that are stored as contiguous ragged arrays. If there is no
+ * such variable, count_varid is set to -1 and vertical_count to NULL.
+ */
+static int read_vertical_count(int ncid, int num_variables, netcdf_dimensions *dimensions, int *count_varid,
+                               long **vertical_count)
+{
+    char name[NC_MAX_NAME + 1];
+    long *count;
+    long num_time;
+    long num_vertical;
+    long total = 0;
+    long i;
+    int result;
+
+    *vertical_count = NULL;
+
+    if (find_vertical_count(ncid, num_variables, dimensions, count_varid) != 0)
+    {
+        return -1;
+    }
+    if (*count_varid < 0)
+    {
+        return 0;
+    }
+
+    result = nc_inq_varname(ncid, *count_varid, name);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+    num_time = dimensions->length[dimensions_find(dimensions, netcdf_dimension_time, -1)];
+    num_vertical = dimensions->length[dimensions_find(dimensions, netcdf_dimension_vertical, -1)];
+
+    count = malloc((num_time + 1) * sizeof(long));
+    if (count == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (num_time + 1) * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    result = nc_get_var_long(ncid, *count_varid, count);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        free(count);
+        return -1;
+    }
+    for (i = 0; i < num_time; i++)
+    {
+        if (count[i] < 0 || count[i] > num_vertical)
+        {
+            harp_set_error(HARP_ERROR_IMPORT, "invalid value (%ld) in count variable '%s' for ragged vertical "
+                           "profiles", count[i], name);
+            free(count);
+            return -1;
+        }
+        total += count[i];
+    }
+    if (total != dimensions->length[dimensions_find(dimensions, netcdf_dimension_vertical_sample, -1)])
+    {
+        harp_set_error(HARP_ERROR_IMPORT, "sum of counts (%ld) in variable '%s' does not match length of "
+                       "dimension '%s' (%ld)", total, name, get_dimension_type_name(netcdf_dimension_vertical_sample),
+                       dimensions->length[dimensions_find(dimensions, netcdf_dimension_vertical_sample, -1)]);
+        free(count);
+        return -1;
+    }
+
+    *vertical_count = count;
+    return 0;
+}
+
+static int read_product(int ncid, harp_product *product, netcdf_dimensions *dimensions, long **vertical_count_out,
+                        harp_deferred_import *import)
+{
+    long *vertical_count;
+    int count_varid;
+    int num_dimensions;
+    int num_variables;
+    int num_attributes;
+    int unlim_dim;
+    int result;
+    int i;
+
+    result = nc_inq(ncid, &num_dimensions, &num_variables, &num_attributes, &unlim_dim);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (read_dimensions(ncid, num_dimensions, dimensions) != 0)
+    {
+        return -1;
+    }
+
+    if (read_vertical_count(ncid, num_variables, dimensions, &count_varid, &vertical_count) != 0)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < num_variables; i++)
+    {
+        if (i == count_varid)
+        {
+            continue;
+        }
+        if (read_variable(product, ncid, i, dimensions, vertical_count, import) != 0)
+        {
+            if (vertical_count != NULL)
+            {
+                free(vertical_count);
+            }
+            return -1;
+        }
+    }
+
+    if (vertical_count_out != NULL)
+    {
+        /* the vertical count is still needed to read the data of deferred variables */
+        *vertical_count_out = vertical_count;
+    }
+    else if (vertical_count != NULL)
+    {
+        free(vertical_count);
+    }
+
+    result = nc_inq_att(ncid, NC_GLOBAL, "source_product", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        if (read_string_attribute(ncid, NC_GLOBAL, "source_product", &product->source_product) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (result != NC_ENOTATT)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    result = nc_inq_att(ncid, NC_GLOBAL, "history", NULL, NULL);
+    if (result == NC_NOERR)
+    {
+        if (read_string_attribute(ncid, NC_GLOBAL, "history", &product->history) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (result != NC_ENOTATT)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    return 0;
+}
+
+int harp_import_netcdf(const char *filename, harp_product **product)
+{
+    harp_product *new_product;
+    netcdf_dimensions dimensions;
+    int ncid;
+    int result;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    result = nc_open(filename, 0, &ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (verify_product(ncid) != 0)
+    {
+        nc_close(ncid);
+        return -1;
+    }
+
+    if (harp_product_new(&new_product) != 0)
+    {
+        nc_close(ncid);
+        return -1;
+    }
+
+    dimensions_init(&dimensions);
+
+    if (read_product(ncid, new_product, &dimensions, NULL, NULL) != 0)
+    {
+        dimensions_done(&dimensions);
+        harp_product_delete(new_product);
+        nc_close(ncid);
+        return -1;
+    }
+
+    dimensions_done(&dimensions);
+
+    result = nc_close(ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_product_delete(new_product);
+        return -1;
+    }
+
+    *product = new_product;
+    return 0;
+}
+
+typedef struct netcdf_deferred_file_struct
+{
+    int ncid;
+    netcdf_dimensions dimensions;
+    long *vertical_count;
+} netcdf_deferred_file;
+
+static int deferred_read_data(void *file, int variable_id, harp_variable *variable)
+{
+    netcdf_deferred_file *netcdf_file = (netcdf_deferred_file *)file;
+
+    return read_variable_data(netcdf_file->ncid, variable_id, &netcdf_file->dimensions, netcdf_file->vertical_count,
+                              variable);
+}
+
+static int deferred_read_time_ranges(void *file, int variable_id, const harp_variable *variable, long num_ranges,
+                                     const long *range_start, const long *range_length, harp_array data)
+{
+    netcdf_deferred_file *netcdf_file = (netcdf_deferred_file *)file;
+
+    return read_variable_time_ranges(netcdf_file->ncid, variable_id, &netcdf_file->dimensions,
+                                     netcdf_file->vertical_count, variable, num_ranges, range_start, range_length,
+                                     data);
+}
+
+static int deferred_close(void *file)
+{
+    netcdf_deferred_file *netcdf_file = (netcdf_deferred_file *)file;
+    int result;
+
+    result = nc_close(netcdf_file->ncid);
+    dimensions_done(&netcdf_file->dimensions);
+    if (netcdf_file->vertical_count != NULL)
+    {
+        free(netcdf_file->vertical_count);
+    }
+    free(netcdf_file);
+
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Import the variables of a HARP netCDF product without reading the data of numeric variables.
+ * The file is kept open until the deferred import is deleted.
+ */
+int harp_import_deferred_netcdf(const char *filename, harp_product **product, harp_deferred_import **import)
+{
+    harp_deferred_import *new_import;
+    harp_product *new_product;
+    netcdf_deferred_file *netcdf_file;
+    int result;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    netcdf_file = (netcdf_deferred_file *)malloc(sizeof(netcdf_deferred_file));
+    if (netcdf_file == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(netcdf_deferred_file), __FILE__, __LINE__);
+        return -1;
+    }
+    dimensions_init(&netcdf_file->dimensions);
+    netcdf_file->vertical_count = NULL;
+
+    result = nc_open(filename, 0, &netcdf_file->ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        free(netcdf_file);
+        return -1;
+    }
+
+    if (verify_product(netcdf_file->ncid) != 0)
+    {
+        deferred_close(netcdf_file);
+        return -1;
+    }
+
+    if (harp_deferred_import_new(&new_import) != 0)
+    {
+        deferred_close(netcdf_file);
+        return -1;
+    }
+    new_import->file = netcdf_file;
+    new_import->read_data = deferred_read_data;
+    new_import->read_time_ranges = deferred_read_time_ranges;
+    new_import->close = deferred_close;
+
+    if (harp_product_new(&new_product) != 0)
+    {
+        harp_deferred_import_delete(new_import);
+        return -1;
+    }
+
+    if (read_product(netcdf_file->ncid, new_product, &netcdf_file->dimensions, &netcdf_file->vertical_count,
+                     new_import) != 0)
+    {
+        harp_product_delete(new_product);
+        harp_deferred_import_delete(new_import);
+        return -1;
+    }
+
+    *product = new_product;
+    *import = new_import;
+    return 0;
+}
+
+static int estimate_product(int ncid, harp_product_estimate *estimate, netcdf_dimensions *dimensions)
+{
+    int count_varid;
+    int num_dimensions;
     int num_variables;
     int num_attributes;
     int unlim_dim;
     int result;
     int i;
 
-    result = nc_inq(ncid, &num_dimensions, &num_variables, &num_attributes, &unlim_dim);
+    result = nc_inq(ncid, &num_dimensions, &num_variables, &num_attributes, &unlim_dim);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (read_dimensions(ncid, num_dimensions, dimensions) != 0)
+    {
+        return -1;
+    }
+
+    if (find_vertical_count(ncid, num_variables, dimensions, &count_varid) != 0)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < num_variables; i++)
+    {
+        harp_data_type data_type;
+        int num_var_dimensions;
+        harp_dimension_type dimension_type[HARP_MAX_NUM_DIMS];
+        long dimension[HARP_MAX_NUM_DIMS];
+        char netcdf_name[NC_MAX_NAME + 1];
+        nc_type netcdf_data_type;
+        int netcdf_num_dimensions;
+        int netcdf_dim_id[NC_MAX_VAR_DIMS];
+        int is_ragged;
+
+        if (i == count_varid)
+        {
+            continue;
+        }
+
+        result = nc_inq_var(ncid, i, netcdf_name, &netcdf_data_type, &netcdf_num_dimensions, netcdf_dim_id, NULL);
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            return -1;
+        }
+
+        if (get_variable_layout(netcdf_name, netcdf_data_type, netcdf_num_dimensions, netcdf_dim_id, dimensions,
+                                count_varid >= 0, &data_type, &num_var_dimensions, dimension_type, dimension,
+                                &is_ragged) != 0)
+        {
+            return -1;
+        }
+
+        if (harp_product_estimate_add_variable(estimate, netcdf_name, data_type, num_var_dimensions, dimension_type,
+                                               dimension) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Estimate the content of a HARP netCDF product using only the dimension and variable definitions in the file header
+ * (no variable data is read).
+ */
+int harp_import_estimate_netcdf(const char *filename, harp_product_estimate **estimate)
+{
+    harp_product_estimate *new_estimate;
+    netcdf_dimensions dimensions;
+    int ncid;
+    int result;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    result = nc_open(filename, 0, &ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (verify_product(ncid) != 0)
+    {
+        nc_close(ncid);
+        return -1;
+    }
+
+    if (harp_product_estimate_new(&new_estimate) != 0)
+    {
+        nc_close(ncid);
+        return -1;
+    }
+
+    dimensions_init(&dimensions);
+
+    if (estimate_product(ncid, new_estimate, &dimensions) != 0)
+    {
+        dimensions_done(&dimensions);
+        harp_product_estimate_delete(new_estimate);
+        nc_close(ncid);
+        return -1;
+    }
+
+    dimensions_done(&dimensions);
+
+    result = nc_close(ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_product_estimate_delete(new_estimate);
+        return -1;
+    }
+
+    *estimate = new_estimate;
+    return 0;
+}
+
+int harp_import_global_attributes_netcdf(const char *filename, double *datetime_start, double *datetime_stop,
+                                         long dimension[], char **source_product)
+{
+    char *attr_source_product = NULL;
+    harp_scalar attr_datetime_start;
+    harp_scalar attr_datetime_stop;
+    harp_data_type attr_data_type;
+    long attr_dimension[HARP_NUM_DIM_TYPES];
+    int result;
+    int ncid;
+    int i;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    result = nc_open(filename, 0, &ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (verify_product(ncid) != 0)
+    {
+        nc_close(ncid);
+        return -1;
+    }
+
+    if (datetime_start != NULL)
+    {
+        if (nc_inq_att(ncid, NC_GLOBAL, "datetime_start", NULL, NULL) == NC_NOERR)
+        {
+            if (read_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", &attr_data_type, &attr_datetime_start) != 0)
+            {
+                nc_close(ncid);
+                return -1;
+            }
+
+            if (attr_data_type != harp_type_double)
+            {
+                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_start' has invalid type");
+                nc_close(ncid);
+                return -1;
+            }
+        }
+        else
+        {
+            attr_datetime_start.double_data = harp_mininf();
+        }
+    }
+
+    if (datetime_stop != NULL)
+    {
+        if (nc_inq_att(ncid, NC_GLOBAL, "datetime_stop", NULL, NULL) == NC_NOERR)
+        {
+            if (read_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", &attr_data_type, &attr_datetime_stop) != 0)
+            {
+                nc_close(ncid);
+                return -1;
+            }
+
+            if (attr_data_type != harp_type_double)
+            {
+                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_stop' has invalid type");
+                nc_close(ncid);
+                return -1;
+            }
+        }
+        else
+        {
+            attr_datetime_stop.double_data = harp_plusinf();
+        }
+    }
+
+    if (dimension != NULL)
+    {
+        int num_dimensions;
+        int num_variables;
+        int num_attributes;
+        int unlim_dim;
+        int result;
+
+        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        {
+            attr_dimension[i] = -1;
+        }
+
+        result = nc_inq(ncid, &num_dimensions, &num_variables, &num_attributes, &unlim_dim);
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            return -1;
+        }
+
+        for (i = 0; i < num_dimensions; i++)
+        {
+            netcdf_dimension_type netcdf_dim_type;
+            harp_dimension_type harp_dim_type;
+            char name[NC_MAX_NAME + 1];
+            size_t length;
+
+            result = nc_inq_dim(ncid, i, name, &length);
+            if (result != NC_NOERR)
+            {
+                harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+                return -1;
+            }
+
+            if (parse_dimension_type(name, &netcdf_dim_type) != 0)
+            {
+                return -1;
+            }
+            if (netcdf_dim_type != netcdf_dimension_independent && netcdf_dim_type != netcdf_dimension_string &&
+                netcdf_dim_type != netcdf_dimension_vertical_sample)
+            {
+                if (get_harp_dimension_type(netcdf_dim_type, &harp_dim_type) != 0)
+                {
+                    return -1;
+                }
+                attr_dimension[harp_dim_type] = (long)length;
+            }
+        }
+    }
+
+    if (source_product != NULL)
+    {
+        if (nc_inq_att(ncid, NC_GLOBAL, "source_product", NULL, NULL) == NC_NOERR)
+        {
+            if (read_string_attribute(ncid, NC_GLOBAL, "source_product", &attr_source_product) != 0)
+            {
+                nc_close(ncid);
+                return -1;
+            }
+        }
+        else
+        {
+            /* use filename if there is no source_product attribute */
+            attr_source_product = strdup(harp_basename(filename));
+            if (attr_source_product == NULL)
+            {
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                               __LINE__);
+                return -1;
+            }
+        }
+    }
+
+    result = nc_close(ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        free(attr_source_product);
+        return -1;
+    }
+
+    if (datetime_start != NULL)
+    {
+        *datetime_start = attr_datetime_start.double_data;
+    }
+
+    if (datetime_stop != NULL)
+    {
+        *datetime_stop = attr_datetime_stop.double_data;
+    }
+
+    if (source_product != NULL)
+    {
+        *source_product = attr_source_product;
+    }
+
+    if (dimension != NULL)
+    {
+        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        {
+            if (attr_dimension[i] >= 0)
+            {
+                dimension[i] = attr_dimension[i];
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Returns the length of the string dimension for a variable of type string (i.e. the length of the longest string,
+ * with a minimum of 1, since netCDF does not support zero length dimensions).
+ */
+static long get_string_length(const harp_variable *variable)
+{
+    long length;
+
+    length = harp_get_max_string_length(variable->num_elements, variable->data.string_data);
+    if (length == 0)
+    {
+        length = 1;
+    }
+
+    return length;
+}
+
+static int write_dimensions(int ncid, const netcdf_dimensions *dimensions, int unlimited_time)
+{
+    int result;
+    int i;
+
+    for (i = 0; i < dimensions->num_dimensions; i++)
+    {
+        int dim_id;
+
+        if (dimensions->type[i] == netcdf_dimension_time && unlimited_time)
+        {
+            /* the time dimension is the record dimension, such that time samples can be appended to the file */
+            result = nc_def_dim(ncid, get_dimension_type_name(dimensions->type[i]), NC_UNLIMITED, &dim_id);
+        }
+        else if (dimensions->type[i] == netcdf_dimension_independent)
+        {
+            char name[64];
+
+            sprintf(name, "independent_%ld", dimensions->length[i]);
+            result = nc_def_dim(ncid, name, dimensions->length[i], &dim_id);
+        }
+        else if (dimensions->type[i] == netcdf_dimension_string)
+        {
+            char name[64];
+
+            sprintf(name, "string_%ld", dimensions->length[i]);
+            result = nc_def_dim(ncid, name, dimensions->length[i], &dim_id);
+        }
+        else
+        {
+            result = nc_def_dim(ncid, get_dimension_type_name(dimensions->type[i]), dimensions->length[i], &dim_id);
+        }
+
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+            return -1;
+        }
+
+        assert(dim_id == i);
+    }
+
+    return 0;
+}
+
+static int write_string_attribute(int ncid, int varid, const char *name, const char *data)
+{
+    int result;
+
+    result = nc_put_att_text(ncid, varid, name, strlen(data), data);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    return 0;
+}
+
+static int write_numeric_attribute(int ncid, int varid, const char *name, harp_data_type data_type, harp_scalar data)
+{
+    int result;
+
+    result = NC_NOERR;
+    switch (data_type)
+    {
+        case harp_type_int8:
+            result = nc_put_att_schar(ncid, varid, name, NC_BYTE, 1, &data.int8_data);
+            break;
+        case harp_type_int16:
+            result = nc_put_att_short(ncid, varid, name, NC_SHORT, 1, &data.int16_data);
+            break;
+        case harp_type_int32:
+            result = nc_put_att_int(ncid, varid, name, NC_INT, 1, &data.int32_data);
+            break;
+        case harp_type_float:
+            result = nc_put_att_float(ncid, varid, name, NC_FLOAT, 1, &data.float_data);
+            break;
+        case harp_type_double:
+            result = nc_put_att_double(ncid, varid, name, NC_DOUBLE, 1, &data.double_data);
+            break;
+        default:
+            assert(0);
+            exit(1);
+    }
+
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    return 0;
+}
+
+static int write_variable_definition(int ncid, const harp_variable *variable, netcdf_dimensions *dimensions,
+                                     int is_ragged, long string_length, int *varid)
+{
+    int num_dimensions;
+    int dim_id[NC_MAX_VAR_DIMS];
+    int result;
+    int i;
+
+    num_dimensions = variable->num_dimensions;
+    assert(num_dimensions <= NC_MAX_VAR_DIMS);
+
+    for (i = 0; i < num_dimensions; i++)
+    {
+        dim_id[i] = dimensions_find(dimensions, get_netcdf_dimension_type(variable->dimension_type[i]),
+                                    variable->dimension[i]);
+        assert(dim_id[i] >= 0);
+    }
+
+    if (is_ragged)
+    {
+        /* the time and vertical dimensions are replaced by the vertical sample dimension */
+        dim_id[0] = dimensions_find(dimensions, netcdf_dimension_vertical_sample, -1);
+        assert(dim_id[0] >= 0);
+        for (i = 1; i < num_dimensions - 1; i++)
+        {
+            dim_id[i] = dim_id[i + 1];
+        }
+        num_dimensions--;
+    }
+
+    /* A variable of type string is stored as a contiguous array of characters. The array has an additional dimension
+     * the length of which is set to the length of the longest string. Shorter strings will be padded with NUL '\0'
+     * termination characters.
+     *
+     * netCDF does not support zero length dimensions, so a dimension of length 1 is added if the maximum string length
+     * is 0. In this case a single NUL character will be written for each string.
+     */
+    if (variable->data_type == harp_type_string)
+    {
+        assert((num_dimensions + 1) < NC_MAX_VAR_DIMS);
+
+        dim_id[num_dimensions] = dimensions_find(dimensions, netcdf_dimension_string, string_length);
+        assert(dim_id[num_dimensions] >= 0);
+
+        num_dimensions++;
+    }
+
+    result = nc_def_var(ncid, variable->name, get_netcdf_type(variable->data_type), num_dimensions, dim_id, varid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (variable->description != NULL && strcmp(variable->description, "") != 0)
+    {
+        if (write_string_attribute(ncid, *varid, "description", variable->description) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (variable->unit != NULL)
+    {
+        if (write_string_attribute(ncid, *varid, "units", variable->unit) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (variable->data_type != harp_type_string)
+    {
+        if (!harp_is_valid_min_for_type(variable->data_type, variable->valid_min))
+        {
+            if (write_numeric_attribute(ncid, *varid, "valid_min", variable->data_type, variable->valid_min) != 0)
+            {
+                return -1;
+            }
+        }
+
+        if (!harp_is_valid_max_for_type(variable->data_type, variable->valid_max))
+        {
+            if (write_numeric_attribute(ncid, *varid, "valid_max", variable->data_type, variable->valid_max) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    if (variable->num_enum_values > 0 && variable->data_type == harp_type_int8)
+    {
+        char *attribute_value;
+
+        if (harp_variable_get_flag_values_string(variable, &attribute_value) != 0)
+        {
+            return -1;
+        }
+        if (write_string_attribute(ncid, *varid, "flag_values", attribute_value) != 0)
+        {
+            free(attribute_value);
+            return -1;
+        }
+        free(attribute_value);
+
+        if (harp_variable_get_flag_meanings_string(variable, &attribute_value) != 0)
+        {
+            return -1;
+        }
+        if (write_string_attribute(ncid, *varid, "flag_meanings", attribute_value) != 0)
+        {
+            free(attribute_value);
+            return -1;
+        }
+        free(attribute_value);
+    }
+
+    return 0;
+}
+
+static int write_variable(int ncid, int varid, const harp_variable *variable)
+{
+    int result = NC_NOERR;
+
+    switch (variable->data_type)
+    {
+        case harp_type_int8:
+            result = nc_put_var_schar(ncid, varid, variable->data.ptr);
+            break;
+        case harp_type_int16:
+            result = nc_put_var_short(ncid, varid, variable->data.ptr);
+            break;
+        case harp_type_int32:
+            result = nc_put_var_int(ncid, varid, variable->data.ptr);
+            break;
+        case harp_type_float:
+            result = nc_put_var_float(ncid, varid, variable->data.ptr);
+            break;
+        case harp_type_double:
+            result = nc_put_var_double(ncid, varid, variable->data.ptr);
+            break;
+        case harp_type_string:
+            {
+                char *buffer;
+
+                if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data, 1, NULL,
+                                                          &buffer) != 0)
+                {
+                    return -1;
+                }
+
+                result = nc_put_var_text(ncid, varid, buffer);
+                free(buffer);
+            }
+            break;
+    }
+
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Write the data of a variable using the record dimension (which should be the time dimension).
+ * For time dependent variables the data is written starting at time index record_offset. String data is padded to
+ * string_length characters (which should be at least the length of the longest string).
+ */
+static int write_variable_records(int ncid, int varid, const harp_variable *variable, long record_offset,
+                                  long string_length)
+{
+    size_t start[NC_MAX_VAR_DIMS];
+    size_t count[NC_MAX_VAR_DIMS];
+    int result = NC_NOERR;
+    int i;
+
+    if (variable->num_elements == 0)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < variable->num_dimensions; i++)
+    {
+        start[i] = 0;
+        count[i] = variable->dimension[i];
+    }
+    if (variable->num_dimensions > 0 && variable->dimension_type[0] == harp_dimension_time)
+    {
+        start[0] = record_offset;
+    }
+
+    switch (variable->data_type)
+    {
+        case harp_type_int8:
+            result = nc_put_vara_schar(ncid, varid, start, count, variable->data.ptr);
+            break;
+        case harp_type_int16:
+            result = nc_put_vara_short(ncid, varid, start, count, variable->data.ptr);
+            break;
+        case harp_type_int32:
+            result = nc_put_vara_int(ncid, varid, start, count, variable->data.ptr);
+            break;
+        case harp_type_float:
+            result = nc_put_vara_float(ncid, varid, start, count, variable->data.ptr);
+            break;
+        case harp_type_double:
+            result = nc_put_vara_double(ncid, varid, start, count, variable->data.ptr);
+            break;
+        case harp_type_string:
+            {
+                char *buffer;
+                long length;
+
+                if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data,
+                                                          string_length, &length, &buffer) != 0)
+                {
+                    return -1;
+                }
+                assert(length == string_length);
+
+                start[variable->num_dimensions] = 0;
+                count[variable->num_dimensions] = string_length;
+                result = nc_put_vara_text(ncid, varid, start, count, buffer);
+                free(buffer);
+            }
+            break;
+    }
+
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    return 0;
+}
+
+static int write_vertical_count_definition(int ncid, netcdf_dimensions *dimensions, int *varid)
+{
+    int dim_id;
+    int result;
+
+    dim_id = dimensions_find(dimensions, netcdf_dimension_time, -1);
+    assert(dim_id >= 0);
+
+    result = nc_def_var(ncid, "vertical_count", NC_INT, 1, &dim_id, varid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
+    }
+
+    if (write_string_attribute(ncid, *varid, "description", "number of vertical levels stored for each time sample")
+        != 0)
+    {
+        return -1;
+    }
+
+    if (write_string_attribute(ncid, *varid, "sample_dimension",
+                               get_dimension_type_name(netcdf_dimension_vertical_sample)) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Write the vertical profiles of a variable as a contiguous ragged array (i.e. only the first vertical_count[i] levels
+ * of each time sample i).
+ */
+static int write_ragged_variable(int ncid, int varid, const harp_variable *variable, const long *vertical_count)
+{
+    harp_variable packed_variable;
+    int result;
+
+    if (variable->num_elements == 0)
+    {
+        return 0;
+    }
+
+    /* use a shallow copy of the variable that refers to the packed data (strings are not duplicated) */
+    packed_variable = *variable;
+    if (harp_variable_pack_ragged_vertical(variable, vertical_count, &packed_variable.data,
+                                           &packed_variable.num_elements) != 0)
+    {
+        return -1;
+    }
+
+    result = write_variable(ncid, varid, &packed_variable);
+    free(packed_variable.data.ptr);
+
+    return result;
+}
+
+static int write_variables(int ncid, const harp_product *product, netcdf_dimensions *dimensions,
+                           const long *vertical_count, harp_deferred_import *import, int unlimited_time)
+{
+    int result;
+    int i;
+
+    /* determine dimensions */
+    for (i = 0; i < product->num_variables; i++)
+    {
+        harp_variable *variable;
+        int j;
+
+        variable = product->variable[i];
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            netcdf_dimension_type dimension_type;
+
+            dimension_type = get_netcdf_dimension_type(variable->dimension_type[j]);
+            if (dimensions_add(dimensions, dimension_type, variable->dimension[j]) < 0)
+            {
+                return -1;
+            }
+        }
+
+        if (variable->data_type == harp_type_string)
+        {
+            if (dimensions_add(dimensions, netcdf_dimension_string, get_string_length(variable)) < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    /* write dimensions */
+    if (write_dimensions(ncid, dimensions, unlimited_time) != 0)
+    {
+        return -1;
+    }
+
+    /* write variable definitions + attributes */
+    for (i = 0; i < product->num_variables; i++)
+    {
+        long string_length = 0;
+        int varid;
+
+        if (product->variable[i]->data_type == harp_type_string)
+        {
+            string_length = get_string_length(product->variable[i]);
+        }
+        if (write_variable_definition(ncid, product->variable[i], dimensions,
+                                      vertical_count != NULL &&
+                                      harp_variable_has_ragged_vertical_layout(product->variable[i]), string_length,
+                                      &varid) != 0)
+        {
+            return -1;
+        }
+        assert(varid == i);
+    }
+
+    if (vertical_count != NULL)
+    {
+        int varid;
+
+        if (write_vertical_count_definition(ncid, dimensions, &varid) != 0)
+        {
+            return -1;
+        }
+        assert(varid == product->num_variables);
+    }
+
+    result = nc_enddef(ncid);
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
         return -1;
     }
 
-    for (i = 0; i < num_dimensions; i++)
+    /* write variable data */
+    for (i = 0; i < product->num_variables; i++)
     {
-        netcdf_dimension_type dimension_type;
-        char name[NC_MAX_NAME + 1];
-        size_t length;
+        double trace_start = harp_trace_begin();
+        int loaded;
 
-        result = nc_inq_dim(ncid, i, name, &length);
-        if (result != NC_NOERR)
+        /* the data of deferred variables is only kept in memory while the variable is being written */
+        if (harp_deferred_import_load_variable(import, product->variable[i], &loaded) != 0)
         {
-            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
             return -1;
         }
+        if (vertical_count != NULL && harp_variable_has_ragged_vertical_layout(product->variable[i]))
+        {
+            result = write_ragged_variable(ncid, i, product->variable[i], vertical_count);
+        }
+        else if (unlimited_time)
+        {
+            long string_length = 0;
 
-        if (parse_dimension_type(name, &dimension_type) != 0)
+            if (product->variable[i]->data_type == harp_type_string)
+            {
+                string_length = get_string_length(product->variable[i]);
+            }
+            result = write_variable_records(ncid, i, product->variable[i], 0, string_length);
+        }
+        else
+        {
+            result = write_variable(ncid, i, product->variable[i]);
+        }
+        if (result == 0)
+        {
+            harp_trace_end_variable(trace_start, "export", "write_variable", product->variable[i]);
+        }
+        if (loaded)
+        {
+            harp_deferred_import_unload_variable(import, product->variable[i]);
+        }
+        if (result != 0)
         {
             return -1;
         }
+    }
 
-        if (dimensions_add(dimensions, dimension_type, (long)length) != i)
+    if (vertical_count != NULL)
+    {
+        result = nc_put_var_long(ncid, product->num_variables, vertical_count);
+        if (result != NC_NOERR)
         {
-            harp_set_error(HARP_ERROR_IMPORT, "duplicate dimensions with name '%s'", name);
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
             return -1;
         }
     }
 
-    for (i = 0; i < num_variables; i++)
+    return 0;
+}
+
+static int write_product(int ncid, const harp_product *product, netcdf_dimensions *dimensions,
+                         harp_deferred_import *import, int unlimited_time)
+{
+    harp_scalar datetime_start;
+    harp_scalar datetime_stop;
+    long *vertical_count = NULL;
+    long num_samples = 0;
+    int result;
+    int i;
+
+    /* write conventions */
+    if (write_string_attribute(ncid, NC_GLOBAL, "Conventions", HARP_CONVENTION) != 0)
+    {
+        return -1;
+    }
+
+    /* write attributes */
+    if (harp_product_get_datetime_range(product, &datetime_start.double_data, &datetime_stop.double_data) == 0)
     {
-        if (read_variable(product, ncid, i, dimensions) != 0)
+        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", harp_type_double, datetime_start) != 0)
+        {
+            return -1;
+        }
+
+        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", harp_type_double, datetime_stop) != 0)
         {
             return -1;
         }
     }
 
-    result = nc_inq_att(ncid, NC_GLOBAL, "source_product", NULL, NULL);
-    if (result == NC_NOERR)
+    if (product->source_product != NULL && strcmp(product->source_product, "") != 0)
     {
-        if (read_string_attribute(ncid, NC_GLOBAL, "source_product", &product->source_product) != 0)
+        if (write_string_attribute(ncid, NC_GLOBAL, "source_product", product->source_product) != 0)
         {
             return -1;
         }
     }
-    else if (result != NC_ENOTATT)
+
+    if (product->history != NULL && strcmp(product->history, "") != 0)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        return -1;
+        if (write_string_attribute(ncid, NC_GLOBAL, "history", product->history) != 0)
+        {
+            return -1;
+        }
     }
 
-    result = nc_inq_att(ncid, NC_GLOBAL, "history", NULL, NULL);
-    if (result == NC_NOERR)
+    /* determine whether vertical profiles should be stored as ragged arrays (this is not possible if time samples can
+     * be appended, since the vertical sample dimension is not a record dimension)
+     */
+    if (harp_option_ragged_vertical && !unlimited_time && product->dimension[harp_dimension_time] > 0 &&
+        product->dimension[harp_dimension_vertical] > 0 && !harp_product_has_variable(product, "vertical_count"))
     {
-        if (read_string_attribute(ncid, NC_GLOBAL, "history", &product->history) != 0)
+        vertical_count = malloc(product->dimension[harp_dimension_time] * sizeof(long));
+        if (vertical_count == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           product->dimension[harp_dimension_time] * sizeof(long), __FILE__, __LINE__);
+            return -1;
+        }
+        if (harp_product_get_vertical_count(product, import, vertical_count) != 0)
         {
+            free(vertical_count);
             return -1;
         }
+        for (i = 0; i < product->dimension[harp_dimension_time]; i++)
+        {
+            num_samples += vertical_count[i];
+        }
+
+        /* only use ragged arrays if this actually removes padding (netCDF-3 does not support zero length dimensions) */
+        if (num_samples == 0 ||
+            num_samples == product->dimension[harp_dimension_time] * product->dimension[harp_dimension_vertical])
+        {
+            free(vertical_count);
+            vertical_count = NULL;
+        }
+        else
+        {
+            if (dimensions_add(dimensions, netcdf_dimension_time, product->dimension[harp_dimension_time]) < 0 ||
+                dimensions_add(dimensions, netcdf_dimension_vertical, product->dimension[harp_dimension_vertical]) < 0
+                || dimensions_add(dimensions, netcdf_dimension_vertical_sample, num_samples) < 0)
+            {
+                free(vertical_count);
+                return -1;
+            }
+        }
     }
-    else if (result != NC_ENOTATT)
+
+    result = write_variables(ncid, product, dimensions, vertical_count, import, unlimited_time);
+
+    if (vertical_count != NULL)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        return -1;
+        free(vertical_count);
     }
 
-    return 0;
+    return result;
 }
 
-int harp_import_netcdf(const char *filename, harp_product **product)
+static int export_netcdf(const char *filename, const harp_product *product, harp_deferred_import *import,
+                         int unlimited_time)
 {
-    harp_product *new_product;
     netcdf_dimensions dimensions;
-    int ncid;
+    int64_t size;
+    int flags = 0;
     int result;
+    int ncid;
 
     if (filename == NULL)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL");
         return -1;
     }
 
-    result = nc_open(filename, 0, &ncid);
-    if (result != NC_NOERR)
+    if (product == NULL)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL");
         return -1;
     }
 
-    if (verify_product(ncid) != 0)
+    if (harp_product_get_storage_size(product, 1, &size) != 0)
     {
-        nc_close(ncid);
         return -1;
     }
-
-    if (harp_product_new(&new_product) != 0)
+    if (size > 1073741824 || unlimited_time)
     {
-        nc_close(ncid);
+        /* files larger than 1GB (or files that can grow by appending time samples) will be stored using 64-bit
+         * offsets */
+        flags |= NC_64BIT_OFFSET;
+    }
+    result = nc_create(filename, flags, &ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_add_error_message(" (%s)", filename);
         return -1;
     }
 
     dimensions_init(&dimensions);
 
-    if (read_product(ncid, new_product, &dimensions) != 0)
+    if (write_product(ncid, product, &dimensions, import, unlimited_time) != 0)
     {
-        dimensions_done(&dimensions);
-        harp_product_delete(new_product);
+        harp_add_error_message(" (%s)", filename);
         nc_close(ncid);
+        dimensions_done(&dimensions);
         return -1;
     }
 
@@ -842,442 +2557,509 @@ int harp_import_netcdf(const char *filename, harp_product **product)
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        harp_product_delete(new_product);
+        harp_add_error_message(" (%s)", filename);
         return -1;
     }
 
-    *product = new_product;
     return 0;
 }
 
-int harp_import_global_attributes_netcdf(const char *filename, double *datetime_start, double *datetime_stop,
-                                         long dimension[], char **source_product)
+/* Export a product to a HARP netCDF file.
+ * If import is not NULL, the product may contain deferred variables of that import, whose data will be read (and
+ * released again) one variable at a time.
+ */
+int harp_export_netcdf(const char *filename, const harp_product *product, harp_deferred_import *import)
+{
+    return export_netcdf(filename, product, import, 0);
+}
+
+/* Verify that the variable can be appended to the corresponding variable in the file (same data type, dimensions, and
+ * unit) and determine its netCDF variable id and (for string variables) the length of its string dimension.
+ */
+static int verify_append_variable(int ncid, const harp_variable *variable, const netcdf_dimensions *dimensions,
+                                  int *varid, long *string_length)
 {
-    char *attr_source_product = NULL;
-    harp_scalar attr_datetime_start;
-    harp_scalar attr_datetime_stop;
-    harp_data_type attr_data_type;
-    long attr_dimension[HARP_NUM_DIM_TYPES];
+    nc_type netcdf_data_type;
+    int netcdf_num_dimensions;
+    int dim_id[NC_MAX_VAR_DIMS];
+    char *unit = NULL;
     int result;
-    int ncid;
     int i;
 
-    if (filename == NULL)
+    result = nc_inq_varid(ncid, variable->name, varid);
+    if (result != NC_NOERR)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        harp_set_error(HARP_ERROR_EXPORT, "variable '%s' does not exist in file", variable->name);
         return -1;
     }
-
-    result = nc_open(filename, 0, &ncid);
+    result = nc_inq_var(ncid, *varid, NULL, &netcdf_data_type, &netcdf_num_dimensions, dim_id, NULL);
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
         return -1;
     }
 
-    if (verify_product(ncid) != 0)
+    if (netcdf_data_type != get_netcdf_type(variable->data_type))
     {
-        nc_close(ncid);
+        harp_set_error(HARP_ERROR_EXPORT, "variable '%s' has a different data type in file", variable->name);
         return -1;
     }
-
-    if (datetime_start != NULL)
+    if (netcdf_num_dimensions != variable->num_dimensions + (variable->data_type == harp_type_string ? 1 : 0))
     {
-        if (nc_inq_att(ncid, NC_GLOBAL, "datetime_start", NULL, NULL) == NC_NOERR)
-        {
-            if (read_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", &attr_data_type, &attr_datetime_start) != 0)
-            {
-                nc_close(ncid);
-                return -1;
-            }
+        harp_set_error(HARP_ERROR_EXPORT, "variable '%s' has a different number of dimensions in file",
+                       variable->name);
+        return -1;
+    }
+    for (i = 0; i < variable->num_dimensions; i++)
+    {
+        netcdf_dimension_type dimension_type = get_netcdf_dimension_type(variable->dimension_type[i]);
 
-            if (attr_data_type != harp_type_double)
-            {
-                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_start' has invalid type");
-                nc_close(ncid);
-                return -1;
-            }
-        }
-        else
+        if (dimensions->type[dim_id[i]] != dimension_type ||
+            (dimension_type != netcdf_dimension_time && dimensions->length[dim_id[i]] != variable->dimension[i]))
         {
-            attr_datetime_start.double_data = harp_mininf();
+            harp_set_error(HARP_ERROR_EXPORT, "dimension %d of variable '%s' does not match the dimension in file", i,
+                           variable->name);
+            return -1;
         }
     }
-
-    if (datetime_stop != NULL)
+    *string_length = 0;
+    if (variable->data_type == harp_type_string)
     {
-        if (nc_inq_att(ncid, NC_GLOBAL, "datetime_stop", NULL, NULL) == NC_NOERR)
+        if (dimensions->type[dim_id[i]] != netcdf_dimension_string)
         {
-            if (read_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", &attr_data_type, &attr_datetime_stop) != 0)
-            {
-                nc_close(ncid);
-                return -1;
-            }
-
-            if (attr_data_type != harp_type_double)
-            {
-                harp_set_error(HARP_ERROR_IMPORT, "attribute 'datetime_stop' has invalid type");
-                nc_close(ncid);
-                return -1;
-            }
+            harp_set_error(HARP_ERROR_EXPORT, "invalid string dimension for variable '%s' in file", variable->name);
+            return -1;
         }
-        else
+        *string_length = dimensions->length[dim_id[i]];
+        if (harp_get_max_string_length(variable->num_elements, variable->data.string_data) > *string_length)
         {
-            attr_datetime_stop.double_data = harp_plusinf();
+            harp_set_error(HARP_ERROR_EXPORT, "variable '%s' contains strings that are longer than the string "
+                           "dimension (%ld) in file", variable->name, *string_length);
+            return -1;
         }
     }
 
-    if (dimension != NULL)
+    if (nc_inq_att(ncid, *varid, "units", NULL, NULL) == NC_NOERR)
     {
-        int num_dimensions;
-        int num_variables;
-        int num_attributes;
-        int unlim_dim;
-        int result;
-
-        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        if (read_string_attribute(ncid, *varid, "units", &unit) != 0)
         {
-            attr_dimension[i] = -1;
+            return -1;
         }
-
-        result = nc_inq(ncid, &num_dimensions, &num_variables, &num_attributes, &unlim_dim);
-        if (result != NC_NOERR)
+    }
+    if ((unit == NULL) != (variable->unit == NULL) ||
+        (unit != NULL && harp_unit_compare(unit, variable->unit) != 0))
+    {
+        harp_set_error(HARP_ERROR_EXPORT, "variable '%s' has a different unit in file", variable->name);
+        if (unit != NULL)
         {
-            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-            return -1;
+            free(unit);
         }
+        return -1;
+    }
+    if (unit != NULL)
+    {
+        free(unit);
+    }
 
-        for (i = 0; i < num_dimensions; i++)
-        {
-            netcdf_dimension_type netcdf_dim_type;
-            harp_dimension_type harp_dim_type;
-            char name[NC_MAX_NAME + 1];
-            size_t length;
+    return 0;
+}
 
-            result = nc_inq_dim(ncid, i, name, &length);
-            if (result != NC_NOERR)
+/* Update the product attributes of a file to which the product was appended. The datetime range is extended to also
+ * cover the product and the last line of the history of the product (i.e. the line that was added by
+ * harp_product_update_history()) is added to the history of the file.
+ */
+static int append_attributes(int ncid, const harp_product *product)
+{
+    harp_scalar datetime_start;
+    harp_scalar datetime_stop;
+    harp_data_type data_type;
+    harp_scalar value;
+    char *history = NULL;
+    int has_datetime_range;
+    int result;
+
+    has_datetime_range = (harp_product_get_datetime_range(product, &datetime_start.double_data,
+                                                          &datetime_stop.double_data) == 0);
+    if (has_datetime_range)
+    {
+        if (nc_inq_att(ncid, NC_GLOBAL, "datetime_start", NULL, NULL) == NC_NOERR)
+        {
+            if (read_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", &data_type, &value) != 0)
             {
-                harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
                 return -1;
             }
-
-            if (parse_dimension_type(name, &netcdf_dim_type) != 0)
+            if (data_type == harp_type_double && value.double_data < datetime_start.double_data)
+            {
+                datetime_start.double_data = value.double_data;
+            }
+        }
+        if (nc_inq_att(ncid, NC_GLOBAL, "datetime_stop", NULL, NULL) == NC_NOERR)
+        {
+            if (read_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", &data_type, &value) != 0)
             {
                 return -1;
             }
-            if (netcdf_dim_type != netcdf_dimension_independent && netcdf_dim_type != netcdf_dimension_string)
+            if (data_type == harp_type_double && value.double_data > datetime_stop.double_data)
             {
-                if (get_harp_dimension_type(netcdf_dim_type, &harp_dim_type) != 0)
-                {
-                    return -1;
-                }
-                attr_dimension[harp_dim_type] = (long)length;
+                datetime_stop.double_data = value.double_data;
             }
         }
     }
 
-    if (source_product != NULL)
+    if (product->history != NULL && product->history[0] != '\0')
     {
-        if (nc_inq_att(ncid, NC_GLOBAL, "source_product", NULL, NULL) == NC_NOERR)
+        const char *line;
+        char *file_history = NULL;
+
+        line = strrchr(product->history, '\n');
+        line = (line == NULL ? product->history : line + 1);
+        if (nc_inq_att(ncid, NC_GLOBAL, "history", NULL, NULL) == NC_NOERR)
         {
-            if (read_string_attribute(ncid, NC_GLOBAL, "source_product", &attr_source_product) != 0)
+            if (read_string_attribute(ncid, NC_GLOBAL, "history", &file_history) != 0)
             {
-                nc_close(ncid);
+                return -1;
+            }
+        }
+        if (file_history == NULL || file_history[0] == '\0')
+        {
+            history = strdup(line);
+            if (history == NULL)
+            {
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)",
+                               __FILE__, __LINE__);
+                free(file_history);
                 return -1;
             }
         }
         else
         {
-            /* use filename if there is no source_product attribute */
-            attr_source_product = strdup(harp_basename(filename));
-            if (attr_source_product == NULL)
+            history = malloc(strlen(file_history) + strlen(line) + 2);
+            if (history == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
-                               __LINE__);
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                               strlen(file_history) + strlen(line) + 2, __FILE__, __LINE__);
+                free(file_history);
                 return -1;
             }
+            sprintf(history, "%s\n%s", file_history, line);
         }
+        free(file_history);
     }
 
-    result = nc_close(ncid);
-    if (result != NC_NOERR)
-    {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        free(attr_source_product);
-        return -1;
-    }
-
-    if (datetime_start != NULL)
+    if (!has_datetime_range && history == NULL)
     {
-        *datetime_start = attr_datetime_start.double_data;
+        return 0;
     }
 
-    if (datetime_stop != NULL)
+    result = nc_redef(ncid);
+    if (result != NC_NOERR)
     {
-        *datetime_stop = attr_datetime_stop.double_data;
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        free(history);
+        return -1;
     }
-
-    if (source_product != NULL)
+    if (has_datetime_range)
     {
-        *source_product = attr_source_product;
+        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", harp_type_double, datetime_start) != 0)
+        {
+            free(history);
+            return -1;
+        }
+        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", harp_type_double, datetime_stop) != 0)
+        {
+            free(history);
+            return -1;
+        }
     }
-
-    if (dimension != NULL)
+    if (history != NULL)
     {
-        for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+        if (write_string_attribute(ncid, NC_GLOBAL, "history", history) != 0)
         {
-            if (attr_dimension[i] >= 0)
-            {
-                dimension[i] = attr_dimension[i];
-            }
+            free(history);
+            return -1;
         }
+        free(history);
+    }
+    result = nc_enddef(ncid);
+    if (result != NC_NOERR)
+    {
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        return -1;
     }
 
     return 0;
 }
 
-static int write_dimensions(int ncid, const netcdf_dimensions *dimensions)
+static int append_product(int ncid, const harp_product *product, netcdf_dimensions *dimensions)
 {
+    int num_dimensions;
+    int num_variables;
+    int unlimited_dim_id;
+    int time_dim_id;
+    long num_records;
+    long *string_length = NULL;
+    int *varid = NULL;
     int result;
     int i;
 
-    for (i = 0; i < dimensions->num_dimensions; i++)
+    if (verify_product(ncid) != 0)
     {
-        int dim_id;
-
-        if (dimensions->type[i] == netcdf_dimension_independent)
-        {
-            char name[64];
-
-            sprintf(name, "independent_%ld", dimensions->length[i]);
-            result = nc_def_dim(ncid, name, dimensions->length[i], &dim_id);
-        }
-        else if (dimensions->type[i] == netcdf_dimension_string)
-        {
-            char name[64];
-
-            sprintf(name, "string_%ld", dimensions->length[i]);
-            result = nc_def_dim(ncid, name, dimensions->length[i], &dim_id);
-        }
-        else
-        {
-            result = nc_def_dim(ncid, get_dimension_type_name(dimensions->type[i]), dimensions->length[i], &dim_id);
-        }
-
-        if (result != NC_NOERR)
-        {
-            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-            return -1;
-        }
-
-        assert(dim_id == i);
+        return -1;
     }
 
-    return 0;
-}
-
-static int write_string_attribute(int ncid, int varid, const char *name, const char *data)
-{
-    int result;
-
-    result = nc_put_att_text(ncid, varid, name, strlen(data), data);
+    result = nc_inq(ncid, &num_dimensions, &num_variables, NULL, &unlimited_dim_id);
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
         return -1;
     }
+    if (read_dimensions(ncid, num_dimensions, dimensions) != 0)
+    {
+        return -1;
+    }
+    time_dim_id = dimensions_find(dimensions, netcdf_dimension_time, -1);
+    if (time_dim_id < 0 || time_dim_id != unlimited_dim_id)
+    {
+        harp_set_error(HARP_ERROR_EXPORT, "file does not have an unlimited time dimension");
+        return -1;
+    }
+    if (dimensions_find(dimensions, netcdf_dimension_vertical_sample, -1) >= 0)
+    {
+        harp_set_error(HARP_ERROR_EXPORT, "cannot append to a file with vertical profiles stored as ragged arrays");
+        return -1;
+    }
+    if (num_variables != product->num_variables)
+    {
+        harp_set_error(HARP_ERROR_EXPORT, "product has %d variables, but file has %d variables",
+                       product->num_variables, num_variables);
+        return -1;
+    }
+    num_records = dimensions->length[time_dim_id];
 
-    return 0;
-}
-
-static int write_numeric_attribute(int ncid, int varid, const char *name, harp_data_type data_type, harp_scalar data)
-{
-    int result;
-
-    result = NC_NOERR;
-    switch (data_type)
+    if (product->num_variables > 0)
     {
-        case harp_type_int8:
-            result = nc_put_att_schar(ncid, varid, name, NC_BYTE, 1, &data.int8_data);
-            break;
-        case harp_type_int16:
-            result = nc_put_att_short(ncid, varid, name, NC_SHORT, 1, &data.int16_data);
-            break;
-        case harp_type_int32:
-            result = nc_put_att_int(ncid, varid, name, NC_INT, 1, &data.int32_data);
-            break;
-        case harp_type_float:
-            result = nc_put_att_float(ncid, varid, name, NC_FLOAT, 1, &data.float_data);
-            break;
-        case harp_type_double:
-            result = nc_put_att_double(ncid, varid, name, NC_DOUBLE, 1, &data.double_data);
-            break;
-        default:
-            assert(0);
-            exit(1);
+        varid = malloc(product->num_variables * sizeof(int));
+        if (varid == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           product->num_variables * sizeof(int), __FILE__, __LINE__);
+            return -1;
+        }
+        string_length = malloc(product->num_variables * sizeof(long));
+        if (string_length == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           product->num_variables * sizeof(long), __FILE__, __LINE__);
+            free(varid);
+            return -1;
+        }
     }
 
-    if (result != NC_NOERR)
+    /* verify all variables before anything is written */
+    for (i = 0; i < product->num_variables; i++)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        return -1;
+        if (verify_append_variable(ncid, product->variable[i], dimensions, &varid[i], &string_length[i]) != 0)
+        {
+            goto error;
+        }
+    }
+
+    /* only the time dependent variables are written; time independent variables are already in the file */
+    for (i = 0; i < product->num_variables; i++)
+    {
+        harp_variable *variable = product->variable[i];
+        double trace_start;
+
+        if (variable->num_dimensions == 0 || variable->dimension_type[0] != harp_dimension_time)
+        {
+            continue;
+        }
+        trace_start = harp_trace_begin();
+        if (write_variable_records(ncid, varid[i], variable, num_records, string_length[i]) != 0)
+        {
+            goto error;
+        }
+        harp_trace_end_variable(trace_start, "export", "append_variable", variable);
+    }
+
+    /* the attributes are only updated once all records have been written, such that a failed append does not leave
+     * the file with attributes that cover records that are not there */
+    if (append_attributes(ncid, product) != 0)
+    {
+        goto error;
     }
 
+    free(string_length);
+    free(varid);
+
     return 0;
+
+  error:
+    free(string_length);
+    free(varid);
+
+    return -1;
 }
 
-static int write_variable_definition(int ncid, const harp_variable *variable, netcdf_dimensions *dimensions, int *varid)
+/* Append the time samples of a product to an existing HARP netCDF file that has the time dimension as unlimited
+ * (record) dimension. The variables of the product should match those in the file (apart from the length of the time
+ * dimension). If the file does not exist, it is created (with an unlimited time dimension).
+ */
+int harp_export_append_netcdf(const char *filename, const harp_product *product)
 {
-    int num_dimensions;
-    int dim_id[NC_MAX_VAR_DIMS];
+    netcdf_dimensions dimensions;
+    struct stat statbuf;
     int result;
-    int i;
-
-    num_dimensions = variable->num_dimensions;
-    assert(num_dimensions <= NC_MAX_VAR_DIMS);
+    int ncid;
 
-    for (i = 0; i < num_dimensions; i++)
+    if (filename == NULL)
     {
-        dim_id[i] = dimensions_find(dimensions, get_netcdf_dimension_type(variable->dimension_type[i]),
-                                    variable->dimension[i]);
-        assert(dim_id[i] >= 0);
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL");
+        return -1;
     }
 
-    /* A variable of type string is stored as a contiguous array of characters. The array has an additional dimension
-     * the length of which is set to the length of the longest string. Shorter strings will be padded with NUL '\0'
-     * termination characters.
-     *
-     * netCDF does not support zero length dimensions, so a dimension of length 1 is added if the maximum string length
-     * is 0. In this case a single NUL character will be written for each string.
-     */
-    if (variable->data_type == harp_type_string)
+    if (product == NULL)
     {
-        long length;
-
-        assert((num_dimensions + 1) < NC_MAX_VAR_DIMS);
-
-        /* determine length for the string dimension (ensure a minimum length of 1) */
-        length = harp_get_max_string_length(variable->num_elements, variable->data.string_data);
-        if (length == 0)
-        {
-            length = 1;
-        }
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL");
+        return -1;
+    }
 
-        dim_id[num_dimensions] = dimensions_find(dimensions, netcdf_dimension_string, length);
-        assert(dim_id[num_dimensions] >= 0);
+    if (stat(filename, &statbuf) != 0 && errno == ENOENT)
+    {
+        return export_netcdf(filename, product, NULL, 1);
+    }
 
-        num_dimensions++;
+    if (product->dimension[harp_dimension_time] == 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product has no time dimension");
+        return -1;
     }
 
-    result = nc_def_var(ncid, variable->name, get_netcdf_type(variable->data_type), num_dimensions, dim_id, varid);
+    result = nc_open(filename, NC_WRITE, &ncid);
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_add_error_message(" (%s)", filename);
         return -1;
     }
 
-    if (variable->description != NULL && strcmp(variable->description, "") != 0)
+    dimensions_init(&dimensions);
+
+    if (append_product(ncid, product, &dimensions) != 0)
     {
-        if (write_string_attribute(ncid, *varid, "description", variable->description) != 0)
-        {
-            return -1;
-        }
+        harp_add_error_message(" (%s)", filename);
+        nc_close(ncid);
+        dimensions_done(&dimensions);
+        return -1;
     }
 
-    if (variable->unit != NULL)
+    dimensions_done(&dimensions);
+
+    result = nc_close(ncid);
+    if (result != NC_NOERR)
     {
-        if (write_string_attribute(ncid, *varid, "units", variable->unit) != 0)
-        {
-            return -1;
-        }
+        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
+        harp_add_error_message(" (%s)", filename);
+        return -1;
     }
 
-    if (variable->data_type != harp_type_string)
+    return 0;
+}
+
+typedef struct netcdf_writer_file_struct
+{
+    int ncid;
+    const long *string_length;
+} netcdf_writer_file;
+
+static int writer_write_data(void *file, int variable_index, const harp_variable *variable, long time_offset)
+{
+    netcdf_writer_file *netcdf_file = (netcdf_writer_file *)file;
+
+    /* the netCDF variable id equals the index of the variable in the product */
+    return write_variable_records(netcdf_file->ncid, variable_index, variable, time_offset,
+                                  netcdf_file->string_length[variable_index]);
+}
+
+static int writer_write_datetime_range(void *file, int has_datetime_range, double datetime_start,
+                                       double datetime_stop)
+{
+    netcdf_writer_file *netcdf_file = (netcdf_writer_file *)file;
+    int define_mode = 0;
+    harp_scalar value;
+    int result;
+
+    if (!has_datetime_range)
     {
-        if (!harp_is_valid_min_for_type(variable->data_type, variable->valid_min))
+        /* remove the initial values that were written by harp_product_writer_open_netcdf() */
+        if (nc_inq_att(netcdf_file->ncid, NC_GLOBAL, "datetime_start", NULL, NULL) != NC_NOERR)
         {
-            if (write_numeric_attribute(ncid, *varid, "valid_min", variable->data_type, variable->valid_min) != 0)
-            {
-                return -1;
-            }
+            return 0;
         }
-
-        if (!harp_is_valid_max_for_type(variable->data_type, variable->valid_max))
+        result = nc_redef(netcdf_file->ncid);
+        if (result == NC_NOERR)
         {
-            if (write_numeric_attribute(ncid, *varid, "valid_max", variable->data_type, variable->valid_max) != 0)
-            {
-                return -1;
-            }
+            result = nc_del_att(netcdf_file->ncid, NC_GLOBAL, "datetime_start");
         }
-    }
-
-    if (variable->num_enum_values > 0 && variable->data_type == harp_type_int8)
-    {
-        char *attribute_value;
-
-        if (harp_variable_get_flag_values_string(variable, &attribute_value) != 0)
+        if (result == NC_NOERR)
         {
-            return -1;
+            result = nc_del_att(netcdf_file->ncid, NC_GLOBAL, "datetime_stop");
         }
-        if (write_string_attribute(ncid, *varid, "flag_values", attribute_value) != 0)
+        if (result == NC_NOERR)
         {
-            free(attribute_value);
+            result = nc_enddef(netcdf_file->ncid);
+        }
+        if (result != NC_NOERR)
+        {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
             return -1;
         }
-        free(attribute_value);
+        return 0;
+    }
 
-        if (harp_variable_get_flag_meanings_string(variable, &attribute_value) != 0)
+    /* if the attributes were already created by harp_product_writer_open_netcdf(), they can be updated in data mode
+     * (without having to rewrite the file)
+     */
+    if (nc_inq_att(netcdf_file->ncid, NC_GLOBAL, "datetime_start", NULL, NULL) != NC_NOERR)
+    {
+        result = nc_redef(netcdf_file->ncid);
+        if (result != NC_NOERR)
         {
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
             return -1;
         }
-        if (write_string_attribute(ncid, *varid, "flag_meanings", attribute_value) != 0)
+        define_mode = 1;
+    }
+    value.double_data = datetime_start;
+    if (write_numeric_attribute(netcdf_file->ncid, NC_GLOBAL, "datetime_start", harp_type_double, value) != 0)
+    {
+        return -1;
+    }
+    value.double_data = datetime_stop;
+    if (write_numeric_attribute(netcdf_file->ncid, NC_GLOBAL, "datetime_stop", harp_type_double, value) != 0)
+    {
+        return -1;
+    }
+    if (define_mode)
+    {
+        result = nc_enddef(netcdf_file->ncid);
+        if (result != NC_NOERR)
         {
-            free(attribute_value);
+            harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
             return -1;
         }
-        free(attribute_value);
     }
 
     return 0;
 }
 
-static int write_variable(int ncid, int varid, const harp_variable *variable)
+static int writer_close(void *file)
 {
-    int result = NC_NOERR;
-
-    switch (variable->data_type)
-    {
-        case harp_type_int8:
-            result = nc_put_var_schar(ncid, varid, variable->data.ptr);
-            break;
-        case harp_type_int16:
-            result = nc_put_var_short(ncid, varid, variable->data.ptr);
-            break;
-        case harp_type_int32:
-            result = nc_put_var_int(ncid, varid, variable->data.ptr);
-            break;
-        case harp_type_float:
-            result = nc_put_var_float(ncid, varid, variable->data.ptr);
-            break;
-        case harp_type_double:
-            result = nc_put_var_double(ncid, varid, variable->data.ptr);
-            break;
-        case harp_type_string:
-            {
-                char *buffer;
-
-                if (harp_get_char_array_from_string_array(variable->num_elements, variable->data.string_data, 1, NULL,
-                                                          &buffer) != 0)
-                {
-                    return -1;
-                }
-
-                result = nc_put_var_text(ncid, varid, buffer);
-                free(buffer);
-            }
-            break;
-    }
+    netcdf_writer_file *netcdf_file = (netcdf_writer_file *)file;
+    int result;
 
+    result = nc_close(netcdf_file->ncid);
+    free(netcdf_file);
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
@@ -1287,28 +3069,27 @@ static int write_variable(int ncid, int varid, const harp_variable *variable)
     return 0;
 }
 
-static int write_product(int ncid, const harp_product *product, netcdf_dimensions *dimensions)
+static int writer_write_product(int ncid, const harp_product *template_product, const harp_product *product,
+                                const long *string_length)
 {
-    harp_scalar datetime_start;
-    harp_scalar datetime_stop;
+    netcdf_dimensions dimensions;
+    harp_scalar datetime;
     int result;
     int i;
 
-    /* write conventions */
     if (write_string_attribute(ncid, NC_GLOBAL, "Conventions", HARP_CONVENTION) != 0)
     {
         return -1;
     }
 
-    /* write attributes */
-    if (harp_product_get_datetime_range(product, &datetime_start.double_data, &datetime_stop.double_data) == 0)
+    /* the datetime range is updated when the writer is closed; the initial values reserve space for the attributes */
+    if (harp_product_get_datetime_range(template_product, &datetime.double_data, &datetime.double_data) == 0)
     {
-        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", harp_type_double, datetime_start) != 0)
+        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_start", harp_type_double, datetime) != 0)
         {
             return -1;
         }
-
-        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", harp_type_double, datetime_stop) != 0)
+        if (write_numeric_attribute(ncid, NC_GLOBAL, "datetime_stop", harp_type_double, datetime) != 0)
         {
             return -1;
         }
@@ -1330,60 +3111,53 @@ static int write_product(int ncid, const harp_product *product, netcdf_dimension
         }
     }
 
-    /* determine dimensions */
+    dimensions_init(&dimensions);
+
     for (i = 0; i < product->num_variables; i++)
     {
-        harp_variable *variable;
+        harp_variable *variable = product->variable[i];
         int j;
 
-        variable = product->variable[i];
         for (j = 0; j < variable->num_dimensions; j++)
         {
-            netcdf_dimension_type dimension_type;
-
-            dimension_type = get_netcdf_dimension_type(variable->dimension_type[j]);
-            if (dimensions_add(dimensions, dimension_type, variable->dimension[j]) < 0)
+            if (dimensions_add(&dimensions, get_netcdf_dimension_type(variable->dimension_type[j]),
+                               variable->dimension[j]) < 0)
             {
+                dimensions_done(&dimensions);
                 return -1;
             }
         }
-
         if (variable->data_type == harp_type_string)
         {
-            long length;
-
-            /* determine length for the string dimension (ensure a minimum length of 1) */
-            length = harp_get_max_string_length(variable->num_elements, variable->data.string_data);
-            if (length == 0)
-            {
-                length = 1;
-            }
-
-            if (dimensions_add(dimensions, netcdf_dimension_string, length) < 0)
+            if (dimensions_add(&dimensions, netcdf_dimension_string, string_length[i]) < 0)
             {
+                dimensions_done(&dimensions);
                 return -1;
             }
         }
     }
 
-    /* write dimensions */
-    if (write_dimensions(ncid, dimensions) != 0)
+    /* the time dimension is the record dimension, such that the file can be appended to with harp_export_append() */
+    if (write_dimensions(ncid, &dimensions, 1) != 0)
     {
+        dimensions_done(&dimensions);
         return -1;
     }
 
-    /* write variable definitions + attributes */
     for (i = 0; i < product->num_variables; i++)
     {
         int varid;
 
-        if (write_variable_definition(ncid, product->variable[i], dimensions, &varid) != 0)
+        if (write_variable_definition(ncid, product->variable[i], &dimensions, 0, string_length[i], &varid) != 0)
         {
+            dimensions_done(&dimensions);
             return -1;
         }
         assert(varid == i);
     }
 
+    dimensions_done(&dimensions);
+
     result = nc_enddef(ncid);
     if (result != NC_NOERR)
     {
@@ -1391,10 +3165,16 @@ static int write_product(int ncid, const harp_product *product, netcdf_dimension
         return -1;
     }
 
-    /* write variable data */
+    /* write the data of the time independent variables */
     for (i = 0; i < product->num_variables; i++)
     {
-        if (write_variable(ncid, i, product->variable[i]) != 0)
+        harp_variable *variable = product->variable[i];
+
+        if (variable->num_dimensions > 0 && variable->dimension_type[0] == harp_dimension_time)
+        {
+            continue;
+        }
+        if (write_variable_records(ncid, i, variable, 0, string_length[i]) != 0)
         {
             return -1;
         }
@@ -1403,36 +3183,19 @@ static int write_product(int ncid, const harp_product *product, netcdf_dimension
     return 0;
 }
 
-int harp_export_netcdf(const char *filename, const harp_product *product)
+/* Create a HARP netCDF file for the product of the writer (the time dependent data is written by writer_write_data).
+ * The template product provides the initial datetime range.
+ */
+int harp_product_writer_open_netcdf(const char *filename, const harp_product *template_product,
+                                    harp_product_writer *writer)
 {
-    netcdf_dimensions dimensions;
-    int64_t size;
-    int flags = 0;
+    netcdf_writer_file *netcdf_file;
     int result;
     int ncid;
 
-    if (filename == NULL)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL");
-        return -1;
-    }
-
-    if (product == NULL)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL");
-        return -1;
-    }
-
-    if (harp_product_get_storage_size(product, 1, &size) != 0)
-    {
-        return -1;
-    }
-    if (size > 1073741824)
-    {
-        /* files larger than 1GB will be stored using 64-bit offsets */
-        flags |= NC_64BIT_OFFSET;
-    }
-    result = nc_create(filename, flags, &ncid);
+    /* as for files created by harp_export_append(), 64-bit offsets are used since the file can grow by appending time
+     * samples */
+    result = nc_create(filename, NC_64BIT_OFFSET, &ncid);
     if (result != NC_NOERR)
     {
         harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
@@ -1440,25 +3203,28 @@ int harp_export_netcdf(const char *filename, const harp_product *product)
         return -1;
     }
 
-    dimensions_init(&dimensions);
-
-    if (write_product(ncid, product, &dimensions) != 0)
+    if (writer_write_product(ncid, template_product, writer->product, writer->string_length) != 0)
     {
         harp_add_error_message(" (%s)", filename);
         nc_close(ncid);
-        dimensions_done(&dimensions);
         return -1;
     }
 
-    dimensions_done(&dimensions);
-
-    result = nc_close(ncid);
-    if (result != NC_NOERR)
+    netcdf_file = malloc(sizeof(netcdf_writer_file));
+    if (netcdf_file == NULL)
     {
-        harp_set_error(HARP_ERROR_NETCDF, "%s", nc_strerror(result));
-        harp_add_error_message(" (%s)", filename);
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(netcdf_writer_file), __FILE__, __LINE__);
+        nc_close(ncid);
         return -1;
     }
+    netcdf_file->ncid = ncid;
+    netcdf_file->string_length = writer->string_length;
+
+    writer->file = netcdf_file;
+    writer->write_data = writer_write_data;
+    writer->write_datetime_range = writer_write_datetime_range;
+    writer->close = writer_close;
 
     return 0;
 }
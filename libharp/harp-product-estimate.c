@@ -0,0 +1,822 @@
+/*
+ * Copyright (C) 2015-2018 S[&]T, The Netherlands.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "harp-internal.h"
+#include "harp-program.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** \defgroup harp_product_estimate HARP Product Estimate
+ * The HARP Product Estimate module contains the functionality to predict the dimensions, variables, and storage size
+ * of a product (after performing a list of operations) without reading any of the variable data.
+ */
+
+static void variable_estimate_delete(harp_variable_estimate *variable)
+{
+    if (variable != NULL)
+    {
+        if (variable->name != NULL)
+        {
+            free(variable->name);
+        }
+        free(variable);
+    }
+}
+
+static int get_variable_index(const harp_product_estimate *estimate, const char *name)
+{
+    int i;
+
+    for (i = 0; i < estimate->num_variables; i++)
+    {
+        if (strcmp(estimate->variable[i]->name, name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* recompute the product dimensions from the dimensions of the remaining variables */
+static void update_dimensions(harp_product_estimate *estimate)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    {
+        estimate->dimension[i] = 0;
+    }
+    for (i = 0; i < estimate->num_variables; i++)
+    {
+        harp_variable_estimate *variable = estimate->variable[i];
+
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            if (variable->dimension_type[j] != harp_dimension_independent)
+            {
+                estimate->dimension[variable->dimension_type[j]] = variable->dimension[j];
+            }
+        }
+    }
+}
+
+static void remove_variable(harp_product_estimate *estimate, int index)
+{
+    variable_estimate_delete(estimate->variable[index]);
+    memmove(&estimate->variable[index], &estimate->variable[index + 1],
+            (estimate->num_variables - index - 1) * sizeof(harp_variable_estimate *));
+    estimate->num_variables--;
+}
+
+int harp_product_estimate_new(harp_product_estimate **new_estimate)
+{
+    harp_product_estimate *estimate;
+    int i;
+
+    estimate = (harp_product_estimate *)malloc(sizeof(harp_product_estimate));
+    if (estimate == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_product_estimate), __FILE__, __LINE__);
+        return -1;
+    }
+
+    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    {
+        estimate->dimension[i] = 0;
+    }
+    estimate->num_variables = 0;
+    estimate->variable = NULL;
+    estimate->is_upper_bound = 0;
+    estimate->num_unresolved_operations = 0;
+
+    *new_estimate = estimate;
+
+    return 0;
+}
+
+/* Add a variable to the estimate; an existing variable with the same name will be replaced. */
+int harp_product_estimate_add_variable(harp_product_estimate *estimate, const char *name, harp_data_type data_type,
+                                       int num_dimensions, const harp_dimension_type *dimension_type,
+                                       const long *dimension)
+{
+    harp_variable_estimate *variable;
+    int index;
+    int i;
+
+    if (num_dimensions < 0 || num_dimensions > HARP_MAX_NUM_DIMS)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "invalid number of dimensions %d for variable '%s' (%s:%u)",
+                       num_dimensions, name, __FILE__, __LINE__);
+        return -1;
+    }
+
+    variable = (harp_variable_estimate *)malloc(sizeof(harp_variable_estimate));
+    if (variable == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_variable_estimate), __FILE__, __LINE__);
+        return -1;
+    }
+    variable->name = strdup(name);
+    if (variable->name == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                       __LINE__);
+        free(variable);
+        return -1;
+    }
+    variable->data_type = data_type;
+    variable->num_dimensions = num_dimensions;
+    for (i = 0; i < num_dimensions; i++)
+    {
+        variable->dimension_type[i] = dimension_type[i];
+        variable->dimension[i] = dimension[i];
+    }
+
+    index = get_variable_index(estimate, name);
+    if (index >= 0)
+    {
+        variable_estimate_delete(estimate->variable[index]);
+        estimate->variable[index] = variable;
+        update_dimensions(estimate);
+        return 0;
+    }
+
+    if (estimate->num_variables % BLOCK_SIZE == 0)
+    {
+        harp_variable_estimate **variable_list;
+
+        variable_list = (harp_variable_estimate **)realloc(estimate->variable, (estimate->num_variables + BLOCK_SIZE) *
+                                                           sizeof(harp_variable_estimate *));
+        if (variable_list == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (estimate->num_variables + BLOCK_SIZE) * sizeof(harp_variable_estimate *), __FILE__,
+                           __LINE__);
+            variable_estimate_delete(variable);
+            return -1;
+        }
+        estimate->variable = variable_list;
+    }
+    estimate->variable[estimate->num_variables] = variable;
+    estimate->num_variables++;
+
+    for (i = 0; i < num_dimensions; i++)
+    {
+        if (dimension_type[i] != harp_dimension_independent && estimate->dimension[dimension_type[i]] == 0)
+        {
+            estimate->dimension[dimension_type[i]] = dimension[i];
+        }
+    }
+
+    return 0;
+}
+
+/* Create an (exact) estimate from the structure of an in-memory product. */
+int harp_product_estimate_from_product(const harp_product *product, harp_product_estimate **new_estimate)
+{
+    harp_product_estimate *estimate;
+    int i;
+
+    if (harp_product_estimate_new(&estimate) != 0)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < product->num_variables; i++)
+    {
+        harp_variable *variable = product->variable[i];
+
+        if (harp_product_estimate_add_variable(estimate, variable->name, variable->data_type,
+                                               variable->num_dimensions, variable->dimension_type,
+                                               variable->dimension) != 0)
+        {
+            harp_product_estimate_delete(estimate);
+            return -1;
+        }
+    }
+
+    *new_estimate = estimate;
+
+    return 0;
+}
+
+/* a unit conversion results in a variable of type double (unless the variable already has the requested unit, which
+ * can not be determined from the estimate); the estimate is then an upper bound */
+static void estimate_unit_conversion(harp_product_estimate *estimate, harp_variable_estimate *variable)
+{
+    if (variable->data_type != harp_type_double)
+    {
+        variable->data_type = harp_type_double;
+        estimate->is_upper_bound = 1;
+    }
+}
+
+/* Determine the data type of a new derived variable (and verify that it can be derived) by searching the derived
+ * variable conversions for a product with variables without data that matches the estimate. */
+static int get_derived_variable_data_type(const harp_product_estimate *estimate,
+                                          const harp_operation_derive_variable *operation, harp_data_type *data_type)
+{
+    harp_product *product;
+    int i;
+
+    if (harp_product_new(&product) != 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < estimate->num_variables; i++)
+    {
+        harp_variable_estimate *variable_estimate = estimate->variable[i];
+        harp_variable *variable;
+
+        if (harp_variable_new_without_data(variable_estimate->name, variable_estimate->data_type,
+                                           variable_estimate->num_dimensions, variable_estimate->dimension_type,
+                                           variable_estimate->dimension, &variable) != 0)
+        {
+            harp_product_delete(product);
+            return -1;
+        }
+        if (harp_product_add_variable(product, variable) != 0)
+        {
+            harp_variable_delete(variable);
+            harp_product_delete(product);
+            return -1;
+        }
+    }
+
+    if (harp_product_get_derived_variable_data_type(product, operation->variable_name, operation->num_dimensions,
+                                                    operation->dimension_type, data_type) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    harp_product_delete(product);
+
+    return 0;
+}
+
+static int estimate_derive_variable(harp_product_estimate *estimate, harp_operation_derive_variable *operation)
+{
+    harp_variable_estimate *variable = NULL;
+    harp_data_type data_type;
+    long dimension[HARP_MAX_NUM_DIMS];
+    int index;
+    int i;
+
+    index = get_variable_index(estimate, operation->variable_name);
+    if (index >= 0)
+    {
+        variable = estimate->variable[index];
+    }
+
+    if (!operation->has_dimensions)
+    {
+        /* only a unit and/or data type conversion of an existing variable */
+        if (variable == NULL)
+        {
+            harp_set_error(HARP_ERROR_VARIABLE_NOT_FOUND, "product does not contain variable '%s'",
+                           operation->variable_name);
+            return -1;
+        }
+        if (operation->unit != NULL)
+        {
+            estimate_unit_conversion(estimate, variable);
+        }
+        if (operation->has_data_type)
+        {
+            variable->data_type = operation->data_type;
+        }
+        return 0;
+    }
+
+    if (variable != NULL && variable->num_dimensions == operation->num_dimensions)
+    {
+        for (i = 0; i < variable->num_dimensions; i++)
+        {
+            if (variable->dimension_type[i] != operation->dimension_type[i])
+            {
+                break;
+            }
+        }
+        if (i == variable->num_dimensions)
+        {
+            /* the variable already exists; at most its data type changes */
+            if (operation->unit != NULL)
+            {
+                estimate_unit_conversion(estimate, variable);
+            }
+            if (operation->has_data_type)
+            {
+                variable->data_type = operation->data_type;
+            }
+            return 0;
+        }
+    }
+
+    for (i = 0; i < operation->num_dimensions; i++)
+    {
+        if (operation->dimension_type[i] == harp_dimension_independent ||
+            estimate->dimension[operation->dimension_type[i]] == 0)
+        {
+            /* the dimension length is determined by the conversion */
+            return 1;
+        }
+        dimension[i] = estimate->dimension[operation->dimension_type[i]];
+    }
+    if (get_derived_variable_data_type(estimate, operation, &data_type) != 0)
+    {
+        return -1;
+    }
+    if (operation->unit != NULL && data_type != harp_type_double)
+    {
+        /* same as for a unit conversion of an existing variable */
+        data_type = harp_type_double;
+        estimate->is_upper_bound = 1;
+    }
+    if (operation->has_data_type)
+    {
+        data_type = operation->data_type;
+    }
+
+    return harp_product_estimate_add_variable(estimate, operation->variable_name, data_type,
+                                              operation->num_dimensions, operation->dimension_type, dimension);
+}
+
+static int estimate_exclude_variable(harp_product_estimate *estimate, harp_operation_exclude_variable *operation)
+{
+    int index;
+    int j;
+
+    for (j = 0; j < operation->num_variables; j++)
+    {
+        index = get_variable_index(estimate, operation->variable_name[j]);
+        if (index >= 0)
+        {
+            remove_variable(estimate, index);
+        }
+    }
+    update_dimensions(estimate);
+
+    return 0;
+}
+
+static int estimate_flatten(harp_product_estimate *estimate, harp_operation_flatten *operation)
+{
+    harp_dimension_type dimension_type = operation->dimension_type;
+    long dim_length = estimate->dimension[dimension_type];
+    long time_length;
+    int i;
+
+    if (dimension_type == harp_dimension_independent)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "cannot flatten independent dimension");
+        return -1;
+    }
+    if (dim_length == 0 || dimension_type == harp_dimension_time)
+    {
+        return 0;
+    }
+
+    time_length = estimate->dimension[harp_dimension_time];
+    if (time_length == 0)
+    {
+        time_length = 1;
+    }
+
+    /* this follows the logic of harp_product_flatten_dimension() */
+    for (i = estimate->num_variables - 1; i >= 0; i--)
+    {
+        harp_variable_estimate *variable = estimate->variable[i];
+        int dim_index = -1;
+        int count = 0;
+        int j;
+
+        if (dim_length != 1 && (strcmp(variable->name, "index") == 0 ||
+                                strcmp(variable->name, "collocation_index") == 0))
+        {
+            remove_variable(estimate, i);
+            continue;
+        }
+
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            if (variable->dimension_type[j] == dimension_type)
+            {
+                count++;
+                dim_index = j;
+            }
+        }
+
+        if (count == 0)
+        {
+            if (variable->num_dimensions == 0 || variable->dimension_type[0] != harp_dimension_time)
+            {
+                continue;
+            }
+            variable->dimension[0] *= dim_length;
+            continue;
+        }
+        if (count >= 2)
+        {
+            remove_variable(estimate, i);
+            continue;
+        }
+
+        /* remove the flattened dimension and make the variable depend on the (extended) time dimension */
+        for (j = dim_index; j < variable->num_dimensions - 1; j++)
+        {
+            variable->dimension_type[j] = variable->dimension_type[j + 1];
+            variable->dimension[j] = variable->dimension[j + 1];
+        }
+        variable->num_dimensions--;
+        if (variable->num_dimensions > 0 && variable->dimension_type[0] == harp_dimension_time)
+        {
+            variable->dimension[0] *= dim_length;
+        }
+        else
+        {
+            for (j = variable->num_dimensions; j > 0; j--)
+            {
+                variable->dimension_type[j] = variable->dimension_type[j - 1];
+                variable->dimension[j] = variable->dimension[j - 1];
+            }
+            variable->dimension_type[0] = harp_dimension_time;
+            variable->dimension[0] = time_length * dim_length;
+            variable->num_dimensions++;
+        }
+    }
+    update_dimensions(estimate);
+
+    return 0;
+}
+
+static int estimate_keep_variable(harp_product_estimate *estimate, harp_operation_keep_variable *operation)
+{
+    uint8_t *included;
+    int index;
+    int j;
+
+    included = (uint8_t *)calloc(estimate->num_variables + 1, sizeof(uint8_t));
+    if (included == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (estimate->num_variables + 1) * sizeof(uint8_t), __FILE__, __LINE__);
+        return -1;
+    }
+
+    for (j = 0; j < operation->num_variables; j++)
+    {
+        index = get_variable_index(estimate, operation->variable_name[j]);
+        if (index < 0)
+        {
+            harp_set_error(HARP_ERROR_OPERATION, "cannot keep non-existent variable %s", operation->variable_name[j]);
+            free(included);
+            return -1;
+        }
+        included[index] = 1;
+    }
+
+    for (j = estimate->num_variables - 1; j >= 0; j--)
+    {
+        if (!included[j])
+        {
+            remove_variable(estimate, j);
+        }
+    }
+    update_dimensions(estimate);
+
+    free(included);
+
+    return 0;
+}
+
+static int estimate_regrid(harp_product_estimate *estimate, harp_operation_regrid *operation)
+{
+    const harp_variable *axis_variable = operation->axis_variable;
+    harp_dimension_type dimension_type;
+    long length;
+    int i;
+    int j;
+
+    dimension_type = axis_variable->dimension_type[axis_variable->num_dimensions - 1];
+    length = axis_variable->dimension[axis_variable->num_dimensions - 1];
+    if (dimension_type == harp_dimension_independent)
+    {
+        harp_set_error(HARP_ERROR_OPERATION, "regridding of '%s' dimension not supported",
+                       harp_get_dimension_type_name(dimension_type));
+        return -1;
+    }
+
+    for (i = 0; i < estimate->num_variables; i++)
+    {
+        harp_variable_estimate *variable = estimate->variable[i];
+
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            if (variable->dimension_type[j] == dimension_type)
+            {
+                variable->dimension[j] = length;
+            }
+        }
+    }
+    update_dimensions(estimate);
+
+    /* variables that can not be regridded will be removed */
+    estimate->is_upper_bound = 1;
+
+    return 0;
+}
+
+static int estimate_rename(harp_product_estimate *estimate, harp_operation_rename *operation)
+{
+    char *new_name;
+    int index;
+
+    index = get_variable_index(estimate, operation->variable_name);
+    if (index < 0)
+    {
+        harp_set_error(HARP_ERROR_VARIABLE_NOT_FOUND, "product does not contain variable '%s'",
+                       operation->variable_name);
+        return -1;
+    }
+
+    new_name = strdup(operation->new_variable_name);
+    if (new_name == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                       __LINE__);
+        return -1;
+    }
+    free(estimate->variable[index]->name);
+    estimate->variable[index]->name = new_name;
+
+    return 0;
+}
+
+static int estimate_wrap(harp_product_estimate *estimate, harp_operation_wrap *operation)
+{
+    int index;
+
+    index = get_variable_index(estimate, operation->variable_name);
+    if (index < 0)
+    {
+        harp_set_error(HARP_ERROR_VARIABLE_NOT_FOUND, "product does not contain variable '%s'",
+                       operation->variable_name);
+        return -1;
+    }
+    estimate->variable[index]->data_type = harp_type_double;
+
+    return 0;
+}
+
+/* Symbolically execute the program (starting at program->current_index) on the estimate.
+ * Filters can only reduce dimension lengths, so they are handled by marking the estimate as an upper bound.
+ * Evaluation stops at the first operation whose outcome depends on the data (e.g. binning); the number of remaining
+ * operations is stored in estimate->num_unresolved_operations.
+ */
+int harp_product_estimate_execute_program(harp_product_estimate *estimate, harp_program *program)
+{
+    while (program->current_index < program->num_operations)
+    {
+        harp_operation *operation = program->operation[program->current_index];
+        int result = 0;
+
+        switch (operation->type)
+        {
+            case operation_area_covers_area_filter:
+            case operation_area_covers_point_filter:
+            case operation_area_inside_area_filter:
+            case operation_area_intersects_area_filter:
+            case operation_bit_mask_filter:
+            case operation_collocation_filter:
+            case operation_comparison_filter:
+            case operation_longitude_range_filter:
+            case operation_membership_filter:
+            case operation_point_distance_filter:
+            case operation_point_in_area_filter:
+            case operation_string_comparison_filter:
+            case operation_string_membership_filter:
+            case operation_valid_range_filter:
+                estimate->is_upper_bound = 1;
+                break;
+            case operation_derive_variable:
+                result = estimate_derive_variable(estimate, (harp_operation_derive_variable *)operation);
+                break;
+            case operation_exclude_variable:
+                result = estimate_exclude_variable(estimate, (harp_operation_exclude_variable *)operation);
+                break;
+            case operation_flatten:
+                result = estimate_flatten(estimate, (harp_operation_flatten *)operation);
+                break;
+            case operation_keep_variable:
+                result = estimate_keep_variable(estimate, (harp_operation_keep_variable *)operation);
+                break;
+            case operation_regrid:
+                result = estimate_regrid(estimate, (harp_operation_regrid *)operation);
+                break;
+            case operation_rename:
+                result = estimate_rename(estimate, (harp_operation_rename *)operation);
+                break;
+            case operation_set:
+            case operation_sort:
+                break;
+            case operation_wrap:
+                result = estimate_wrap(estimate, (harp_operation_wrap *)operation);
+                break;
+            case operation_bin_collocated:
+            case operation_bin_full:
+            case operation_bin_spatial:
+            case operation_bin_with_variable:
+            case operation_derive_smoothed_column_collocated_dataset:
+            case operation_derive_smoothed_column_collocated_product:
+            case operation_regrid_collocated_dataset:
+            case operation_regrid_collocated_product:
+            case operation_smooth_collocated_dataset:
+            case operation_smooth_collocated_product:
+                /* the result of these operations depends on the data and/or on external products */
+                result = 1;
+                break;
+        }
+
+        if (result < 0)
+        {
+            return -1;
+        }
+        if (result > 0)
+        {
+            estimate->num_unresolved_operations = program->num_operations - program->current_index;
+            return 0;
+        }
+        if (estimate->num_variables == 0)
+        {
+            return 0;
+        }
+        program->current_index++;
+    }
+
+    return 0;
+}
+
+/** \addtogroup harp_product_estimate
+ * @{
+ */
+
+/** Delete a product estimate.
+ * \param estimate Product estimate.
+ */
+LIBHARP_API void harp_product_estimate_delete(harp_product_estimate *estimate)
+{
+    if (estimate != NULL)
+    {
+        if (estimate->variable != NULL)
+        {
+            int i;
+
+            for (i = 0; i < estimate->num_variables; i++)
+            {
+                variable_estimate_delete(estimate->variable[i]);
+            }
+            free(estimate->variable);
+        }
+        free(estimate);
+    }
+}
+
+/** Determine the predicted storage size in bytes of the variable data of a product.
+ * For string variables only the storage for the string pointers is taken into account (the string lengths can not be
+ * predicted without reading the data).
+ * \param estimate Product estimate.
+ * \param size Pointer to the C variable where the size in bytes will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_product_estimate_get_storage_size(const harp_product_estimate *estimate, int64_t *size)
+{
+    int64_t total_size = 0;
+    int i;
+
+    if (estimate == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "estimate is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (size == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "size is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    for (i = 0; i < estimate->num_variables; i++)
+    {
+        harp_variable_estimate *variable = estimate->variable[i];
+        int64_t num_elements = 1;
+        int j;
+
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            num_elements *= variable->dimension[j];
+        }
+        total_size += num_elements * harp_get_size_for_type(variable->data_type);
+    }
+
+    *size = total_size;
+
+    return 0;
+}
+
+/** Print a product estimate.
+ * The output follows the layout of harp_product_print() and ends with the predicted storage size.
+ * \param estimate Product estimate.
+ * \param print Reference to a printf compatible function.
+ */
+LIBHARP_API void harp_product_estimate_print(const harp_product_estimate *estimate, int (*print) (const char *, ...))
+{
+    int64_t size;
+    int i;
+    int j;
+
+    if (estimate == NULL)
+    {
+        print("NULL\n");
+        return;
+    }
+    print("dimensions:\n");
+    for (i = 0; i < HARP_NUM_DIM_TYPES; i++)
+    {
+        if (estimate->dimension[i] > 0)
+        {
+            print("    %s = %ld\n", harp_get_dimension_type_name(i), estimate->dimension[i]);
+        }
+    }
+    print("\n");
+
+    print("variables:\n");
+    for (i = 0; i < estimate->num_variables; i++)
+    {
+        harp_variable_estimate *variable = estimate->variable[i];
+
+        print("    %s %s", harp_get_data_type_name(variable->data_type), variable->name);
+        if (variable->num_dimensions > 0)
+        {
+            print(" {");
+            for (j = 0; j < variable->num_dimensions; j++)
+            {
+                if (variable->dimension_type[j] != harp_dimension_independent)
+                {
+                    print("%s = ", harp_get_dimension_type_name(variable->dimension_type[j]));
+                }
+                print("%ld", variable->dimension[j]);
+                if (j < variable->num_dimensions - 1)
+                {
+                    print(", ");
+                }
+            }
+            print("}");
+        }
+        print("\n");
+    }
+    print("\n");
+
+    harp_product_estimate_get_storage_size(estimate, &size);
+    print("size: %lld bytes%s\n", (long long)size, estimate->is_upper_bound ? " (upper bound)" : "");
+    if (estimate->num_unresolved_operations > 0)
+    {
+        print("unresolved operations: %d\n", estimate->num_unresolved_operations);
+    }
+}
+
+/** @} */
@@ -325,6 +325,7 @@ int harp_product_make_time_dependent(harp_product *product)
 int harp_product_rearrange_dimension(harp_product *product, harp_dimension_type dimension_type, long num_dim_elements,
                                      const long *dim_element_ids)
 {
+    harp_gather_plan *plan;
     int i;
 
     if (dimension_type == harp_dimension_independent)
@@ -354,6 +355,17 @@ int harp_product_rearrange_dimension(harp_product *product, harp_dimension_type
         return 0;
     }
 
+    /* the rearrangement is the same for all variables, so derive it only once */
+    if (harp_gather_plan_new(product->dimension[dimension_type], num_dim_elements, dim_element_ids, &plan) != 0)
+    {
+        return -1;
+    }
+    if (plan->is_identity)
+    {
+        harp_gather_plan_delete(plan);
+        return 0;
+    }
+
     for (i = 0; i < product->num_variables; i++)
     {
         harp_variable *variable = product->variable[i];
@@ -366,13 +378,16 @@ int harp_product_rearrange_dimension(harp_product *product, harp_dimension_type
                 continue;
             }
 
-            if (harp_variable_rearrange_dimension(variable, j, num_dim_elements, dim_element_ids) != 0)
+            if (harp_variable_rearrange_dimension_with_plan(variable, j, plan) != 0)
             {
+                harp_gather_plan_delete(plan);
                 return -1;
             }
         }
     }
 
+    harp_gather_plan_delete(plan);
+
     product->dimension[dimension_type] = num_dim_elements;
 
     return 0;
@@ -763,6 +778,130 @@ int harp_product_get_storage_size(const harp_product *product, int with_attribut
     return 0;
 }
 
+/* Returns 1 if any of the block_size elements starting at offset contains a value other than the fill value for the
+ * data type of the variable (NaN for floating point data, 0 for integer data, and NULL or empty strings).
+ */
+static int has_non_fill_values(const harp_variable *variable, long offset, long block_size)
+{
+    long i;
+
+    switch (variable->data_type)
+    {
+        case harp_type_int8:
+            for (i = offset; i < offset + block_size; i++)
+            {
+                if (variable->data.int8_data[i] != 0)
+                {
+                    return 1;
+                }
+            }
+            break;
+        case harp_type_int16:
+            for (i = offset; i < offset + block_size; i++)
+            {
+                if (variable->data.int16_data[i] != 0)
+                {
+                    return 1;
+                }
+            }
+            break;
+        case harp_type_int32:
+            for (i = offset; i < offset + block_size; i++)
+            {
+                if (variable->data.int32_data[i] != 0)
+                {
+                    return 1;
+                }
+            }
+            break;
+        case harp_type_float:
+            for (i = offset; i < offset + block_size; i++)
+            {
+                if (!harp_isnan(variable->data.float_data[i]))
+                {
+                    return 1;
+                }
+            }
+            break;
+        case harp_type_double:
+            for (i = offset; i < offset + block_size; i++)
+            {
+                if (!harp_isnan(variable->data.double_data[i]))
+                {
+                    return 1;
+                }
+            }
+            break;
+        case harp_type_string:
+            for (i = offset; i < offset + block_size; i++)
+            {
+                if (variable->data.string_data[i] != NULL && variable->data.string_data[i][0] != '\0')
+                {
+                    return 1;
+                }
+            }
+            break;
+    }
+
+    return 0;
+}
+
+/* Determine for each time sample the number of vertical levels that contain actual data.
+ * Only variables for which harp_variable_has_ragged_vertical_layout() holds are considered. Trailing vertical levels
+ * for which all these variables only contain fill values are treated as padding. The count array should be able to
+ * hold product->dimension[harp_dimension_time] elements. If import is not NULL, the product may contain deferred
+ * variables of that import, whose data will be read (and released again) one variable at a time.
+ */
+int harp_product_get_vertical_count(const harp_product *product, harp_deferred_import *import, long *count)
+{
+    long num_time = product->dimension[harp_dimension_time];
+    long num_vertical = product->dimension[harp_dimension_vertical];
+    long i;
+    int k;
+
+    for (i = 0; i < num_time; i++)
+    {
+        count[i] = 0;
+    }
+
+    for (k = 0; k < product->num_variables; k++)
+    {
+        harp_variable *variable = product->variable[k];
+        long block_size;
+        int loaded;
+
+        if (!harp_variable_has_ragged_vertical_layout(variable) || variable->num_elements == 0)
+        {
+            continue;
+        }
+        if (harp_deferred_import_load_variable(import, variable, &loaded) != 0)
+        {
+            return -1;
+        }
+
+        block_size = variable->num_elements / (num_time * num_vertical);
+        for (i = 0; i < num_time; i++)
+        {
+            long j;
+
+            for (j = num_vertical - 1; j >= count[i]; j--)
+            {
+                if (has_non_fill_values(variable, (i * num_vertical + j) * block_size, block_size))
+                {
+                    count[i] = j + 1;
+                    break;
+                }
+            }
+        }
+        if (loaded)
+        {
+            harp_deferred_import_unload_variable(import, variable);
+        }
+    }
+
+    return 0;
+}
+
 /** \addtogroup harp_product
  * @{
  */
@@ -1010,6 +1149,288 @@ LIBHARP_API int harp_product_append(harp_product *product, harp_product *other_p
     return 0;
 }
 
+/** Concatenate a list of products along the time dimension.
+ * The variables are the same as with successive calls to harp_product_append(), but the data of each variable is
+ * copied only once into a buffer that is preallocated for the final dimension lengths (instead of reallocating and
+ * copying the merged data for each appended product).
+ * The 'index' variable, if present, will be removed and all variables will be made time dependent.
+ * Non-time dimensions will be extended to the maximum length found in any of the products.
+ * The 'source_product' and 'history' attributes are copied from the first non-empty product.
+ * All products need to have the same set of variables (with the same data type, dimension types and unit).
+ * The input products will be modified (variables are moved/freed as soon as their data has been copied), so the
+ * input products should only be deleted by the caller after this function returns.
+ * \param num_products Number of products in \a product.
+ * \param product Products that should be concatenated.
+ * \param merged_product Pointer to the variable where the concatenated product will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+int harp_product_concatenate(int num_products, harp_product **product, harp_product **merged_product)
+{
+    harp_product *new_product;
+    harp_variable *first_variable;
+    long dimension[HARP_NUM_DIM_TYPES];
+    int i, j, k;
+
+    if (num_products <= 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "invalid number of products (%d) (%s:%u)", num_products, __FILE__,
+                       __LINE__);
+        return -1;
+    }
+
+    for (j = 0; j < HARP_NUM_DIM_TYPES; j++)
+    {
+        dimension[j] = 0;
+    }
+    for (i = 0; i < num_products; i++)
+    {
+        if (harp_product_has_variable(product[i], "index"))
+        {
+            if (harp_product_remove_variable_by_name(product[i], "index") != 0)
+            {
+                return -1;
+            }
+        }
+        if (harp_product_make_time_dependent(product[i]) != 0)
+        {
+            return -1;
+        }
+        if (product[i]->num_variables != product[0]->num_variables)
+        {
+            harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "products don't have the same number of variables");
+            return -1;
+        }
+        for (j = 0; j < product[0]->num_variables; j++)
+        {
+            if (!harp_product_has_variable(product[i], product[0]->variable[j]->name))
+            {
+                harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "products don't all have variable '%s'",
+                               product[0]->variable[j]->name);
+                return -1;
+            }
+        }
+        for (j = 0; j < HARP_NUM_DIM_TYPES; j++)
+        {
+            if (j == harp_dimension_time)
+            {
+                dimension[j] += product[i]->dimension[j];
+            }
+            else if (product[i]->dimension[j] > dimension[j])
+            {
+                dimension[j] = product[i]->dimension[j];
+            }
+        }
+    }
+
+    /* verify that all variables can be concatenated before moving any data */
+    for (j = 0; j < product[0]->num_variables; j++)
+    {
+        first_variable = product[0]->variable[j];
+        for (i = 1; i < num_products; i++)
+        {
+            harp_variable *variable;
+
+            if (harp_product_get_variable_by_name(product[i], first_variable->name, &variable) != 0)
+            {
+                return -1;
+            }
+            if (variable->data_type != first_variable->data_type)
+            {
+                harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variables don't have the same datatype (%s)",
+                               first_variable->name);
+                return -1;
+            }
+            if (variable->num_dimensions != first_variable->num_dimensions)
+            {
+                harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variables don't have the same number of dimensions (%s)",
+                               first_variable->name);
+                return -1;
+            }
+            if (variable->num_enum_values != first_variable->num_enum_values)
+            {
+                harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variables don't have the same number of enumeration "
+                               "values (%s)", first_variable->name);
+                return -1;
+            }
+            if ((variable->unit == NULL) != (first_variable->unit == NULL) ||
+                (variable->unit != NULL && strcmp(variable->unit, first_variable->unit) != 0))
+            {
+                harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variables don't have the same unit (%s)",
+                               first_variable->name);
+                return -1;
+            }
+            for (k = 1; k < first_variable->num_dimensions; k++)
+            {
+                if (variable->dimension_type[k] != first_variable->dimension_type[k])
+                {
+                    harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variables (%s) don't have the same type of "
+                                   "dimensions", first_variable->name);
+                    return -1;
+                }
+                if (variable->dimension_type[k] == harp_dimension_independent &&
+                    variable->dimension[k] != first_variable->dimension[k])
+                {
+                    harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variables (%s) don't have the same dimension "
+                                   "lengths", first_variable->name);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    if (harp_product_new(&new_product) != 0)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < num_products; i++)
+    {
+        if (!harp_product_is_empty(product[i]))
+        {
+            break;
+        }
+    }
+    if (i < num_products)
+    {
+        if (product[i]->source_product != NULL)
+        {
+            new_product->source_product = strdup(product[i]->source_product);
+            if (new_product->source_product == NULL)
+            {
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)",
+                               __FILE__, __LINE__);
+                harp_product_delete(new_product);
+                return -1;
+            }
+        }
+        if (product[i]->history != NULL)
+        {
+            new_product->history = strdup(product[i]->history);
+            if (new_product->history == NULL)
+            {
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)",
+                               __FILE__, __LINE__);
+                harp_product_delete(new_product);
+                return -1;
+            }
+        }
+    }
+
+    /* fill one variable at a time and free the source variables directly afterwards to limit peak memory usage */
+    while (product[0]->num_variables > 0)
+    {
+        harp_variable *new_variable;
+        long new_dimension[HARP_MAX_NUM_DIMS];
+        char *name;
+        long offset = 0;
+        long element_size;
+
+        first_variable = product[0]->variable[0];
+        for (k = 0; k < first_variable->num_dimensions; k++)
+        {
+            if (first_variable->dimension_type[k] == harp_dimension_independent)
+            {
+                new_dimension[k] = first_variable->dimension[k];
+            }
+            else
+            {
+                new_dimension[k] = dimension[first_variable->dimension_type[k]];
+            }
+        }
+        if (harp_variable_new(first_variable->name, first_variable->data_type, first_variable->num_dimensions,
+                              first_variable->dimension_type, new_dimension, &new_variable) != 0)
+        {
+            harp_product_delete(new_product);
+            return -1;
+        }
+        if (harp_variable_copy_attributes(first_variable, new_variable) != 0)
+        {
+            harp_variable_delete(new_variable);
+            harp_product_delete(new_product);
+            return -1;
+        }
+        new_variable->valid_min = first_variable->valid_min;
+        new_variable->valid_max = first_variable->valid_max;
+        if (harp_product_add_variable(new_product, new_variable) != 0)
+        {
+            harp_variable_delete(new_variable);
+            harp_product_delete(new_product);
+            return -1;
+        }
+
+        name = new_variable->name;
+        element_size = harp_get_size_for_type(new_variable->data_type);
+        for (i = 0; i < num_products; i++)
+        {
+            harp_variable *variable;
+
+            if (harp_product_get_variable_by_name(product[i], name, &variable) != 0)
+            {
+                harp_product_delete(new_product);
+                return -1;
+            }
+
+            /* pad non-time dimensions of the source to the final lengths */
+            for (k = 1; k < variable->num_dimensions; k++)
+            {
+                if (variable->dimension[k] != new_dimension[k])
+                {
+                    if (harp_variable_resize_dimension(variable, k, new_dimension[k]) != 0)
+                    {
+                        harp_product_delete(new_product);
+                        return -1;
+                    }
+                }
+            }
+
+            /* for strings only the pointers are gathered here; the strings themselves are copied below */
+            memcpy((char *)new_variable->data.ptr + offset * element_size, variable->data.ptr,
+                   (size_t)variable->num_elements * element_size);
+            offset += variable->num_elements;
+
+            if (variable->data_type != harp_type_string)
+            {
+                if (harp_product_remove_variable(product[i], variable) != 0)
+                {
+                    harp_product_delete(new_product);
+                    return -1;
+                }
+            }
+        }
+        assert(offset == new_variable->num_elements);
+
+        if (new_variable->data_type == harp_type_string)
+        {
+            char *string_block;
+
+            /* the source strings can be part of the string blocks of the source variables, so copy all strings into
+             * a single new string block before the source variables are removed */
+            if (harp_string_array_copy(new_variable->num_elements, new_variable->data.string_data,
+                                       new_variable->data.string_data, &string_block) != 0)
+            {
+                memset(new_variable->data.string_data, 0, (size_t)new_variable->num_elements * element_size);
+                harp_product_delete(new_product);
+                return -1;
+            }
+            harp_variable_set_string_block(new_variable, string_block);
+            for (i = 0; i < num_products; i++)
+            {
+                if (harp_product_remove_variable_by_name(product[i], name) != 0)
+                {
+                    harp_product_delete(new_product);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    *merged_product = new_product;
+
+    return 0;
+}
+
 /** Set the source product attribute of the specified product.
  * Stores the base name of \a product_path as the value of the source product attribute of the specified product.
  * The previous value (if any) will be freed.
@@ -1696,6 +2117,88 @@ LIBHARP_API void harp_product_print(const harp_product *product, int show_attrib
     }
 }
 
+/* Move the dimension at dim_index to the front of the variable (or directly after the time dimension if the variable
+ * is time dependent).
+ * The data of each time sample is reordered in a single pass using block copies of the contiguous sub arrays that
+ * follow the moved dimension. If the memory layout does not change (i.e. the dimension is already in front or all
+ * dimensions it moves past have length 1) then only the dimension information is updated.
+ */
+static int move_dimension_to_front(harp_variable *var, int dim_index)
+{
+    harp_dimension_type dimension_type;
+    long num_samples = 1;
+    long num_outer = 1;
+    long length;
+    long block_size;
+    int first;
+    int j;
+
+    first = (var->dimension_type[0] == harp_dimension_time) ? 1 : 0;
+    if (dim_index == first)
+    {
+        return 0;
+    }
+
+    if (first)
+    {
+        num_samples = var->dimension[0];
+    }
+    for (j = first; j < dim_index; j++)
+    {
+        num_outer *= var->dimension[j];
+    }
+    length = var->dimension[dim_index];
+    block_size = harp_get_size_for_type(var->data_type);
+    for (j = dim_index + 1; j < var->num_dimensions; j++)
+    {
+        block_size *= var->dimension[j];
+    }
+
+    if (num_outer > 1 && length > 1 && block_size > 0)
+    {
+        long sample_size = num_outer * length * block_size;
+        char *buffer;
+        long i;
+
+        buffer = malloc((size_t)sample_size);
+        if (buffer == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (size_t)sample_size, __FILE__, __LINE__);
+            return -1;
+        }
+        for (i = 0; i < num_samples; i++)
+        {
+            char *sample = (char *)var->data.ptr + i * sample_size;
+            long k;
+
+            for (k = 0; k < length; k++)
+            {
+                long l;
+
+                for (l = 0; l < num_outer; l++)
+                {
+                    memcpy(&buffer[(k * num_outer + l) * block_size], &sample[(l * length + k) * block_size],
+                           (size_t)block_size);
+                }
+            }
+            memcpy(sample, buffer, (size_t)sample_size);
+        }
+        free(buffer);
+    }
+
+    dimension_type = var->dimension_type[dim_index];
+    for (j = dim_index; j > first; j--)
+    {
+        var->dimension[j] = var->dimension[j - 1];
+        var->dimension_type[j] = var->dimension_type[j - 1];
+    }
+    var->dimension[first] = length;
+    var->dimension_type[first] = dimension_type;
+
+    return 0;
+}
+
 /** Collapse a given dimension into the time dimension
  *
  * Flattening a product for a certain dimension collapses the dimension into the time dimension (i.e. the time
@@ -1736,34 +2239,24 @@ LIBHARP_API int harp_product_flatten_dimension(harp_product *product, harp_dimen
         return 0;
     }
 
-    if (dim_length != 1)
-    {
-        /* remove index and collocation_index variables if they exist */
-        if (harp_product_has_variable(product, "index"))
-        {
-            if (harp_product_remove_variable_by_name(product, "index") != 0)
-            {
-                return -1;
-            }
-        }
-        if (harp_product_has_variable(product, "collocation_index"))
-        {
-            if (harp_product_remove_variable_by_name(product, "collocation_index") != 0)
-            {
-                return -1;
-            }
-        }
-    }
-
     for (i = product->num_variables - 1; i >= 0; i--)
     {
-        int order[HARP_MAX_NUM_DIMS];
         int dim_index = -1;
         int count = 0;
         int j;
 
         var = product->variable[i];
 
+        if (dim_length != 1 && (strcmp(var->name, "index") == 0 || strcmp(var->name, "collocation_index") == 0))
+        {
+            /* remove index and collocation_index variables since they will no longer be unique */
+            if (harp_product_remove_variable(product, var) != 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+
         for (j = 0; j < var->num_dimensions; j++)
         {
             if (var->dimension_type[j] == dimension_type)
@@ -1777,6 +2270,11 @@ LIBHARP_API int harp_product_flatten_dimension(harp_product *product, harp_dimen
         {
             if (var->num_dimensions > 0 && var->dimension_type[0] == harp_dimension_time)
             {
+                if (dim_length == 1)
+                {
+                    /* flattening a dimension of length 1 does not change the variable */
+                    continue;
+                }
                 /* add the dimension to be flattened in the right place; this effectively extends time appropriately */
                 if (harp_variable_add_dimension(var, 1, dimension_type, dim_length) != 0)
                 {
@@ -1798,6 +2296,14 @@ LIBHARP_API int harp_product_flatten_dimension(harp_product *product, harp_dimen
             continue;
         }
 
+        /* move the dimension to the front (after the time dimension, if present); this is done before making the
+         * variable time dependent such that the reordering is not performed on replicated data
+         */
+        if (move_dimension_to_front(var, dim_index) != 0)
+        {
+            return -1;
+        }
+
         /* the variable must be time-dependend */
         if (var->dimension_type[0] != harp_dimension_time)
         {
@@ -1809,37 +2315,11 @@ LIBHARP_API int harp_product_flatten_dimension(harp_product *product, harp_dimen
             {
                 return -1;
             }
-
-            dim_index++;
-        }
-
-        /* derive the new order of dimensions, splicing in dim_index at position 1 *if necessary* */
-        if (dim_index != 1)
-        {
-            order[0] = 0;
-            order[1] = dim_index;
-            for (j = 2; j < var->num_dimensions; j++)
-            {
-                if (j <= dim_index)
-                {
-                    order[j] = j - 1;
-                }
-                else
-                {
-                    order[j] = j;
-                }
-            }
-
-            /* reorder dimensions */
-            if (harp_array_transpose(var->data_type, var->num_dimensions, var->dimension, order, var->data) != 0)
-            {
-                return -1;
-            }
         }
 
-        /* update the dimension info */
-        var->dimension[harp_dimension_time] *= var->dimension[dim_index];
-        for (j = dim_index; j < var->num_dimensions - 1; j++)
+        /* merge the time dimension and the flattened dimension (which now has index 1); this requires no data copy */
+        var->dimension[0] *= var->dimension[1];
+        for (j = 1; j < var->num_dimensions - 1; j++)
         {
             var->dimension[j] = var->dimension[j + 1];
             var->dimension_type[j] = var->dimension_type[j + 1];
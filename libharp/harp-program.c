@@ -59,6 +59,9 @@ int harp_program_new(harp_program **new_program)
     program->option_enable_aux_afgl86 = harp_get_option_enable_aux_afgl86();
     program->option_enable_aux_usstd76 = harp_get_option_enable_aux_usstd76();
     program->option_regrid_out_of_bounds = harp_get_option_regrid_out_of_bounds();
+    program->execution_option_enable_aux_afgl86 = program->option_enable_aux_afgl86;
+    program->execution_option_enable_aux_usstd76 = program->option_enable_aux_usstd76;
+    program->execution_option_regrid_out_of_bounds = 0;
 
     /* we only explicitly set the regrid_out_of_bounds option */
     harp_set_option_regrid_out_of_bounds(0);
@@ -67,6 +70,33 @@ int harp_program_new(harp_program **new_program)
     return 0;
 }
 
+/* Prepare a program for being executed again (on a new product).
+ * This resets the program to its first operation and stores the current values of the global HARP options that can be
+ * modified by 'set' operations. Once the program has been executed for the product, harp_program_restore_options()
+ * should be called, such that 'set' operations for one product do not affect the next product (or the caller).
+ */
+void harp_program_reset(harp_program *program)
+{
+    program->current_index = 0;
+
+    program->execution_option_enable_aux_afgl86 = harp_get_option_enable_aux_afgl86();
+    program->execution_option_enable_aux_usstd76 = harp_get_option_enable_aux_usstd76();
+    program->execution_option_regrid_out_of_bounds = harp_get_option_regrid_out_of_bounds();
+
+    /* as for a new program, only the regrid_out_of_bounds option is explicitly set */
+    harp_set_option_regrid_out_of_bounds(0);
+}
+
+/* Set the global HARP options that can be modified by 'set' operations back to the values that they had when
+ * harp_program_reset() was called.
+ */
+void harp_program_restore_options(harp_program *program)
+{
+    harp_set_option_enable_aux_afgl86(program->execution_option_enable_aux_afgl86);
+    harp_set_option_enable_aux_usstd76(program->execution_option_enable_aux_usstd76);
+    harp_set_option_regrid_out_of_bounds(program->execution_option_regrid_out_of_bounds);
+}
+
 void harp_program_delete(harp_program *program)
 {
     if (program != NULL)
@@ -1136,12 +1166,89 @@ static int execute_wrap(harp_product *product, harp_operation_wrap *operation)
     return 0;
 }
 
-/* this will start with the operation at program->current_index */
-int harp_product_execute_program(harp_product *product, harp_program *program)
+/* name of the operation type as used for trace spans */
+static const char *get_operation_name(harp_operation_type type)
+{
+    switch (type)
+    {
+        case operation_area_covers_area_filter:
+            return "area_covers_area_filter";
+        case operation_area_covers_point_filter:
+            return "area_covers_point_filter";
+        case operation_area_inside_area_filter:
+            return "area_inside_area_filter";
+        case operation_area_intersects_area_filter:
+            return "area_intersects_area_filter";
+        case operation_bin_collocated:
+            return "bin_collocated";
+        case operation_bin_full:
+            return "bin_full";
+        case operation_bin_spatial:
+            return "bin_spatial";
+        case operation_bin_with_variable:
+            return "bin_with_variable";
+        case operation_bit_mask_filter:
+            return "bit_mask_filter";
+        case operation_collocation_filter:
+            return "collocation_filter";
+        case operation_comparison_filter:
+            return "comparison_filter";
+        case operation_derive_variable:
+            return "derive_variable";
+        case operation_derive_smoothed_column_collocated_dataset:
+            return "derive_smoothed_column_collocated_dataset";
+        case operation_derive_smoothed_column_collocated_product:
+            return "derive_smoothed_column_collocated_product";
+        case operation_exclude_variable:
+            return "exclude_variable";
+        case operation_flatten:
+            return "flatten";
+        case operation_keep_variable:
+            return "keep_variable";
+        case operation_longitude_range_filter:
+            return "longitude_range_filter";
+        case operation_membership_filter:
+            return "membership_filter";
+        case operation_point_distance_filter:
+            return "point_distance_filter";
+        case operation_point_in_area_filter:
+            return "point_in_area_filter";
+        case operation_regrid:
+            return "regrid";
+        case operation_regrid_collocated_dataset:
+            return "regrid_collocated_dataset";
+        case operation_regrid_collocated_product:
+            return "regrid_collocated_product";
+        case operation_rename:
+            return "rename";
+        case operation_set:
+            return "set";
+        case operation_smooth_collocated_dataset:
+            return "smooth_collocated_dataset";
+        case operation_smooth_collocated_product:
+            return "smooth_collocated_product";
+        case operation_sort:
+            return "sort";
+        case operation_string_comparison_filter:
+            return "string_comparison_filter";
+        case operation_string_membership_filter:
+            return "string_membership_filter";
+        case operation_valid_range_filter:
+            return "valid_range_filter";
+        case operation_wrap:
+            return "wrap";
+    }
+
+    assert(0);
+    exit(1);
+}
+
+static int execute_program(harp_product *product, harp_program *program, int end_index)
 {
-    while (program->current_index < program->num_operations)
+    while (program->current_index < end_index)
     {
         harp_operation *operation = program->operation[program->current_index];
+        double trace_start = harp_trace_begin();
 
         /* note that some consecutive filter operations can be executed together for optimization purposes */
         /* so the filter functions below may increase program->current_index itself */
@@ -1303,6 +1410,8 @@ int harp_product_execute_program(harp_product *product, harp_program *program)
                 break;
         }
 
+        harp_trace_end_product(trace_start, "operation", get_operation_name(operation->type), NULL, product);
+
         if (harp_product_is_empty(product))
         {
             /* don't perform any of the remaining actions; just return the empty product */
@@ -1314,6 +1423,120 @@ int harp_product_execute_program(harp_product *product, harp_program *program)
     return 0;
 }
 
+/* Returns 1 if all operations of the program only select or rename variables (i.e. they do not need the data of any
+ * variable, nor change the dimensions of the product), 0 otherwise.
+ */
+int harp_program_is_variable_selection(const harp_program *program)
+{
+    int i;
+
+    for (i = 0; i < program->num_operations; i++)
+    {
+        switch (program->operation[i]->type)
+        {
+            case operation_exclude_variable:
+            case operation_keep_variable:
+            case operation_rename:
+                break;
+            default:
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int is_time_variable(const harp_product *product, const char *variable_name)
+{
+    harp_variable *variable;
+
+    if (!harp_product_has_variable(product, variable_name))
+    {
+        return 0;
+    }
+    if (harp_product_get_variable_by_name(product, variable_name, &variable) != 0)
+    {
+        return 0;
+    }
+
+    return variable->num_dimensions == 1 && variable->dimension_type[0] == harp_dimension_time;
+}
+
+/* Returns the number of operations (starting with the operation at program->current_index) that only filter the time
+ * dimension of the product based on 1-D time dependent variables (or, for collocation filters, that select and repeat
+ * time samples based on the 'collocation_index' or 'index' variable). These operations can be performed on a product
+ * that only contains these variables, such that for the other variables only the resulting time samples need to be
+ * read. The product may contain variables without data.
+ */
+int harp_program_get_num_time_filters(const harp_program *program, const harp_product *product)
+{
+    int i;
+
+    if (product->dimension[harp_dimension_time] == 0)
+    {
+        return 0;
+    }
+
+    for (i = program->current_index; i < program->num_operations; i++)
+    {
+        const harp_operation *operation = program->operation[i];
+        const char *variable_name;
+
+        switch (operation->type)
+        {
+            case operation_bit_mask_filter:
+            case operation_comparison_filter:
+            case operation_longitude_range_filter:
+            case operation_membership_filter:
+            case operation_string_comparison_filter:
+            case operation_string_membership_filter:
+            case operation_valid_range_filter:
+                if (harp_operation_get_variable_name(operation, &variable_name) != 0 ||
+                    !is_time_variable(product, variable_name))
+                {
+                    return i - program->current_index;
+                }
+                break;
+            case operation_collocation_filter:
+                /* if neither variable is present, the 'index' variable is derived from the time dimension */
+                if ((harp_product_has_variable(product, "collocation_index") &&
+                     !is_time_variable(product, "collocation_index")) ||
+                    (harp_product_has_variable(product, "index") && !is_time_variable(product, "index")))
+                {
+                    return i - program->current_index;
+                }
+                break;
+            default:
+                return i - program->current_index;
+        }
+    }
+
+    return i - program->current_index;
+}
+
+/* this will start with the operation at program->current_index */
+int harp_product_execute_program(harp_product *product, harp_program *program)
+{
+    return harp_product_execute_program_operations(product, program, program->num_operations -
+                                                   program->current_index);
+}
+
+/* Execute num_operations operations of the program (starting with the operation at program->current_index).
+ * Consecutive value filters on the same variable are always performed together, so num_operations should not end
+ * in the middle of such a sequence.
+ */
+int harp_product_execute_program_operations(harp_product *product, harp_program *program, int num_operations)
+{
+    harp_memory_subsystem previous_subsystem;
+    int result;
+
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_operations);
+    result = execute_program(product, program, program->current_index + num_operations);
+    harp_memory_set_subsystem(previous_subsystem);
+
+    return result;
+}
+
 /** \addtogroup harp_product
  * @{
  */
@@ -46,16 +46,26 @@ typedef struct harp_program_struct
     int option_enable_aux_afgl86;
     int option_enable_aux_usstd76;
     int option_regrid_out_of_bounds;
+    /* global HARP options at the start of the current execution (see harp_program_reset()) */
+    int execution_option_enable_aux_afgl86;
+    int execution_option_enable_aux_usstd76;
+    int execution_option_regrid_out_of_bounds;
 } harp_program;
 
 int harp_program_new(harp_program **new_program);
 void harp_program_delete(harp_program *program);
+void harp_program_reset(harp_program *program);
+void harp_program_restore_options(harp_program *program);
 int harp_program_add_operation(harp_program *program, harp_operation *operation);
+int harp_program_is_variable_selection(const harp_program *program);
+int harp_program_get_num_time_filters(const harp_program *program, const harp_product *product);
 
 /* Parser */
 int harp_program_from_string(const char *str, harp_program **new_program);
 
 /* Execution */
 int harp_product_execute_program(harp_product *product, harp_program *program);
+int harp_product_execute_program_operations(harp_product *product, harp_program *program, int num_operations);
+int harp_product_estimate_execute_program(harp_product_estimate *estimate, harp_program *program);
 
 #endif
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2015-2018 S[&]T, The Netherlands.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "harp-internal.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* Trace spans are written as 'complete' events of the Chrome trace event format (which can be viewed with e.g.
+ * chrome://tracing or Perfetto). Events are streamed to the trace file as soon as a span ends, so memory usage does not
+ * grow with the number of spans. Nested spans (e.g. variable reads within an ingestion) are shown as a call stack.
+ */
+
+/* hot paths check this flag (via harp_trace_begin()) such that disabled tracing only costs a single comparison */
+int harp_trace_enabled = 0;
+
+static FILE *trace_file = NULL;
+static long trace_num_events = 0;
+static long trace_pid = 0;
+
+/* Returns a timestamp in microseconds from a monotonic clock.
+ * A monotonic clock is used (instead of the wall clock) such that span durations are not affected by adjustments of
+ * the system time. The origin of the clock is arbitrary, which is fine for the trace event format.
+ */
+double harp_trace_get_time(void)
+{
+#ifdef WIN32
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart * 1e6 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+#endif
+}
+
+static void write_json_string(const char *str)
+{
+    fputc('"', trace_file);
+    while (*str != '\0')
+    {
+        unsigned char c = (unsigned char)*str;
+
+        if (c == '"' || c == '\\')
+        {
+            fputc('\\', trace_file);
+            fputc(c, trace_file);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(trace_file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, trace_file);
+        }
+        str++;
+    }
+    fputc('"', trace_file);
+}
+
+/* Record a span that started at start_time (as returned by harp_trace_begin()).
+ * The detail (e.g. a filename or variable name) is optional. Negative values for num_elements/num_bytes indicate that
+ * the value is not applicable and are left out of the event.
+ */
+void harp_trace_end(double start_time, const char *category, const char *name, const char *detail, long num_elements,
+                    int64_t num_bytes)
+{
+    double end_time;
+
+    if (!harp_trace_enabled || start_time <= 0)
+    {
+        /* tracing was not active when the span started */
+        return;
+    }
+    end_time = harp_trace_get_time();
+
+    fprintf(trace_file, "%s\n{\"name\":", trace_num_events > 0 ? "," : "");
+    write_json_string(name);
+    fprintf(trace_file, ",\"cat\":");
+    write_json_string(category);
+    fprintf(trace_file, ",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,\"pid\":%ld,\"tid\":1,\"args\":{", start_time,
+            end_time - start_time, trace_pid);
+    if (detail != NULL)
+    {
+        fprintf(trace_file, "\"detail\":");
+        write_json_string(detail);
+    }
+    if (num_elements >= 0)
+    {
+        fprintf(trace_file, "%s\"elements\":%ld", detail != NULL ? "," : "", num_elements);
+    }
+    if (num_bytes >= 0)
+    {
+        fprintf(trace_file, "%s\"bytes\":%lld", (detail != NULL || num_elements >= 0) ? "," : "",
+                (long long)num_bytes);
+    }
+    fprintf(trace_file, "}}");
+    trace_num_events++;
+}
+
+/* Record a span for a step that produced (or processed) a single variable.
+ * The variable name is used as detail of the span.
+ */
+void harp_trace_end_variable(double start_time, const char *category, const char *name, const harp_variable *variable)
+{
+    if (!harp_trace_enabled || start_time <= 0)
+    {
+        return;
+    }
+
+    harp_trace_end(start_time, category, name, variable->name, variable->num_elements,
+                   variable->num_elements * (int64_t)harp_get_size_for_type(variable->data_type));
+}
+
+/* Record a span for a step that produced (or processed) a full product.
+ * The element and byte counts are the totals for all variables in the product.
+ */
+void harp_trace_end_product(double start_time, const char *category, const char *name, const char *detail,
+                            const harp_product *product)
+{
+    long num_elements = 0;
+    int64_t num_bytes = 0;
+    int i;
+
+    if (!harp_trace_enabled || start_time <= 0)
+    {
+        return;
+    }
+
+    if (product != NULL)
+    {
+        for (i = 0; i < product->num_variables; i++)
+        {
+            num_elements += product->variable[i]->num_elements;
+            num_bytes += product->variable[i]->num_elements *
+                (int64_t)harp_get_size_for_type(product->variable[i]->data_type);
+        }
+    }
+
+    harp_trace_end(start_time, category, name, detail, num_elements, num_bytes);
+}
+
+/* Start tracing if the HARP_TRACE environment variable is set (and tracing was not yet started). */
+int harp_trace_init(void)
+{
+    const char *filename = getenv("HARP_TRACE");
+
+    if (filename == NULL || *filename == '\0' || harp_trace_enabled)
+    {
+        return 0;
+    }
+
+    return harp_trace_start(filename);
+}
+
+/** \addtogroup harp_general
+ * @{
+ */
+
+/** Start recording trace spans of the main processing steps of HARP.
+ * When tracing is enabled, HARP records the duration of its main processing steps (such as module detection, the
+ * reading of each variable during ingestion, each operation that is performed on a product, the derivation of
+ * variables, and the import/export of products), together with the number of elements and bytes that were processed.
+ * The spans are written to the given file using the JSON Chrome trace event format, which can be viewed with e.g.
+ * chrome://tracing or https://ui.perfetto.dev.
+ * Tracing is stopped (and the trace file is finalized) with harp_trace_stop() or by the final call to harp_done().
+ * Tracing can also be enabled by setting the HARP_TRACE environment variable to the path of the trace file before
+ * calling harp_init().
+ * \param filename Path of the trace file (an existing file will be overwritten).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_trace_start(const char *filename)
+{
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (harp_trace_enabled)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "tracing is already active (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    trace_file = fopen(filename, "w");
+    if (trace_file == NULL)
+    {
+        harp_set_error(HARP_ERROR_FILE_OPEN, "could not open trace file '%s' (%s) (%s:%u)", filename, strerror(errno),
+                       __FILE__, __LINE__);
+        return -1;
+    }
+    fprintf(trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+#ifdef WIN32
+    trace_pid = (long)_getpid();
+#else
+    trace_pid = (long)getpid();
+#endif
+    trace_num_events = 0;
+    harp_trace_enabled = 1;
+
+    return 0;
+}
+
+/** Stop recording trace spans and close the trace file.
+ * This function does nothing if tracing was not started.
+ * \see harp_trace_start()
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_trace_stop(void)
+{
+    if (!harp_trace_enabled)
+    {
+        return 0;
+    }
+    harp_trace_enabled = 0;
+
+    fprintf(trace_file, "\n]}\n");
+    if (fclose(trace_file) != 0)
+    {
+        trace_file = NULL;
+        harp_set_error(HARP_ERROR_FILE_CLOSE, "could not close trace file (%s) (%s:%u)", strerror(errno), __FILE__,
+                       __LINE__);
+        return -1;
+    }
+    trace_file = NULL;
+
+    return 0;
+}
+
+/** @} */
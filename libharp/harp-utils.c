@@ -882,7 +882,6 @@ long harp_parse_double(const char *buffer, long buffer_length, double *dst, int
     long length;
     int value_length;
     int exponent_length;
-    int has_sign;
     double value;
     long exponent;
     int negative = 0;
@@ -895,23 +894,21 @@ long harp_parse_double(const char *buffer, long buffer_length, double *dst, int
         length--;
     }
 
-    has_sign = 0;
     if (length > 0)
     {
         if (*buffer == '+' || *buffer == '-')
         {
             negative = (*buffer == '-');
-            has_sign = 1;
             buffer++;
             length--;
         }
     }
 
-    /* check for NaN/Inf */
+    /* check for NaN/Inf (a sign is allowed for both, since e.g. printf() can produce '-nan') */
     if (length >= 3)
     {
         if ((buffer[0] == 'N' || buffer[0] == 'n') && (buffer[1] == 'A' || buffer[1] == 'a') &&
-            (buffer[2] == 'N' || buffer[2] == 'n') && !has_sign)
+            (buffer[2] == 'N' || buffer[2] == 'n'))
         {
             length -= 3;
             if (!ignore_trailing_bytes && length != 0)
@@ -1156,6 +1153,119 @@ int harp_get_char_array_from_string_array(long num_strings, char **string_data,
     return 0;
 }
 
+/**
+ * Allocate a block of memory for \a num_strings fixed length strings of \a string_length characters.
+ * The caller should store the characters of the strings (\a num_strings times \a string_length characters, without
+ * termination) at the start of the block and then call harp_string_block_distribute() to create the strings.
+ * The block ends with an additional empty string (at offset \a num_strings * (\a string_length + 1)) that can be
+ * used for padding. The block should be released with harp_memory_free().
+ * \param[in] num_strings Number of strings.
+ * \param[in] string_length Fixed length of each string (excluding termination).
+ * \return
+ *   \arg \c Pointer to the block of memory, Success.
+ *   \arg \c NULL, Error occurred (check #harp_errno).
+ */
+char *harp_string_block_new(long num_strings, long string_length)
+{
+    size_t size = (size_t)num_strings * (string_length + 1) + 1;
+    char *block;
+
+    block = harp_memory_alloc(size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    block[size - 1] = '\0';
+
+    return block;
+}
+
+/**
+ * Turn the fixed length strings that were stored at the start of a block of memory from harp_string_block_new() into
+ * NUL terminated strings and store a pointer to each string in \a string_data. The strings are made NUL terminated in
+ * place, so the strings remain part of the block (and should not be released individually).
+ * \param[in] block Block of memory as returned by harp_string_block_new().
+ * \param[in] num_strings Number of strings.
+ * \param[in] string_length Fixed length of each string (excluding termination).
+ * \param[out] string_data Array of \a num_strings elements in which the pointers to the strings will be stored.
+ */
+void harp_string_block_distribute(char *block, long num_strings, long string_length, char **string_data)
+{
+    long i;
+
+    /* move the strings (starting with the last one) to make room for the termination characters */
+    for (i = num_strings - 1; i >= 0; i--)
+    {
+        char *str = &block[i * (string_length + 1)];
+
+        if (i > 0)
+        {
+            memmove(str, &block[i * string_length], string_length);
+        }
+        str[string_length] = '\0';
+        string_data[i] = str;
+    }
+}
+
+/**
+ * Copy an array of strings. The copies of all (non NULL) strings are stored in a single block of memory, which
+ * should be released with harp_memory_free() (the copies should not be released individually).
+ * The source and target array are allowed to be the same array.
+ * \param[in] num_strings Number of strings in the array.
+ * \param[in] source_data Array of strings to copy.
+ * \param[out] target_data Array of \a num_strings elements in which the pointers to the copies will be stored.
+ * \param[out] block Pointer to the C variable where the block of memory will be stored (will be NULL if there are no
+ *   non NULL strings).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+int harp_string_array_copy(long num_strings, char **source_data, char **target_data, char **block)
+{
+    size_t size = 0;
+    char *data;
+    long i;
+
+    for (i = 0; i < num_strings; i++)
+    {
+        if (source_data[i] != NULL)
+        {
+            size += strlen(source_data[i]) + 1;
+        }
+    }
+    if (size == 0)
+    {
+        memset(target_data, 0, num_strings * sizeof(char *));
+        *block = NULL;
+        return 0;
+    }
+
+    data = harp_memory_alloc(size);
+    if (data == NULL)
+    {
+        return -1;
+    }
+
+    size = 0;
+    for (i = 0; i < num_strings; i++)
+    {
+        if (source_data[i] != NULL)
+        {
+            size_t length = strlen(source_data[i]) + 1;
+
+            target_data[i] = memcpy(&data[size], source_data[i], length);
+            size += length;
+        }
+        else
+        {
+            target_data[i] = NULL;
+        }
+    }
+    *block = data;
+
+    return 0;
+}
+
 static void fill_int8(long num_elements, int8_t *data, int8_t value)
 {
     int8_t *last;
@@ -1282,52 +1392,43 @@ void harp_array_replace_fill_value(harp_data_type data_type, long num_elements,
         return;
     }
 
+    /* the values are always (re)assigned, such that the loops have no branches and can be vectorized */
     harp_fill_value = harp_get_fill_value_for_type(data_type);
     switch (data_type)
     {
         case harp_type_int8:
             for (i = 0; i < num_elements; i++)
             {
-                if (data.int8_data[i] == fill_value.int8_data)
-                {
-                    data.int8_data[i] = harp_fill_value.int8_data;
-                }
+                data.int8_data[i] = (data.int8_data[i] == fill_value.int8_data) ? harp_fill_value.int8_data :
+                    data.int8_data[i];
             }
             break;
         case harp_type_int16:
             for (i = 0; i < num_elements; i++)
             {
-                if (data.int16_data[i] == fill_value.int16_data)
-                {
-                    data.int16_data[i] = harp_fill_value.int16_data;
-                }
+                data.int16_data[i] = (data.int16_data[i] == fill_value.int16_data) ? harp_fill_value.int16_data :
+                    data.int16_data[i];
             }
             break;
         case harp_type_int32:
             for (i = 0; i < num_elements; i++)
             {
-                if (data.int32_data[i] == fill_value.int32_data)
-                {
-                    data.int32_data[i] = harp_fill_value.int32_data;
-                }
+                data.int32_data[i] = (data.int32_data[i] == fill_value.int32_data) ? harp_fill_value.int32_data :
+                    data.int32_data[i];
             }
             break;
         case harp_type_float:
             for (i = 0; i < num_elements; i++)
             {
-                if (data.float_data[i] == fill_value.float_data)
-                {
-                    data.float_data[i] = harp_fill_value.float_data;
-                }
+                data.float_data[i] = (data.float_data[i] == fill_value.float_data) ? harp_fill_value.float_data :
+                    data.float_data[i];
             }
             break;
         case harp_type_double:
             for (i = 0; i < num_elements; i++)
             {
-                if (data.double_data[i] == fill_value.double_data)
-                {
-                    data.double_data[i] = harp_fill_value.double_data;
-                }
+                data.double_data[i] = (data.double_data[i] == fill_value.double_data) ? harp_fill_value.double_data :
+                    data.double_data[i];
             }
             break;
         default:
@@ -41,6 +41,95 @@
  * The HARP Variables module contains everything related to HARP variables.
  */
 
+/* Variables are allocated as part of this wrapper, which holds the properties of a variable that are not part of the
+ * public harp_variable struct.
+ */
+typedef struct harp_variable_private_struct
+{
+    harp_variable variable;     /* should be the first member, such that the wrapper can be cast to harp_variable */
+    char *string_block; /* if not NULL, block of memory that holds (non NULL) strings of 'data' */
+    size_t string_block_size;
+} harp_variable_private;
+
+/* Allocate a variable (including its private properties); only the private properties are initialized. */
+static harp_variable *variable_alloc(void)
+{
+    harp_variable_private *private_variable;
+
+    private_variable = (harp_variable_private *)malloc(sizeof(harp_variable_private));
+    if (private_variable == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_variable_private), __FILE__, __LINE__);
+        return NULL;
+    }
+    private_variable->string_block = NULL;
+    private_variable->string_block_size = 0;
+
+    return &private_variable->variable;
+}
+
+/* Set the block of memory (allocated using harp_memory_alloc()) that holds (part of) the strings of a variable.
+ * The strings that are part of the block are not allocated individually, can be shared by several elements, and are
+ * released together with the block. Any previous string block of the variable is released.
+ */
+void harp_variable_set_string_block(harp_variable *variable, char *string_block)
+{
+    harp_variable_private *private_variable = (harp_variable_private *)variable;
+
+    if (private_variable->string_block != NULL)
+    {
+        harp_memory_free(private_variable->string_block);
+    }
+    private_variable->string_block = string_block;
+    private_variable->string_block_size = string_block == NULL ? 0 : harp_memory_get_size(string_block);
+}
+
+/* Returns whether a (non NULL) string of a variable is part of the string block of the variable. Other strings are
+ * allocated individually (and are never shared by several elements). If variable is NULL, 0 is returned.
+ */
+int harp_variable_is_block_string(const harp_variable *variable, const char *string)
+{
+    const harp_variable_private *private_variable = (const harp_variable_private *)variable;
+
+    if (private_variable == NULL || private_variable->string_block == NULL)
+    {
+        return 0;
+    }
+
+    return string >= private_variable->string_block &&
+        string < private_variable->string_block + private_variable->string_block_size;
+}
+
+/* Free a string of a variable, unless it is NULL or part of the string block of the variable. */
+void harp_variable_free_string(const harp_variable *variable, char *string)
+{
+    if (string != NULL && !harp_variable_is_block_string(variable, string))
+    {
+        free(string);
+    }
+}
+
+/* Duplicate a string of a variable that is going to be stored in a second element (strings in the string block of
+ * the variable can be shared, so those are not duplicated).
+ */
+static int share_string(const harp_variable *variable, char **string)
+{
+    if (*string == NULL || harp_variable_is_block_string(variable, *string))
+    {
+        return 0;
+    }
+    *string = strdup(*string);
+    if (*string == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                       __LINE__);
+        return -1;
+    }
+
+    return 0;
+}
+
 static void write_scalar(harp_scalar data, harp_data_type data_type, int (*print) (const char *, ...))
 {
     switch (data_type)
@@ -318,24 +407,12 @@ int harp_variable_set_enumeration_values_using_flag_meanings(harp_variable *vari
     return 0;
 }
 
-/** Rearrange the data of a variable in one dimension.
- * This function allows data of a variable to be rearranged according to the order of the indices in dim_element_id.
- * The number of indices (num_dim_elements) in dim_element_id does not have to correspond to the number of
- * elements in the specified (dim_index) dimension. This means that the data block will grow/shrink when the amount of
- * elements in dim_element_id is larger/smaller (note that the amount of elements can only become larger if elements
- * are duplicated).
- *
- * \param variable Pointer to variable that should have its data rearranged.
- * \param dim_index The id of the dimension in which the rearrangement should take place.
- * \param num_dim_elements Number of elements in dim_element_id.
- * \param dim_element_ids An array containing the ids in dimension dim_index in the new arrangement (ids may occur more
- * than once and the number of ids may be smaller or larger than the length of dimension dim_index).
- * \return
- *   \arg \c 0, Success.
- *   \arg \c -1, Error occurred (check #harp_errno).
+/* Rearrange the data of a variable in one dimension without allocating a second data block.
+ * This is used as fallback when there is not enough memory available (within the memory limit) to gather the data
+ * into a new data block. Validation of the arguments should already have been performed by the caller.
  */
-int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, long num_dim_elements,
-                                      const long *dim_element_ids)
+static int rearrange_dimension_in_place(harp_variable *variable, int dim_index, long num_dim_elements,
+                                        const long *dim_element_ids)
 {
     char *buffer;
     long *move_to_id;
@@ -347,59 +424,6 @@ int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, lo
     long filter_block_size;
     long i_increment;
     long i;
-    int needs_shuffle;
-
-    /* The multidimensional array is split in three parts:
-     *   num_elements = num_groups * dim[dim_index] * num_block_elements
-     *   new_num_elements = num_groups * num_dim_elements * num_block_elements */
-    if (variable == NULL)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable is NULL (%s:%u)", __FILE__, __LINE__);
-        return -1;
-    }
-    if (num_dim_elements <= 0)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "num_dim_elements argument <= 0 (%s:%u)", __FILE__, __LINE__);
-        return -1;
-    }
-    if (dim_element_ids == NULL)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dim_element_ids argument is NULL (%s:%u)", __FILE__, __LINE__);
-        return -1;
-    }
-    if (dim_index < 0 || dim_index >= variable->num_dimensions)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dim_index argument (%d) is not in the range [0,%d) (%s:%u)",
-                       dim_index, variable->num_dimensions, __FILE__, __LINE__);
-        return -1;
-    }
-    if (variable->num_elements == 0)
-    {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "cannot reshape variable '%s' (variable has 0 elements) (%s:%u)",
-                       variable->name, __FILE__, __LINE__);
-        return -1;
-    }
-
-    needs_shuffle = num_dim_elements != variable->dimension[dim_index];
-    for (i = 0; i < num_dim_elements; i++)
-    {
-        if (dim_element_ids[i] < 0 || dim_element_ids[i] >= variable->dimension[dim_index])
-        {
-            harp_set_error(HARP_ERROR_INVALID_ARGUMENT,
-                           "dim_element_ids[%d] argument (%d) is not in the range [0,%d) (%s:%u)",
-                           i, dim_element_ids[i], variable->dimension[dim_index], __FILE__, __LINE__);
-            return -1;
-        }
-        if (dim_element_ids[i] != i)
-        {
-            needs_shuffle = 1;
-        }
-    }
-    if (!needs_shuffle)
-    {
-        /* all ellements are already in the right location, don't do anything */
-        return 0;
-    }
 
     /* Calculate the number of times we have to reshuffle the indices (i.e. the product of the higher dimensions). */
     num_groups = 1;
@@ -423,11 +447,9 @@ int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, lo
     {
         void *variable_data;
 
-        variable_data = realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
+        variable_data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
         if (variable_data == NULL)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %u bytes) (%s:%u)",
-                           new_num_elements * element_size, __FILE__, __LINE__);
             return -1;
         }
 
@@ -504,7 +526,8 @@ int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, lo
             memmove(to_ptr, from_ptr, (size_t)(variable->dimension[dim_index] * filter_block_size));
         }
 
-        /* remove all strings for blocks that will be removed */
+        /* remove all strings for blocks that will be removed
+         * (strings that are part of the string block of the variable are released together with the block) */
         if (variable->data_type == harp_type_string)
         {
             long j;
@@ -519,10 +542,7 @@ int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, lo
                     string_data = (char **)&to_ptr[j * filter_block_size];
                     for (k = 0; k < num_block_elements; k++)
                     {
-                        if (string_data[k] != NULL)
-                        {
-                            free(string_data[k]);
-                        }
+                        harp_variable_free_string(variable, string_data[k]);
                     }
                 }
             }
@@ -602,61 +622,508 @@ int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, lo
                     {
                         char **string_data;
 
-                        /* duplicate all strings in the block */
+                        /* duplicate all strings in the block (strings in the string block can be shared) */
                         string_data = (char **)&to_ptr[to_id * filter_block_size];
                         for (k = 0; k < num_block_elements; k++)
                         {
-                            if (string_data[k] != NULL)
+                            if (share_string(variable, &string_data[k]) != 0)
                             {
-                                string_data[k] = strdup(string_data[k]);
-                                if (string_data[k] == NULL)
-                                {
-                                    free(moved);
-                                    free(buffer);
-                                    free(move_to_id);
-                                    harp_set_error(HARP_ERROR_OUT_OF_MEMORY,
-                                                   "out of memory (could not duplicate string) (%s:%u)", __FILE__,
-                                                   __LINE__);
-                                    return -1;
-                                }
+                                free(moved);
+                                free(buffer);
+                                free(move_to_id);
+                                return -1;
                             }
                         }
                     }
                 }
                 else
                 {
-                    memcpy(&to_ptr[to_id * filter_block_size], &to_ptr[from_id * filter_block_size],
-                           (size_t)filter_block_size);
-                    moved[from_id] = 1;
+                    memcpy(&to_ptr[to_id * filter_block_size], &to_ptr[from_id * filter_block_size],
+                           (size_t)filter_block_size);
+                    moved[from_id] = 1;
+                }
+            }
+        }
+
+        i += i_increment;
+    }
+
+    free(moved);
+    free(buffer);
+    free(move_to_id);
+
+    /* if num_dim_elements < dimension[dim_index] then make data block smaller */
+    if (num_dim_elements < variable->dimension[dim_index])
+    {
+        void *variable_data;
+
+        variable_data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
+        if (variable_data == NULL)
+        {
+            return -1;
+        }
+        variable->data.ptr = variable_data;
+    }
+
+    /* update variable properties */
+    variable->num_elements = new_num_elements;
+    variable->dimension[dim_index] = num_dim_elements;
+
+    return 0;
+}
+
+/* Build a gather plan for rearranging a dimension of length source_length according to dim_element_ids. */
+int harp_gather_plan_new(long source_length, long num_dim_elements, const long *dim_element_ids,
+                         harp_gather_plan **new_plan)
+{
+    harp_gather_plan *plan;
+    long num_runs;
+    long i;
+
+    if (num_dim_elements <= 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "num_dim_elements argument <= 0 (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (dim_element_ids == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dim_element_ids argument is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    for (i = 0; i < num_dim_elements; i++)
+    {
+        if (dim_element_ids[i] < 0 || dim_element_ids[i] >= source_length)
+        {
+            harp_set_error(HARP_ERROR_INVALID_ARGUMENT,
+                           "dim_element_ids[%ld] argument (%ld) is not in the range [0,%ld) (%s:%u)", i,
+                           dim_element_ids[i], source_length, __FILE__, __LINE__);
+            return -1;
+        }
+    }
+
+    plan = (harp_gather_plan *)malloc(sizeof(harp_gather_plan));
+    if (plan == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_gather_plan), __FILE__, __LINE__);
+        return -1;
+    }
+    plan->source_length = source_length;
+    plan->target_length = num_dim_elements;
+    plan->source_id = NULL;
+    plan->first_target_id = NULL;
+    plan->num_runs = 0;
+    plan->run = NULL;
+    plan->is_identity = (num_dim_elements == source_length);
+    plan->is_compaction = 1;
+    plan->is_permutation = (num_dim_elements == source_length);
+    plan->num_cycles = 0;
+    plan->cycle_start = NULL;
+
+    plan->source_id = (long *)malloc((size_t)num_dim_elements * sizeof(long));
+    if (plan->source_id == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (size_t)num_dim_elements * sizeof(long), __FILE__, __LINE__);
+        harp_gather_plan_delete(plan);
+        return -1;
+    }
+    memcpy(plan->source_id, dim_element_ids, (size_t)num_dim_elements * sizeof(long));
+
+    plan->first_target_id = (long *)malloc((size_t)source_length * sizeof(long));
+    if (plan->first_target_id == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (size_t)source_length * sizeof(long), __FILE__, __LINE__);
+        harp_gather_plan_delete(plan);
+        return -1;
+    }
+    for (i = 0; i < source_length; i++)
+    {
+        plan->first_target_id[i] = -1;
+    }
+
+    num_runs = 0;
+    for (i = 0; i < num_dim_elements; i++)
+    {
+        if (plan->first_target_id[dim_element_ids[i]] == -1)
+        {
+            plan->first_target_id[dim_element_ids[i]] = i;
+        }
+        else
+        {
+            plan->is_permutation = 0;
+        }
+        if (dim_element_ids[i] != i)
+        {
+            plan->is_identity = 0;
+        }
+        if (i > 0 && dim_element_ids[i] <= dim_element_ids[i - 1])
+        {
+            plan->is_compaction = 0;
+        }
+        if (i == 0 || dim_element_ids[i] != dim_element_ids[i - 1] + 1)
+        {
+            num_runs++;
+        }
+    }
+
+    plan->run = (harp_gather_run *)malloc((size_t)num_runs * sizeof(harp_gather_run));
+    if (plan->run == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (size_t)num_runs * sizeof(harp_gather_run), __FILE__, __LINE__);
+        harp_gather_plan_delete(plan);
+        return -1;
+    }
+    for (i = 0; i < num_dim_elements; i++)
+    {
+        if (i == 0 || dim_element_ids[i] != dim_element_ids[i - 1] + 1)
+        {
+            plan->run[plan->num_runs].source_id = dim_element_ids[i];
+            plan->run[plan->num_runs].target_id = i;
+            plan->run[plan->num_runs].length = 1;
+            plan->num_runs++;
+        }
+        else
+        {
+            plan->run[plan->num_runs - 1].length++;
+        }
+    }
+    assert(plan->num_runs == num_runs);
+
+    if (plan->is_permutation && !plan->is_identity)
+    {
+        uint8_t *visited;
+
+        /* a permutation consists of at most num_dim_elements / 2 cycles of two or more elements */
+        plan->cycle_start = (long *)malloc((size_t)(num_dim_elements / 2) * sizeof(long));
+        if (plan->cycle_start == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (size_t)(num_dim_elements / 2) * sizeof(long), __FILE__, __LINE__);
+            harp_gather_plan_delete(plan);
+            return -1;
+        }
+        visited = (uint8_t *)calloc((size_t)num_dim_elements, sizeof(uint8_t));
+        if (visited == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (size_t)num_dim_elements * sizeof(uint8_t), __FILE__, __LINE__);
+            harp_gather_plan_delete(plan);
+            return -1;
+        }
+        for (i = 0; i < num_dim_elements; i++)
+        {
+            long j = i;
+
+            if (visited[i] || dim_element_ids[i] == i)
+            {
+                continue;
+            }
+            plan->cycle_start[plan->num_cycles] = i;
+            plan->num_cycles++;
+            do
+            {
+                visited[j] = 1;
+                j = dim_element_ids[j];
+            } while (j != i);
+        }
+        free(visited);
+    }
+
+    *new_plan = plan;
+
+    return 0;
+}
+
+void harp_gather_plan_delete(harp_gather_plan *plan)
+{
+    if (plan->source_id != NULL)
+    {
+        free(plan->source_id);
+    }
+    if (plan->first_target_id != NULL)
+    {
+        free(plan->first_target_id);
+    }
+    if (plan->run != NULL)
+    {
+        free(plan->run);
+    }
+    if (plan->cycle_start != NULL)
+    {
+        free(plan->cycle_start);
+    }
+    free(plan);
+}
+
+/* free the strings of all source blocks that do not end up in the rearranged data */
+static void free_unused_strings(const harp_variable *variable, char **string_data, long num_groups,
+                                long num_block_elements, const harp_gather_plan *plan)
+{
+    long i, j, k;
+
+    for (i = 0; i < num_groups; i++)
+    {
+        for (j = 0; j < plan->source_length; j++)
+        {
+            if (plan->first_target_id[j] == -1)
+            {
+                char **block = &string_data[(i * plan->source_length + j) * num_block_elements];
+
+                for (k = 0; k < num_block_elements; k++)
+                {
+                    harp_variable_free_string(variable, block[k]);
+                    block[k] = NULL;
+                }
+            }
+        }
+    }
+}
+
+/* duplicate the strings of all target blocks that are copies of a source block that was already used before */
+static int duplicate_reused_strings(const harp_variable *variable, char **string_data, long num_groups,
+                                    long num_block_elements, const harp_gather_plan *plan)
+{
+    long i, j, k;
+
+    for (i = 0; i < num_groups; i++)
+    {
+        for (j = 0; j < plan->target_length; j++)
+        {
+            if (plan->first_target_id[plan->source_id[j]] != j)
+            {
+                char **block = &string_data[(i * plan->target_length + j) * num_block_elements];
+
+                for (k = 0; k < num_block_elements; k++)
+                {
+                    if (share_string(variable, &block[k]) != 0)
+                    {
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Rearrange the data of a variable in one dimension using a gather plan (see harp_variable_rearrange_dimension()).
+ * The length of the dimension of the variable should equal the source length of the plan.
+ * The same plan can be applied to all variables that depend on the dimension.
+ */
+int harp_variable_rearrange_dimension_with_plan(harp_variable *variable, int dim_index, harp_gather_plan *plan)
+{
+    long new_num_elements;
+    long num_groups;
+    long num_block_elements;
+    long block_size;
+    long i, j;
+
+    if (variable == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (dim_index < 0 || dim_index >= variable->num_dimensions)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dim_index argument (%d) is not in the range [0,%d) (%s:%u)",
+                       dim_index, variable->num_dimensions, __FILE__, __LINE__);
+        return -1;
+    }
+    if (variable->dimension[dim_index] != plan->source_length)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dimension length (%ld) of variable '%s' does not match length "
+                       "(%ld) of rearrangement (%s:%u)", variable->dimension[dim_index], variable->name,
+                       plan->source_length, __FILE__, __LINE__);
+        return -1;
+    }
+    if (variable->num_elements == 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "cannot reshape variable '%s' (variable has 0 elements) (%s:%u)",
+                       variable->name, __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (plan->is_identity)
+    {
+        /* all elements are already in the right location, don't do anything */
+        return 0;
+    }
+
+    num_groups = 1;
+    for (i = 0; i < dim_index; i++)
+    {
+        num_groups *= variable->dimension[i];
+    }
+    num_block_elements = variable->num_elements / (num_groups * plan->source_length);
+    new_num_elements = num_groups * plan->target_length * num_block_elements;
+    block_size = num_block_elements * harp_get_size_for_type(variable->data_type);
+
+    if (plan->is_compaction)
+    {
+        /* elements are only removed, so all runs can be moved forward within the existing data block */
+        if (variable->data_type == harp_type_string)
+        {
+            free_unused_strings(variable, variable->data.string_data, num_groups, num_block_elements, plan);
+        }
+        for (i = 0; i < num_groups; i++)
+        {
+            char *from_ptr = (char *)variable->data.ptr + i * plan->source_length * block_size;
+            char *to_ptr = (char *)variable->data.ptr + i * plan->target_length * block_size;
+
+            for (j = 0; j < plan->num_runs; j++)
+            {
+                const harp_gather_run *run = &plan->run[j];
+
+                if (to_ptr != from_ptr || run->target_id != run->source_id)
+                {
+                    memmove(&to_ptr[run->target_id * block_size], &from_ptr[run->source_id * block_size],
+                            (size_t)(run->length * block_size));
+                }
+            }
+        }
+        if (new_num_elements < variable->num_elements)
+        {
+            void *variable_data;
+
+            variable_data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements *
+                                                harp_get_size_for_type(variable->data_type));
+            if (variable_data == NULL)
+            {
+                return -1;
+            }
+            variable->data.ptr = variable_data;
+        }
+    }
+    else if (plan->is_permutation)
+    {
+        char *block;
+
+        /* each element is only moved, so follow the cycles of the permutation within the existing data block (this
+         * also holds for strings, since each string still ends up in exactly one element) */
+        block = malloc((size_t)block_size);
+        if (block == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           (size_t)block_size, __FILE__, __LINE__);
+            return -1;
+        }
+        for (i = 0; i < num_groups; i++)
+        {
+            char *ptr = (char *)variable->data.ptr + i * plan->source_length * block_size;
+
+            for (j = 0; j < plan->num_cycles; j++)
+            {
+                long target_id = plan->cycle_start[j];
+
+                memcpy(block, &ptr[target_id * block_size], (size_t)block_size);
+                while (plan->source_id[target_id] != plan->cycle_start[j])
+                {
+                    memcpy(&ptr[target_id * block_size], &ptr[plan->source_id[target_id] * block_size],
+                           (size_t)block_size);
+                    target_id = plan->source_id[target_id];
                 }
+                memcpy(&ptr[target_id * block_size], block, (size_t)block_size);
             }
         }
-
-        i += i_increment;
+        free(block);
     }
-
-    free(moved);
-    free(buffer);
-    free(move_to_id);
-
-    /* if num_dim_elements < dimension[dim_index] then make data block smaller */
-    if (num_dim_elements < variable->dimension[dim_index])
+    else
     {
-        void *variable_data;
+        size_t data_size = (size_t)new_num_elements * harp_get_size_for_type(variable->data_type);
+        int64_t available;
+        char *data;
 
-        variable_data = realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
-        if (variable_data == NULL)
+        available = harp_memory_get_available();
+        if (available >= 0 && available < (int64_t)data_size)
+        {
+            /* not enough memory for a second copy of the data, so rearrange the data in place */
+            return rearrange_dimension_in_place(variable, dim_index, plan->target_length, plan->source_id);
+        }
+        data = harp_memory_alloc(data_size);
+        if (data == NULL)
         {
-            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %u bytes) (%s:%u)",
-                           new_num_elements * element_size, __FILE__, __LINE__);
             return -1;
         }
-        variable->data.ptr = variable_data;
+        for (i = 0; i < num_groups; i++)
+        {
+            char *from_ptr = (char *)variable->data.ptr + i * plan->source_length * block_size;
+            char *to_ptr = data + i * plan->target_length * block_size;
+
+            for (j = 0; j < plan->num_runs; j++)
+            {
+                const harp_gather_run *run = &plan->run[j];
+
+                memcpy(&to_ptr[run->target_id * block_size], &from_ptr[run->source_id * block_size],
+                       (size_t)(run->length * block_size));
+            }
+        }
+        if (variable->data_type == harp_type_string)
+        {
+            if (duplicate_reused_strings(variable, (char **)data, num_groups, num_block_elements, plan) != 0)
+            {
+                harp_memory_free(data);
+                return -1;
+            }
+            free_unused_strings(variable, variable->data.string_data, num_groups, num_block_elements, plan);
+        }
+        harp_memory_free(variable->data.ptr);
+        variable->data.ptr = data;
     }
 
     /* update variable properties */
     variable->num_elements = new_num_elements;
-    variable->dimension[dim_index] = num_dim_elements;
+    variable->dimension[dim_index] = plan->target_length;
+
+    return 0;
+}
+
+/** Rearrange the data of a variable in one dimension.
+ * This function allows data of a variable to be rearranged according to the order of the indices in dim_element_id.
+ * The number of indices (num_dim_elements) in dim_element_id does not have to correspond to the number of
+ * elements in the specified (dim_index) dimension. This means that the data block will grow/shrink when the amount of
+ * elements in dim_element_id is larger/smaller (note that the amount of elements can only become larger if elements
+ * are duplicated).
+ *
+ * \param variable Pointer to variable that should have its data rearranged.
+ * \param dim_index The id of the dimension in which the rearrangement should take place.
+ * \param num_dim_elements Number of elements in dim_element_id.
+ * \param dim_element_ids An array containing the ids in dimension dim_index in the new arrangement (ids may occur more
+ * than once and the number of ids may be smaller or larger than the length of dimension dim_index).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+int harp_variable_rearrange_dimension(harp_variable *variable, int dim_index, long num_dim_elements,
+                                      const long *dim_element_ids)
+{
+    harp_gather_plan *plan;
+
+    if (variable == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (dim_index < 0 || dim_index >= variable->num_dimensions)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dim_index argument (%d) is not in the range [0,%d) (%s:%u)",
+                       dim_index, variable->num_dimensions, __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (harp_gather_plan_new(variable->dimension[dim_index], num_dim_elements, dim_element_ids, &plan) != 0)
+    {
+        return -1;
+    }
+    if (harp_variable_rearrange_dimension_with_plan(variable, dim_index, plan) != 0)
+    {
+        harp_gather_plan_delete(plan);
+        return -1;
+    }
+    harp_gather_plan_delete(plan);
 
     return 0;
 }
@@ -776,21 +1243,16 @@ int harp_variable_filter_dimension(harp_variable *variable, int dim_index, const
 
                     for (k = 0; k < num_block_elements; k++)
                     {
-                        if (string_data[k] != NULL)
-                        {
-                            free(string_data[k]);
-                        }
+                        harp_variable_free_string(variable, string_data[k]);
                     }
                 }
             }
         }
     }
 
-    variable_data = realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
+    variable_data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
     if (variable_data == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %u bytes) (%s:%u)",
-                       new_num_elements * element_size, __FILE__, __LINE__);
         return -1;
     }
     variable->data.ptr = variable_data;
@@ -870,10 +1332,7 @@ int harp_variable_resize_dimension(harp_variable *variable, int dim_index, long
                 /* remove trailing strings */
                 for (j = length * num_block_elements; j < variable->dimension[dim_index] * num_block_elements; j++)
                 {
-                    if (variable->data.string_data[from_offset + j] != NULL)
-                    {
-                        free(variable->data.string_data[from_offset + j]);
-                    }
+                    harp_variable_free_string(variable, variable->data.string_data[from_offset + j]);
                 }
             }
 
@@ -886,12 +1345,9 @@ int harp_variable_resize_dimension(harp_variable *variable, int dim_index, long
         }
     }
 
-    data = realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
+    data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
     if (data == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY,
-                       "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       (size_t)new_num_elements * element_size, __FILE__, __LINE__);
         return -1;
     }
     variable->data.ptr = data;
@@ -1035,11 +1491,9 @@ int harp_variable_add_dimension(harp_variable *variable, int dim_index, harp_dim
 
     new_num_elements = num_blocks * length * num_block_elements;
 
-    data = realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
+    data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
     if (data == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       (size_t)new_num_elements * element_size, __FILE__, __LINE__);
         return -1;
     }
     variable->data.ptr = data;
@@ -1065,15 +1519,9 @@ int harp_variable_add_dimension(harp_variable *variable, int dim_index, harp_dim
                 /* duplicate all strings in the block (except for the first block) */
                 for (k = 0; k < num_block_elements; k++)
                 {
-                    if (string_data[k] != NULL)
+                    if (share_string(variable, &string_data[k]) != 0)
                     {
-                        string_data[k] = strdup(string_data[k]);
-                        if (string_data[k] == NULL)
-                        {
-                            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string)"
-                                           " (%s:%u)", __FILE__, __LINE__);
-                            return -1;
-                        }
+                        return -1;
                     }
                 }
             }
@@ -1122,24 +1570,123 @@ int harp_variable_remove_dimension(harp_variable *variable, int dim_index, long
     return 0;
 }
 
-/** \addtogroup harp_variable
- * @{
+/* Returns 1 if the given variable has the vertical dimension directly following the time dimension, i.e. if its
+ * vertical profiles can be stored as ragged arrays, 0 otherwise.
  */
+int harp_variable_has_ragged_vertical_layout(const harp_variable *variable)
+{
+    return variable->num_dimensions >= 2 && variable->dimension_type[0] == harp_dimension_time &&
+        variable->dimension_type[1] == harp_dimension_vertical;
+}
 
-/** Create new variable.
- * \param name Name of the variable.
- * \param data_type Storage type of the variable data.
- * \param num_dimensions Number of array dimensions (use '0' for scalar data).
- * \param dimension_type Array with the dimension type for each of the dimensions.
- * \param dimension Array with length for each of the dimensions.
- * \param new_variable Pointer to the C variable where the new HARP variable will be stored.
- * \return
- *   \arg \c 0, Success.
- *   \arg \c -1, Error occurred (check #harp_errno).
+/* Copy the first vertical_count[i] levels of each time sample i of a variable for which
+ * harp_variable_has_ragged_vertical_layout() holds into a newly allocated contiguous ragged array.
+ * The packed array should be released with free(); strings are not duplicated.
  */
-LIBHARP_API int harp_variable_new(const char *name, harp_data_type data_type, int num_dimensions,
-                                  const harp_dimension_type *dimension_type, const long *dimension,
-                                  harp_variable **new_variable)
+int harp_variable_pack_ragged_vertical(const harp_variable *variable, const long *vertical_count, harp_array *packed,
+                                       long *num_elements)
+{
+    long num_time = variable->dimension[0];
+    long num_vertical = variable->dimension[1];
+    long element_size = harp_get_size_for_type(variable->data_type);
+    long block_size;
+    long i;
+
+    packed->ptr = malloc((variable->num_elements + 1) * element_size);
+    if (packed->ptr == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       (variable->num_elements + 1) * element_size, __FILE__, __LINE__);
+        return -1;
+    }
+
+    *num_elements = 0;
+    if (variable->num_elements == 0)
+    {
+        return 0;
+    }
+    block_size = variable->num_elements / (num_time * num_vertical);
+    for (i = 0; i < num_time; i++)
+    {
+        memcpy(&((char *)packed->ptr)[*num_elements * element_size],
+               &((char *)variable->data.ptr)[i * num_vertical * block_size * element_size],
+               vertical_count[i] * block_size * element_size);
+        *num_elements += vertical_count[i] * block_size;
+    }
+
+    return 0;
+}
+
+/* Distribute vertical profiles that were stored as a contiguous ragged array over the (padded) data of num_time time
+ * samples of the variable (the vertical count of the first time sample is vertical_count[0]).
+ * The padding levels are set to NaN for floating point data, 0 for integer data, and empty strings. If empty_string
+ * is not NULL the padding strings point to empty_string, otherwise each padding string is allocated separately.
+ * Ownership of the strings in the packed array is transferred to the variable data.
+ */
+int harp_variable_unpack_ragged_vertical(const harp_variable *variable, long num_time, harp_array packed,
+                                         const long *vertical_count, char *empty_string, harp_array data)
+{
+    long num_vertical = variable->dimension[1];
+    long element_size = harp_get_size_for_type(variable->data_type);
+    long block_size;
+    long offset = 0;
+    long i, j;
+
+    if (variable->num_elements == 0)
+    {
+        return 0;
+    }
+    block_size = variable->num_elements / (variable->dimension[0] * num_vertical);
+
+    for (i = 0; i < num_time; i++)
+    {
+        long num_packed = vertical_count[i] * block_size;
+
+        memcpy(&((char *)data.ptr)[i * num_vertical * block_size * element_size],
+               &((char *)packed.ptr)[offset * element_size], num_packed * element_size);
+        offset += num_packed;
+    }
+
+    for (i = 0; i < num_time; i++)
+    {
+        for (j = (i * num_vertical + vertical_count[i]) * block_size; j < (i + 1) * num_vertical * block_size; j++)
+        {
+            switch (variable->data_type)
+            {
+                case harp_type_float:
+                    data.float_data[j] = (float)harp_nan();
+                    break;
+                case harp_type_double:
+                    data.double_data[j] = harp_nan();
+                    break;
+                case harp_type_string:
+                    if (empty_string != NULL)
+                    {
+                        data.string_data[j] = empty_string;
+                        break;
+                    }
+                    data.string_data[j] = strdup("");
+                    if (data.string_data[j] == NULL)
+                    {
+                        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)",
+                                       __FILE__, __LINE__);
+                        return -1;
+                    }
+                    break;
+                default:
+                    /* the data is not necessarily initialized (e.g. for deferred variables) */
+                    memset(&((char *)data.ptr)[j * element_size], 0, element_size);
+                    break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int variable_new(const char *name, harp_data_type data_type, int num_dimensions,
+                        const harp_dimension_type *dimension_type, const long *dimension, int with_data,
+                        harp_variable **new_variable)
 {
     harp_variable *variable;
     int i;
@@ -1189,11 +1736,9 @@ LIBHARP_API int harp_variable_new(const char *name, harp_data_type data_type, in
         }
     }
 
-    variable = (harp_variable *)malloc(sizeof(harp_variable));
+    variable = variable_alloc();
     if (variable == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       sizeof(harp_variable), __FILE__, __LINE__);
         return -1;
     }
     variable->name = NULL;
@@ -1222,15 +1767,16 @@ LIBHARP_API int harp_variable_new(const char *name, harp_data_type data_type, in
         return -1;
     }
 
-    variable->data.ptr = malloc((size_t)variable->num_elements * harp_get_size_for_type(data_type));
-    if (variable->data.ptr == NULL)
+    if (with_data)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       variable->num_elements * harp_get_size_for_type(data_type), __FILE__, __LINE__);
-        harp_variable_delete(variable);
-        return -1;
+        variable->data.ptr = harp_memory_alloc((size_t)variable->num_elements * harp_get_size_for_type(data_type));
+        if (variable->data.ptr == NULL)
+        {
+            harp_variable_delete(variable);
+            return -1;
+        }
+        memset(variable->data.ptr, 0, (size_t)variable->num_elements * harp_get_size_for_type(data_type));
     }
-    memset(variable->data.ptr, 0, (size_t)variable->num_elements * harp_get_size_for_type(data_type));
 
     if (data_type != harp_type_string)
     {
@@ -1242,6 +1788,39 @@ LIBHARP_API int harp_variable_new(const char *name, harp_data_type data_type, in
     return 0;
 }
 
+/* Create a new variable without allocating a data buffer (data.ptr will be NULL).
+ * This is used for deferred imports, where the data of a variable is only read when it is needed. Such a variable
+ * will not pass harp_variable_verify() until a data buffer (allocated with harp_memory_alloc()) has been attached.
+ */
+int harp_variable_new_without_data(const char *name, harp_data_type data_type, int num_dimensions,
+                                   const harp_dimension_type *dimension_type, const long *dimension,
+                                   harp_variable **new_variable)
+{
+    return variable_new(name, data_type, num_dimensions, dimension_type, dimension, 0, new_variable);
+}
+
+/** \addtogroup harp_variable
+ * @{
+ */
+
+/** Create new variable.
+ * \param name Name of the variable.
+ * \param data_type Storage type of the variable data.
+ * \param num_dimensions Number of array dimensions (use '0' for scalar data).
+ * \param dimension_type Array with the dimension type for each of the dimensions.
+ * \param dimension Array with length for each of the dimensions.
+ * \param new_variable Pointer to the C variable where the new HARP variable will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_variable_new(const char *name, harp_data_type data_type, int num_dimensions,
+                                  const harp_dimension_type *dimension_type, const long *dimension,
+                                  harp_variable **new_variable)
+{
+    return variable_new(name, data_type, num_dimensions, dimension_type, dimension, 1, new_variable);
+}
+
 /** Delete variable.
  * Remove variable and all attached attributes.
  * \param variable HARP variable
@@ -1264,14 +1843,12 @@ LIBHARP_API void harp_variable_delete(harp_variable *variable)
 
             for (i = 0; i < variable->num_elements; i++)
             {
-                if (variable->data.string_data[i] != NULL)
-                {
-                    free(variable->data.string_data[i]);
-                }
+                harp_variable_free_string(variable, variable->data.string_data[i]);
             }
         }
-        free(variable->data.ptr);
+        harp_memory_free(variable->data.ptr);
     }
+    harp_variable_set_string_block(variable, NULL);
     if (variable->description != NULL)
     {
         free(variable->description);
@@ -1297,6 +1874,54 @@ LIBHARP_API void harp_variable_delete(harp_variable *variable)
     free(variable);
 }
 
+/** Detach the data buffer from a variable.
+ * Ownership of the data buffer of a numeric variable is transferred to the caller, which avoids a copy when the data
+ * needs to outlive the variable (e.g. in a language binding). The returned buffer should be released using
+ * harp_variable_data_delete(). After this call the variable no longer has any data and the only valid operation on
+ * the variable is harp_variable_delete().
+ * Detaching the data of a string variable is not supported.
+ * \param variable HARP variable.
+ * \param data Pointer to the C variable where the pointer to the data buffer will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_variable_detach_data(harp_variable *variable, void **data)
+{
+    if (variable == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (data == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "data is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (variable->data_type == harp_type_string)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "cannot detach data of variable '%s' of type '%s' (%s:%u)",
+                       variable->name, harp_get_data_type_name(variable->data_type), __FILE__, __LINE__);
+        return -1;
+    }
+
+    *data = variable->data.ptr;
+    variable->data.ptr = NULL;
+
+    return 0;
+}
+
+/** Delete a data buffer that was detached from a variable.
+ * \param data Data buffer as returned by harp_variable_detach_data().
+ */
+LIBHARP_API void harp_variable_data_delete(void *data)
+{
+    if (data != NULL)
+    {
+        harp_memory_free(data);
+    }
+}
+
 /** Create a copy of a variable.
  * The function will create a deep-copy of the given HARP variable, also creating copyies of all attributes.
  * \param other_variable Variable that should be copied.
@@ -1310,11 +1935,9 @@ LIBHARP_API int harp_variable_copy(const harp_variable *other_variable, harp_var
     harp_variable *variable;
     long i;
 
-    variable = (harp_variable *)malloc(sizeof(harp_variable));
+    variable = variable_alloc();
     if (variable == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       sizeof(harp_variable), __FILE__, __LINE__);
         return -1;
     }
     variable->name = NULL;
@@ -1391,28 +2014,26 @@ LIBHARP_API int harp_variable_copy(const harp_variable *other_variable, harp_var
         }
     }
 
-    variable->data.ptr = malloc((size_t)variable->num_elements * harp_get_size_for_type(variable->data_type));
+    variable->data.ptr = harp_memory_alloc((size_t)variable->num_elements *
+                                           harp_get_size_for_type(variable->data_type));
     if (variable->data.ptr == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       variable->num_elements * harp_get_size_for_type(variable->data_type), __FILE__, __LINE__);
         harp_variable_delete(variable);
         return -1;
     }
     if (variable->data_type == harp_type_string)
     {
         memset(variable->data.ptr, 0, (size_t)variable->num_elements * harp_get_size_for_type(harp_type_string));
-        for (i = 0; i < variable->num_elements; i++)
+        char *string_block;
+
+        /* the copies of the strings are stored in a single block of memory that is owned by the variable */
+        if (harp_string_array_copy(variable->num_elements, other_variable->data.string_data,
+                                   variable->data.string_data, &string_block) != 0)
         {
-            variable->data.string_data[i] = strdup(other_variable->data.string_data[i]);
-            if (variable->data.string_data[i] == NULL)
-            {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
-                               __LINE__);
-                harp_variable_delete(variable);
-                return -1;
-            }
+            harp_variable_delete(variable);
+            return -1;
         }
+        harp_variable_set_string_block(variable, string_block);
     }
     else
     {
@@ -1516,28 +2137,62 @@ LIBHARP_API int harp_variable_append(harp_variable *variable, const harp_variabl
 
     element_size = harp_get_size_for_type(variable->data_type);
     new_num_elements = variable->num_elements + other_variable->num_elements;
-    data = realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
+    data = harp_memory_realloc(variable->data.ptr, (size_t)new_num_elements * element_size);
     if (data == NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                       (size_t)new_num_elements * element_size, __FILE__, __LINE__);
         return -1;
     }
     variable->data.ptr = data;
 
     if (variable->data_type == harp_type_string)
     {
-        memset(&variable->data.string_data[variable->num_elements], 0,
-               (size_t)other_variable->num_elements * element_size);
-        for (i = 0; i < other_variable->num_elements; i++)
+        if (((harp_variable_private *)variable)->string_block != NULL)
         {
-            variable->data.string_data[variable->num_elements + i] = strdup(other_variable->data.string_data[i]);
-            if (variable->data.string_data[variable->num_elements + i] == NULL)
+            char **string_data;
+            char *string_block;
+
+            /* store the existing and the appended strings together in a new string block */
+            string_data = malloc((size_t)new_num_elements * element_size);
+            if (string_data == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
-                               __LINE__);
+                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                               (size_t)new_num_elements * element_size, __FILE__, __LINE__);
+                return -1;
+            }
+            memcpy(string_data, variable->data.string_data, (size_t)variable->num_elements * element_size);
+            memcpy(&string_data[variable->num_elements], other_variable->data.string_data,
+                   (size_t)other_variable->num_elements * element_size);
+            if (harp_string_array_copy(new_num_elements, string_data, string_data, &string_block) != 0)
+            {
+                free(string_data);
                 return -1;
             }
+            for (i = 0; i < variable->num_elements; i++)
+            {
+                harp_variable_free_string(variable, variable->data.string_data[i]);
+            }
+            memcpy(variable->data.string_data, string_data, (size_t)new_num_elements * element_size);
+            free(string_data);
+            harp_variable_set_string_block(variable, string_block);
+        }
+        else
+        {
+            memset(&variable->data.string_data[variable->num_elements], 0,
+                   (size_t)other_variable->num_elements * element_size);
+            for (i = 0; i < other_variable->num_elements; i++)
+            {
+                if (other_variable->data.string_data[i] != NULL)
+                {
+                    variable->data.string_data[variable->num_elements + i] =
+                        strdup(other_variable->data.string_data[i]);
+                    if (variable->data.string_data[variable->num_elements + i] == NULL)
+                    {
+                        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)",
+                                       __FILE__, __LINE__);
+                        return -1;
+                    }
+                }
+            }
         }
     }
     else
@@ -1810,10 +2465,9 @@ LIBHARP_API int harp_variable_set_string_data_element(harp_variable *variable, l
         return -1;
     }
 
-    if (variable->data.string_data[index] != NULL)
-    {
-        free(variable->data.string_data[index]);
-    }
+    /* only the string that is replaced is released (a string that is part of the string block of the variable is
+     * released together with the block); the new string is allocated individually */
+    harp_variable_free_string(variable, variable->data.string_data[index]);
 
     variable->data.string_data[index] = strdup(str);
 
@@ -1880,11 +2534,9 @@ LIBHARP_API int harp_variable_convert_data_type(harp_variable *variable, harp_da
     switch (target_data_type)
     {
         case harp_type_int8:
-            data.ptr = malloc((size_t)variable->num_elements * sizeof(int8_t));
+            data.ptr = harp_memory_alloc((size_t)variable->num_elements * sizeof(int8_t));
             if (data.ptr == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               variable->num_elements * sizeof(int8_t), __FILE__, __LINE__);
                 return -1;
             }
             switch (variable->data_type)
@@ -1983,11 +2635,9 @@ LIBHARP_API int harp_variable_convert_data_type(harp_variable *variable, harp_da
             }
             break;
         case harp_type_int16:
-            data.ptr = malloc((size_t)variable->num_elements * sizeof(int16_t));
+            data.ptr = harp_memory_alloc((size_t)variable->num_elements * sizeof(int16_t));
             if (data.ptr == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               variable->num_elements * sizeof(int16_t), __FILE__, __LINE__);
                 return -1;
             }
             switch (variable->data_type)
@@ -2072,11 +2722,9 @@ LIBHARP_API int harp_variable_convert_data_type(harp_variable *variable, harp_da
             }
             break;
         case harp_type_int32:
-            data.ptr = malloc((size_t)variable->num_elements * sizeof(int32_t));
+            data.ptr = harp_memory_alloc((size_t)variable->num_elements * sizeof(int32_t));
             if (data.ptr == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               variable->num_elements * sizeof(int32_t), __FILE__, __LINE__);
                 return -1;
             }
             switch (variable->data_type)
@@ -2147,11 +2795,9 @@ LIBHARP_API int harp_variable_convert_data_type(harp_variable *variable, harp_da
             }
             break;
         case harp_type_float:
-            data.ptr = malloc((size_t)variable->num_elements * sizeof(float));
+            data.ptr = harp_memory_alloc((size_t)variable->num_elements * sizeof(float));
             if (data.ptr == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               variable->num_elements * sizeof(float), __FILE__, __LINE__);
                 return -1;
             }
             switch (variable->data_type)
@@ -2208,11 +2854,9 @@ LIBHARP_API int harp_variable_convert_data_type(harp_variable *variable, harp_da
             }
             break;
         case harp_type_double:
-            data.ptr = malloc((size_t)variable->num_elements * sizeof(double));
+            data.ptr = harp_memory_alloc((size_t)variable->num_elements * sizeof(double));
             if (data.ptr == NULL)
             {
-                harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
-                               variable->num_elements * sizeof(double), __FILE__, __LINE__);
                 return -1;
             }
             switch (variable->data_type)
@@ -2259,7 +2903,7 @@ LIBHARP_API int harp_variable_convert_data_type(harp_variable *variable, harp_da
             exit(1);
     }
 
-    free(variable->data.ptr);
+    harp_memory_free(variable->data.ptr);
     variable->data.ptr = data.ptr;
     variable->data_type = target_data_type;
 
@@ -30,6 +30,8 @@
  */
 
 #include "harp-internal.h"
+#include "harp-ingestion.h"
+#include "harp-program.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -55,6 +57,9 @@ int harp_option_enable_aux_afgl86 = 0;
 int harp_option_enable_aux_usstd76 = 0;
 int harp_option_hdf5_compression = 0;
 int harp_option_regrid_out_of_bounds = 0;
+int harp_option_ragged_vertical = 0;
+int64_t harp_option_memory_limit = 0;
+int harp_option_test_num_workers = 1;
 
 typedef enum file_format_enum
 {
@@ -446,6 +451,117 @@ LIBHARP_API int harp_get_option_regrid_out_of_bounds(void)
     return harp_option_regrid_out_of_bounds;
 }
 
+/** Enable/Disable storage of vertical profiles as ragged arrays when exporting to netCDF or HDF5.
+ * When enabled, variables that have the vertical dimension directly following the time dimension are stored using the
+ * CF contiguous ragged array representation. For each time sample only the vertical levels up to the last level that
+ * contains data (for any of these variables) are stored, together with a per-sample count variable. Trailing levels
+ * that only contain fill values (NaN for floating point data, 0 for integer data, and empty strings) are treated as
+ * padding and will not be written.
+ * The padding is restored when the product is imported again, so the imported product will be equal to the original.
+ * By default ragged storage is disabled.
+ * \param enable
+ *   \arg 0: Store vertical profiles padded to the full vertical dimension length.
+ *   \arg 1: Store vertical profiles as ragged arrays.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_set_option_ragged_vertical(int enable)
+{
+    if (enable != 0 && enable != 1)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "enable argument (%d) is not valid (%s:%u)", enable, __FILE__,
+                       __LINE__);
+        return -1;
+    }
+
+    harp_option_ragged_vertical = enable;
+
+    return 0;
+}
+
+/** Retrieve the current setting for storing vertical profiles as ragged arrays.
+ * \see harp_set_option_ragged_vertical()
+ * \return
+ *   \arg \c 0, Vertical profiles are stored padded.
+ *   \arg \c 1, Vertical profiles are stored as ragged arrays.
+ */
+LIBHARP_API int harp_get_option_ragged_vertical(void)
+{
+    return harp_option_ragged_vertical;
+}
+
+/** Set the maximum amount of memory that HARP may use for the data of variables.
+ * When an allocation would make the total amount of variable data that is in memory exceed this limit, the operation
+ * that requested the memory will fail with a #HARP_ERROR_OUT_OF_MEMORY error (instead of the application running out
+ * of system memory). Only memory that is allocated via the HARP memory allocator (see harp_set_memory_allocator())
+ * is counted. The current usage can be retrieved using harp_get_memory_usage().
+ * By default there is no memory limit.
+ * The limit is checked against process wide counters that are updated without locking, so it can only be relied upon
+ * if HARP is used from a single thread at a time.
+ * \param limit Maximum number of bytes, or 0 to disable the memory limit.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_set_option_memory_limit(int64_t limit)
+{
+    if (limit < 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "limit argument (%ld) is not valid (%s:%u)", (long)limit,
+                       __FILE__, __LINE__);
+        return -1;
+    }
+
+    harp_option_memory_limit = limit;
+
+    return 0;
+}
+
+/** Retrieve the current memory limit.
+ * \see harp_set_option_memory_limit()
+ * \return Maximum number of bytes that can be used for variable data (0 means that there is no limit).
+ */
+LIBHARP_API int64_t harp_get_option_memory_limit(void)
+{
+    return harp_option_memory_limit;
+}
+
+/** Set the number of worker processes that are used to test the ingestion options of a product.
+ * harp_import_test() tests the ingestion of a product for all possible combinations of ingestion options. When more
+ * than one worker is used, the combinations are tested concurrently, each in a separate process. The module detection
+ * and opening of the product are performed only once and are shared with the worker processes. The results are always
+ * printed in the same order as when the combinations are tested sequentially.
+ * On Windows the combinations are always tested sequentially.
+ * By default a single worker is used (i.e. sequential testing).
+ * \param num_workers Maximum number of combinations that are tested concurrently (should be >= 1).
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_set_option_test_num_workers(int num_workers)
+{
+    if (num_workers < 1)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "num_workers argument (%d) is not valid (%s:%u)", num_workers,
+                       __FILE__, __LINE__);
+        return -1;
+    }
+
+    harp_option_test_num_workers = num_workers;
+
+    return 0;
+}
+
+/** Retrieve the number of worker processes that are used to test the ingestion options of a product.
+ * \see harp_set_option_test_num_workers()
+ * \return Maximum number of combinations of ingestion options that are tested concurrently.
+ */
+LIBHARP_API int harp_get_option_test_num_workers(void)
+{
+    return harp_option_test_num_workers;
+}
+
 /** Initializes the HARP C library.
  * This function should be called before any other HARP C library function is called (except for
  * harp_set_coda_definition_path(), harp_set_coda_definition_path_conditional(), and harp_set_warning_handler()).
@@ -461,6 +577,9 @@ LIBHARP_API int harp_get_option_regrid_out_of_bounds(void)
  * If you use CODA functions directly in combination with HARP functions you should call coda_init() and coda_done()
  * explictly yourself and not rely on HARP having performed the coda_init() for you.
  *
+ * If the HARP_TRACE environment variable is set then the first call to harp_init() will start tracing to the file
+ * that is referenced by this environment variable (see harp_trace_start()).
+ *
  * It is valid to perform multiple calls to harp_init() after each other. Only the first call to harp_init() will do
  * the actual initialization and all following calls to harp_init() will only increase an initialization counter. Each
  * call to harp_init() needs to be matched by a call to harp_done() at clean-up time (i.e. the number of calls to
@@ -479,6 +598,10 @@ LIBHARP_API int harp_init(void)
         {
             return -1;
         }
+        if (harp_trace_init() != 0)
+        {
+            return -1;
+        }
     }
 
     harp_init_counter++;
@@ -507,148 +630,102 @@ LIBHARP_API void harp_done(void)
             harp_unit_done();
             harp_derived_variable_list_done();
             harp_ingestion_done();
+            harp_trace_stop();
         }
     }
 }
 
 /** @} */
 
-/** Import a product from a file.
- * \ingroup harp_product
- * This will first try to import the file as an HDF4, HDF5, or netCDF file that complies to the HARP Data Format.
- * If the file is not stored using the HARP format then it will try to import it using one of the available ingestion
- * modules.
- * The \a options parameter is optional (can be NULL) and describes the ingestion options. The parameter is only
- * applicable if the file is not already using the HARP format and needs to be converted using one of the ingestion
- * modules.
- * The \a operations parameter is optional (can be NULL) and provides the list of operations that will be performed as
- * part of the import. Some operations, such as filters, can already be performed as part of an import and this may thus
- * be faster than using a harp_product_execute_operations() after a full import of the product.
- * \param[in] filename Path to the file that is to be imported.
- * \param[in] operations string (optional) containing actions to apply as part of the import; should be specified as a
- * semi-colon separated string of operations.
- * \param[in] options Ingestion module specific options (optional); should be specified as a semi-colon separated
- * string of key=value pair; only used if the file is not in HARP format.
- * \param[out] product Pointer to a location where a pointer to the ingested product will be stored.
- * \return
- *   \arg \c 0, Success.
- *   \arg \c -1, Error occurred (check #harp_errno).
- */
-LIBHARP_API int harp_import(const char *filename, const char *operations, const char *options, harp_product **product)
+struct harp_import_session_struct
 {
-    harp_product *imported_product;
-    file_format format;
-    int result;
+    harp_program *program;      /* parsed operations */
+    char *options;      /* ingestion options (can be NULL) */
+    harp_ingestion_session *ingestion_session;  /* created when the first non-HARP product is imported */
+};
 
-    if (determine_file_format(filename, &format) != 0)
+static void import_session_delete(harp_import_session *session)
+{
+    if (session != NULL)
     {
-        return -1;
+        harp_ingestion_session_delete(session->ingestion_session);
+        harp_program_delete(session->program);
+        if (session->options != NULL)
+        {
+            free(session->options);
+        }
+        free(session);
     }
+}
 
-    switch (format)
+static int import_session_new(const char *operations, const char *options, harp_import_session **new_session)
+{
+    harp_import_session *session;
+
+    session = (harp_import_session *)malloc(sizeof(harp_import_session));
+    if (session == NULL)
     {
-        case format_hdf4:
-#ifdef HAVE_HDF4
-            result = harp_import_hdf4(filename, &imported_product);
-#else
-            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
-            result = -1;
-#endif
-            break;
-        case format_hdf5:
-#ifdef HAVE_HDF5
-            result = harp_import_hdf5(filename, &imported_product);
-#else
-            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
-            result = -1;
-#endif
-            break;
-        case format_netcdf:
-            result = harp_import_netcdf(filename, &imported_product);
-            break;
-        default:
-            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
-            result = -1;
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_import_session), __FILE__, __LINE__);
+        return -1;
     }
+    session->program = NULL;
+    session->options = NULL;
+    session->ingestion_session = NULL;
 
-    if (result != 0)
+    if (operations == NULL)
     {
-        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
-        {
-            return -1;
-        }
-
-        /* try ingest */
-        if (harp_ingest(filename, operations, options, &imported_product) != 0)
+        if (harp_program_new(&session->program) != 0)
         {
+            import_session_delete(session);
             return -1;
         }
     }
     else
     {
-        if (harp_product_verify(imported_product) != 0)
+        if (harp_program_from_string(operations, &session->program) != 0)
         {
-            harp_product_delete(imported_product);
+            import_session_delete(session);
             return -1;
         }
+    }
 
-        /* set source_product if it was empty; we need this for the 'collocate_xxx()' operations to work */
-        if (imported_product->source_product == NULL)
-        {
-            if (harp_product_set_source_product(imported_product, filename) != 0)
-            {
-                harp_product_delete(imported_product);
-                return -1;
-            }
-        }
-
-        if (operations != NULL)
+    if (options != NULL)
+    {
+        session->options = strdup(options);
+        if (session->options == NULL)
         {
-            if (harp_product_execute_operations(imported_product, operations) != 0)
-            {
-                harp_product_delete(imported_product);
-                return -1;
-            }
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                           __LINE__);
+            import_session_delete(session);
+            return -1;
         }
     }
 
-    *product = imported_product;
-
+    *new_session = session;
     return 0;
 }
 
-/** Test import of a product.
- * \ingroup harp_product
- * If the product is a HARP product then verify that the product is a HARP compliant netCDF/HDF4/HDF5 product.
- * Otherwise, try to import the product using an applicable ingestion module and test the ingestion for all possible
- * ingestion options.
- * Results are printed using the provided \a print function.
- * The \a print function parameter should be a function that resembles printf().
- * \param[in] filename Filename of the product to import.
- * \param[in] print Reference to a printf compatible function.
- * \return
- *   \arg \c 0, Success.
- *   \arg \c 1, Import failed (error is already printed, #harp_errno should be ignored).
- *   \arg \c -1, Error occurred (check #harp_errno).
- */
-LIBHARP_API int harp_import_test(const char *filename, int (*print) (const char *, ...))
+static int import_deferred(const char *filename, harp_product **product, harp_deferred_import **import)
 {
-    harp_product *product;
+    harp_memory_subsystem previous_subsystem;
+    double trace_start;
     file_format format;
     int result;
-
-    print("product: %s\n", filename);
+    int i;
 
     if (determine_file_format(filename, &format) != 0)
     {
         return -1;
     }
 
+    trace_start = harp_trace_begin();
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_import);
     switch (format)
     {
         case format_hdf4:
 #ifdef HAVE_HDF4
-            result = harp_import_hdf4(filename, &product);
+            result = harp_import_deferred_hdf4(filename, product, import);
 #else
             harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
             result = -1;
@@ -656,181 +733,1646 @@ LIBHARP_API int harp_import_test(const char *filename, int (*print) (const char
             break;
         case format_hdf5:
 #ifdef HAVE_HDF5
-            result = harp_import_hdf5(filename, &product);
+            result = harp_import_deferred_hdf5(filename, product, import);
 #else
             harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
             result = -1;
 #endif
             break;
         case format_netcdf:
-            result = harp_import_netcdf(filename, &product);
+            result = harp_import_deferred_netcdf(filename, product, import);
             break;
         default:
             harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
             result = -1;
     }
-
+    harp_memory_set_subsystem(previous_subsystem);
     if (result != 0)
     {
-        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+        return -1;
+    }
+
+    /* variables without data are verified once their data is loaded */
+    for (i = 0; i < (*product)->num_variables; i++)
+    {
+        if ((*product)->variable[i]->data.ptr != NULL && harp_variable_verify((*product)->variable[i]) != 0)
         {
+            harp_product_delete(*product);
+            harp_deferred_import_delete(*import);
             return -1;
         }
-        /* try ingest */
-        return harp_ingest_test(filename, print);
     }
 
-    print("import:");
-    if (harp_product_verify(product) != 0)
+    /* set source_product if it was empty; this is consistent with harp_import() */
+    if ((*product)->source_product == NULL)
     {
-        print(" [FAIL]\n");
-        print("ERROR: %s\n", harp_errno_to_string(harp_errno));
-        harp_product_delete(product);
-        return 1;
+        if (harp_product_set_source_product(*product, filename) != 0)
+        {
+            harp_product_delete(*product);
+            harp_deferred_import_delete(*import);
+            return -1;
+        }
     }
-    print(" [OK]\n");
-
-    harp_product_delete(product);
+    harp_trace_end(trace_start, "import", "import_deferred", filename, -1, -1);
 
     return 0;
 }
 
-/** Retrieve global attributes from a product file.
- * \ingroup harp_product
- * This function retrieves the product metadata without performing a full import.
- * \param filename Path to the file for which to retrieve global attributes.
- * \param options Ingestion module specific options (optional); should be specified as a semi-colon separated
- * string of key=value pair; only used if the file is not in HARP format.
- * \param new_metadata Pointer to the variable where the metadata should be stored.
- * \return
- *   \arg \c 0, Succes.
- *   \arg \c -1, Error occurred (check #harp_errno).
+/* Name of the variable that is used to keep track of the time samples in the file during time filtering. */
+#define TIME_INDEX_VARIABLE_NAME "harp_time_index"
+
+/* Create a product with copies of the variables that are needed by the first num_operations operations of the program
+ * (which should all be time filters, see harp_program_get_num_time_filters()) and a variable with the index of each
+ * time sample in the file, and perform these operations on it. The variables that are needed remain loaded in product.
  */
-LIBHARP_API int harp_import_product_metadata(const char *filename, const char *options,
-                                             harp_product_metadata **new_metadata)
+static int execute_time_filters(harp_product *product, harp_deferred_import *import, harp_program *program,
+                                int num_operations, harp_product **filter_product)
 {
-    harp_product_metadata *metadata = NULL;
-    file_format format;
-    int result;
-
-    if (determine_file_format(filename, &format) != 0)
-    {
-        return -1;
-    }
+    harp_dimension_type dimension_type = harp_dimension_time;
+    harp_product *new_product;
+    harp_variable *time_index;
+    long num_time = product->dimension[harp_dimension_time];
+    long i;
 
-    if (harp_product_metadata_new(&metadata) != 0)
+    if (harp_product_new(&new_product) != 0)
     {
         return -1;
     }
-
-    /* set the filename attr */
-    metadata->filename = strdup(filename);
-    if (!metadata->filename)
+    if (product->source_product != NULL)
     {
-        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
-                       __LINE__);
-        harp_product_metadata_delete(metadata);
-        return -1;
+        if (harp_product_set_source_product(new_product, product->source_product) != 0)
+        {
+            harp_product_delete(new_product);
+            return -1;
+        }
     }
 
-    switch (format)
+    for (i = 0; i < num_operations; i++)
     {
-        case format_hdf4:
-#ifdef HAVE_HDF4
-            result = harp_import_global_attributes_hdf4(filename, &metadata->datetime_start, &metadata->datetime_stop,
-                                                        metadata->dimension, &metadata->source_product);
-#else
-            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
-            result = -1;
-#endif
-            break;
-        case format_hdf5:
-#ifdef HAVE_HDF5
-            result = harp_import_global_attributes_hdf5(filename, &metadata->datetime_start, &metadata->datetime_stop,
-                                                        metadata->dimension, &metadata->source_product);
-#else
-            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
-            result = -1;
-#endif
-            break;
-        case format_netcdf:
-            result = harp_import_global_attributes_netcdf(filename, &metadata->datetime_start, &metadata->datetime_stop,
-                                                          metadata->dimension, &metadata->source_product);
-            break;
-        default:
-            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
-            result = -1;
-    }
+        const char *variable_name[2];
+        int num_variable_names = 1;
+        int k;
 
-    if (result != 0)
-    {
-        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+        if (harp_operation_get_variable_name(program->operation[program->current_index + i], &variable_name[0]) != 0)
         {
-            harp_product_metadata_delete(metadata);
+            harp_product_delete(new_product);
             return -1;
         }
-
-        /* try ingest */
-        if (harp_ingest_global_attributes(filename, options, &metadata->datetime_start, &metadata->datetime_stop,
-                                          metadata->dimension, &metadata->source_product) != 0)
+        if (program->operation[program->current_index + i]->type == operation_collocation_filter)
         {
-            harp_product_metadata_delete(metadata);
-            return -1;
+            variable_name[1] = "collocation_index";
+            num_variable_names = 2;
         }
-    }
+        for (k = 0; k < num_variable_names; k++)
+        {
+            harp_variable *variable;
+            harp_variable *variable_copy;
+            int loaded;
 
-    *new_metadata = metadata;
+            if (!harp_product_has_variable(product, variable_name[k]) ||
+                harp_product_has_variable(new_product, variable_name[k]))
+            {
+                continue;
+            }
+            if (harp_product_get_variable_by_name(product, variable_name[k], &variable) != 0)
+            {
+                harp_product_delete(new_product);
+                return -1;
+            }
+            if (harp_deferred_import_load_variable(import, variable, &loaded) != 0)
+            {
+                harp_product_delete(new_product);
+                return -1;
+            }
+            if (harp_variable_copy(variable, &variable_copy) != 0)
+            {
+                harp_product_delete(new_product);
+                return -1;
+            }
+            if (harp_product_add_variable(new_product, variable_copy) != 0)
+            {
+                harp_variable_delete(variable_copy);
+                harp_product_delete(new_product);
+                return -1;
+            }
+        }
+    }
+
+    if (harp_variable_new(TIME_INDEX_VARIABLE_NAME, harp_type_int32, 1, &dimension_type, &num_time, &time_index) != 0)
+    {
+        harp_product_delete(new_product);
+        return -1;
+    }
+    for (i = 0; i < num_time; i++)
+    {
+        time_index->data.int32_data[i] = (int32_t)i;
+    }
+    if (harp_product_add_variable(new_product, time_index) != 0)
+    {
+        harp_variable_delete(time_index);
+        harp_product_delete(new_product);
+        return -1;
+    }
+
+    if (harp_product_execute_program_operations(new_product, program, num_operations) != 0)
+    {
+        harp_product_delete(new_product);
+        return -1;
+    }
+
+    *filter_product = new_product;
+    return 0;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long value_a = *(const long *)a;
+    long value_b = *(const long *)b;
+
+    return value_a < value_b ? -1 : (value_a > value_b ? 1 : 0);
+}
+
+/* Only read the time samples of the filter product (see execute_time_filters()) for all variables of the product and
+ * apply the (possibly repeated or reordered) sequence of time samples of the filter product to the product.
+ * Variables that were added to the filter product by the filters (e.g. 'collocation_index') are added to the product.
+ */
+static int apply_time_filters(harp_product *product, harp_deferred_import *import, harp_product *filter_product)
+{
+    harp_variable *time_index;
+    long num_time = product->dimension[harp_dimension_time];
+    long num_indices;
+    long *index;
+    long *dimension_index;
+    int is_rearranged = 0;
+    int loaded;
+    long i;
+
+    if (harp_product_get_variable_by_name(filter_product, TIME_INDEX_VARIABLE_NAME, &time_index) != 0)
+    {
+        return -1;
+    }
+
+    /* the filters can repeat and reorder time samples, so determine the sorted set of time samples to read */
+    index = (long *)malloc(2 * time_index->num_elements * sizeof(long));
+    if (index == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       2 * time_index->num_elements * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    dimension_index = &index[time_index->num_elements];
+    for (i = 0; i < time_index->num_elements; i++)
+    {
+        index[i] = time_index->data.int32_data[i];
+        if (i > 0 && index[i] <= index[i - 1])
+        {
+            is_rearranged = 1;
+        }
+    }
+    num_indices = time_index->num_elements;
+    if (is_rearranged)
+    {
+        qsort(index, num_indices, sizeof(long), compare_long);
+        num_indices = 1;
+        for (i = 1; i < time_index->num_elements; i++)
+        {
+            if (index[i] != index[num_indices - 1])
+            {
+                index[num_indices] = index[i];
+                num_indices++;
+            }
+        }
+    }
+
+    if (num_indices < num_time)
+    {
+        if (harp_deferred_import_select_time(import, product, num_indices, index) != 0)
+        {
+            free(index);
+            return -1;
+        }
+    }
+
+    for (i = 0; i < product->num_variables; i++)
+    {
+        if (harp_deferred_import_load_variable(import, product->variable[i], &loaded) != 0)
+        {
+            free(index);
+            return -1;
+        }
+    }
+
+    if (is_rearranged)
+    {
+        /* map the time samples of the filter product to the time samples that were read */
+        for (i = 0; i < time_index->num_elements; i++)
+        {
+            long key = time_index->data.int32_data[i];
+            long *position;
+
+            position = (long *)bsearch(&key, index, num_indices, sizeof(long), compare_long);
+            assert(position != NULL);
+            dimension_index[i] = position - index;
+        }
+        if (harp_product_rearrange_dimension(product, harp_dimension_time, time_index->num_elements,
+                                             dimension_index) != 0)
+        {
+            free(index);
+            return -1;
+        }
+    }
+    free(index);
+
+    for (i = 0; i < filter_product->num_variables; i++)
+    {
+        harp_variable *variable = filter_product->variable[i];
+        harp_variable *variable_copy;
+
+        if (variable == time_index || harp_product_has_variable(product, variable->name))
+        {
+            continue;
+        }
+        if (harp_variable_copy(variable, &variable_copy) != 0)
+        {
+            return -1;
+        }
+        if (harp_product_add_variable(product, variable_copy) != 0)
+        {
+            harp_variable_delete(variable_copy);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Import a HARP product and perform the operations on the time dimension at the start of the program (see
+ * harp_program_get_num_time_filters()) such that only the remaining time samples are read from the file.
+ * The filters are performed on a product that only contains the variables that the filters need, after which the
+ * data of the other variables is read for the resulting time samples only (using a small number of contiguous reads).
+ * Afterwards, program->current_index refers to the first operation that still needs to be performed.
+ */
+static int import_harp_product(const char *filename, harp_program *program, harp_product **product)
+{
+    harp_deferred_import *import;
+    harp_product *imported_product;
+    harp_product *filter_product = NULL;
+    int num_operations;
+    int loaded;
+    int i;
+
+    if (import_deferred(filename, &imported_product, &import) != 0)
+    {
+        return -1;
+    }
+
+    num_operations = harp_program_get_num_time_filters(program, imported_product);
+    if (num_operations > 0 && import->read_time_ranges != NULL &&
+        !harp_product_has_variable(imported_product, TIME_INDEX_VARIABLE_NAME))
+    {
+        int first_index = program->current_index;
+
+        if (execute_time_filters(imported_product, import, program, num_operations, &filter_product) != 0)
+        {
+            harp_product_delete(imported_product);
+            harp_deferred_import_delete(import);
+            return -1;
+        }
+        if (harp_product_is_empty(filter_product))
+        {
+            /* the remaining operations are not performed on an empty product (consistent with a full import) */
+            harp_product_remove_all_variables(imported_product);
+            program->current_index = program->num_operations;
+        }
+        else
+        {
+            program->current_index = first_index + num_operations;
+            if (apply_time_filters(imported_product, import, filter_product) != 0)
+            {
+                harp_product_delete(filter_product);
+                harp_product_delete(imported_product);
+                harp_deferred_import_delete(import);
+                return -1;
+            }
+        }
+        harp_product_delete(filter_product);
+    }
+
+    /* read the data of all (remaining) variables */
+    for (i = 0; i < imported_product->num_variables; i++)
+    {
+        if (harp_deferred_import_load_variable(import, imported_product->variable[i], &loaded) != 0)
+        {
+            harp_product_delete(imported_product);
+            harp_deferred_import_delete(import);
+            return -1;
+        }
+    }
+    harp_deferred_import_delete(import);
+
+    *product = imported_product;
+    return 0;
+}
+
+static int import_file(harp_import_session *session, const char *filename, harp_product **product)
+{
+    harp_product *imported_product;
+    file_format format;
+    int result;
+
+    if (determine_file_format(filename, &format) != 0)
+    {
+        return -1;
+    }
+
+    if (session->program->num_operations > 0)
+    {
+        /* HARP products are opened without reading any data, such that time filters at the start of the program only
+         * require the remaining time samples to be read */
+        result = import_harp_product(filename, session->program, &imported_product);
+    }
+    else
+    {
+        switch (format)
+        {
+            case format_hdf4:
+#ifdef HAVE_HDF4
+                result = harp_import_hdf4(filename, &imported_product);
+#else
+                harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+                result = -1;
+#endif
+                break;
+            case format_hdf5:
+#ifdef HAVE_HDF5
+                result = harp_import_hdf5(filename, &imported_product);
+#else
+                harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+                result = -1;
+#endif
+                break;
+            case format_netcdf:
+                result = harp_import_netcdf(filename, &imported_product);
+                break;
+            default:
+                harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+                result = -1;
+        }
+    }
+
+    if (result != 0)
+    {
+        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+        {
+            return -1;
+        }
+
+        /* try ingest */
+        if (session->ingestion_session == NULL)
+        {
+            if (harp_ingestion_session_new(session->program, session->options, &session->ingestion_session) != 0)
+            {
+                return -1;
+            }
+        }
+        if (harp_ingestion_session_ingest(session->ingestion_session, filename, &imported_product) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if (harp_product_verify(imported_product) != 0)
+        {
+            harp_product_delete(imported_product);
+            return -1;
+        }
+
+        /* set source_product if it was empty; we need this for the 'collocate_xxx()' operations to work */
+        if (imported_product->source_product == NULL)
+        {
+            if (harp_product_set_source_product(imported_product, filename) != 0)
+            {
+                harp_product_delete(imported_product);
+                return -1;
+            }
+        }
+
+        if (session->program->current_index < session->program->num_operations)
+        {
+            if (harp_product_execute_program(imported_product, session->program) != 0)
+            {
+                harp_product_delete(imported_product);
+                return -1;
+            }
+        }
+    }
+
+    *product = imported_product;
+
+    return 0;
+}
+
+static int import_product(harp_import_session *session, const char *filename, harp_product **product)
+{
+    double trace_start = harp_trace_begin();
+    int result;
+
+    /* the program is executed from the start for each product and the effect of its 'set' operations is undone
+     * afterwards, such that each product is imported the same way as with a freshly parsed program */
+    harp_program_reset(session->program);
+    result = import_file(session, filename, product);
+    harp_program_restore_options(session->program);
+    if (result != 0)
+    {
+        return -1;
+    }
+    harp_trace_end_product(trace_start, "import", "import", filename, *product);
+
+    return 0;
+}
+
+/** Import a product from a file.
+ * \ingroup harp_product
+ * This will first try to import the file as an HDF4, HDF5, or netCDF file that complies to the HARP Data Format.
+ * If the file is not stored using the HARP format then it will try to import it using one of the available ingestion
+ * modules.
+ * The \a options parameter is optional (can be NULL) and describes the ingestion options. The parameter is only
+ * applicable if the file is not already using the HARP format and needs to be converted using one of the ingestion
+ * modules.
+ * The \a operations parameter is optional (can be NULL) and provides the list of operations that will be performed as
+ * part of the import. Some operations, such as filters, can already be performed as part of an import and this may thus
+ * be faster than using a harp_product_execute_operations() after a full import of the product.
+ * \param[in] filename Path to the file that is to be imported.
+ * \param[in] operations string (optional) containing actions to apply as part of the import; should be specified as a
+ * semi-colon separated string of operations.
+ * \param[in] options Ingestion module specific options (optional); should be specified as a semi-colon separated
+ * string of key=value pair; only used if the file is not in HARP format.
+ * \param[out] product Pointer to a location where a pointer to the ingested product will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import(const char *filename, const char *operations, const char *options, harp_product **product)
+{
+    harp_import_session *session;
+    harp_memory_subsystem previous_subsystem;
+    int result;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (product == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (import_session_new(operations, options, &session) != 0)
+    {
+        return -1;
+    }
+
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_import);
+    result = import_product(session, filename, product);
+    harp_memory_set_subsystem(previous_subsystem);
+
+    import_session_delete(session);
+
+    return result;
+}
+
+/** Start an import session for importing a series of products with the same operations and options.
+ * \ingroup harp_product
+ * Importing products using a session gives the same results as calling harp_import() for each product, but the setup
+ * that is independent of the individual products is performed only once. The operations and ingestion options are
+ * parsed when the session is created, and the ingestion module that was used for the previous product is tried first
+ * when detecting the product type of the next product (the ingestion options are only validated again when a product
+ * requires a different ingestion module). This reduces the overhead per product when importing a large number of
+ * (small) products of the same product type.
+ * The session should be ended with harp_import_session_delete(). Note that the global libcoda options that HARP
+ * requires for ingestion (see harp_import()) remain set for the lifetime of the session.
+ * \param[in] operations string (optional) containing actions to apply as part of the import of each product; should
+ * be specified as a semi-colon separated string of operations.
+ * \param[in] options Ingestion module specific options (optional); should be specified as a semi-colon separated
+ * string of key=value pair; only used if a file is not in HARP format.
+ * \param[out] session Pointer to a location where a pointer to the new import session will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import_session_new(const char *operations, const char *options, harp_import_session **session)
+{
+    if (session == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "session is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    return import_session_new(operations, options, session);
+}
+
+/** Import a product from a file using an import session.
+ * \ingroup harp_product
+ * This behaves the same as harp_import() with the operations and options of the session.
+ * \param[in] session Import session (see harp_import_session_new()).
+ * \param[in] filename Path to the file that is to be imported.
+ * \param[out] product Pointer to a location where a pointer to the ingested product will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import_session_import(harp_import_session *session, const char *filename,
+                                           harp_product **product)
+{
+    harp_memory_subsystem previous_subsystem;
+    int result;
+
+    if (session == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "session is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (product == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_import);
+    result = import_product(session, filename, product);
+    harp_memory_set_subsystem(previous_subsystem);
+
+    return result;
+}
+
+/** End an import session.
+ * \ingroup harp_product
+ * This releases all resources of the session and restores the global options that were modified by the session.
+ * \param[in] session Import session (see harp_import_session_new()).
+ */
+LIBHARP_API void harp_import_session_delete(harp_import_session *session)
+{
+    import_session_delete(session);
+}
+
+/** Import a list of products and concatenate them along the time dimension.
+ * \ingroup harp_product
+ * Each file is imported using harp_import() with the given \a operations and \a options. Products that are empty
+ * after the import (see harp_product_is_empty()) are skipped. The remaining products are concatenated along the time
+ * dimension in the order in which they are provided, with the same rules as for harp_product_append() (i.e. the
+ * 'index' variable is removed, all variables are made time dependent and non-time dimensions are extended to the
+ * maximum length of all products). The 'source_product' and 'history' attributes of the result are taken from the
+ * first non-empty product.
+ * The final dimension lengths are determined from the imported products before any data is concatenated, such that
+ * the data of each variable is copied only once into a preallocated buffer.
+ * If none of the imported products contain data, an empty product (without variables) is returned.
+ * \param[in] num_files Number of files in \a filenames.
+ * \param[in] filenames Paths to the files that are to be imported.
+ * \param[in] operations string (optional) containing actions to apply as part of the import of each file; should be
+ * specified as a semi-colon separated string of operations.
+ * \param[in] options Ingestion module specific options (optional); should be specified as a semi-colon separated
+ * string of key=value pair; only used if a file is not in HARP format.
+ * \param[out] product Pointer to a location where a pointer to the concatenated product will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import_concatenated(int num_files, const char **filenames, const char *operations,
+                                         const char *options, harp_product **product)
+{
+    harp_import_session *session;
+    harp_memory_subsystem previous_subsystem;
+    harp_product **imported_product;
+    harp_product *merged_product;
+    int num_products = 0;
+    int result = 0;
+    int i;
+
+    if (num_files < 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "invalid number of files (%d) (%s:%u)", num_files, __FILE__,
+                       __LINE__);
+        return -1;
+    }
+    if (num_files > 0 && filenames == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filenames is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (num_files == 0)
+    {
+        return harp_product_new(product);
+    }
+
+    imported_product = (harp_product **)malloc(num_files * sizeof(harp_product *));
+    if (imported_product == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_files * sizeof(harp_product *), __FILE__, __LINE__);
+        return -1;
+    }
+
+    /* use a single session such that the operations and options are only parsed once for all files */
+    if (import_session_new(operations, options, &session) != 0)
+    {
+        free(imported_product);
+        return -1;
+    }
+
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_import);
+
+    for (i = 0; i < num_files; i++)
+    {
+        harp_product *file_product;
+
+        if (import_product(session, filenames[i], &file_product) != 0)
+        {
+            harp_add_error_message(" (%s)", filenames[i]);
+            result = -1;
+            break;
+        }
+        if (harp_product_is_empty(file_product))
+        {
+            harp_product_delete(file_product);
+            continue;
+        }
+        imported_product[num_products] = file_product;
+        num_products++;
+    }
+
+    import_session_delete(session);
+
+    if (result == 0)
+    {
+        if (num_products == 0)
+        {
+            result = harp_product_new(&merged_product);
+        }
+        else if (num_products == 1)
+        {
+            char *source_product = imported_product[0]->source_product;
+
+            /* make the result consistent with a concatenation of multiple products (which keeps the source_product
+             * attribute of the first product, whereas harp_product_append() removes it) */
+            imported_product[0]->source_product = NULL;
+            result = harp_product_append(imported_product[0], NULL);
+            imported_product[0]->source_product = source_product;
+            if (result == 0)
+            {
+                merged_product = imported_product[0];
+                num_products = 0;
+            }
+        }
+        else
+        {
+            result = harp_product_concatenate(num_products, imported_product, &merged_product);
+        }
+    }
+
+    harp_memory_set_subsystem(previous_subsystem);
+
+    for (i = 0; i < num_products; i++)
+    {
+        harp_product_delete(imported_product[i]);
+    }
+    free(imported_product);
+
+    if (result != 0)
+    {
+        return -1;
+    }
+
+    *product = merged_product;
+
+    return 0;
+}
+
+/** Test import of a product.
+ * \ingroup harp_product
+ * If the product is a HARP product then verify that the product is a HARP compliant netCDF/HDF4/HDF5 product.
+ * Otherwise, try to import the product using an applicable ingestion module and test the ingestion for all possible
+ * ingestion options.
+ * Results are printed using the provided \a print function.
+ * The \a print function parameter should be a function that resembles printf().
+ * \param[in] filename Filename of the product to import.
+ * \param[in] print Reference to a printf compatible function.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c 1, Import failed (error is already printed, #harp_errno should be ignored).
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import_test(const char *filename, int (*print) (const char *, ...))
+{
+    harp_product *product;
+    file_format format;
+    int result;
+
+    print("product: %s\n", filename);
+
+    if (determine_file_format(filename, &format) != 0)
+    {
+        return -1;
+    }
+
+    switch (format)
+    {
+        case format_hdf4:
+#ifdef HAVE_HDF4
+            result = harp_import_hdf4(filename, &product);
+#else
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_hdf5:
+#ifdef HAVE_HDF5
+            result = harp_import_hdf5(filename, &product);
+#else
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_netcdf:
+            result = harp_import_netcdf(filename, &product);
+            break;
+        default:
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+    }
+
+    if (result != 0)
+    {
+        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+        {
+            return -1;
+        }
+        /* try ingest */
+        return harp_ingest_test(filename, print);
+    }
+
+    print("import:");
+    if (harp_product_verify(product) != 0)
+    {
+        print(" [FAIL]\n");
+        print("ERROR: %s\n", harp_errno_to_string(harp_errno));
+        harp_product_delete(product);
+        return 1;
+    }
+    print(" [OK]\n");
+
+    harp_product_delete(product);
+
+    return 0;
+}
+
+/** Retrieve global attributes from a product file.
+ * \ingroup harp_product
+ * This function retrieves the product metadata without performing a full import.
+ * \param filename Path to the file for which to retrieve global attributes.
+ * \param options Ingestion module specific options (optional); should be specified as a semi-colon separated
+ * string of key=value pair; only used if the file is not in HARP format.
+ * \param new_metadata Pointer to the variable where the metadata should be stored.
+ * \return
+ *   \arg \c 0, Succes.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import_product_metadata(const char *filename, const char *options,
+                                             harp_product_metadata **new_metadata)
+{
+    harp_product_metadata *metadata = NULL;
+    file_format format;
+    int result;
+
+    if (determine_file_format(filename, &format) != 0)
+    {
+        return -1;
+    }
+
+    if (harp_product_metadata_new(&metadata) != 0)
+    {
+        return -1;
+    }
+
+    /* set the filename attr */
+    metadata->filename = strdup(filename);
+    if (!metadata->filename)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not duplicate string) (%s:%u)", __FILE__,
+                       __LINE__);
+        harp_product_metadata_delete(metadata);
+        return -1;
+    }
+
+    switch (format)
+    {
+        case format_hdf4:
+#ifdef HAVE_HDF4
+            result = harp_import_global_attributes_hdf4(filename, &metadata->datetime_start, &metadata->datetime_stop,
+                                                        metadata->dimension, &metadata->source_product);
+#else
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_hdf5:
+#ifdef HAVE_HDF5
+            result = harp_import_global_attributes_hdf5(filename, &metadata->datetime_start, &metadata->datetime_stop,
+                                                        metadata->dimension, &metadata->source_product);
+#else
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_netcdf:
+            result = harp_import_global_attributes_netcdf(filename, &metadata->datetime_start, &metadata->datetime_stop,
+                                                          metadata->dimension, &metadata->source_product);
+            break;
+        default:
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+    }
+
+    if (result != 0)
+    {
+        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+        {
+            harp_product_metadata_delete(metadata);
+            return -1;
+        }
+
+        /* try ingest */
+        if (harp_ingest_global_attributes(filename, options, &metadata->datetime_start, &metadata->datetime_stop,
+                                          metadata->dimension, &metadata->source_product) != 0)
+        {
+            harp_product_metadata_delete(metadata);
+            return -1;
+        }
+    }
+
+    *new_metadata = metadata;
+
+    return 0;
+}
+
+/** Estimate the result of an import without reading the variable data.
+ * \ingroup harp_product_estimate
+ * This function predicts the dimensions and variables (and thereby the storage size) of the product that
+ * harp_import() would return for the same arguments. For HARP netCDF products only the file header is read and for
+ * products that need to be ingested only the dimension lengths and the variable definitions of the ingestion module
+ * are used. For HARP HDF4/HDF5 products a deferred import is performed (which only reads the variable definitions,
+ * the attributes and the data of string variables).
+ *
+ * The operations are evaluated symbolically. Filters can only reduce dimension lengths and are therefore handled by
+ * setting the \a is_upper_bound field of the estimate (the predicted lengths will then be upper bounds).
+ * Evaluation stops at the first operation whose result depends on the data or on external products (such as binning or
+ * regridding using a collocated dataset). The number of operations that could not be evaluated is stored in the
+ * \a num_unresolved_operations field of the estimate.
+ * \param[in] filename Path to the file that is to be imported.
+ * \param[in] operations string (optional) containing actions to apply as part of the import; should be specified as a
+ * semi-colon separated string of operations.
+ * \param[in] options Ingestion module specific options (optional); should be specified as a semi-colon separated
+ * string of key=value pair; only used if the file is not in HARP format.
+ * \param[out] estimate Pointer to a location where a pointer to the product estimate will be stored.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_import_estimate(const char *filename, const char *operations, const char *options,
+                                     harp_product_estimate **estimate)
+{
+    harp_product_estimate *new_estimate = NULL;
+    harp_deferred_import *import = NULL;
+    harp_product *product = NULL;
+    harp_program *program;
+    file_format format;
+    int result;
+
+    if (filename == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (estimate == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "estimate is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if (operations == NULL)
+    {
+        if (harp_program_new(&program) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if (harp_program_from_string(operations, &program) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (determine_file_format(filename, &format) != 0)
+    {
+        harp_program_delete(program);
+        return -1;
+    }
+
+    switch (format)
+    {
+        case format_hdf4:
+#ifdef HAVE_HDF4
+            result = harp_import_deferred_hdf4(filename, &product, &import);
+#else
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_hdf5:
+#ifdef HAVE_HDF5
+            result = harp_import_deferred_hdf5(filename, &product, &import);
+#else
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_netcdf:
+            result = harp_import_estimate_netcdf(filename, &new_estimate);
+            break;
+        default:
+            harp_set_error(HARP_ERROR_UNSUPPORTED_PRODUCT, NULL);
+            result = -1;
+    }
+
+    if (result == 0 && product != NULL)
+    {
+        /* the structure is taken from a deferred import of the HDF4/HDF5 product (which only reads the variable
+         * definitions and attributes, and the data of string variables) */
+        result = harp_product_estimate_from_product(product, &new_estimate);
+        harp_product_delete(product);
+        harp_deferred_import_delete(import);
+        if (result != 0)
+        {
+            harp_program_delete(program);
+            return -1;
+        }
+    }
+    else if (result != 0)
+    {
+        if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+        {
+            harp_program_delete(program);
+            return -1;
+        }
+
+        /* try ingest */
+        if (harp_ingest_estimate(filename, options, &new_estimate) != 0)
+        {
+            harp_program_delete(program);
+            return -1;
+        }
+    }
+
+    if (new_estimate->num_variables > 0)
+    {
+        if (harp_product_estimate_execute_program(new_estimate, program) != 0)
+        {
+            harp_product_estimate_delete(new_estimate);
+            harp_program_delete(program);
+            return -1;
+        }
+    }
+
+    harp_program_delete(program);
+
+    *estimate = new_estimate;
+
+    return 0;
+}
+
+static int export_product(const char *filename, file_format format, const harp_product *product,
+                          harp_deferred_import *import)
+{
+    harp_memory_subsystem previous_subsystem;
+    double trace_start;
+    int result;
+
+    trace_start = harp_trace_begin();
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_export);
+    switch (format)
+    {
+        case format_hdf4:
+#ifdef HAVE_HDF4
+            result = harp_export_hdf4(filename, product, import);
+#else
+            coda_set_error(HARP_ERROR_NO_HDF4_SUPPORT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_hdf5:
+#ifdef HAVE_HDF5
+            result = harp_export_hdf5(filename, product, import);
+#else
+            coda_set_error(HARP_ERROR_NO_HDF5_SUPPORT, NULL);
+            result = -1;
+#endif
+            break;
+        case format_netcdf:
+            result = harp_export_netcdf(filename, product, import);
+            break;
+        default:
+            assert(0);
+            exit(1);
+    }
+    harp_memory_set_subsystem(previous_subsystem);
+    if (result == 0)
+    {
+        harp_trace_end_product(trace_start, "export", "export", filename, product);
+    }
+
+    return result;
+}
+
+/** Export HARP product to a file.
+ * \ingroup harp_product
+ * Export product to an HDF4, HDF5, or netCDF file that complies to the HARP Data Format.
+ * \param filename Path to the file to which the product is to be exported.
+ * \param export_format Either "hdf4", "hdf5", or "netcdf".
+ * \param product Product that should be exported to file.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_export(const char *filename, const char *export_format, const harp_product *product)
+{
+    file_format format;
+
+    format = format_from_string(export_format);
+    if (format == format_unknown)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "unsupported export format '%s'", export_format);
+        return -1;
+    }
+
+    return export_product(filename, format, product, NULL);
+}
+
+/** Append the time samples of a HARP product to a HARP netCDF file.
+ * \ingroup harp_product
+ * The file should have been created by a previous call to harp_export_append() (or by a netCDF product writer, see
+ * harp_product_writer_open()) and uses the time dimension as unlimited (record) dimension. Only the new time samples
+ * are written to the file; the rest of the file is left as is.
+ * The product should have the same variables as the file, with the same data types, units, and dimensions (apart from
+ * the length of the time dimension). Variables that do not depend on time are not written (the values in the file are
+ * kept). After the time samples have been written, the datetime_start and datetime_stop attributes of the file are
+ * updated to also cover the appended product, and the last line of the history of the product (i.e. the line that was
+ * added by harp_product_update_history()) is added to the history attribute of the file.
+ * If the file does not exist yet, it is created as a HARP netCDF file with an unlimited time dimension (in which case
+ * vertical profiles will never be stored as ragged arrays).
+ * \param filename Path to the netCDF file to which the product is to be appended.
+ * \param product Product that should be appended to the file.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_export_append(const char *filename, const harp_product *product)
+{
+    harp_memory_subsystem previous_subsystem;
+    double trace_start;
+    int result;
+
+    trace_start = harp_trace_begin();
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_export);
+    result = harp_export_append_netcdf(filename, product);
+    harp_memory_set_subsystem(previous_subsystem);
+    if (result == 0)
+    {
+        harp_trace_end_product(trace_start, "export", "export_append", filename, product);
+    }
+
+    return result;
+}
+
+static void product_writer_delete(harp_product_writer *writer)
+{
+    if (writer->product != NULL)
+    {
+        harp_product_delete(writer->product);
+    }
+    if (writer->string_length != NULL)
+    {
+        free(writer->string_length);
+    }
+    free(writer);
+}
+
+/* Create the definition of the file content: time dependent variables get the full length of the time dimension (but
+ * no data), time independent variables are copied including their data.
+ */
+static int product_writer_init_product(harp_product_writer *writer, const harp_product *product, long num_time)
+{
+    int i;
+
+    if (harp_product_new(&writer->product) != 0)
+    {
+        return -1;
+    }
+    if (product->source_product != NULL)
+    {
+        if (harp_product_set_source_product(writer->product, product->source_product) != 0)
+        {
+            return -1;
+        }
+    }
+    if (product->history != NULL)
+    {
+        if (harp_product_set_history(writer->product, product->history) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (product->num_variables > 0)
+    {
+        writer->string_length = malloc(product->num_variables * sizeof(long));
+        if (writer->string_length == NULL)
+        {
+            harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                           product->num_variables * sizeof(long), __FILE__, __LINE__);
+            return -1;
+        }
+    }
+
+    for (i = 0; i < product->num_variables; i++)
+    {
+        const harp_variable *variable = product->variable[i];
+        harp_variable *new_variable;
+
+        if (variable->num_dimensions > 0 && variable->dimension_type[0] == harp_dimension_time)
+        {
+            long dimension[HARP_MAX_NUM_DIMS];
+
+            memcpy(dimension, variable->dimension, variable->num_dimensions * sizeof(long));
+            dimension[0] = num_time;
+            if (harp_variable_new_without_data(variable->name, variable->data_type, variable->num_dimensions,
+                                               variable->dimension_type, dimension, &new_variable) != 0)
+            {
+                return -1;
+            }
+            if (harp_variable_copy_attributes(variable, new_variable) != 0)
+            {
+                harp_variable_delete(new_variable);
+                return -1;
+            }
+        }
+        else
+        {
+            if (harp_variable_copy(variable, &new_variable) != 0)
+            {
+                return -1;
+            }
+        }
+        if (harp_product_add_variable(writer->product, new_variable) != 0)
+        {
+            harp_variable_delete(new_variable);
+            return -1;
+        }
+
+        /* the length of the string dimension is fixed by the strings in the initial product (with a minimum of 1) */
+        writer->string_length[i] = 0;
+        if (variable->data_type == harp_type_string)
+        {
+            writer->string_length[i] = harp_get_max_string_length(variable->num_elements, variable->data.string_data);
+            if (writer->string_length[i] == 0)
+            {
+                writer->string_length[i] = 1;
+            }
+        }
+    }
 
     return 0;
 }
 
-/** Export HARP product to a file.
+/** Create a HARP product file to which a product can be written one block of time samples at a time.
  * \ingroup harp_product
- * Export product to an HDF4, HDF5, or netCDF file that complies to the HARP Data Format.
- * \param filename Path to the file to which the product is to be exported.
- * \param export_format Either "hdf4", "hdf5", or "netcdf".
- * \param product Product that should be exported to file.
+ * This allows writing products that are larger than the available memory. The \a product is used as definition of the
+ * file content: the file will contain the same variables (with the same data types, dimensions, and attributes) and
+ * product attributes, except that the time dimension will have length \a num_time.
+ * For netCDF files the time dimension is stored as unlimited (record) dimension, such that time samples can be added to
+ * the file afterwards with harp_export_append().
+ * The data of variables that do not depend on time is written to the file by this function. The data of time dependent
+ * variables in \a product is not written (apart from being used to determine the maximum string length of string
+ * variables). The time dependent data should be written using harp_product_writer_write() (which can be called with
+ * \a product itself if this is the first block of time samples).
+ * The file is finalized with harp_product_writer_close().
+ * \param filename Path to the file that is to be created.
+ * \param format Either "hdf4", "hdf5", or "netcdf".
+ * \param product Product that defines the variables and attributes of the file.
+ * \param num_time Total number of time samples that will be written to the file.
+ * \param writer Pointer to the C variable where the new product writer will be stored.
  * \return
  *   \arg \c 0, Success.
  *   \arg \c -1, Error occurred (check #harp_errno).
  */
-LIBHARP_API int harp_export(const char *filename, const char *export_format, const harp_product *product)
+LIBHARP_API int harp_product_writer_open(const char *filename, const char *format, const harp_product *product,
+                                         long num_time, harp_product_writer **writer)
 {
-    file_format format;
+    harp_memory_subsystem previous_subsystem;
+    harp_product_writer *new_writer;
+    file_format export_format;
+    int result;
 
-    format = format_from_string(export_format);
-    if (format == format_unknown)
+    if (filename == NULL)
     {
-        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "unsupported export format '%s'", export_format);
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "filename is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (product == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (product->dimension[harp_dimension_time] > 0 && num_time <= 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "num_time argument (%ld) is not valid (%s:%u)", num_time,
+                       __FILE__, __LINE__);
+        return -1;
+    }
+    export_format = format_from_string(format);
+    if (export_format == format_unknown)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "unsupported export format '%s'", format);
         return -1;
     }
 
-    switch (format)
+    new_writer = malloc(sizeof(harp_product_writer));
+    if (new_writer == NULL)
     {
-        case format_hdf4:
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       sizeof(harp_product_writer), __FILE__, __LINE__);
+        return -1;
+    }
+    new_writer->product = NULL;
+    new_writer->string_length = NULL;
+    new_writer->time_offset = 0;
+    new_writer->has_datetime_range = 0;
+    new_writer->datetime_start = 0;
+    new_writer->datetime_stop = 0;
+    new_writer->file = NULL;
+    new_writer->write_data = NULL;
+    new_writer->write_datetime_range = NULL;
+    new_writer->close = NULL;
+
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_export);
+    result = product_writer_init_product(new_writer, product, num_time);
+    if (result == 0)
+    {
+        switch (export_format)
+        {
+            case format_hdf4:
 #ifdef HAVE_HDF4
-            return harp_export_hdf4(filename, product);
+                result = harp_product_writer_open_hdf4(filename, product, new_writer);
 #else
-            coda_set_error(HARP_ERROR_NO_HDF4_SUPPORT, NULL);
-            return -1;
+                harp_set_error(HARP_ERROR_NO_HDF4_SUPPORT, NULL);
+                result = -1;
 #endif
-        case format_hdf5:
+                break;
+            case format_hdf5:
 #ifdef HAVE_HDF5
-            return harp_export_hdf5(filename, product);
+                result = harp_product_writer_open_hdf5(filename, product, new_writer);
 #else
-            coda_set_error(HARP_ERROR_NO_HDF5_SUPPORT, NULL);
-            return -1;
+                harp_set_error(HARP_ERROR_NO_HDF5_SUPPORT, NULL);
+                result = -1;
 #endif
-        case format_netcdf:
-            return harp_export_netcdf(filename, product);
-        default:
-            assert(0);
-            exit(1);
+                break;
+            case format_netcdf:
+                result = harp_product_writer_open_netcdf(filename, product, new_writer);
+                break;
+            default:
+                assert(0);
+                exit(1);
+        }
+    }
+    harp_memory_set_subsystem(previous_subsystem);
+    if (result != 0)
+    {
+        product_writer_delete(new_writer);
+        return -1;
+    }
+
+    *writer = new_writer;
+
+    return 0;
+}
+
+/** Write a block of time samples to a product file.
+ * \ingroup harp_product
+ * The time dependent variables of \a product are written to the file directly after the time samples that were
+ * written by previous calls to this function. The product should contain all time dependent variables of the
+ * product that was used to open the writer, with the same data types and dimensions (apart from the length of the
+ * time dimension). Strings can not be longer than the longest string of the corresponding variable in the product
+ * that was used to open the writer. Time independent variables of \a product are ignored.
+ * \param writer Product writer.
+ * \param product Product containing the next block of time samples.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_product_writer_write(harp_product_writer *writer, const harp_product *product)
+{
+    harp_memory_subsystem previous_subsystem;
+    double datetime_start;
+    double datetime_stop;
+    double trace_start;
+    long num_time;
+    int i;
+
+    if (writer == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "writer is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    if (product == NULL)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product is NULL (%s:%u)", __FILE__, __LINE__);
+        return -1;
+    }
+    num_time = product->dimension[harp_dimension_time];
+    if (num_time == 0)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product has no time dimension");
+        return -1;
     }
+    if (writer->time_offset + num_time > writer->product->dimension[harp_dimension_time])
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "product has %ld time samples, but only %ld time samples remain "
+                       "to be written", num_time, writer->product->dimension[harp_dimension_time] -
+                       writer->time_offset);
+        return -1;
+    }
+
+    /* verify all time dependent variables before anything is written */
+    for (i = 0; i < writer->product->num_variables; i++)
+    {
+        const harp_variable *file_variable = writer->product->variable[i];
+        harp_variable *variable;
+        int j;
+
+        if (file_variable->num_dimensions == 0 || file_variable->dimension_type[0] != harp_dimension_time)
+        {
+            continue;
+        }
+        if (harp_product_get_variable_by_name(product, file_variable->name, &variable) != 0)
+        {
+            return -1;
+        }
+        if (variable->data_type != file_variable->data_type)
+        {
+            harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable '%s' has data type '%s' (expected '%s')",
+                           variable->name, harp_get_data_type_name(variable->data_type),
+                           harp_get_data_type_name(file_variable->data_type));
+            return -1;
+        }
+        if (variable->num_dimensions != file_variable->num_dimensions)
+        {
+            harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable '%s' has %d dimensions (expected %d)",
+                           variable->name, variable->num_dimensions, file_variable->num_dimensions);
+            return -1;
+        }
+        for (j = 0; j < variable->num_dimensions; j++)
+        {
+            if (variable->dimension_type[j] != file_variable->dimension_type[j] ||
+                (j > 0 && variable->dimension[j] != file_variable->dimension[j]))
+            {
+                harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "dimension %d of variable '%s' does not match the "
+                               "dimension in the file", j, variable->name);
+                return -1;
+            }
+        }
+        if (variable->data_type == harp_type_string &&
+            harp_get_max_string_length(variable->num_elements, variable->data.string_data) > writer->string_length[i])
+        {
+            harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "variable '%s' contains strings that are longer than the "
+                           "maximum string length (%ld) of the file", variable->name, writer->string_length[i]);
+            return -1;
+        }
+    }
+
+    trace_start = harp_trace_begin();
+    previous_subsystem = harp_memory_set_subsystem(harp_memory_subsystem_export);
+    for (i = 0; i < writer->product->num_variables; i++)
+    {
+        const harp_variable *file_variable = writer->product->variable[i];
+        harp_variable *variable;
+
+        if (file_variable->num_dimensions == 0 || file_variable->dimension_type[0] != harp_dimension_time)
+        {
+            continue;
+        }
+        harp_product_get_variable_by_name(product, file_variable->name, &variable);
+        if (writer->write_data(writer->file, i, variable, writer->time_offset) != 0)
+        {
+            harp_memory_set_subsystem(previous_subsystem);
+            return -1;
+        }
+    }
+    harp_memory_set_subsystem(previous_subsystem);
+    writer->time_offset += num_time;
+
+    if (harp_product_get_datetime_range(product, &datetime_start, &datetime_stop) == 0)
+    {
+        if (!writer->has_datetime_range || datetime_start < writer->datetime_start)
+        {
+            writer->datetime_start = datetime_start;
+        }
+        if (!writer->has_datetime_range || datetime_stop > writer->datetime_stop)
+        {
+            writer->datetime_stop = datetime_stop;
+        }
+        writer->has_datetime_range = 1;
+    }
+    harp_trace_end_product(trace_start, "export", "write_time_block", NULL, product);
 
     return 0;
 }
 
+/** Finalize and close a product file that was created with harp_product_writer_open().
+ * \ingroup harp_product
+ * The datetime_start and datetime_stop attributes of the file are set to the datetime range of all products that were
+ * written (the attributes are removed if none of the written products had a datetime range). The writer is always
+ * deleted, also when an error occurs. It is an error if fewer time samples were written than the length of the time
+ * dimension that was provided to harp_product_writer_open().
+ * \param writer Product writer.
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_product_writer_close(harp_product_writer *writer)
+{
+    int result = 0;
+
+    if (writer == NULL)
+    {
+        return 0;
+    }
+
+    /* the datetime range attributes that were written when the file was created are only preliminary */
+    result = writer->write_datetime_range(writer->file, writer->has_datetime_range, writer->datetime_start,
+                                          writer->datetime_stop);
+    if (writer->close(writer->file) != 0)
+    {
+        result = -1;
+    }
+    writer->file = NULL;
+    if (result == 0 && writer->time_offset != writer->product->dimension[harp_dimension_time])
+    {
+        harp_set_error(HARP_ERROR_EXPORT, "only %ld of %ld time samples were written", writer->time_offset,
+                       writer->product->dimension[harp_dimension_time]);
+        result = -1;
+    }
+    product_writer_delete(writer);
+
+    return result;
+}
+
+/** Convert a product to a HARP product file.
+ * \ingroup harp_product
+ * This is equal to a harp_import() of the input file, followed by a harp_product_update_history() (if \a executable is
+ * provided) and a harp_export() of the resulting product, with the difference that if the input file is already a
+ * HARP product and the operations only select or rename variables (i.e. 'keep()', 'exclude()', and 'rename()'), the
+ * product is converted one variable at a time. The data of each variable is then read from the input file directly
+ * before it is written to the output file, such that the memory needed for the conversion does not exceed the size
+ * of the largest variable.
+ * If the resulting product is empty (see harp_product_is_empty()), no output file is written and 1 is returned.
+ * \param[in] input_filename Path to the file that is to be imported.
+ * \param[in] operations string (optional) containing actions to apply as part of the import; should be specified as a
+ * semi-colon separated string of operations.
+ * \param[in] options Ingestion module specific options (optional); should be specified as a semi-colon separated
+ * string of key=value pair; only used if the file is not in HARP format.
+ * \param[in] output_filename Path to the file to which the product is to be exported.
+ * \param[in] export_format Either "hdf4", "hdf5", or "netcdf".
+ * \param[in] executable Name of the command line tool that performs the conversion (optional); if provided, the
+ * history attribute of the product is updated using \a executable, \a argc, and \a argv.
+ * \param[in] argc Variable as passed by main().
+ * \param[in] argv Variable as passed by main().
+ * \return
+ *   \arg \c 0, Success.
+ *   \arg \c 1, The product was empty and no output file was written.
+ *   \arg \c -1, Error occurred (check #harp_errno).
+ */
+LIBHARP_API int harp_convert(const char *input_filename, const char *operations, const char *options,
+                             const char *output_filename, const char *export_format, const char *executable,
+                             int argc, char *argv[])
+{
+    harp_deferred_import *import = NULL;
+    harp_product *product = NULL;
+    file_format format;
+    int result;
+    int i;
+
+    format = format_from_string(export_format);
+    if (format == format_unknown)
+    {
+        harp_set_error(HARP_ERROR_INVALID_ARGUMENT, "unsupported export format '%s'", export_format);
+        return -1;
+    }
+
+    result = 1;
+    if (operations != NULL)
+    {
+        harp_program *program;
+
+        if (harp_program_from_string(operations, &program) != 0)
+        {
+            return -1;
+        }
+        result = harp_program_is_variable_selection(program);
+        harp_program_delete(program);
+    }
+    if (result)
+    {
+        if (import_deferred(input_filename, &product, &import) != 0)
+        {
+            if (harp_errno != HARP_ERROR_UNSUPPORTED_PRODUCT)
+            {
+                return -1;
+            }
+            /* not a HARP product; fall back to a regular import (which will try the ingestion modules) */
+            product = NULL;
+            import = NULL;
+        }
+        else if (operations != NULL)
+        {
+            if (harp_product_execute_operations(product, operations) != 0)
+            {
+                harp_product_delete(product);
+                harp_deferred_import_delete(import);
+                return -1;
+            }
+        }
+    }
+    if (product == NULL)
+    {
+        if (harp_import(input_filename, operations, options, &product) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (harp_product_is_empty(product))
+    {
+        harp_product_delete(product);
+        harp_deferred_import_delete(import);
+        return 1;
+    }
+
+    if (executable != NULL)
+    {
+        if (harp_product_update_history(product, executable, argc, argv) != 0)
+        {
+            harp_product_delete(product);
+            harp_deferred_import_delete(import);
+            return -1;
+        }
+    }
+
+    if (import != NULL)
+    {
+        /* The datetime variables are needed for the datetime_start/datetime_stop attributes. */
+        for (i = 0; i < product->num_variables; i++)
+        {
+            harp_variable *variable = product->variable[i];
+            int loaded;
+
+            if (strncmp(variable->name, "datetime", 8) == 0)
+            {
+                if (harp_deferred_import_load_variable(import, variable, &loaded) != 0)
+                {
+                    harp_product_delete(product);
+                    harp_deferred_import_delete(import);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    result = export_product(output_filename, format, product, import);
+
+    harp_product_delete(product);
+    harp_deferred_import_delete(import);
+
+    return result;
+}
+
 /**
  * Return a string describing the dimension type.
  */
@@ -22,6 +22,175 @@
 
 #include <string.h>
 
+/* number of elements along each axis of a tile that is copied at once by reorder_data() */
+#define REORDER_BLOCK_SIZE 32
+
+/* Copy a block of num_a x num_b elements where the element at (a, b) is located at src[a * src_stride_a +
+ * b * src_stride_b] and is stored at dst[a * dst_stride_a + b * dst_stride_b] (strides are in elements).
+ */
+static void copy_block(char *dst, long dst_stride_a, long dst_stride_b, const char *src, long src_stride_a,
+                       long src_stride_b, long num_a, long num_b, int element_size)
+{
+    long a, b;
+
+    switch (element_size)
+    {
+        case 1:
+            for (a = 0; a < num_a; a++)
+            {
+                int8_t *dst_ptr = (int8_t *)dst + a * dst_stride_a;
+                const int8_t *src_ptr = (const int8_t *)src + a * src_stride_a;
+
+                for (b = 0; b < num_b; b++)
+                {
+                    dst_ptr[b * dst_stride_b] = src_ptr[b * src_stride_b];
+                }
+            }
+            break;
+        case 2:
+            for (a = 0; a < num_a; a++)
+            {
+                int16_t *dst_ptr = (int16_t *)dst + a * dst_stride_a;
+                const int16_t *src_ptr = (const int16_t *)src + a * src_stride_a;
+
+                for (b = 0; b < num_b; b++)
+                {
+                    dst_ptr[b * dst_stride_b] = src_ptr[b * src_stride_b];
+                }
+            }
+            break;
+        case 4:
+            for (a = 0; a < num_a; a++)
+            {
+                int32_t *dst_ptr = (int32_t *)dst + a * dst_stride_a;
+                const int32_t *src_ptr = (const int32_t *)src + a * src_stride_a;
+
+                for (b = 0; b < num_b; b++)
+                {
+                    dst_ptr[b * dst_stride_b] = src_ptr[b * src_stride_b];
+                }
+            }
+            break;
+        case 8:
+            for (a = 0; a < num_a; a++)
+            {
+                int64_t *dst_ptr = (int64_t *)dst + a * dst_stride_a;
+                const int64_t *src_ptr = (const int64_t *)src + a * src_stride_a;
+
+                for (b = 0; b < num_b; b++)
+                {
+                    dst_ptr[b * dst_stride_b] = src_ptr[b * src_stride_b];
+                }
+            }
+            break;
+        default:
+            for (a = 0; a < num_a; a++)
+            {
+                for (b = 0; b < num_b; b++)
+                {
+                    memcpy(dst + (a * dst_stride_a + b * dst_stride_b) * element_size,
+                           src + (a * src_stride_a + b * src_stride_b) * element_size, element_size);
+                }
+            }
+            break;
+    }
+}
+
+/* Convert an N-D array between HARP (row-major) and MATLAB (column-major) memory layout.
+ * If to_matlab is set, src is in row-major order and dst will be in column-major order (using the same dimension
+ * lengths), otherwise src is in column-major order and dst will be in row-major order.
+ * The array is processed in slabs of REORDER_BLOCK_SIZE indices of the first dimension. Within a slab the row-major
+ * side is traversed sequentially and the (first dimension x last dimension) planes are transposed in tiles of
+ * REORDER_BLOCK_SIZE x REORDER_BLOCK_SIZE elements, such that each tile is read and written as a set of short
+ * contiguous runs.
+ */
+static void reorder_data(int num_dims, const long *dim, int element_size, const void *src, void *dst, int to_matlab)
+{
+    long index[HARP_MAX_NUM_DIMS];
+    long num_elements = 1;
+    long num_first, num_last, num_middle;
+    long row_major_stride_first, column_major_stride_last;
+    long src_stride_first, src_stride_last, dst_stride_first, dst_stride_last;
+    long a, b, m;
+    int i;
+
+    for (i = 0; i < num_dims; i++)
+    {
+        num_elements *= dim[i];
+    }
+    if (num_dims <= 1 || num_elements <= 1)
+    {
+        memcpy(dst, src, (size_t)num_elements * element_size);
+        return;
+    }
+
+    num_first = dim[0];
+    num_last = dim[num_dims - 1];
+    num_middle = num_elements / (num_first * num_last);
+    row_major_stride_first = num_elements / num_first;
+    column_major_stride_last = num_elements / num_last;
+    if (to_matlab)
+    {
+        src_stride_first = row_major_stride_first;
+        src_stride_last = 1;
+        dst_stride_first = 1;
+        dst_stride_last = column_major_stride_last;
+    }
+    else
+    {
+        src_stride_first = 1;
+        src_stride_last = column_major_stride_last;
+        dst_stride_first = row_major_stride_first;
+        dst_stride_last = 1;
+    }
+
+    for (a = 0; a < num_first; a += REORDER_BLOCK_SIZE)
+    {
+        long num_a = num_first - a < REORDER_BLOCK_SIZE ? num_first - a : REORDER_BLOCK_SIZE;
+
+        for (i = 0; i < num_dims; i++)
+        {
+            index[i] = 0;
+        }
+        for (m = 0; m < num_middle; m++)
+        {
+            long row_major_offset = m * num_last;
+            long column_major_offset = 0;
+            long src_offset, dst_offset;
+
+            /* column major offset of the middle dimensions (in units of the first dimension) */
+            for (i = num_dims - 2; i > 0; i--)
+            {
+                column_major_offset = column_major_offset * dim[i] + index[i];
+            }
+            column_major_offset *= num_first;
+
+            src_offset = (to_matlab ? row_major_offset : column_major_offset) + a * src_stride_first;
+            dst_offset = (to_matlab ? column_major_offset : row_major_offset) + a * dst_stride_first;
+
+            for (b = 0; b < num_last; b += REORDER_BLOCK_SIZE)
+            {
+                long num_b = num_last - b < REORDER_BLOCK_SIZE ? num_last - b : REORDER_BLOCK_SIZE;
+
+                copy_block((char *)dst + (dst_offset + b * dst_stride_last) * element_size, dst_stride_first,
+                           dst_stride_last, (const char *)src + (src_offset + b * src_stride_last) * element_size,
+                           src_stride_first, src_stride_last, num_a, num_b, element_size);
+            }
+
+            /* advance the (row-major) index of the middle dimensions */
+            for (i = num_dims - 2; i > 0; i--)
+            {
+                index[i]++;
+                if (index[i] < dim[i])
+                {
+                    break;
+                }
+                index[i] = 0;
+            }
+        }
+    }
+}
+
 static void harp_matlab_add_harp_product_variable(mxArray *mx_struct, harp_product **product, int index)
 {
 
@@ -157,117 +326,19 @@ static void harp_matlab_add_harp_product_variable(mxArray *mx_struct, harp_produ
     switch (type)
     {
         case harp_type_int8:
-            {
-                long counter = 0;
-                int8_t *data;
-
-                mx_data = mxCreateNumericArray(num_dims, matlabdim, mxINT8_CLASS, mxREAL);
-                data = mxGetData(mx_data);
-
-                while (counter < num_elements)
-                {
-                    mwSize j, k;
-
-                    for (j = 0; j < num_elements / matlabdim[num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < matlabdim[num_dims - 1]; k++)
-                        {
-                            data[j + k * num_elements / matlabdim[num_dims - 1]] = variable_data.int8_data[counter++];
-                        }
-                    }
-                }
-
-            }
+            mx_data = mxCreateNumericArray(num_dims, matlabdim, mxINT8_CLASS, mxREAL);
             break;
         case harp_type_int16:
-            {
-                long counter = 0;
-                int16_t *data;
-
-                mx_data = mxCreateNumericArray(num_dims, matlabdim, mxINT16_CLASS, mxREAL);
-                data = mxGetData(mx_data);
-
-                while (counter < num_elements)
-                {
-                    mwSize j, k;
-
-                    for (j = 0; j < num_elements / matlabdim[num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < matlabdim[num_dims - 1]; k++)
-                        {
-                            data[j + k * num_elements / matlabdim[num_dims - 1]] = variable_data.int16_data[counter++];
-                        }
-                    }
-                }
-            }
+            mx_data = mxCreateNumericArray(num_dims, matlabdim, mxINT16_CLASS, mxREAL);
             break;
         case harp_type_int32:
-            {
-                long counter = 0;
-                int32_t *data;
-
-                mx_data = mxCreateNumericArray(num_dims, matlabdim, mxINT32_CLASS, mxREAL);
-                data = mxGetData(mx_data);
-
-                while (counter < num_elements)
-                {
-                    mwSize j, k;
-
-                    for (j = 0; j < num_elements / matlabdim[num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < matlabdim[num_dims - 1]; k++)
-                        {
-                            data[j + k * num_elements / matlabdim[num_dims - 1]] = variable_data.int32_data[counter++];
-                        }
-                    }
-                }
-            }
+            mx_data = mxCreateNumericArray(num_dims, matlabdim, mxINT32_CLASS, mxREAL);
             break;
         case harp_type_double:
-            {
-                long counter = 0;
-                double *data;
-
-                mx_data = mxCreateNumericArray(num_dims, matlabdim, mxDOUBLE_CLASS, mxREAL);
-                data = mxGetData(mx_data);
-
-                while (counter < num_elements)
-                {
-                    mwSize j, k;
-
-                    for (j = 0; j < num_elements / matlabdim[num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < matlabdim[num_dims - 1]; k++)
-                        {
-                            data[j + k * num_elements / matlabdim[num_dims - 1]] = variable_data.double_data[counter++];
-                        }
-                    }
-                }
-
-            }
+            mx_data = mxCreateNumericArray(num_dims, matlabdim, mxDOUBLE_CLASS, mxREAL);
             break;
         case harp_type_float:
-            {
-                long counter = 0;
-                float *data;
-
-                mx_data = mxCreateNumericArray(num_dims, matlabdim, mxSINGLE_CLASS, mxREAL);
-                data = mxGetData(mx_data);
-
-                while (counter < num_elements)
-                {
-                    mwSize j, k;
-
-                    for (j = 0; j < num_elements / matlabdim[num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < matlabdim[num_dims - 1]; k++)
-                        {
-                            data[j + k * num_elements / matlabdim[num_dims - 1]] = variable_data.float_data[counter++];
-                        }
-                    }
-                }
-
-            }
+            mx_data = mxCreateNumericArray(num_dims, matlabdim, mxSINGLE_CLASS, mxREAL);
             break;
         case harp_type_string:
             if (num_dims == 0)
@@ -286,7 +357,11 @@ static void harp_matlab_add_harp_product_variable(mxArray *mx_struct, harp_produ
             break;
     }
 
-
+    if (type != harp_type_string)
+    {
+        /* convert from row-major (HARP) to column-major (MATLAB) order */
+        reorder_data(num_dims, dim, harp_get_size_for_type(type), variable_data.ptr, mxGetData(mx_data), 1);
+    }
 
     mxAddField(struct_data, "data");
     mxSetField(struct_data, 0, "data", mx_data);
@@ -410,6 +485,11 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
     {
         dim[i] = (long)mxGetDimensions(datastructure)[i];
     }
+    for (i = matlab_num_dims; i < HARP_MAX_NUM_DIMS; i++)
+    {
+        /* MATLAB drops trailing singleton dimensions */
+        dim[i] = 1;
+    }
 
     num_elements = (long)mxGetNumberOfElements(datastructure);
 
@@ -476,7 +556,6 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
     {
         case mxINT8_CLASS:
             {
-                long counter = 0;
                 int8_t *data;
                 int inner;
 
@@ -511,24 +590,12 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
                 mxFree(unit_string);
                 mxFree(des_string);
 
-                while (counter < num_elements)
-                {
-                    long j, k;
-
-                    for (j = 0; j < num_elements / dim[matlab_num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < dim[matlab_num_dims - 1]; k++)
-                        {
-                            variable_new->data.int8_data[counter++] =
-                                data[j + k * num_elements / dim[matlab_num_dims - 1]];
-                        }
-                    }
-                }
+                /* convert from column-major (MATLAB) to row-major (HARP) order */
+                reorder_data(harp_num_dims, dim, (int)sizeof(int8_t), data, variable_new->data.ptr, 0);
             }
             break;
         case mxINT16_CLASS:
             {
-                long counter = 0;
                 int16_t *data;
                 int inner;
 
@@ -564,25 +631,13 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
 
                 data = mxGetData(datastructure);
 
-                while (counter < num_elements)
-                {
-                    long j, k;
-
-                    for (j = 0; j < num_elements / dim[matlab_num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < dim[matlab_num_dims - 1]; k++)
-                        {
-                            variable_new->data.int16_data[counter++] =
-                                data[j + k * num_elements / dim[matlab_num_dims - 1]];
-                        }
-                    }
-                }
+                /* convert from column-major (MATLAB) to row-major (HARP) order */
+                reorder_data(harp_num_dims, dim, (int)sizeof(int16_t), data, variable_new->data.ptr, 0);
 
             }
             break;
         case mxINT32_CLASS:
             {
-                long counter = 0;
                 int32_t *data;
                 int inner;
 
@@ -618,24 +673,12 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
 
                 data = mxGetData(datastructure);
 
-                while (counter < num_elements)
-                {
-                    long j, k;
-
-                    for (j = 0; j < num_elements / dim[matlab_num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < dim[matlab_num_dims - 1]; k++)
-                        {
-                            variable_new->data.int32_data[counter++] =
-                                data[j + k * num_elements / dim[matlab_num_dims - 1]];
-                        }
-                    }
-                }
+                /* convert from column-major (MATLAB) to row-major (HARP) order */
+                reorder_data(harp_num_dims, dim, (int)sizeof(int32_t), data, variable_new->data.ptr, 0);
             }
             break;
         case mxDOUBLE_CLASS:
             {
-                long counter = 0;
                 double *data;
                 int inner;
 
@@ -671,24 +714,12 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
                 mxFree(des_string);
 
                 data = mxGetPr(datastructure);
-                while (counter < num_elements)
-                {
-                    long j, k;
-
-                    for (j = 0; j < num_elements / dim[matlab_num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < dim[matlab_num_dims - 1]; k++)
-                        {
-                            variable_new->data.double_data[counter++] =
-                                data[j + k * num_elements / dim[matlab_num_dims - 1]];
-                        }
-                    }
-                }
+                /* convert from column-major (MATLAB) to row-major (HARP) order */
+                reorder_data(harp_num_dims, dim, (int)sizeof(double), data, variable_new->data.ptr, 0);
             }
             break;
         case mxSINGLE_CLASS:
             {
-                long counter = 0;
                 float *data;
                 int inner;
 
@@ -722,19 +753,8 @@ static void harp_matlab_add_matlab_product_variable(harp_product **product, cons
                 mxFree(unit_string);
                 mxFree(des_string);
 
-                while (counter < num_elements)
-                {
-                    long j, k;
-
-                    for (j = 0; j < num_elements / dim[matlab_num_dims - 1]; j++)
-                    {
-                        for (k = 0; k < dim[matlab_num_dims - 1]; k++)
-                        {
-                            variable_new->data.float_data[counter++] =
-                                data[j + k * num_elements / dim[matlab_num_dims - 1]];
-                        }
-                    }
-                }
+                /* convert from column-major (MATLAB) to row-major (HARP) order */
+                reorder_data(harp_num_dims, dim, (int)sizeof(float), data, variable_new->data.ptr, 0);
 
             }
             break;
@@ -3,9 +3,9 @@ import _cffi_backend
 
 ffi = _cffi_backend.FFI('_harpc',
     _version = 0x2601,
-    _types = b'\x00\x00\x01\x0D\x00\x01\xBA\x03\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x00\x0B\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x01\x0B\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x07\x01\x00\x00\x00\x0F\x00\x00\x4B\x0D\x00\x00\x00\x0F\x00\x00\x5E\x0D\x00\x00\x04\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x01\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x9A\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x01\xC5\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x8F\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x09\x01\x00\x00\x4B\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x04\x11\x00\x00\x07\x01\x00\x00\x07\x03\x00\x00\x2F\x03\x00\x00\xA1\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x07\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x44\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x01\xC3\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x01\x11\x00\x00\x14\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x0E\x01\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x30\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x07\x01\x00\x00\x30\x11\x00\x00\x30\x11\x00\x00\x0A\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x04\x11\x00\x00\x06\x09\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x40\x11\x00\x00\x07\x01\x00\x00\x01\x03\x00\x00\x63\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x44\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x44\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x44\x11\x00\x00\x09\x01\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x44\x11\x00\x00\x09\x01\x00\x00\x01\x11\x00\x00\x09\x01\x00\x00\x01\x11\x00\x00\x09\x01\x00\x00\x07\x01\x00\x00\x4B\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x44\x11\x00\x00\x09\x01\x00\x01\xCA\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x84\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x01\xC4\x03\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x84\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x84\x11\x00\x00\x01\x11\x00\x01\xC6\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x84\x11\x00\x00\x01\x11\x00\x00\x2F\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x20\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x01\xC5\x03\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x01\xC7\x03\x00\x00\xA1\x11\x00\x00\xA1\x11\x00\x00\xA1\x11\x00\x00\x38\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x36\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x01\xC3\x03\x00\x00\x38\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x36\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x25\x11\x00\x00\x38\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x01\x11\x00\x00\x04\x03\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x36\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x01\xB2\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x07\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x07\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x44\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x07\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x25\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x9A\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x2A\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\xA1\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\xA1\x11\x00\x00\xA1\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x01\xC7\x03\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x07\x01\x00\x00\x63\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\xAF\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x07\x01\x00\x00\x63\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x25\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x09\x01\x00\x00\x09\x01\x00\x00\x94\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x9A\x11\x00\x00\x09\x01\x00\x00\x09\x01\x00\x00\x94\x11\x00\x00\x09\x01\x00\x00\x30\x11\x00\x00\x09\x01\x00\x00\x30\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x01\x11\x00\x00\xC0\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x36\x11\x00\x00\x38\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x01\x11\x00\x00\x38\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x01\x11\x00\x00\x5A\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x20\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x25\x11\x00\x00\x48\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x2A\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xA1\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xA1\x11\x00\x00\x04\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xA1\x11\x00\x00\xA1\x11\x00\x00\xA1\x11\x00\x00\xA1\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xA1\x11\x00\x00\xF0\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xA1\x11\x00\x00\x07\x01\x00\x00\x63\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xA1\x11\x00\x00\x09\x01\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xF0\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xF0\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xF0\x11\x00\x00\x07\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xF0\x11\x00\x00\x38\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xF0\x11\x00\x00\xA1\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\xF0\x11\x00\x00\x07\x01\x00\x00\x36\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x07\x01\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x07\x01\x00\x00\x30\x11\x00\x00\x30\x11\x00\x00\x30\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x07\x01\x00\x00\x30\x11\x00\x00\x30\x11\x00\x00\x07\x01\x00\x00\x30\x11\x00\x00\x30\x11\x00\x00\x5A\x11\x00\x00\x30\x11\x00\x00\x00\x0F\x00\x00\x0A\x0D\x00\x00\x00\x0F\x00\x00\x2F\x0D\x00\x00\x04\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x01\x11\x00\x00\x01\x0F\x00\x01\xD4\x0D\x00\x00\x44\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x84\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x84\x11\x00\x00\x48\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x9A\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x25\x11\x00\x00\x07\x01\x00\x00\x07\x01\x00\x00\x48\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x8F\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x8F\x11\x00\x00\x48\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\xA1\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\xA1\x11\x00\x00\x48\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\xA1\x11\x00\x00\x07\x01\x00\x00\x48\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x07\x01\x00\x00\x01\x11\x00\x00\x01\x0F\x00\x01\xD4\x0D\x00\x00\x17\x01\x00\x01\xBA\x03\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x18\x01\x00\x01\xB2\x11\x00\x00\x00\x0F\x00\x01\xD4\x0D\x00\x00\x00\x0F\x00\x00\x02\x01\x00\x00\x07\x05\x00\x00\x00\x08\x00\x01\xBE\x03\x00\x00\x0D\x01\x00\x00\x00\x09\x00\x01\xC1\x03\x00\x01\xC2\x03\x00\x00\x01\x09\x00\x00\x02\x09\x00\x00\x03\x09\x00\x00\x05\x09\x00\x00\x04\x09\x00\x00\x07\x09\x00\x01\xC9\x03\x00\x00\x13\x01\x00\x00\x15\x01\x00\x01\xCC\x03\x00\x00\x11\x01\x00\x00\x2F\x05\x00\x00\x00\x05\x00\x00\x2F\x05\x00\x00\x00\x08\x00\x01\xD2\x03\x00\x00\x08\x09\x00\x01\xD4\x03\x00\x00\x00\x01',
-    _globals = (b'\xFF\xFF\xFF\x1FHARP_ERROR_ARRAY_NUM_DIMS_MISMATCH',-308,b'\xFF\xFF\xFF\x1FHARP_ERROR_ARRAY_OUT_OF_BOUNDS',-309,b'\xFF\xFF\xFF\x1FHARP_ERROR_CODA',-105,b'\xFF\xFF\xFF\x1FHARP_ERROR_EXPORT',-601,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_CLOSE',-202,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_NOT_FOUND',-200,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_OPEN',-201,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_READ',-203,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_WRITE',-204,b'\xFF\xFF\xFF\x1FHARP_ERROR_HDF4',-100,b'\xFF\xFF\xFF\x1FHARP_ERROR_HDF5',-102,b'\xFF\xFF\xFF\x1FHARP_ERROR_IMPORT',-600,b'\xFF\xFF\xFF\x1FHARP_ERROR_INGESTION',-700,b'\xFF\xFF\xFF\x1FHARP_ERROR_INGESTION_OPTION_SYNTAX',-701,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_ARGUMENT',-300,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_DATETIME',-304,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_FORMAT',-303,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_INDEX',-301,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_INGESTION_OPTION',-702,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_INGESTION_OPTION_VALUE',-703,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_NAME',-302,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_PRODUCT',-306,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_TYPE',-305,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_VARIABLE',-307,b'\xFF\xFF\xFF\x1FHARP_ERROR_NETCDF',-104,b'\xFF\xFF\xFF\x1FHARP_ERROR_NO_DATA',-900,b'\xFF\xFF\xFF\x1FHARP_ERROR_NO_HDF4_SUPPORT',-101,b'\xFF\xFF\xFF\x1FHARP_ERROR_NO_HDF5_SUPPORT',-103,b'\xFF\xFF\xFF\x1FHARP_ERROR_OPERATION',-500,b'\xFF\xFF\xFF\x1FHARP_ERROR_OPERATION_SYNTAX',-501,b'\xFF\xFF\xFF\x1FHARP_ERROR_OUT_OF_MEMORY',-1,b'\xFF\xFF\xFF\x1FHARP_ERROR_UNIT_CONVERSION',-400,b'\xFF\xFF\xFF\x1FHARP_ERROR_UNSUPPORTED_PRODUCT',-800,b'\xFF\xFF\xFF\x1FHARP_ERROR_VARIABLE_NOT_FOUND',-310,b'\xFF\xFF\xFF\x1FHARP_MAX_NUM_DIMS',8,b'\xFF\xFF\xFF\x1FHARP_NUM_DATA_TYPES',6,b'\xFF\xFF\xFF\x1FHARP_NUM_DIM_TYPES',5,b'\xFF\xFF\xFF\x1FHARP_SUCCESS',0,b'\x00\x01\x83\x23harp_add_error_message',0,b'\x00\x00\x00\x23harp_basename',0,b'\x00\x00\x71\x23harp_collocation_result_add_pair',0,b'\x00\x01\x86\x23harp_collocation_result_delete',0,b'\x00\x00\x7B\x23harp_collocation_result_filter_for_collocation_indices',0,b'\x00\x00\x69\x23harp_collocation_result_filter_for_source_product_a',0,b'\x00\x00\x69\x23harp_collocation_result_filter_for_source_product_b',0,b'\x00\x00\x60\x23harp_collocation_result_new',0,b'\x00\x00\x3E\x23harp_collocation_result_read',0,b'\x00\x00\x6D\x23harp_collocation_result_remove_pair_at_index',0,b'\x00\x00\x66\x23harp_collocation_result_sort_by_a',0,b'\x00\x00\x66\x23harp_collocation_result_sort_by_b',0,b'\x00\x00\x66\x23harp_collocation_result_sort_by_collocation_index',0,b'\x00\x01\x86\x23harp_collocation_result_swap_datasets',0,b'\x00\x00\x42\x23harp_collocation_result_write',0,b'\x00\x00\x2C\x23harp_convert_unit',0,b'\x00\x00\x8C\x23harp_dataset_add_product',0,b'\x00\x01\x89\x23harp_dataset_delete',0,b'\x00\x00\x91\x23harp_dataset_get_index_from_source_product',0,b'\x00\x00\x83\x23harp_dataset_has_product',0,b'\x00\x00\x87\x23harp_dataset_import',0,b'\x00\x00\x80\x23harp_dataset_new',0,b'\x00\x01\x8C\x23harp_dataset_print',0,b'\xFF\xFF\xFF\x0Bharp_dimension_independent',-1,b'\xFF\xFF\xFF\x0Bharp_dimension_latitude',1,b'\xFF\xFF\xFF\x0Bharp_dimension_longitude',2,b'\xFF\xFF\xFF\x0Bharp_dimension_spectral',4,b'\xFF\xFF\xFF\x0Bharp_dimension_time',0,b'\xFF\xFF\xFF\x0Bharp_dimension_vertical',3,b'\x00\x00\x11\x23harp_doc_export_ingestion_definitions',0,b'\x00\x01\x30\x23harp_doc_list_conversions',0,b'\x00\x01\xB8\x23harp_done',0,b'\x00\x00\x0A\x21harp_errno',0,b'\x00\x00\x09\x23harp_errno_to_string',0,b'\x00\x00\x22\x23harp_export',0,b'\x00\x01\x6E\x23harp_geometry_get_area',0,b'\x00\x00\x4D\x23harp_geometry_get_point_distance',0,b'\x00\x01\x74\x23harp_geometry_has_area_overlap',0,b'\x00\x00\x54\x23harp_geometry_has_point_in_area',0,b'\x00\x00\x03\x23harp_get_data_type_name',0,b'\x00\x00\x06\x23harp_get_dimension_type_name',0,b'\x00\x00\x0E\x23harp_get_fill_value_for_type',0,b'\x00\x01\x7E\x23harp_get_option_enable_aux_afgl86',0,b'\x00\x01\x7E\x23harp_get_option_enable_aux_usstd76',0,b'\x00\x01\x7E\x23harp_get_option_hdf5_compression',0,b'\x00\x01\x7E\x23harp_get_option_regrid_out_of_bounds',0,b'\x00\x01\x80\x23harp_get_size_for_type',0,b'\x00\x00\x0E\x23harp_get_valid_max_for_type',0,b'\x00\x00\x0E\x23harp_get_valid_min_for_type',0,b'\x00\x00\x1C\x23harp_import',0,b'\x00\x00\x27\x23harp_import_product_metadata',0,b'\x00\x00\x46\x23harp_import_test',0,b'\x00\x01\x7E\x23harp_init',0,b'\x00\x00\x5C\x23harp_is_fill_value_for_type',0,b'\x00\x00\x5C\x23harp_is_valid_max_for_type',0,b'\x00\x00\x5C\x23harp_is_valid_min_for_type',0,b'\x00\x00\x4A\x23harp_isfinite',0,b'\x00\x00\x4A\x23harp_isinf',0,b'\x00\x00\x4A\x23harp_ismininf',0,b'\x00\x00\x4A\x23harp_isnan',0,b'\x00\x00\x4A\x23harp_isplusinf',0,b'\x00\x00\x0C\x23harp_mininf',0,b'\x00\x00\x0C\x23harp_nan',0,b'\x00\x00\x3A\x23harp_parse_dimension_type',0,b'\x00\x00\x0C\x23harp_plusinf',0,b'\x00\x00\xBD\x23harp_product_add_derived_variable',0,b'\x00\x00\xE5\x23harp_product_add_variable',0,b'\x00\x00\xDD\x23harp_product_append',0,b'\x00\x01\x02\x23harp_product_bin',0,b'\x00\x01\x08\x23harp_product_bin_spatial',0,b'\x00\x01\x2C\x23harp_product_copy',0,b'\x00\x01\x90\x23harp_product_delete',0,b'\x00\x00\xEE\x23harp_product_detach_variable',0,b'\x00\x00\x99\x23harp_product_execute_operations',0,b'\x00\x00\xCB\x23harp_product_flatten_dimension',0,b'\x00\x01\x19\x23harp_product_get_derived_variable',0,b'\x00\x00\xE1\x23harp_product_get_metadata',0,b'\x00\x00\x9D\x23harp_product_get_smoothed_column',0,b'\x00\x00\xA7\x23harp_product_get_smoothed_column_using_collocated_dataset',0,b'\x00\x00\xB2\x23harp_product_get_smoothed_column_using_collocated_product',0,b'\x00\x01\x22\x23harp_product_get_variable_by_name',0,b'\x00\x01\x27\x23harp_product_get_variable_index_by_name',0,b'\x00\x01\x15\x23harp_product_has_variable',0,b'\x00\x01\x12\x23harp_product_is_empty',0,b'\x00\x01\x99\x23harp_product_metadata_delete',0,b'\x00\x01\x34\x23harp_product_metadata_new',0,b'\x00\x01\x9C\x23harp_product_metadata_print',0,b'\x00\x00\x96\x23harp_product_new',0,b'\x00\x01\x93\x23harp_product_print',0,b'\x00\x00\xE9\x23harp_product_regrid_with_axis_variable',0,b'\x00\x00\xCF\x23harp_product_regrid_with_collocated_dataset',0,b'\x00\x00\xD6\x23harp_product_regrid_with_collocated_product',0,b'\x00\x00\xE5\x23harp_product_remove_variable',0,b'\x00\x00\x99\x23harp_product_remove_variable_by_name',0,b'\x00\x00\xE5\x23harp_product_replace_variable',0,b'\x00\x00\x99\x23harp_product_set_history',0,b'\x00\x00\x99\x23harp_product_set_source_product',0,b'\x00\x00\xF2\x23harp_product_smooth_vertical_with_collocated_dataset',0,b'\x00\x00\xFA\x23harp_product_smooth_vertical_with_collocated_product',0,b'\x00\x00\x99\x23harp_product_sort',0,b'\x00\x00\xC5\x23harp_product_update_history',0,b'\x00\x01\x12\x23harp_product_verify',0,b'\x00\x00\x14\x23harp_report_warning',0,b'\x00\x00\x11\x23harp_set_coda_definition_path',0,b'\x00\x00\x17\x23harp_set_coda_definition_path_conditional',0,b'\x00\x01\xAC\x23harp_set_error',0,b'\x00\x01\x6B\x23harp_set_option_enable_aux_afgl86',0,b'\x00\x01\x6B\x23harp_set_option_enable_aux_usstd76',0,b'\x00\x01\x6B\x23harp_set_option_hdf5_compression',0,b'\x00\x01\x6B\x23harp_set_option_regrid_out_of_bounds',0,b'\x00\x00\x11\x23harp_set_udunits2_xml_path',0,b'\x00\x00\x17\x23harp_set_udunits2_xml_path_conditional',0,b'\x00\x01\xB0\x23harp_str64',0,b'\x00\x01\xB4\x23harp_str64u',0,b'\xFF\xFF\xFF\x0Bharp_type_double',4,b'\xFF\xFF\xFF\x0Bharp_type_float',3,b'\xFF\xFF\xFF\x0Bharp_type_int16',1,b'\xFF\xFF\xFF\x0Bharp_type_int32',2,b'\xFF\xFF\xFF\x0Bharp_type_int8',0,b'\xFF\xFF\xFF\x0Bharp_type_string',5,b'\x00\x01\x45\x23harp_variable_append',0,b'\x00\x01\x3B\x23harp_variable_convert_data_type',0,b'\x00\x01\x37\x23harp_variable_convert_unit',0,b'\x00\x01\x5E\x23harp_variable_copy',0,b'\x00\x01\x62\x23harp_variable_copy_attributes',0,b'\x00\x01\xA0\x23harp_variable_delete',0,b'\x00\x01\x5A\x23harp_variable_has_dimension_type',0,b'\x00\x01\x66\x23harp_variable_has_dimension_types',0,b'\x00\x01\x56\x23harp_variable_has_unit',0,b'\x00\x00\x32\x23harp_variable_new',0,b'\x00\x01\xA7\x23harp_variable_print',0,b'\x00\x01\xA3\x23harp_variable_print_data',0,b'\x00\x01\x37\x23harp_variable_rename',0,b'\x00\x01\x37\x23harp_variable_set_description',0,b'\x00\x01\x49\x23harp_variable_set_enumeration_values',0,b'\x00\x01\x4E\x23harp_variable_set_string_data_element',0,b'\x00\x01\x37\x23harp_variable_set_unit',0,b'\x00\x01\x3F\x23harp_variable_smooth_vertical',0,b'\x00\x01\x53\x23harp_variable_verify',0,b'\x00\x00\x01\x21libharp_version',0),
-    _struct_unions = ((b'\x00\x00\x01\xBF\x00\x00\x00\x03harp_array_union',b'\x00\x01\xCB\x11int8_data',b'\x00\x01\xC8\x11int16_data',b'\x00\x00\x7E\x11int32_data',b'\x00\x01\xBD\x11float_data',b'\x00\x00\x30\x11double_data',b'\x00\x00\xC9\x11string_data',b'\x00\x01\xD3\x11ptr'),(b'\x00\x00\x01\xC2\x00\x00\x00\x02harp_collocation_pair_struct',b'\x00\x00\x2F\x11collocation_index',b'\x00\x00\x2F\x11product_index_a',b'\x00\x00\x2F\x11sample_index_a',b'\x00\x00\x2F\x11product_index_b',b'\x00\x00\x2F\x11sample_index_b',b'\x00\x00\x0A\x11num_differences',b'\x00\x00\x30\x11difference'),(b'\x00\x00\x01\xC3\x00\x00\x00\x02harp_collocation_result_struct',b'\x00\x00\x84\x11dataset_a',b'\x00\x00\x84\x11dataset_b',b'\x00\x00\x0A\x11num_differences',b'\x00\x00\xC9\x11difference_variable_name',b'\x00\x00\xC9\x11difference_unit',b'\x00\x00\x2F\x11num_pairs',b'\x00\x01\xC0\x11pair'),(b'\x00\x00\x01\xC4\x00\x00\x00\x02harp_dataset_struct',b'\x00\x01\xD1\x11product_to_index',b'\x00\x00\xC9\x11source_product',b'\x00\x00\x94\x11sorted_index',b'\x00\x00\x2F\x11num_products',b'\x00\x00\x2A\x11metadata'),(b'\x00\x00\x01\xC6\x00\x00\x00\x02harp_product_metadata_struct',b'\x00\x01\xB2\x11filename',b'\x00\x00\x4B\x11datetime_start',b'\x00\x00\x4B\x11datetime_stop',b'\x00\x01\xCD\x11dimension',b'\x00\x01\xB2\x11source_product'),(b'\x00\x00\x01\xC5\x00\x00\x00\x02harp_product_struct',b'\x00\x01\xCD\x11dimension',b'\x00\x00\x0A\x11num_variables',b'\x00\x00\x38\x11variable',b'\x00\x01\xB2\x11source_product',b'\x00\x01\xB2\x11history'),(b'\x00\x00\x00\x5E\x00\x00\x00\x03harp_scalar_union',b'\x00\x01\xCC\x11int8_data',b'\x00\x01\xC9\x11int16_data',b'\x00\x01\xCA\x11int32_data',b'\x00\x01\xBE\x11float_data',b'\x00\x00\x4B\x11double_data'),(b'\x00\x00\x01\xC7\x00\x00\x00\x02harp_variable_struct',b'\x00\x01\xB2\x11name',b'\x00\x00\x04\x11data_type',b'\x00\x00\x0A\x11num_dimensions',b'\x00\x01\xBB\x11dimension_type',b'\x00\x01\xCF\x11dimension',b'\x00\x00\x2F\x11num_elements',b'\x00\x01\xBF\x11data',b'\x00\x01\xB2\x11description',b'\x00\x01\xB2\x11unit',b'\x00\x00\x5E\x11valid_min',b'\x00\x00\x5E\x11valid_max',b'\x00\x00\x0A\x11num_enum_values',b'\x00\x00\xC9\x11enum_name'),(b'\x00\x00\x01\xD2\x00\x00\x00\x10hashtable_struct',)),
-    _enums = (b'\x00\x00\x00\x04\x00\x00\x00\x16harp_data_type_enum\x00harp_type_int8,harp_type_int16,harp_type_int32,harp_type_float,harp_type_double,harp_type_string',b'\x00\x00\x00\x07\x00\x00\x00\x15harp_dimension_type_enum\x00harp_dimension_independent,harp_dimension_time,harp_dimension_latitude,harp_dimension_longitude,harp_dimension_vertical,harp_dimension_spectral'),
-    _typenames = (b'\x00\x00\x01\xBFharp_array',b'\x00\x00\x01\xC2harp_collocation_pair',b'\x00\x00\x01\xC3harp_collocation_result',b'\x00\x00\x00\x04harp_data_type',b'\x00\x00\x01\xC4harp_dataset',b'\x00\x00\x00\x07harp_dimension_type',b'\x00\x00\x01\xC5harp_product',b'\x00\x00\x01\xC6harp_product_metadata',b'\x00\x00\x00\x5Eharp_scalar',b'\x00\x00\x01\xC7harp_variable'),
+    _types = b'\x00\x00\x01\x0D\x00\x02\x20\x03\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x00\x0B\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x01\x0B\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x02\x0B\x00\x00\x00\x0F\x00\x00\x01\x0D\x00\x00\x07\x01\x00\x00\x00\x0F\x00\x00\x6E\x0D\x00\x00\x00\x0F\x00\x00\x81\x0D\x00\x00\x04\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x02\x15\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\xC7\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x01\xF6\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\xBF\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x02\x2C\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x3D\x11\x00\x00\x09\x01\x00\x01\x6A\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\xB7\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x09\x01\x00\x00\x6E\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x04\x11\x00\x00\x07\x01\x00\x00\x07\x03\x00\x00\x43\x03\x00\x00\xCE\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x07\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x63\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x02\x29\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x3D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x01\x11\x00\x00\x17\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x0E\x01\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x4F\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x0E\x01\x00\x00\x0E\x01\x00\x00\x07\x01\x00\x00\x4F\x11\x00\x00\x4F\x11\x00\x00\x0D\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x04\x11\x00\x00\x09\x09\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x0A\x11\x00\x01\xC7\x03\x00\x00\x85\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x5F\x11\x00\x00\x07\x01\x00\x00\x01\x03\x00\x00\x8B\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x63\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x63\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x63\x11\x00\x00\x09\x01\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x63\x11\x00\x00\x09\x01\x00\x00\x01\x11\x00\x00\x09\x01\x00\x00\x01\x11\x00\x00\x09\x01\x00\x00\x07\x01\x00\x00\x6E\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x63\x11\x00\x00\x09\x01\x00\x02\x36\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xAC\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x02\x2A\x03\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xAC\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xAC\x11\x00\x00\x01\x11\x00\x02\x2E\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xAC\x11\x00\x00\x01\x11\x00\x00\x43\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x02\x2B\x03\x00\x00\x01\x11\x00\x00\x2D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x2D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x02\x2C\x03\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x02\x30\x03\x00\x00\xCE\x11\x00\x00\xCE\x11\x00\x00\xCE\x11\x00\x00\x57\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x55\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x02\x29\x03\x00\x00\x57\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x55\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x3D\x11\x00\x00\x57\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x01\x11\x00\x00\x04\x03\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x55\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x27\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x07\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x07\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x63\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x07\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x3D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\xC7\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x49\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\xCE\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\xCE\x11\x00\x00\xCE\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x02\x30\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x07\x01\x00\x00\x8B\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\xDC\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x07\x01\x00\x00\x8B\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x3D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x09\x01\x00\x00\x09\x01\x00\x00\xBC\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xC7\x11\x00\x00\x09\x01\x00\x00\x09\x01\x00\x00\xBC\x11\x00\x00\x09\x01\x00\x00\x4F\x11\x00\x00\x09\x01\x00\x00\x4F\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x01\x11\x00\x00\xED\x11\x00\x00\x01\x11\x00\x00\x07\x01\x00\x00\x55\x11\x00\x00\x57\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x01\x11\x00\x00\x57\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x01\x11\x00\x00\x7D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x01\x11\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x3D\x11\x00\x00\x2D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x02\x2D\x03\x00\x00\x85\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x49\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x02\x2F\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x6A\x11\x00\x00\x3D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x00\x04\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x00\xCE\x11\x00\x00\xCE\x11\x00\x00\xCE\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x01\x1D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x00\x07\x01\x00\x00\x8B\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x00\x09\x01\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\xCE\x11\x00\x01\xD9\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x1D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x1D\x11\x00\x00\x01\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x1D\x11\x00\x00\x07\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x1D\x11\x00\x00\x57\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x1D\x11\x00\x00\xCE\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\x1D\x11\x00\x00\x07\x01\x00\x00\x55\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x07\x01\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x07\x01\x00\x00\x8B\x11\x00\x00\x01\x11\x00\x00\x01\x11\x00\x00\x2D\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x07\x01\x00\x00\x4F\x11\x00\x00\x4F\x11\x00\x00\x4F\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x07\x01\x00\x00\x4F\x11\x00\x00\x4F\x11\x00\x00\x07\x01\x00\x00\x4F\x11\x00\x00\x4F\x11\x00\x00\x7D\x11\x00\x00\x4F\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x85\x11\x00\x00\x85\x11\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x17\x01\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x01\xD5\x03\x00\x01\xD8\x03\x00\x02\x1B\x03\x00\x00\x00\x0F\x00\x00\x0D\x0D\x00\x00\x00\x0F\x00\x01\xC7\x0D\x00\x00\x00\x0F\x00\x00\x43\x0D\x00\x00\x04\x11\x00\x00\x00\x0F\x00\x01\xD9\x0D\x00\x00\x1C\x01\x00\x00\x00\x0F\x00\x01\xD9\x0D\x00\x02\x3F\x03\x00\x00\x1C\x01\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\x01\x11\x00\x00\x01\x0F\x00\x02\x3F\x0D\x00\x00\x63\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xAC\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xAC\x11\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xBF\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xC7\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\x3D\x11\x00\x00\x07\x01\x00\x00\x07\x01\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x02\x2D\x03\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x01\x63\x11\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xB7\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xB7\x11\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xCE\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xCE\x11\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\xCE\x11\x00\x00\x07\x01\x00\x00\x6B\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\x07\x01\x00\x00\x01\x11\x00\x00\x01\x0F\x00\x02\x3F\x0D\x00\x00\x17\x01\x00\x02\x20\x03\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\x18\x01\x00\x02\x15\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x01\xD9\x11\x00\x00\x00\x0F\x00\x02\x3F\x0D\x00\x00\x00\x0F\x00\x00\x02\x01\x00\x00\x07\x05\x00\x00\x00\x08\x00\x02\x24\x03\x00\x00\x0D\x01\x00\x00\x00\x09\x00\x02\x27\x03\x00\x02\x28\x03\x00\x00\x01\x09\x00\x00\x02\x09\x00\x00\x03\x09\x00\x00\x04\x09\x00\x00\x07\x09\x00\x00\x05\x09\x00\x00\x06\x09\x00\x00\x08\x09\x00\x00\x0B\x09\x00\x02\x32\x03\x00\x02\x33\x03\x00\x00\x0A\x09\x00\x02\x35\x03\x00\x00\x13\x01\x00\x00\x15\x01\x00\x02\x38\x03\x00\x00\x11\x01\x00\x00\x43\x05\x00\x00\x00\x05\x00\x00\x43\x05\x00\x00\x00\x08\x00\x02\x3E\x03\x00\x00\x0C\x09\x00\x00\x00\x01',
+    _globals = (b'\xFF\xFF\xFF\x1FHARP_ERROR_ARRAY_NUM_DIMS_MISMATCH',-308,b'\xFF\xFF\xFF\x1FHARP_ERROR_ARRAY_OUT_OF_BOUNDS',-309,b'\xFF\xFF\xFF\x1FHARP_ERROR_CODA',-105,b'\xFF\xFF\xFF\x1FHARP_ERROR_EXPORT',-601,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_CLOSE',-202,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_NOT_FOUND',-200,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_OPEN',-201,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_READ',-203,b'\xFF\xFF\xFF\x1FHARP_ERROR_FILE_WRITE',-204,b'\xFF\xFF\xFF\x1FHARP_ERROR_HDF4',-100,b'\xFF\xFF\xFF\x1FHARP_ERROR_HDF5',-102,b'\xFF\xFF\xFF\x1FHARP_ERROR_IMPORT',-600,b'\xFF\xFF\xFF\x1FHARP_ERROR_INGESTION',-700,b'\xFF\xFF\xFF\x1FHARP_ERROR_INGESTION_OPTION_SYNTAX',-701,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_ARGUMENT',-300,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_DATETIME',-304,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_FORMAT',-303,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_INDEX',-301,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_INGESTION_OPTION',-702,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_INGESTION_OPTION_VALUE',-703,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_NAME',-302,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_PRODUCT',-306,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_TYPE',-305,b'\xFF\xFF\xFF\x1FHARP_ERROR_INVALID_VARIABLE',-307,b'\xFF\xFF\xFF\x1FHARP_ERROR_NETCDF',-104,b'\xFF\xFF\xFF\x1FHARP_ERROR_NO_DATA',-900,b'\xFF\xFF\xFF\x1FHARP_ERROR_NO_HDF4_SUPPORT',-101,b'\xFF\xFF\xFF\x1FHARP_ERROR_NO_HDF5_SUPPORT',-103,b'\xFF\xFF\xFF\x1FHARP_ERROR_OPERATION',-500,b'\xFF\xFF\xFF\x1FHARP_ERROR_OPERATION_SYNTAX',-501,b'\xFF\xFF\xFF\x1FHARP_ERROR_OUT_OF_MEMORY',-1,b'\xFF\xFF\xFF\x1FHARP_ERROR_UNIT_CONVERSION',-400,b'\xFF\xFF\xFF\x1FHARP_ERROR_UNSUPPORTED_PRODUCT',-800,b'\xFF\xFF\xFF\x1FHARP_ERROR_VARIABLE_NOT_FOUND',-310,b'\xFF\xFF\xFF\x1FHARP_MAX_NUM_DIMS',8,b'\xFF\xFF\xFF\x1FHARP_NUM_DATA_TYPES',6,b'\xFF\xFF\xFF\x1FHARP_NUM_DIM_TYPES',5,b'\xFF\xFF\xFF\x1FHARP_NUM_MEMORY_SUBSYSTEMS',4,b'\xFF\xFF\xFF\x1FHARP_SUCCESS',0,b'\x00\x01\xDC\x23harp_add_error_message',0,b'\x00\x00\x00\x23harp_basename',0,b'\x00\x00\x99\x23harp_collocation_result_add_pair',0,b'\x00\x01\xDF\x23harp_collocation_result_delete',0,b'\x00\x00\xA3\x23harp_collocation_result_filter_for_collocation_indices',0,b'\x00\x00\x91\x23harp_collocation_result_filter_for_source_product_a',0,b'\x00\x00\x91\x23harp_collocation_result_filter_for_source_product_b',0,b'\x00\x00\x88\x23harp_collocation_result_new',0,b'\x00\x00\x5D\x23harp_collocation_result_read',0,b'\x00\x00\x95\x23harp_collocation_result_remove_pair_at_index',0,b'\x00\x00\x8E\x23harp_collocation_result_sort_by_a',0,b'\x00\x00\x8E\x23harp_collocation_result_sort_by_b',0,b'\x00\x00\x8E\x23harp_collocation_result_sort_by_collocation_index',0,b'\x00\x01\xDF\x23harp_collocation_result_swap_datasets',0,b'\x00\x00\x61\x23harp_collocation_result_write',0,b'\x00\x00\x1F\x23harp_convert',0,b'\x00\x00\x4B\x23harp_convert_unit',0,b'\x00\x00\xB4\x23harp_dataset_add_product',0,b'\x00\x01\xE2\x23harp_dataset_delete',0,b'\x00\x00\xB9\x23harp_dataset_get_index_from_source_product',0,b'\x00\x00\xAB\x23harp_dataset_has_product',0,b'\x00\x00\xAF\x23harp_dataset_import',0,b'\x00\x00\xA8\x23harp_dataset_new',0,b'\x00\x01\xE5\x23harp_dataset_print',0,b'\xFF\xFF\xFF\x0Bharp_dimension_independent',-1,b'\xFF\xFF\xFF\x0Bharp_dimension_latitude',1,b'\xFF\xFF\xFF\x0Bharp_dimension_longitude',2,b'\xFF\xFF\xFF\x0Bharp_dimension_spectral',4,b'\xFF\xFF\xFF\x0Bharp_dimension_time',0,b'\xFF\xFF\xFF\x0Bharp_dimension_vertical',3,b'\x00\x00\x14\x23harp_doc_export_ingestion_definitions',0,b'\x00\x01\x59\x23harp_doc_list_conversions',0,b'\x00\x02\x1E\x23harp_done',0,b'\x00\x00\x0D\x21harp_errno',0,b'\x00\x00\x0C\x23harp_errno_to_string',0,b'\x00\x00\x3A\x23harp_export',0,b'\x00\x00\x65\x23harp_export_append',0,b'\x00\x01\xB2\x23harp_geometry_get_area',0,b'\x00\x00\x70\x23harp_geometry_get_point_distance',0,b'\x00\x01\xB8\x23harp_geometry_has_area_overlap',0,b'\x00\x00\x77\x23harp_geometry_has_point_in_area',0,b'\x00\x00\x03\x23harp_get_data_type_name',0,b'\x00\x00\x06\x23harp_get_dimension_type_name',0,b'\x00\x00\x11\x23harp_get_fill_value_for_type',0,b'\x00\x00\x09\x23harp_get_memory_subsystem_name',0,b'\x00\x01\xC2\x23harp_get_memory_usage',0,b'\x00\x00\x83\x23harp_get_memory_usage_for_subsystem',0,b'\x00\x01\xCE\x23harp_get_option_enable_aux_afgl86',0,b'\x00\x01\xCE\x23harp_get_option_enable_aux_usstd76',0,b'\x00\x01\xCE\x23harp_get_option_hdf5_compression',0,b'\x00\x01\xD0\x23harp_get_option_memory_limit',0,b'\x00\x01\xCE\x23harp_get_option_ragged_vertical',0,b'\x00\x01\xCE\x23harp_get_option_regrid_out_of_bounds',0,b'\x00\x01\xCE\x23harp_get_option_test_num_workers',0,b'\x00\x01\xD2\x23harp_get_size_for_type',0,b'\x00\x00\x11\x23harp_get_valid_max_for_type',0,b'\x00\x00\x11\x23harp_get_valid_min_for_type',0,b'\x00\x00\x29\x23harp_import',0,b'\x00\x01\xAB\x23harp_import_concatenated',0,b'\x00\x00\x2F\x23harp_import_estimate',0,b'\x00\x00\x46\x23harp_import_product_metadata',0,b'\x00\x01\xE9\x23harp_import_session_delete',0,b'\x00\x00\xBE\x23harp_import_session_import',0,b'\x00\x00\x35\x23harp_import_session_new',0,b'\x00\x00\x69\x23harp_import_test',0,b'\x00\x01\xCE\x23harp_init',0,b'\x00\x00\x7F\x23harp_is_fill_value_for_type',0,b'\x00\x00\x7F\x23harp_is_valid_max_for_type',0,b'\x00\x00\x7F\x23harp_is_valid_min_for_type',0,b'\x00\x00\x6D\x23harp_isfinite',0,b'\x00\x00\x6D\x23harp_isinf',0,b'\x00\x00\x6D\x23harp_ismininf',0,b'\x00\x00\x6D\x23harp_isnan',0,b'\x00\x00\x6D\x23harp_isplusinf',0,b'\xFF\xFF\xFF\x0Bharp_memory_subsystem_export',3,b'\xFF\xFF\xFF\x0Bharp_memory_subsystem_general',0,b'\xFF\xFF\xFF\x0Bharp_memory_subsystem_import',1,b'\xFF\xFF\xFF\x0Bharp_memory_subsystem_operations',2,b'\x00\x00\x0F\x23harp_mininf',0,b'\x00\x00\x0F\x23harp_nan',0,b'\x00\x00\x59\x23harp_parse_dimension_type',0,b'\x00\x00\x0F\x23harp_plusinf',0,b'\x00\x00\xEA\x23harp_product_add_derived_variable',0,b'\x00\x01\x12\x23harp_product_add_variable',0,b'\x00\x01\x0A\x23harp_product_append',0,b'\x00\x01\x2F\x23harp_product_bin',0,b'\x00\x01\x35\x23harp_product_bin_spatial',0,b'\x00\x01\x5E\x23harp_product_copy',0,b'\x00\x01\xEC\x23harp_product_delete',0,b'\x00\x01\x1B\x23harp_product_detach_variable',0,b'\x00\x01\xF5\x23harp_product_estimate_delete',0,b'\x00\x01\x62\x23harp_product_estimate_get_storage_size',0,b'\x00\x01\xF8\x23harp_product_estimate_print',0,b'\x00\x00\xC6\x23harp_product_execute_operations',0,b'\x00\x00\xF8\x23harp_product_flatten_dimension',0,b'\x00\x01\x46\x23harp_product_get_derived_variable',0,b'\x00\x01\x0E\x23harp_product_get_metadata',0,b'\x00\x00\xCA\x23harp_product_get_smoothed_column',0,b'\x00\x00\xD4\x23harp_product_get_smoothed_column_using_collocated_dataset',0,b'\x00\x00\xDF\x23harp_product_get_smoothed_column_using_collocated_product',0,b'\x00\x01\x4F\x23harp_product_get_variable_by_name',0,b'\x00\x01\x54\x23harp_product_get_variable_index_by_name',0,b'\x00\x01\x42\x23harp_product_has_variable',0,b'\x00\x01\x3F\x23harp_product_is_empty',0,b'\x00\x01\xFC\x23harp_product_metadata_delete',0,b'\x00\x01\x66\x23harp_product_metadata_new',0,b'\x00\x01\xFF\x23harp_product_metadata_print',0,b'\x00\x00\xC3\x23harp_product_new',0,b'\x00\x01\xEF\x23harp_product_print',0,b'\x00\x01\x16\x23harp_product_regrid_with_axis_variable',0,b'\x00\x00\xFC\x23harp_product_regrid_with_collocated_dataset',0,b'\x00\x01\x03\x23harp_product_regrid_with_collocated_product',0,b'\x00\x01\x12\x23harp_product_remove_variable',0,b'\x00\x00\xC6\x23harp_product_remove_variable_by_name',0,b'\x00\x01\x12\x23harp_product_replace_variable',0,b'\x00\x00\xC6\x23harp_product_set_history',0,b'\x00\x00\xC6\x23harp_product_set_source_product',0,b'\x00\x01\x1F\x23harp_product_smooth_vertical_with_collocated_dataset',0,b'\x00\x01\x27\x23harp_product_smooth_vertical_with_collocated_product',0,b'\x00\x00\xC6\x23harp_product_sort',0,b'\x00\x00\xF2\x23harp_product_update_history',0,b'\x00\x01\x3F\x23harp_product_verify',0,b'\x00\x01\x69\x23harp_product_writer_close',0,b'\x00\x00\x3F\x23harp_product_writer_open',0,b'\x00\x01\x6C\x23harp_product_writer_write',0,b'\x00\x00\x17\x23harp_report_warning',0,b'\x00\x00\x14\x23harp_set_coda_definition_path',0,b'\x00\x00\x1A\x23harp_set_coda_definition_path_conditional',0,b'\x00\x02\x0F\x23harp_set_error',0,b'\x00\x01\xC9\x23harp_set_memory_allocator',0,b'\x00\x01\xA8\x23harp_set_option_enable_aux_afgl86',0,b'\x00\x01\xA8\x23harp_set_option_enable_aux_usstd76',0,b'\x00\x01\xA8\x23harp_set_option_hdf5_compression',0,b'\x00\x01\xC6\x23harp_set_option_memory_limit',0,b'\x00\x01\xA8\x23harp_set_option_ragged_vertical',0,b'\x00\x01\xA8\x23harp_set_option_regrid_out_of_bounds',0,b'\x00\x01\xA8\x23harp_set_option_test_num_workers',0,b'\x00\x00\x14\x23harp_set_udunits2_xml_path',0,b'\x00\x00\x1A\x23harp_set_udunits2_xml_path_conditional',0,b'\x00\x02\x13\x23harp_str64',0,b'\x00\x02\x17\x23harp_str64u',0,b'\x00\x00\x14\x23harp_trace_start',0,b'\x00\x01\xCE\x23harp_trace_stop',0,b'\xFF\xFF\xFF\x0Bharp_type_double',4,b'\xFF\xFF\xFF\x0Bharp_type_float',3,b'\xFF\xFF\xFF\x0Bharp_type_int16',1,b'\xFF\xFF\xFF\x0Bharp_type_int32',2,b'\xFF\xFF\xFF\x0Bharp_type_int8',0,b'\xFF\xFF\xFF\x0Bharp_type_string',5,b'\x00\x01\x7E\x23harp_variable_append',0,b'\x00\x01\x74\x23harp_variable_convert_data_type',0,b'\x00\x01\x70\x23harp_variable_convert_unit',0,b'\x00\x01\x9B\x23harp_variable_copy',0,b'\x00\x01\x9F\x23harp_variable_copy_attributes',0,b'\x00\x02\x1B\x23harp_variable_data_delete',0,b'\x00\x02\x03\x23harp_variable_delete',0,b'\x00\x01\x8C\x23harp_variable_detach_data',0,b'\x00\x01\x97\x23harp_variable_has_dimension_type',0,b'\x00\x01\xA3\x23harp_variable_has_dimension_types',0,b'\x00\x01\x93\x23harp_variable_has_unit',0,b'\x00\x00\x51\x23harp_variable_new',0,b'\x00\x02\x0A\x23harp_variable_print',0,b'\x00\x02\x06\x23harp_variable_print_data',0,b'\x00\x01\x70\x23harp_variable_rename',0,b'\x00\x01\x70\x23harp_variable_set_description',0,b'\x00\x01\x82\x23harp_variable_set_enumeration_values',0,b'\x00\x01\x87\x23harp_variable_set_string_data_element',0,b'\x00\x01\x70\x23harp_variable_set_unit',0,b'\x00\x01\x78\x23harp_variable_smooth_vertical',0,b'\x00\x01\x90\x23harp_variable_verify',0,b'\x00\x00\x01\x21libharp_version',0),
+    _struct_unions = ((b'\x00\x00\x02\x25\x00\x00\x00\x03harp_array_union',b'\x00\x02\x37\x11int8_data',b'\x00\x02\x34\x11int16_data',b'\x00\x00\xA6\x11int32_data',b'\x00\x02\x23\x11float_data',b'\x00\x00\x4F\x11double_data',b'\x00\x00\x27\x11string_data',b'\x00\x01\xD9\x11ptr'),(b'\x00\x00\x02\x28\x00\x00\x00\x02harp_collocation_pair_struct',b'\x00\x00\x43\x11collocation_index',b'\x00\x00\x43\x11product_index_a',b'\x00\x00\x43\x11sample_index_a',b'\x00\x00\x43\x11product_index_b',b'\x00\x00\x43\x11sample_index_b',b'\x00\x00\x0D\x11num_differences',b'\x00\x00\x4F\x11difference'),(b'\x00\x00\x02\x29\x00\x00\x00\x02harp_collocation_result_struct',b'\x00\x00\xAC\x11dataset_a',b'\x00\x00\xAC\x11dataset_b',b'\x00\x00\x0D\x11num_differences',b'\x00\x00\x27\x11difference_variable_name',b'\x00\x00\x27\x11difference_unit',b'\x00\x00\x43\x11num_pairs',b'\x00\x02\x26\x11pair'),(b'\x00\x00\x02\x2A\x00\x00\x00\x02harp_dataset_struct',b'\x00\x02\x3D\x11product_to_index',b'\x00\x00\x27\x11source_product',b'\x00\x00\xBC\x11sorted_index',b'\x00\x00\x43\x11num_products',b'\x00\x00\x49\x11metadata'),(b'\x00\x00\x02\x2B\x00\x00\x00\x10harp_import_session_struct',),(b'\x00\x00\x02\x2D\x00\x00\x00\x02harp_product_estimate_struct',b'\x00\x02\x39\x11dimension',b'\x00\x00\x0D\x11num_variables',b'\x00\x02\x31\x11variable',b'\x00\x00\x0D\x11is_upper_bound',b'\x00\x00\x0D\x11num_unresolved_operations'),(b'\x00\x00\x02\x2E\x00\x00\x00\x02harp_product_metadata_struct',b'\x00\x02\x15\x11filename',b'\x00\x00\x6E\x11datetime_start',b'\x00\x00\x6E\x11datetime_stop',b'\x00\x02\x39\x11dimension',b'\x00\x02\x15\x11source_product'),(b'\x00\x00\x02\x2C\x00\x00\x00\x02harp_product_struct',b'\x00\x02\x39\x11dimension',b'\x00\x00\x0D\x11num_variables',b'\x00\x00\x57\x11variable',b'\x00\x02\x15\x11source_product',b'\x00\x02\x15\x11history'),(b'\x00\x00\x02\x2F\x00\x00\x00\x10harp_product_writer_struct',),(b'\x00\x00\x00\x81\x00\x00\x00\x03harp_scalar_union',b'\x00\x02\x38\x11int8_data',b'\x00\x02\x35\x11int16_data',b'\x00\x02\x36\x11int32_data',b'\x00\x02\x24\x11float_data',b'\x00\x00\x6E\x11double_data'),(b'\x00\x00\x02\x33\x00\x00\x00\x02harp_variable_estimate_struct',b'\x00\x02\x15\x11name',b'\x00\x00\x04\x11data_type',b'\x00\x00\x0D\x11num_dimensions',b'\x00\x02\x21\x11dimension_type',b'\x00\x02\x3B\x11dimension'),(b'\x00\x00\x02\x30\x00\x00\x00\x02harp_variable_struct',b'\x00\x02\x15\x11name',b'\x00\x00\x04\x11data_type',b'\x00\x00\x0D\x11num_dimensions',b'\x00\x02\x21\x11dimension_type',b'\x00\x02\x3B\x11dimension',b'\x00\x00\x43\x11num_elements',b'\x00\x02\x25\x11data',b'\x00\x02\x15\x11description',b'\x00\x02\x15\x11unit',b'\x00\x00\x81\x11valid_min',b'\x00\x00\x81\x11valid_max',b'\x00\x00\x0D\x11num_enum_values',b'\x00\x00\x27\x11enum_name'),(b'\x00\x00\x02\x3E\x00\x00\x00\x10hashtable_struct',)),
+    _enums = (b'\x00\x00\x00\x04\x00\x00\x00\x16harp_data_type_enum\x00harp_type_int8,harp_type_int16,harp_type_int32,harp_type_float,harp_type_double,harp_type_string',b'\x00\x00\x00\x07\x00\x00\x00\x15harp_dimension_type_enum\x00harp_dimension_independent,harp_dimension_time,harp_dimension_latitude,harp_dimension_longitude,harp_dimension_vertical,harp_dimension_spectral',b'\x00\x00\x00\x0A\x00\x00\x00\x16harp_memory_subsystem_enum\x00harp_memory_subsystem_general,harp_memory_subsystem_import,harp_memory_subsystem_operations,harp_memory_subsystem_export'),
+    _typenames = (b'\x00\x00\x02\x25harp_array',b'\x00\x00\x02\x28harp_collocation_pair',b'\x00\x00\x02\x29harp_collocation_result',b'\x00\x00\x00\x04harp_data_type',b'\x00\x00\x02\x2Aharp_dataset',b'\x00\x00\x00\x07harp_dimension_type',b'\x00\x00\x02\x2Bharp_import_session',b'\x00\x00\x00\x0Aharp_memory_subsystem',b'\x00\x00\x02\x2Charp_product',b'\x00\x00\x02\x2Dharp_product_estimate',b'\x00\x00\x02\x2Eharp_product_metadata',b'\x00\x00\x02\x2Fharp_product_writer',b'\x00\x00\x00\x81harp_scalar',b'\x00\x00\x02\x30harp_variable',b'\x00\x00\x02\x33harp_variable_estimate'),
 )
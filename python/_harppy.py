@@ -723,22 +723,32 @@ def _import_scalar(c_data_type, c_data):
 
     raise UnsupportedTypeError("unsupported C data type code '%d'" % c_data_type)
 
-def _import_array(c_data_type, c_num_elements, c_data):
+def _import_array(c_variable):
+    c_data_type = c_variable.data_type
+    c_num_elements = c_variable.num_elements
+
     if c_data_type == _lib.harp_type_string:
         data = numpy.empty((c_num_elements,), dtype=numpy.object)
         for i in range(c_num_elements):
             # NB. The _ffi.string() method returns a copy of the C string.
-            data[i] = _decode_string(_ffi.string(c_data.string_data[i]))
+            data[i] = _decode_string(_ffi.string(c_variable.data.string_data[i]))
         return data
 
-    # NB. The _ffi.buffer() method, as well as the numpy.frombuffer() method, provide a view on the C array; neither
-    # method incurs a copy.
-    c_data_buffer = _ffi.buffer(c_data.ptr, c_num_elements * _lib.harp_get_size_for_type(c_data_type))
-    return numpy.copy(numpy.frombuffer(c_data_buffer, dtype=_get_py_data_type(c_data_type)))
+    # Take over ownership of the C data buffer instead of copying it. The buffer is released by
+    # harp_variable_data_delete() when the cdata object returned by _ffi.gc() is garbage collected. Both the
+    # _ffi.buffer() and the numpy.frombuffer() methods provide a view without a copy and keep a reference to the object
+    # they were created from, so the buffer stays alive for as long as the NumPy array (or any view on it) exists.
+    c_data_ptr = _ffi.new("void **")
+    if _lib.harp_variable_detach_data(_ffi.addressof(c_variable), c_data_ptr) != 0:
+        raise CLibraryError()
+    c_data = _ffi.gc(c_data_ptr[0], _lib.harp_variable_data_delete)
+
+    c_data_buffer = _ffi.buffer(c_data, c_num_elements * _lib.harp_get_size_for_type(c_data_type))
+    return numpy.frombuffer(c_data_buffer, dtype=_get_py_data_type(c_data_type))
 
 def _import_variable(c_variable):
     # Import variable data.
-    data = _import_array(c_variable.data_type, c_variable.num_elements, c_variable.data)
+    data = _import_array(c_variable)
 
     num_dimensions = c_variable.num_dimensions
     if num_dimensions == 0:
@@ -1032,9 +1042,9 @@ def import_product(filename, operations="", options=""):
     modules.
 
     If the filename argument is a list of filenames or a globbing (glob.glob())
-    pattern then the harp.import_product() function will be called on each
-    individual file and the result of harp.concatenate() on the imported products
-    will be returned.
+    pattern then each individual file will be imported and the imported products
+    will be concatenated (see harp.concatenate()) by the HARP C library. Files for
+    which the import results in an empty product will be skipped.
 
     Arguments:
     filename -- Filename, list of filenames or file pattern of the product(s) to import
@@ -1054,23 +1064,20 @@ def import_product(filename, operations="", options=""):
         filenames = sorted(glob.glob(filename))
         if len(filenames) == 0:
             raise Error("no files matching '%s'" % (filename))
-    if filenames is not None:
-        products = []
-        for file in filenames:
-            try:
-                product = import_product(file, operations, options)
-                products.append(product)
-            except NoDataError:
-                pass
-        if len(products) == 0:
-            raise NoDataError()
-        return concatenate(products)
 
     c_product_ptr = _ffi.new("harp_product **")
 
-    # Import the product as a C product.
-    if _lib.harp_import(_encode_path(filename), _encode_string(operations), _encode_string(options), c_product_ptr) != 0:
-        raise CLibraryError()
+    if filenames is not None:
+        # Import and concatenate the products as a single C product.
+        c_filenames = [_ffi.new("char[]", _encode_path(file)) for file in filenames]
+        if _lib.harp_import_concatenated(len(c_filenames), _ffi.new("char *[]", c_filenames),
+                                         _encode_string(operations), _encode_string(options), c_product_ptr) != 0:
+            raise CLibraryError()
+    else:
+        # Import the product as a C product.
+        if _lib.harp_import(_encode_path(filename), _encode_string(operations), _encode_string(options),
+                            c_product_ptr) != 0:
+            raise CLibraryError()
 
     try:
         # Raise an exception if the imported C product contains no variables, or variables without data.
@@ -1081,8 +1088,11 @@ def import_product(filename, operations="", options=""):
         product = _import_product(c_product_ptr[0])
 
         if operations or options:
-            # Update history
-            command = "harp.import_product('{0}'".format(filename)
+            # Update history (a list of filenames is recorded as a single command covering all files)
+            if filenames is None or isinstance(filename, bytes) or isinstance(filename, str):
+                command = "harp.import_product('{0}'".format(filename)
+            else:
+                command = "harp.import_product([{0}]".format(",".join("'{0}'".format(file) for file in filenames))
             if operations:
                 command += ",operations='{0}'".format(operations)
             if options:
@@ -0,0 +1,1093 @@
+/*
+ * Copyright (C) 2015-2018 S[&]T, The Netherlands.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* harpbench uses internal libharp functions (e.g. harp_array_transpose()) and should therefore be linked against a
+ * libharp build that exports all symbols */
+
+#include "harp-internal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* number of across-track pixels per scanline of a synthetic swath */
+#define NUM_PIXELS_PER_SCANLINE 60
+
+/* number of samples per product when testing harp_product_append() */
+#define APPEND_CHUNK_SIZE 1000
+
+/* ratio between the number of samples of dataset A and dataset B for the matchup benchmark */
+#define MATCHUP_SAMPLE_RATIO 100
+
+int matchup(int argc, char *argv[]);
+
+typedef enum synthetic_product_type_enum
+{
+    synthetic_swath,
+    synthetic_profile,
+    synthetic_spectra
+} synthetic_product_type;
+
+#define NUM_SYNTHETIC_PRODUCT_TYPES 3
+
+static const char *synthetic_product_type_name[NUM_SYNTHETIC_PRODUCT_TYPES] = { "swath", "profile", "spectra" };
+
+typedef struct bench_options_struct
+{
+    long num_samples;
+    long num_vertical;
+    long num_spectral;
+    int num_repeats;
+    unsigned long seed;
+    char workdir[HARP_MAX_PATH_LENGTH];
+} bench_options;
+
+typedef struct bench_run_struct
+{
+    double seconds;     /* duration of the timed part of the benchmark */
+    long num_elements;  /* number of elements (samples, array elements, or pairs) that were processed */
+    int64_t num_bytes;  /* number of bytes of variable data (or file data) that were processed */
+} bench_run;
+
+typedef struct benchmark_struct
+{
+    const char *name;
+    const char *description;
+    int (*run) (const bench_options *options, bench_run *run);
+} benchmark;
+
+static uint64_t random_state;
+
+static void random_seed(unsigned long seed)
+{
+    /* xorshift requires a non-zero state */
+    random_state = 0x9E3779B97F4A7C15ULL ^ (uint64_t)seed;
+    if (random_state == 0)
+    {
+        random_state = 1;
+    }
+}
+
+/* deterministic uniform random number in [0, 1) (xorshift64*) */
+static double random_uniform(void)
+{
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+
+    return (double)((random_state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+static double get_time(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (double)tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+static int64_t get_product_data_size(const harp_product *product)
+{
+    int64_t size = 0;
+    int i;
+
+    for (i = 0; i < product->num_variables; i++)
+    {
+        size += product->variable[i]->num_elements * (int64_t)harp_get_size_for_type(product->variable[i]->data_type);
+    }
+
+    return size;
+}
+
+static int add_variable(harp_product *product, const char *name, harp_data_type data_type, int num_dimensions,
+                        const harp_dimension_type *dimension_type, const long *dimension, const char *unit,
+                        harp_variable **new_variable)
+{
+    harp_variable *variable;
+
+    if (harp_variable_new(name, data_type, num_dimensions, dimension_type, dimension, &variable) != 0)
+    {
+        return -1;
+    }
+    if (unit != NULL && harp_variable_set_unit(variable, unit) != 0)
+    {
+        harp_variable_delete(variable);
+        return -1;
+    }
+    if (harp_product_add_variable(product, variable) != 0)
+    {
+        harp_variable_delete(variable);
+        return -1;
+    }
+    *new_variable = variable;
+
+    return 0;
+}
+
+/* Generate a synthetic product.
+ * All product types contain a swath of ground pixels (NUM_PIXELS_PER_SCANLINE across-track pixels per scanline) that
+ * covers the globe from south to north, with datetime, footprint, and geometry information.
+ * A 'profile' product adds vertical profiles and a 'spectra' product adds (L1-like) spectra.
+ * The content is fully determined by the random seed (see random_seed()) and the provided dimension lengths.
+ */
+static int generate_product(synthetic_product_type type, long num_samples, long num_vertical, long num_spectral,
+                            harp_product **new_product)
+{
+    harp_dimension_type dimension_type[2] = { harp_dimension_time, harp_dimension_independent };
+    harp_product *product;
+    harp_variable *datetime;
+    harp_variable *latitude;
+    harp_variable *longitude;
+    harp_variable *latitude_bounds;
+    harp_variable *longitude_bounds;
+    harp_variable *solar_zenith_angle;
+    harp_variable *cloud_fraction;
+    harp_variable *column;
+    long num_scanlines = (num_samples + NUM_PIXELS_PER_SCANLINE - 1) / NUM_PIXELS_PER_SCANLINE;
+    long dimension[2];
+    long i, j;
+
+    if (harp_product_new(&product) != 0)
+    {
+        return -1;
+    }
+    if (harp_product_set_source_product(product, synthetic_product_type_name[type]) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+
+    dimension[0] = num_samples;
+    dimension[1] = 4;
+    if (add_variable(product, "datetime", harp_type_double, 1, dimension_type, dimension, "s since 2000-01-01",
+                     &datetime) != 0 ||
+        add_variable(product, "latitude", harp_type_double, 1, dimension_type, dimension, "degree_north",
+                     &latitude) != 0 ||
+        add_variable(product, "longitude", harp_type_double, 1, dimension_type, dimension, "degree_east",
+                     &longitude) != 0 ||
+        add_variable(product, "latitude_bounds", harp_type_double, 2, dimension_type, dimension, "degree_north",
+                     &latitude_bounds) != 0 ||
+        add_variable(product, "longitude_bounds", harp_type_double, 2, dimension_type, dimension, "degree_east",
+                     &longitude_bounds) != 0 ||
+        add_variable(product, "solar_zenith_angle", harp_type_float, 1, dimension_type, dimension, "degree",
+                     &solar_zenith_angle) != 0 ||
+        add_variable(product, "cloud_fraction", harp_type_float, 1, dimension_type, dimension, HARP_UNIT_DIMENSIONLESS,
+                     &cloud_fraction) != 0 ||
+        add_variable(product, "O3_column_number_density", harp_type_double, 1, dimension_type, dimension, "mol/m2",
+                     &column) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+
+    for (i = 0; i < num_samples; i++)
+    {
+        long scanline = i / NUM_PIXELS_PER_SCANLINE;
+        long pixel = i % NUM_PIXELS_PER_SCANLINE;
+        double lat, lon;
+
+        lat = -85.0 + 170.0 * (scanline + 0.5) / num_scanlines + 0.01 * (random_uniform() - 0.5);
+        lon = -179.5 + fmod(7.3 * scanline + 0.5 * pixel + 0.01 * random_uniform(), 359.0);
+
+        datetime->data.double_data[i] = 6e8 + 0.5 * scanline;
+        latitude->data.double_data[i] = lat;
+        longitude->data.double_data[i] = lon;
+        latitude_bounds->data.double_data[4 * i] = lat - 0.1;
+        latitude_bounds->data.double_data[4 * i + 1] = lat - 0.1;
+        latitude_bounds->data.double_data[4 * i + 2] = lat + 0.1;
+        latitude_bounds->data.double_data[4 * i + 3] = lat + 0.1;
+        longitude_bounds->data.double_data[4 * i] = lon - 0.25;
+        longitude_bounds->data.double_data[4 * i + 1] = lon + 0.25;
+        longitude_bounds->data.double_data[4 * i + 2] = lon + 0.25;
+        longitude_bounds->data.double_data[4 * i + 3] = lon - 0.25;
+        solar_zenith_angle->data.float_data[i] = (float)(20.0 + 0.75 * fabs(lat) + random_uniform());
+        cloud_fraction->data.float_data[i] = (float)random_uniform();
+        column->data.double_data[i] = 0.1 + 0.05 * random_uniform();
+    }
+
+    if (type == synthetic_profile)
+    {
+        harp_variable *altitude;
+        harp_variable *pressure;
+        harp_variable *number_density;
+
+        dimension_type[1] = harp_dimension_vertical;
+        dimension[1] = num_vertical;
+        if (add_variable(product, "altitude", harp_type_double, 2, dimension_type, dimension, "km", &altitude) != 0 ||
+            add_variable(product, "pressure", harp_type_double, 2, dimension_type, dimension, "hPa", &pressure) != 0 ||
+            add_variable(product, "O3_number_density", harp_type_double, 2, dimension_type, dimension, "molec/cm3",
+                         &number_density) != 0)
+        {
+            harp_product_delete(product);
+            return -1;
+        }
+        for (i = 0; i < num_samples; i++)
+        {
+            for (j = 0; j < num_vertical; j++)
+            {
+                double z = 60.0 * j / num_vertical;
+
+                altitude->data.double_data[i * num_vertical + j] = z;
+                pressure->data.double_data[i * num_vertical + j] = 1013.25 * exp(-z / 7.0);
+                number_density->data.double_data[i * num_vertical + j] =
+                    5e12 * exp(-(z - 22.0) * (z - 22.0) / 50.0) * (1.0 + 0.1 * (random_uniform() - 0.5));
+            }
+        }
+    }
+    else if (type == synthetic_spectra)
+    {
+        harp_variable *wavelength;
+        harp_variable *radiance;
+
+        dimension_type[1] = harp_dimension_spectral;
+        dimension[1] = num_spectral;
+        if (add_variable(product, "wavelength", harp_type_double, 2, dimension_type, dimension, "nm",
+                         &wavelength) != 0 ||
+            add_variable(product, "photon_radiance", harp_type_double, 2, dimension_type, dimension,
+                         "count/s/cm2/sr/nm", &radiance) != 0)
+        {
+            harp_product_delete(product);
+            return -1;
+        }
+        for (i = 0; i < num_samples; i++)
+        {
+            for (j = 0; j < num_spectral; j++)
+            {
+                double lambda = 270.0 + 230.0 * j / num_spectral + 0.01 * (i % NUM_PIXELS_PER_SCANLINE);
+
+                wavelength->data.double_data[i * num_spectral + j] = lambda;
+                radiance->data.double_data[i * num_spectral + j] = 1e13 * (lambda / 500.0) * (1.0 + 0.05 *
+                                                                                                random_uniform());
+            }
+        }
+    }
+
+    *new_product = product;
+
+    return 0;
+}
+
+static int bench_append(const bench_options *options, bench_run *run)
+{
+    harp_product **chunk;
+    harp_product *product;
+    long num_chunks = (options->num_samples + APPEND_CHUNK_SIZE - 1) / APPEND_CHUNK_SIZE;
+    double start;
+    long i, k;
+
+    chunk = malloc(num_chunks * sizeof(harp_product *));
+    if (chunk == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       num_chunks * sizeof(harp_product *), __FILE__, __LINE__);
+        return -1;
+    }
+    for (i = 0; i < num_chunks; i++)
+    {
+        long num_samples = APPEND_CHUNK_SIZE;
+
+        if (i == num_chunks - 1)
+        {
+            num_samples = options->num_samples - i * APPEND_CHUNK_SIZE;
+        }
+        if (generate_product(synthetic_profile, num_samples, options->num_vertical, 0, &chunk[i]) != 0)
+        {
+            while (i > 0)
+            {
+                i--;
+                harp_product_delete(chunk[i]);
+            }
+            free(chunk);
+            return -1;
+        }
+    }
+
+    /* the first chunk is the product to which all other chunks are appended (as is done by harpmerge) */
+    product = chunk[0];
+    start = get_time();
+    for (i = 1; i < num_chunks; i++)
+    {
+        if (harp_product_append(product, chunk[i]) != 0)
+        {
+            break;
+        }
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = product->dimension[harp_dimension_time];
+    run->num_bytes = get_product_data_size(product);
+
+    for (k = 0; k < num_chunks; k++)
+    {
+        harp_product_delete(chunk[k]);
+    }
+    free(chunk);
+
+    return i == num_chunks ? 0 : -1;
+}
+
+static int bench_transpose(const bench_options *options, bench_run *run)
+{
+    harp_product *product;
+    harp_variable *variable;
+    double start;
+
+    if (generate_product(synthetic_spectra, options->num_samples, 0, options->num_spectral, &product) != 0)
+    {
+        return -1;
+    }
+    if (harp_product_get_variable_by_name(product, "photon_radiance", &variable) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+
+    start = get_time();
+    if (harp_array_transpose(variable->data_type, variable->num_dimensions, variable->dimension, NULL,
+                             variable->data) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = variable->num_elements;
+    run->num_bytes = variable->num_elements * (int64_t)sizeof(double);
+
+    harp_product_delete(product);
+
+    return 0;
+}
+
+static int bench_bin_spatial(const bench_options *options, bench_run *run)
+{
+    harp_product *product;
+    double latitude_edges[181];
+    double longitude_edges[361];
+    long *time_bin_index;
+    int64_t num_bytes;
+    double start;
+    long i;
+
+    for (i = 0; i < 181; i++)
+    {
+        latitude_edges[i] = -90.0 + i;
+    }
+    for (i = 0; i < 361; i++)
+    {
+        longitude_edges[i] = -180.0 + i;
+    }
+
+    time_bin_index = calloc(options->num_samples, sizeof(long));
+    if (time_bin_index == NULL)
+    {
+        harp_set_error(HARP_ERROR_OUT_OF_MEMORY, "out of memory (could not allocate %lu bytes) (%s:%u)",
+                       options->num_samples * sizeof(long), __FILE__, __LINE__);
+        return -1;
+    }
+    if (generate_product(synthetic_swath, options->num_samples, 0, 0, &product) != 0)
+    {
+        free(time_bin_index);
+        return -1;
+    }
+    num_bytes = get_product_data_size(product);
+
+    start = get_time();
+    if (harp_product_bin_spatial(product, 1, options->num_samples, time_bin_index, 181, latitude_edges, 361,
+                                 longitude_edges) != 0)
+    {
+        harp_product_delete(product);
+        free(time_bin_index);
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = options->num_samples;
+    run->num_bytes = num_bytes;
+
+    harp_product_delete(product);
+    free(time_bin_index);
+
+    return 0;
+}
+
+static int bench_collocation_io(const bench_options *options, bench_run *run)
+{
+    const char *difference_variable_name[2] = { "datetime", "point_distance" };
+    const char *difference_unit[2] = { "s", "km" };
+    harp_collocation_result *collocation_result;
+    char filename[HARP_MAX_PATH_LENGTH];
+    struct stat statbuf;
+    double start;
+    long i;
+
+    snprintf(filename, HARP_MAX_PATH_LENGTH, "%s/collocation.csv", options->workdir);
+
+    if (harp_collocation_result_new(&collocation_result, 2, difference_variable_name, difference_unit) != 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < options->num_samples; i++)
+    {
+        double difference[2];
+
+        difference[0] = 3600 * random_uniform();
+        difference[1] = 50 * random_uniform();
+        if (harp_collocation_result_add_pair(collocation_result, i, (i % 2 == 0) ? "A_1.nc" : "A_2.nc", i / 2,
+                                             "B_1.nc", i / MATCHUP_SAMPLE_RATIO, 2, difference) != 0)
+        {
+            harp_collocation_result_delete(collocation_result);
+            return -1;
+        }
+    }
+
+    start = get_time();
+    if (harp_collocation_result_write(filename, collocation_result) != 0)
+    {
+        harp_collocation_result_delete(collocation_result);
+        return -1;
+    }
+    harp_collocation_result_delete(collocation_result);
+    if (harp_collocation_result_read(filename, &collocation_result) != 0)
+    {
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = collocation_result->num_pairs;
+    run->num_bytes = (stat(filename, &statbuf) == 0) ? (int64_t)statbuf.st_size : 0;
+
+    harp_collocation_result_delete(collocation_result);
+    unlink(filename);
+
+    return 0;
+}
+
+static int bench_convert_unit(const bench_options *options, bench_run *run)
+{
+    harp_product *product;
+    harp_variable *variable;
+    double start;
+
+    if (generate_product(synthetic_profile, options->num_samples, options->num_vertical, 0, &product) != 0)
+    {
+        return -1;
+    }
+    if (harp_product_get_variable_by_name(product, "O3_number_density", &variable) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+
+    start = get_time();
+    if (harp_variable_convert_unit(variable, "mol/m3") != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = variable->num_elements;
+    run->num_bytes = variable->num_elements * (int64_t)sizeof(double);
+
+    harp_product_delete(product);
+
+    return 0;
+}
+
+static int bench_filter(const bench_options *options, bench_run *run)
+{
+    harp_product *product;
+    int64_t num_bytes;
+    double start;
+
+    if (generate_product(synthetic_profile, options->num_samples, options->num_vertical, 0, &product) != 0)
+    {
+        return -1;
+    }
+    num_bytes = get_product_data_size(product);
+
+    start = get_time();
+    if (harp_product_execute_operations(product, "latitude >= -60 [degree_north]; latitude <= 60 [degree_north];"
+                                        "solar_zenith_angle < 80 [degree]; cloud_fraction < 0.5") != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = options->num_samples;
+    run->num_bytes = num_bytes;
+
+    harp_product_delete(product);
+
+    return 0;
+}
+
+static int bench_export(const bench_options *options, bench_run *run, const char *format)
+{
+    harp_product *product;
+    char filename[HARP_MAX_PATH_LENGTH];
+    double start;
+
+    snprintf(filename, HARP_MAX_PATH_LENGTH, "%s/export.%s", options->workdir, strcmp(format, "netcdf") == 0 ? "nc" :
+             "h5");
+
+    if (generate_product(synthetic_profile, options->num_samples, options->num_vertical, 0, &product) != 0)
+    {
+        return -1;
+    }
+
+    start = get_time();
+    if (harp_export(filename, format, product) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = options->num_samples;
+    run->num_bytes = get_product_data_size(product);
+
+    harp_product_delete(product);
+    unlink(filename);
+
+    return 0;
+}
+
+static int bench_export_netcdf(const bench_options *options, bench_run *run)
+{
+    return bench_export(options, run, "netcdf");
+}
+
+static int bench_export_hdf5(const bench_options *options, bench_run *run)
+{
+    return bench_export(options, run, "hdf5");
+}
+
+static int bench_import_netcdf(const bench_options *options, bench_run *run)
+{
+    harp_product *product;
+    char filename[HARP_MAX_PATH_LENGTH];
+    double start;
+
+    snprintf(filename, HARP_MAX_PATH_LENGTH, "%s/import.nc", options->workdir);
+
+    if (generate_product(synthetic_profile, options->num_samples, options->num_vertical, 0, &product) != 0)
+    {
+        return -1;
+    }
+    if (harp_export(filename, "netcdf", product) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    harp_product_delete(product);
+
+    start = get_time();
+    if (harp_import(filename, NULL, NULL, &product) != 0)
+    {
+        unlink(filename);
+        return -1;
+    }
+    run->seconds = get_time() - start;
+    run->num_elements = product->dimension[harp_dimension_time];
+    run->num_bytes = get_product_data_size(product);
+
+    harp_product_delete(product);
+    unlink(filename);
+
+    return 0;
+}
+
+/* Collocate a swath (dataset A) with a sparse set of profiles (dataset B) using harpcollocate's matchup.
+ * The timing includes the import of the products of both datasets.
+ */
+static int bench_matchup(const bench_options *options, bench_run *run)
+{
+    harp_product *product_a;
+    harp_product *product_b;
+    char dataset_a[HARP_MAX_PATH_LENGTH];
+    char dataset_b[HARP_MAX_PATH_LENGTH];
+    char filename_a[HARP_MAX_PATH_LENGTH];
+    char filename_b[HARP_MAX_PATH_LENGTH];
+    char output[HARP_MAX_PATH_LENGTH];
+    char *argv[9];
+    struct stat statbuf;
+    long num_samples_b;
+    double start;
+    int result;
+
+    snprintf(dataset_a, HARP_MAX_PATH_LENGTH, "%s/dataset_a", options->workdir);
+    snprintf(dataset_b, HARP_MAX_PATH_LENGTH, "%s/dataset_b", options->workdir);
+    snprintf(filename_a, HARP_MAX_PATH_LENGTH, "%s/swath.nc", dataset_a);
+    snprintf(filename_b, HARP_MAX_PATH_LENGTH, "%s/profile.nc", dataset_b);
+    snprintf(output, HARP_MAX_PATH_LENGTH, "%s/matchup.csv", options->workdir);
+
+    if (mkdir(dataset_a, 0700) != 0 || mkdir(dataset_b, 0700) != 0)
+    {
+        harp_set_error(HARP_ERROR_FILE_WRITE, "could not create directory in '%s' (%s:%u)", options->workdir,
+                       __FILE__, __LINE__);
+        rmdir(dataset_a);
+        return -1;
+    }
+
+    num_samples_b = options->num_samples / MATCHUP_SAMPLE_RATIO;
+    if (num_samples_b < 1)
+    {
+        num_samples_b = 1;
+    }
+
+    result = generate_product(synthetic_swath, options->num_samples, 0, 0, &product_a);
+    if (result == 0)
+    {
+        result = harp_export(filename_a, "netcdf", product_a);
+        if (result == 0)
+        {
+            result = generate_product(synthetic_profile, num_samples_b, options->num_vertical, 0, &product_b);
+        }
+        if (result == 0)
+        {
+            const char *name[3] = { "datetime", "latitude", "longitude" };
+            int k;
+
+            /* place each profile at the location and time of every MATCHUP_SAMPLE_RATIO-th swath pixel */
+            for (k = 0; k < 3; k++)
+            {
+                harp_variable *variable_a;
+                harp_variable *variable_b;
+                long i;
+
+                if (harp_product_get_variable_by_name(product_a, name[k], &variable_a) != 0 ||
+                    harp_product_get_variable_by_name(product_b, name[k], &variable_b) != 0)
+                {
+                    result = -1;
+                    break;
+                }
+                for (i = 0; i < num_samples_b; i++)
+                {
+                    variable_b->data.double_data[i] = variable_a->data.double_data[i * MATCHUP_SAMPLE_RATIO];
+                }
+            }
+            if (result == 0)
+            {
+                result = harp_export(filename_b, "netcdf", product_b);
+            }
+            harp_product_delete(product_b);
+        }
+        harp_product_delete(product_a);
+    }
+    if (result == 0)
+    {
+        argv[0] = "matchup";
+        argv[1] = "-d";
+        argv[2] = "datetime 60 [s]";
+        argv[3] = "-d";
+        argv[4] = "point_distance 100 [km]";
+        argv[5] = dataset_a;
+        argv[6] = dataset_b;
+        argv[7] = output;
+        argv[8] = NULL;
+
+        start = get_time();
+        result = matchup(8, argv);
+        run->seconds = get_time() - start;
+        run->num_elements = options->num_samples;
+        run->num_bytes = (stat(output, &statbuf) == 0) ? (int64_t)statbuf.st_size : 0;
+    }
+
+    unlink(output);
+    unlink(filename_a);
+    unlink(filename_b);
+    rmdir(dataset_a);
+    rmdir(dataset_b);
+
+    return result == 0 ? 0 : -1;
+}
+
+static benchmark benchmark_list[] = {
+    {"append", "harp_product_append() of profile products of 1000 samples", bench_append},
+    {"transpose", "harp_array_transpose() of a [time,spectral] double array", bench_transpose},
+    {"bin_spatial", "harp_product_bin_spatial() of a swath to a 1x1 degree grid", bench_bin_spatial},
+    {"collocation_io", "harp_collocation_result_write()/harp_collocation_result_read()", bench_collocation_io},
+    {"convert_unit", "harp_variable_convert_unit() of a [time,vertical] variable", bench_convert_unit},
+    {"filter", "filter operations (harp_product_execute_operations()) on a profile product", bench_filter},
+    {"export_netcdf", "harp_export() of a profile product to netCDF", bench_export_netcdf},
+    {"export_hdf5", "harp_export() of a profile product to HDF5", bench_export_hdf5},
+    {"import_netcdf", "harp_import() of a profile product from netCDF", bench_import_netcdf},
+    {"matchup", "harpcollocate matchup of a swath with profiles (including import)", bench_matchup},
+    {NULL, NULL, NULL}
+};
+
+static int run_benchmark(const benchmark *bench, const bench_options *options)
+{
+    bench_run run;
+    double total_seconds = 0;
+    double best_seconds = 0;
+    int i;
+
+    for (i = 0; i < options->num_repeats; i++)
+    {
+        /* each repetition uses the same synthetic data */
+        random_seed(options->seed);
+        memset(&run, 0, sizeof(run));
+        if (bench->run(options, &run) != 0)
+        {
+            return -1;
+        }
+        total_seconds += run.seconds;
+        if (i == 0 || run.seconds < best_seconds)
+        {
+            best_seconds = run.seconds;
+        }
+    }
+
+    printf("%s,%ld,%lld,%d,%.6f,%.6f,%.6g,%.6g\n", bench->name, run.num_elements, (long long)run.num_bytes,
+           options->num_repeats, best_seconds, total_seconds / options->num_repeats,
+           best_seconds > 0 ? run.num_elements / best_seconds : 0.0,
+           best_seconds > 0 ? run.num_bytes / best_seconds : 0.0);
+    fflush(stdout);
+
+    return 0;
+}
+
+static int print_warning(const char *message, va_list ap)
+{
+    int result;
+
+    fprintf(stderr, "WARNING: ");
+    result = vfprintf(stderr, message, ap);
+    fprintf(stderr, "\n");
+
+    return result;
+}
+
+static void print_version(void)
+{
+    printf("harpbench version %s\n", libharp_version);
+    printf("Copyright (C) 2015-2018 S[&]T, The Netherlands.\n");
+}
+
+static void print_help(void)
+{
+    printf("Usage:\n");
+    printf("    harpbench [options] [benchmark...]\n");
+    printf("        Run microbenchmarks of HARP library functions on synthetic products.\n");
+    printf("        If no benchmarks are given, all benchmarks are run.\n");
+    printf("        Results are written to stdout in csv format with the columns:\n");
+    printf("            benchmark, num_elements, num_bytes, num_repeats, best_seconds,\n");
+    printf("            mean_seconds, elements_per_second, bytes_per_second\n");
+    printf("        where the throughput is based on the best (fastest) repetition.\n");
+    printf("\n");
+    printf("        Options:\n");
+    printf("            -n, --num-samples <n>\n");
+    printf("                Length of the time dimension of the synthetic products\n");
+    printf("                (default: 100000).\n");
+    printf("            --num-vertical <n>\n");
+    printf("                Length of the vertical dimension of profile products\n");
+    printf("                (default: 50).\n");
+    printf("            --num-spectral <n>\n");
+    printf("                Length of the spectral dimension of spectra products\n");
+    printf("                (default: 1000).\n");
+    printf("            -r, --repeat <n>\n");
+    printf("                Number of repetitions per benchmark (default: 5).\n");
+    printf("            -s, --seed <n>\n");
+    printf("                Seed for the generation of the synthetic data (default: 1).\n");
+    printf("\n");
+    printf("    harpbench --generate <type> [options] <output product file>\n");
+    printf("        Generate a synthetic HARP product (in netCDF format).\n");
+    printf("        The product content is fully determined by the seed and dimension\n");
+    printf("        lengths. Available types:\n");
+    printf("            swath   : ground pixels with datetime, footprints and geometry\n");
+    printf("            profile : swath with vertical profiles\n");
+    printf("            spectra : swath with radiance spectra\n");
+    printf("        The options -n, --num-vertical, --num-spectral, and -s (see above)\n");
+    printf("        can be used to control the product.\n");
+    printf("\n");
+    printf("    harpbench --list\n");
+    printf("        List the available benchmarks.\n");
+    printf("\n");
+    printf("    harpbench -h, --help\n");
+    printf("        Show help (this text).\n");
+    printf("\n");
+    printf("    harpbench -v, --version\n");
+    printf("        Print the version number of HARP and exit.\n");
+    printf("\n");
+}
+
+static int parse_long_argument(const char *str, long *value)
+{
+    char *endptr;
+
+    *value = strtol(str, &endptr, 10);
+    if (*endptr != '\0' || *value < 1)
+    {
+        fprintf(stderr, "ERROR: invalid argument: '%s'\n", str);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int generate(const bench_options *options, const char *type_name, const char *filename)
+{
+    harp_product *product;
+    int type;
+
+    for (type = 0; type < NUM_SYNTHETIC_PRODUCT_TYPES; type++)
+    {
+        if (strcmp(type_name, synthetic_product_type_name[type]) == 0)
+        {
+            break;
+        }
+    }
+    if (type == NUM_SYNTHETIC_PRODUCT_TYPES)
+    {
+        fprintf(stderr, "ERROR: invalid product type '%s'\n", type_name);
+        return -1;
+    }
+
+    random_seed(options->seed);
+    if (generate_product((synthetic_product_type)type, options->num_samples, options->num_vertical,
+                         options->num_spectral, &product) != 0)
+    {
+        fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
+        return -1;
+    }
+    if (harp_export(filename, "netcdf", product) != 0)
+    {
+        fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
+        harp_product_delete(product);
+        return -1;
+    }
+    harp_product_delete(product);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options;
+    const char *generate_type = NULL;
+    const char *tmpdir;
+    int result = 0;
+    int i, k;
+
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))
+    {
+        print_help();
+        exit(0);
+    }
+
+    if (argc > 1 && (strcmp(argv[1], "-v") == 0 || strcmp(argv[1], "--version") == 0))
+    {
+        print_version();
+        exit(0);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--list") == 0)
+    {
+        for (k = 0; benchmark_list[k].name != NULL; k++)
+        {
+            printf("%-16s %s\n", benchmark_list[k].name, benchmark_list[k].description);
+        }
+        exit(0);
+    }
+
+    options.num_samples = 100000;
+    options.num_vertical = 50;
+    options.num_spectral = 1000;
+    options.num_repeats = 5;
+    options.seed = 1;
+
+    for (i = 1; i < argc; i++)
+    {
+        long value;
+
+        if (i == 1 && strcmp(argv[i], "--generate") == 0 && i + 1 < argc && argv[i + 1][0] != '-')
+        {
+            generate_type = argv[i + 1];
+            i++;
+        }
+        else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--num-samples") == 0) && i + 1 < argc)
+        {
+            if (parse_long_argument(argv[i + 1], &options.num_samples) != 0)
+            {
+                exit(1);
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "--num-vertical") == 0 && i + 1 < argc)
+        {
+            if (parse_long_argument(argv[i + 1], &options.num_vertical) != 0)
+            {
+                exit(1);
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "--num-spectral") == 0 && i + 1 < argc)
+        {
+            if (parse_long_argument(argv[i + 1], &options.num_spectral) != 0)
+            {
+                exit(1);
+            }
+            i++;
+        }
+        else if ((strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--repeat") == 0) && i + 1 < argc)
+        {
+            if (parse_long_argument(argv[i + 1], &value) != 0 || value > 1000000)
+            {
+                exit(1);
+            }
+            options.num_repeats = (int)value;
+            i++;
+        }
+        else if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--seed") == 0) && i + 1 < argc)
+        {
+            char *endptr;
+
+            options.seed = strtoul(argv[i + 1], &endptr, 10);
+            if (*endptr != '\0')
+            {
+                fprintf(stderr, "ERROR: invalid argument: '%s'\n", argv[i + 1]);
+                exit(1);
+            }
+            i++;
+        }
+        else if (argv[i][0] != '-')
+        {
+            /* assume all arguments from here on are benchmark names (or the output file) */
+            break;
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: invalid arguments\n");
+            print_help();
+            exit(1);
+        }
+    }
+
+    if (generate_type != NULL && i != argc - 1)
+    {
+        fprintf(stderr, "ERROR: invalid arguments\n");
+        print_help();
+        exit(1);
+    }
+    for (k = i; generate_type == NULL && k < argc; k++)
+    {
+        int j;
+
+        for (j = 0; benchmark_list[j].name != NULL; j++)
+        {
+            if (strcmp(argv[k], benchmark_list[j].name) == 0)
+            {
+                break;
+            }
+        }
+        if (benchmark_list[j].name == NULL)
+        {
+            fprintf(stderr, "ERROR: unknown benchmark '%s'\n", argv[k]);
+            exit(1);
+        }
+    }
+
+    if (harp_set_coda_definition_path_conditional(argv[0], NULL, "../share/coda/definitions") != 0)
+    {
+        fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
+        exit(1);
+    }
+    if (harp_set_udunits2_xml_path_conditional(argv[0], NULL, "../share/harp/udunits2.xml") != 0)
+    {
+        fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
+        exit(1);
+    }
+
+    harp_set_warning_handler(print_warning);
+
+    if (harp_init() != 0)
+    {
+        fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
+        exit(1);
+    }
+
+    if (generate_type != NULL)
+    {
+        result = generate(&options, generate_type, argv[i]) == 0 ? 0 : 1;
+        harp_done();
+        return result;
+    }
+
+    tmpdir = getenv("TMPDIR");
+    snprintf(options.workdir, HARP_MAX_PATH_LENGTH, "%s/harpbench.XXXXXX", tmpdir != NULL ? tmpdir : "/tmp");
+    if (mkdtemp(options.workdir) == NULL)
+    {
+        fprintf(stderr, "ERROR: could not create temporary directory '%s'\n", options.workdir);
+        harp_done();
+        exit(1);
+    }
+
+    printf("benchmark,num_elements,num_bytes,num_repeats,best_seconds,mean_seconds,elements_per_second,"
+           "bytes_per_second\n");
+    for (k = 0; benchmark_list[k].name != NULL; k++)
+    {
+        if (i < argc)
+        {
+            int j;
+
+            for (j = i; j < argc; j++)
+            {
+                if (strcmp(argv[j], benchmark_list[k].name) == 0)
+                {
+                    break;
+                }
+            }
+            if (j == argc)
+            {
+                continue;
+            }
+        }
+        if (run_benchmark(&benchmark_list[k], &options) != 0)
+        {
+            if (harp_errno == HARP_ERROR_NO_HDF5_SUPPORT)
+            {
+                fprintf(stderr, "WARNING: skipping benchmark '%s' (%s)\n", benchmark_list[k].name,
+                        harp_errno_to_string(harp_errno));
+                continue;
+            }
+            fprintf(stderr, "ERROR: benchmark '%s' failed: %s\n", benchmark_list[k].name,
+                    harp_errno_to_string(harp_errno));
+            result = 1;
+        }
+    }
+
+    rmdir(options.workdir);
+
+    harp_done();
+    return result;
+}
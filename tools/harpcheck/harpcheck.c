@@ -36,6 +36,7 @@
 #include "harp.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -60,13 +61,44 @@ static void print_version()
 static void print_help()
 {
     printf("Usage:\n");
-    printf("    harpcheck <input product file> [input product file...]\n");
+    printf("    harpcheck [options] <input product file> [input product file...]\n");
     printf("        If the product is a HARP product then verify that the\n");
     printf("        product is HARP compliant.\n");
     printf("        Otherwise, try to import the product using an applicable\n");
     printf("        ingestion module and test the ingestion for all possible\n");
     printf("        ingestion options.\n");
     printf("\n");
+    printf("        Options:\n");
+    printf("            -j, --jobs <n>\n");
+    printf("                Test up to <n> combinations of ingestion options\n");
+    printf("                concurrently (each in a separate process). Results\n");
+    printf("                are reported in the same order as for sequential\n");
+    printf("                testing. Default is 1 (not supported on Windows).\n");
+    printf("\n");
+    printf("    harpcheck --estimate [options] <input product file> [input product file...]\n");
+    printf("        Predict the storage size of the variable data of each product (and\n");
+    printf("        the total for all products) after import without reading the\n");
+    printf("        variable data. The total equals the size of the product that would\n");
+    printf("        result from merging all products.\n");
+    printf("\n");
+    printf("        Options:\n");
+    printf("            -a, --operations <operation list>\n");
+    printf("                List of operations to apply to each product.\n");
+    printf("                An operation list needs to be provided as a single expression.\n");
+    printf("                See the 'operations' section of the HARP documentation for\n");
+    printf("                more details.\n");
+    printf("\n");
+    printf("            -o, --options <option list>\n");
+    printf("                List of options to pass to the ingestion module.\n");
+    printf("                Only applicable if the input product is not in HARP format.\n");
+    printf("                Options are separated by semi-colons. Each option consists\n");
+    printf("                of an <option name>=<value> pair. An option list needs to be\n");
+    printf("                provided as a single expression.\n");
+    printf("\n");
+    printf("        Sizes are printed in bytes. Sizes that are marked with '<=' are upper\n");
+    printf("        bounds (e.g. because of filter operations). Products for which not all\n");
+    printf("        operations could be evaluated (e.g. binning) are reported as such.\n");
+    printf("\n");
     printf("    harpcheck -h, --help\n");
     printf("        Show help (this text).\n");
     printf("\n");
@@ -75,8 +107,91 @@ static void print_help()
     printf("\n");
 }
 
+static int estimate(int argc, char *argv[])
+{
+    const char *operations = NULL;
+    const char *options = NULL;
+    int64_t total_size = 0;
+    long total_time = 0;
+    int is_upper_bound = 0;
+    int is_complete = 1;
+    int i;
+
+    for (i = 2; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--operations") == 0) && i + 1 < argc &&
+            argv[i + 1][0] != '-')
+        {
+            operations = argv[i + 1];
+            i++;
+        }
+        else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--options") == 0) && i + 1 < argc &&
+                 argv[i + 1][0] != '-')
+        {
+            options = argv[i + 1];
+            i++;
+        }
+        else if (argv[i][0] != '-')
+        {
+            /* assume all arguments from here on are files */
+            break;
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: invalid arguments\n");
+            print_help();
+            exit(1);
+        }
+    }
+
+    if (i == argc)
+    {
+        fprintf(stderr, "ERROR: invalid arguments\n");
+        print_help();
+        exit(1);
+    }
+
+    for (; i < argc; i++)
+    {
+        harp_product_estimate *product_estimate;
+        int64_t size;
+
+        if (harp_import_estimate(argv[i], operations, options, &product_estimate) != 0)
+        {
+            fprintf(stderr, "ERROR: %s (%s)\n", harp_errno_to_string(harp_errno), argv[i]);
+            return -1;
+        }
+        if (harp_product_estimate_get_storage_size(product_estimate, &size) != 0)
+        {
+            fprintf(stderr, "ERROR: %s (%s)\n", harp_errno_to_string(harp_errno), argv[i]);
+            harp_product_estimate_delete(product_estimate);
+            return -1;
+        }
+
+        printf("%s: %s%lld bytes", argv[i], product_estimate->is_upper_bound ? "<=" : "", (long long)size);
+        if (product_estimate->num_unresolved_operations > 0)
+        {
+            printf(" (%d unresolved operations)", product_estimate->num_unresolved_operations);
+            is_complete = 0;
+        }
+        printf("\n");
+
+        total_size += size;
+        total_time += product_estimate->dimension[harp_dimension_time];
+        is_upper_bound |= product_estimate->is_upper_bound;
+
+        harp_product_estimate_delete(product_estimate);
+    }
+
+    printf("total: %s%lld bytes (time = %ld)%s\n", is_upper_bound ? "<=" : "", (long long)total_size, total_time,
+           is_complete ? "" : " (incomplete)");
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
+    long num_workers = 1;
     int result = 0;
     int i;
     int k;
@@ -96,7 +211,26 @@ int main(int argc, char *argv[])
     /* parse argumenst */
     for (i = 1; i < argc; i++)
     {
-        if (argv[i][0] != '-')
+        if (i == 1 && strcmp(argv[i], "--estimate") == 0)
+        {
+            /* arguments are parsed by estimate() */
+            break;
+        }
+        else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc &&
+                 argv[i + 1][0] != '-')
+        {
+            char *endptr;
+
+            num_workers = strtol(argv[i + 1], &endptr, 10);
+            if (*endptr != '\0' || num_workers < 1 || num_workers > INT_MAX)
+            {
+                fprintf(stderr, "ERROR: invalid number of jobs argument: '%s'\n", argv[i + 1]);
+                print_help();
+                exit(1);
+            }
+            i++;
+        }
+        else if (argv[i][0] != '-')
         {
             /* assume all arguments from here on are files */
             break;
@@ -109,6 +243,13 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (i == argc)
+    {
+        fprintf(stderr, "ERROR: invalid arguments\n");
+        print_help();
+        exit(1);
+    }
+
     if (harp_set_coda_definition_path_conditional(argv[0], NULL, "../share/coda/definitions") != 0)
     {
         fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
@@ -128,6 +269,23 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
+    if (harp_set_option_test_num_workers((int)num_workers) != 0)
+    {
+        fprintf(stderr, "ERROR: %s\n", harp_errno_to_string(harp_errno));
+        harp_done();
+        exit(1);
+    }
+
+    if (strcmp(argv[1], "--estimate") == 0)
+    {
+        if (estimate(argc, argv) != 0)
+        {
+            result = 1;
+        }
+        harp_done();
+        return result;
+    }
+
     for (k = i; k < argc; k++)
     {
         const char *filename = argv[k];
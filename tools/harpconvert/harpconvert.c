@@ -40,6 +40,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+static int show_memory_usage = 0;
+
 static int print_warning(const char *message, va_list ap)
 {
     int result;
@@ -51,6 +53,61 @@ static int print_warning(const char *message, va_list ap)
     return result;
 }
 
+static int parse_memory_limit(const char *str, int64_t *limit)
+{
+    char *endptr;
+    double value;
+
+    value = strtod(str, &endptr);
+    if (endptr == str || value < 0)
+    {
+        return -1;
+    }
+    switch (*endptr)
+    {
+        case 'k':
+        case 'K':
+            value *= 1024;
+            endptr++;
+            break;
+        case 'm':
+        case 'M':
+            value *= 1024 * 1024;
+            endptr++;
+            break;
+        case 'g':
+        case 'G':
+            value *= 1024 * 1024 * 1024;
+            endptr++;
+            break;
+    }
+    if (*endptr != '\0')
+    {
+        return -1;
+    }
+    *limit = (int64_t)value;
+
+    return 0;
+}
+
+static void print_memory_usage(void)
+{
+    int64_t current_usage;
+    int64_t peak_usage;
+    int i;
+
+    harp_get_memory_usage(&current_usage, &peak_usage);
+    fprintf(stderr, "memory usage: %ld bytes (peak: %ld bytes)\n", (long)current_usage, (long)peak_usage);
+    for (i = 0; i < HARP_NUM_MEMORY_SUBSYSTEMS; i++)
+    {
+        harp_memory_subsystem subsystem = (harp_memory_subsystem)i;
+
+        harp_get_memory_usage_for_subsystem(subsystem, &current_usage, &peak_usage);
+        fprintf(stderr, "    %s: %ld bytes (peak: %ld bytes)\n", harp_get_memory_subsystem_name(subsystem),
+                (long)current_usage, (long)peak_usage);
+    }
+}
+
 static void print_version()
 {
     printf("harpconvert version %s\n", libharp_version);
@@ -89,9 +146,37 @@ static void print_help()
     printf("                Set data compression level for storing in HDF5 format.\n");
     printf("                0=disabled, 1=low, ..., 9=high.\n");
     printf("\n");
+    printf("            --ragged-vertical\n");
+    printf("                Store vertical profiles as ragged arrays (without the padding\n");
+    printf("                of profiles with fewer levels) when storing in netCDF or HDF5\n");
+    printf("                format.\n");
+    printf("\n");
+    printf("            --append\n");
+    printf("                Append the time samples of the product to the output product\n");
+    printf("                (which should be a netCDF file that was created using this\n");
+    printf("                option). The variables of the product should match those in\n");
+    printf("                the output product. If the output product does not exist, it\n");
+    printf("                will be created using an unlimited time dimension.\n");
+    printf("                Only supported for the netcdf format.\n");
+    printf("\n");
+    printf("            --memory-limit <size>\n");
+    printf("                Maximum amount of memory to use for the data of variables.\n");
+    printf("                The size is in bytes and may be followed by a K, M, or G\n");
+    printf("                suffix. The tool will fail with an out of memory error if\n");
+    printf("                the limit is exceeded.\n");
+    printf("\n");
+    printf("            --memory-usage\n");
+    printf("                Print the (peak) memory usage of the data of variables per\n");
+    printf("                subsystem (import, operations, export) to stderr at exit.\n");
+    printf("\n");
     printf("        If the imported product is empty, a warning will be printed and the\n");
     printf("        tool will return with exit code 2 (without writing a file).\n");
     printf("\n");
+    printf("        If the input product is a HARP product and the operations only\n");
+    printf("        consist of keep(), exclude(), and rename() operations, the product\n");
+    printf("        is converted one variable at a time (such that the memory usage is\n");
+    printf("        limited to the size of the largest variable).\n");
+    printf("\n");
     printf("    harpconvert --generate-documentation [output directory]\n");
     printf("        Generate a series of documentation files in the specified output\n");
     printf("        directory. The documentation describes the set of supported foreign\n");
@@ -133,14 +218,46 @@ static int generate_doc(int argc, char *argv[])
     return 0;
 }
 
-static int convert(int argc, char *argv[])
+/* Import the input product and append it to the output product (which will be created if it does not exist). */
+static int append(const char *input_filename, const char *operations, const char *options,
+                  const char *output_filename, int argc, char *argv[])
 {
     harp_product *product;
+
+    if (harp_import(input_filename, operations, options, &product) != 0)
+    {
+        return -1;
+    }
+    if (harp_product_is_empty(product))
+    {
+        harp_product_delete(product);
+        return -2;
+    }
+    /* this line is also added to the history of the output product if the product is appended to an existing file */
+    if (harp_product_update_history(product, "harpconvert", argc, argv) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    if (harp_export_append(output_filename, product) != 0)
+    {
+        harp_product_delete(product);
+        return -1;
+    }
+    harp_product_delete(product);
+
+    return 0;
+}
+
+static int convert(int argc, char *argv[])
+{
     const char *operations = NULL;
     const char *options = NULL;
     const char *output_filename = NULL;
     const char *output_format = "netcdf";
     const char *input_filename = NULL;
+    int append_mode = 0;
+    int result;
     int i;
 
     for (i = 1; i < argc; i++)
@@ -173,6 +290,30 @@ static int convert(int argc, char *argv[])
             }
             i++;
         }
+        else if (strcmp(argv[i], "--ragged-vertical") == 0)
+        {
+            harp_set_option_ragged_vertical(1);
+        }
+        else if (strcmp(argv[i], "--append") == 0)
+        {
+            append_mode = 1;
+        }
+        else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc && argv[i + 1][0] != '-')
+        {
+            int64_t limit;
+
+            if (parse_memory_limit(argv[i + 1], &limit) != 0 || harp_set_option_memory_limit(limit) != 0)
+            {
+                fprintf(stderr, "ERROR: invalid memory limit argument: '%s'\n", argv[i + 1]);
+                print_help();
+                return -1;
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "--memory-usage") == 0)
+        {
+            show_memory_usage = 1;
+        }
         else if (argv[i][0] != '-')
         {
             /* Assume the next argument is an input file. */
@@ -196,33 +337,25 @@ static int convert(int argc, char *argv[])
     input_filename = argv[argc - 2];
     output_filename = argv[argc - 1];
 
-    if (harp_import(input_filename, operations, options, &product) != 0)
+    if (append_mode)
     {
-        return -1;
+        if (strcmp(output_format, "netcdf") != 0)
+        {
+            fprintf(stderr, "ERROR: appending is only supported for the netcdf format\n");
+            return -1;
+        }
+        return append(input_filename, operations, options, output_filename, argc, argv);
     }
 
-    if (harp_product_is_empty(product))
+    /* HARP products are converted one variable at a time if the operations allow this */
+    result = harp_convert(input_filename, operations, options, output_filename, output_format, "harpconvert", argc,
+                          argv);
+    if (result == 1)
     {
-        harp_product_delete(product);
         return -2;
     }
 
-    /* Update the product */
-    if (harp_product_update_history(product, "harpconvert", argc, argv) != 0)
-    {
-        harp_product_delete(product);
-        return -1;
-    }
-
-    /* Export the product */
-    if (harp_export(output_filename, output_format, product) != 0)
-    {
-        harp_product_delete(product);
-        return -1;
-    }
-
-    harp_product_delete(product);
-    return 0;
+    return result;
 }
 
 int main(int argc, char *argv[])
@@ -276,6 +409,11 @@ int main(int argc, char *argv[])
         result = convert(argc, argv);
     }
 
+    if (show_memory_usage)
+    {
+        print_memory_usage();
+    }
+
     if (result == -1)
     {
         if (harp_errno != HARP_SUCCESS)
@@ -83,6 +83,13 @@ static void print_help()
     printf("            -d, --data\n");
     printf("                Show data values for each variable.\n");
     printf("\n");
+    printf("            -e, --estimate\n");
+    printf("                Only show the predicted dimensions, variables, and storage\n");
+    printf("                size of the product after the operations have been\n");
+    printf("                performed, without reading the variable data.\n");
+    printf("                For operations whose result depends on the data (such as\n");
+    printf("                filters) the predicted values are upper bounds.\n");
+    printf("\n");
     printf("    harpdump --dataset [options] <file|dir> [<file|dir> ...]\n");
     printf("        Print metadata for all files in the dataset in csv format.\n");
     printf("\n");
@@ -246,6 +253,7 @@ static int dump(int argc, char *argv[])
     const char *operations = NULL;
     const char *options = NULL;
     harp_product *product;
+    int estimate = 0;
     int data = 0;
     int list = 0;
     int i;
@@ -273,6 +281,10 @@ static int dump(int argc, char *argv[])
         {
             data = 1;
         }
+        else if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--estimate") == 0)
+        {
+            estimate = 1;
+        }
         else if (argv[i][0] != '-')
         {
             /* assume all arguments from here on are files */
@@ -293,6 +305,19 @@ static int dump(int argc, char *argv[])
         return -1;
     }
 
+    if (estimate)
+    {
+        harp_product_estimate *product_estimate;
+
+        if (harp_import_estimate(argv[argc - 1], operations, options, &product_estimate) != 0)
+        {
+            return -1;
+        }
+        harp_product_estimate_print(product_estimate, printf);
+        harp_product_estimate_delete(product_estimate);
+        return 0;
+    }
+
     if (harp_import(argv[argc - 1], operations, options, &product) != 0)
     {
         return -1;
@@ -39,6 +39,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+static int show_memory_usage = 0;
+
 static int print_warning(const char *message, va_list ap)
 {
     int result;
@@ -50,6 +52,61 @@ static int print_warning(const char *message, va_list ap)
     return result;
 }
 
+static int parse_memory_limit(const char *str, int64_t *limit)
+{
+    char *endptr;
+    double value;
+
+    value = strtod(str, &endptr);
+    if (endptr == str || value < 0)
+    {
+        return -1;
+    }
+    switch (*endptr)
+    {
+        case 'k':
+        case 'K':
+            value *= 1024;
+            endptr++;
+            break;
+        case 'm':
+        case 'M':
+            value *= 1024 * 1024;
+            endptr++;
+            break;
+        case 'g':
+        case 'G':
+            value *= 1024 * 1024 * 1024;
+            endptr++;
+            break;
+    }
+    if (*endptr != '\0')
+    {
+        return -1;
+    }
+    *limit = (int64_t)value;
+
+    return 0;
+}
+
+static void print_memory_usage(void)
+{
+    int64_t current_usage;
+    int64_t peak_usage;
+    int i;
+
+    harp_get_memory_usage(&current_usage, &peak_usage);
+    fprintf(stderr, "memory usage: %ld bytes (peak: %ld bytes)\n", (long)current_usage, (long)peak_usage);
+    for (i = 0; i < HARP_NUM_MEMORY_SUBSYSTEMS; i++)
+    {
+        harp_memory_subsystem subsystem = (harp_memory_subsystem)i;
+
+        harp_get_memory_usage_for_subsystem(subsystem, &current_usage, &peak_usage);
+        fprintf(stderr, "    %s: %ld bytes (peak: %ld bytes)\n", harp_get_memory_subsystem_name(subsystem),
+                (long)current_usage, (long)peak_usage);
+    }
+}
+
 static void print_version()
 {
     printf("harpmerge version %s\n", libharp_version);
@@ -97,6 +154,16 @@ static void print_help()
     printf("                Set data compression level for storing in HDF5 format.\n");
     printf("                0=disabled, 1=low, ..., 9=high.\n");
     printf("\n");
+    printf("            --memory-limit <size>\n");
+    printf("                Maximum amount of memory to use for the data of variables.\n");
+    printf("                The size is in bytes and may be followed by a K, M, or G\n");
+    printf("                suffix. The tool will fail with an out of memory error if\n");
+    printf("                the limit is exceeded.\n");
+    printf("\n");
+    printf("            --memory-usage\n");
+    printf("                Print the (peak) memory usage of the data of variables per\n");
+    printf("                subsystem (import, operations, export) to stderr at exit.\n");
+    printf("\n");
     printf("        If the merged product is empty, a warning will be printed and the\n");
     printf("        tool will return with exit code 2 (without writing a file).\n");
     printf("\n");
@@ -207,6 +274,22 @@ static int merge(int argc, char *argv[])
             }
             i++;
         }
+        else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc && argv[i + 1][0] != '-')
+        {
+            int64_t limit;
+
+            if (parse_memory_limit(argv[i + 1], &limit) != 0 || harp_set_option_memory_limit(limit) != 0)
+            {
+                fprintf(stderr, "ERROR: invalid memory limit argument: '%s'\n", argv[i + 1]);
+                print_help();
+                return -1;
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "--memory-usage") == 0)
+        {
+            show_memory_usage = 1;
+        }
         else if (argv[i][0] != '-')
         {
             /* Assume the next argument is the dataset directory path. */
@@ -336,6 +419,11 @@ int main(int argc, char *argv[])
 
     result = merge(argc, argv);
 
+    if (show_memory_usage)
+    {
+        print_memory_usage();
+    }
+
     if (result == -1)
     {
         if (harp_errno != HARP_SUCCESS)